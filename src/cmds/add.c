@@ -32,7 +32,7 @@ static const struct opt_fn add_option_fns[] = {
  */
 static item it = {.item_id = -1,
                   .item_code = {"z"},
-                  .item_name = (char[ITEM_NAME_MAX]){"\0"},
+                  .item_name = NULL, /* Set by add_item_name */
                   .item_st = TODO};
 
 void add_help() {
@@ -83,7 +83,9 @@ void add_restage_item_code(const char *code) {
     } else {
         id = dir_get_id_from_prefix(code);
     }
-    if (id < 0) {
+    if (id == DIR_PREFIX_AMBIGUOUS) {
+        printf("More than one item has code prefix %s\n", code);
+    } else if (id < 0) {
         printf("No item found with code %s\n", code);
     } else {
         if (dir_change_item_status_id(id, TODO) == 0)
@@ -95,6 +97,14 @@ void add_restage_item_code(const char *code) {
 
 void add_item_name(const char *name) {
     assert(name);
+
+    /* Rejected before an ID is used up */
+    const int name_max = dir_name_max();
+    if (name_max > 0 && strlen(name) > (size_t)name_max) {
+        printf("Unable to add item, names must be at most %d characters\n",
+               name_max);
+        return;
+    }
     item_set_name_deep(&it, name, strlen(name));
 
     /* ID set to next available number */
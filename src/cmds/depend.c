@@ -48,8 +48,8 @@ _parse_ids_from_user(const char *dep_str,
 
     struct dependency_list *list = graph_init_dependency_list(0);
 
-    char *to_str = strtok(NULL, DEP_SIBLING_DELIM);
-    while (to_str) {
+    for (char *to_str = strtok(NULL, DEP_SIBLING_DELIM); to_str;
+         to_str = strtok(NULL, DEP_SIBLING_DELIM)) {
         sitem_id to = strtol(to_str, NULL, 10);
         if (!dir_contains_item_with_id(to)) {
             printf("No item in project with ID %d\n", to);
@@ -58,7 +58,6 @@ _parse_ids_from_user(const char *dep_str,
         }
         struct dependency *dep = graph_new_dependency(from, to, 0);
         graph_new_dependency_to_list(list, &dep);
-        to_str = strtok(NULL, DEP_SIBLING_DELIM);
     }
     return list;
 }
@@ -75,7 +74,13 @@ _parse_codes_from_user(const char *dep_str,
             prefix_len > ITEM_CODE_LEN ? ITEM_CODE_LEN : prefix_len);
     sitem_id from = dir_get_id_from_prefix(curr_code);
 
-    if (from < 0) {
+    if (from == DIR_PREFIX_AMBIGUOUS) {
+        printf("More than one item has code prefix: %s\n", curr_code);
+        if (*project_dependencies) {
+            graph_free_dependency_list(project_dependencies);
+        }
+        return NULL;
+    } else if (from < 0) {
         printf("No item listed with code prefix: %s\n", curr_code);
         if (*project_dependencies) {
             graph_free_dependency_list(project_dependencies);
@@ -96,12 +101,15 @@ _parse_codes_from_user(const char *dep_str,
                 prefix_len > ITEM_CODE_LEN ? ITEM_CODE_LEN : prefix_len);
         sitem_id to = dir_get_id_from_prefix(curr_code);
 
-        if (!dir_contains_item_with_id(to)) {
+        if (to == DIR_PREFIX_AMBIGUOUS) {
+            printf("More than one item has code prefix: %s\n",
+                   curr_code);
+        } else if (!dir_contains_item_with_id(to)) {
             printf("No item in project with ID %d\n", to);
-            continue;
+        } else {
+            struct dependency *dep = graph_new_dependency(from, to, 0);
+            graph_new_dependency_to_list(list, &dep);
         }
-        struct dependency *dep = graph_new_dependency(from, to, 0);
-        graph_new_dependency_to_list(list, &dep);
 
         to_str = next_to_str;
         next_to_str = strtok(NULL, DEP_SIBLING_DELIM);
@@ -0,0 +1,111 @@
+#include "gc.h"
+#include "config.h"
+#include "dir.h"
+#include "opts.h"
+
+#ifdef DEBUG
+#include "dev-utils/debug-out.h"
+#endif
+
+/* Option names */
+static const struct option gc_long_options[] = {
+    {"help", no_argument, 0, 'h'},       /* Help option */
+    {"keep", required_argument, 0, 'k'}, /* Done items kept unarchived */
+    {0, 0, 0, 0}};
+
+static const char *gc_short_options = "+hk:";
+
+static const struct opt_fn gc_option_fns[] = {
+    {'h', gc_help, NULL}, {'k', NULL, gc_set_keep}, {0, 0, 0}};
+
+/* Newest done items left out of the archive */
+static int gc_keep_done = GC_KEEP_DONE;
+
+/* Fewest done items archived at once, any number once -k is given */
+static int gc_archive_min = GC_ARCHIVE_MIN;
+
+static int gc_setting_opts = 0; /* Valid setting options handled */
+
+void gc_help() {
+    printf("%s %s - compact project item storage\n", CONF_NAME_UPPER,
+           GC_CMD_NAME);
+    printf("usage: %s %s [<options>]\n", CONF_CMD_NAME, GC_CMD_NAME);
+    printf("\n");
+    printf("\t-h, --help\tBring up this help page\n");
+    printf("\t-k, --keep <n>\tArchive all but the newest n done items "
+           "(default %d)\n",
+           GC_KEEP_DONE);
+    printf("\n");
+    printf("Items changing status leave dead entries behind, which are also "
+           "removed\nautomatically once they make up most of an item file\n");
+    printf("\n");
+    printf("Done items are moved to the compressed archive once at least %d "
+           "are beyond\nthose kept, archived items are listed with list -a "
+           "and are moved back\nif their status changes\n",
+           GC_ARCHIVE_MIN);
+}
+
+void gc_set_keep(const char *num) {
+    assert(num);
+
+    char *end;
+    const long keep = strtol(num, &end, 10);
+    if (*num == '\0' || *end != '\0' || keep < 0 || keep > INT_MAX) {
+        printf("Invalid number of done items to keep '%s'\n", num);
+        return;
+    }
+
+    gc_keep_done = (int)keep;
+    gc_archive_min = 1;
+    gc_setting_opts++;
+}
+
+int gc_compact_project() {
+    const int archived = dir_archive_items(gc_keep_done, gc_archive_min);
+
+    if (archived < 0) {
+#ifdef DEBUG
+        log_err("Done items could not be archived");
+#endif
+        puts("Could not archive done items");
+        return -1;
+    }
+
+    if (archived > 0)
+        printf("Archived %d done items\n", archived);
+
+    const int removed = dir_compact_items();
+
+    if (removed < 0) {
+#ifdef DEBUG
+        log_err("Item files could not be compacted");
+#endif
+        puts("Could not compact project items");
+        return -1;
+    }
+
+    printf("Removed %d dead item entries\n", removed);
+    return 0;
+}
+
+int gc_cmd(const int argc, char *const argv[], const char *proj_path) {
+    assert(proj_path);
+
+    if (*proj_path == '\0') {
+        printf("Not in a project\n");
+        return RET_NO_PROJ;
+    }
+
+    const int opts_handled = opts_handle_opts(argc, argv, gc_short_options,
+                                              gc_long_options, gc_option_fns);
+
+    if (opts_handled < 0) {
+        printf("Unknown options provided");
+        return RET_INVALID_OPTS;
+    }
+
+    if (opts_handled == gc_setting_opts && gc_compact_project() < 0)
+        return -1;
+
+    return 0;
+}
@@ -0,0 +1,45 @@
+#ifndef GC_H
+#define GC_H
+
+#include <assert.h>
+#include <getopt.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define GC_CMD_NAME "gc"
+
+#define GC_KEEP_DONE 100  /* Newest done items kept out of the archive */
+#define GC_ARCHIVE_MIN 64 /* Fewest done items worth archiving by default */
+
+/**
+ * @brief Show help for gc command
+ */
+extern void gc_help(void);
+
+/**
+ * @brief Set the number of the newest done items left out of the archive,
+ * archiving any number of items beyond them
+ * @param num Non-negative decimal number of items
+ */
+extern void gc_set_keep(const char *num);
+
+/**
+ * @brief Compact project item storage, moving old done items to the archive
+ * and removing entries left behind by items which have changed status
+ * @return 0 on success, -1 if storage could not be compacted
+ * @see dir_archive_items
+ * @see dir_compact_items
+ */
+extern int gc_compact_project(void);
+
+/**
+ * @brief Garbage collection command
+ * @param argc
+ * @param argv
+ * @param proj_path
+ * @return return code
+ */
+extern int gc_cmd(const int argc, char *const argv[], const char *proj_path);
+
+#endif
@@ -9,13 +9,26 @@
 
 /* Option names */
 static const struct option init_long_options[] = {
-    {"help", no_argument, 0, 'h'}, /* Help option */
+    {"help", no_argument, 0, 'h'},             /* Help option */
+    {"layout", required_argument, 0, 'l'},     /* Item storage layout */
+    {"durability", required_argument, 0, 'd'}, /* Durability mode */
     {0, 0, 0, 0}};
 
-static const char *init_short_options = "+h";
+static const char *init_short_options = "+hl:d:";
 
-static const struct opt_fn init_option_fns[] = {{'h', init_help, NULL},
-                                                {0, 0, 0}};
+static const struct opt_fn init_option_fns[] = {
+    {'h', init_help, NULL},
+    {'l', NULL, init_set_layout},
+    {'d', NULL, init_set_durability},
+    {0, 0, 0}};
+
+/* Layout to store items of the new project in */
+static enum dir_layout init_layout = DIR_LAYOUT_FILES;
+
+/* Durability mode of writes to the new project */
+static enum dir_durability init_durability = DIR_DURABILITY_FDATASYNC;
+
+static int init_setting_opts = 0; /* Valid setting options handled */
 
 void init_help() {
     printf("%s %s - Initialise a project at the current directory\n",
@@ -23,12 +36,42 @@ void init_help() {
     printf("usage: %s %s [<options>]\n", CONF_CMD_NAME, INIT_CMD_NAME);
     printf("\n");
     printf("\t-h, --help\tBring up this help page\n");
+    printf("\t-l, --layout\tStore items in the given layout: files (default), "
+           "table, binary, lsm, btree or segments\n");
+    printf("\t-d, --durability\tSync written files: none, fdatasync "
+           "(default) or batched\n");
+}
+
+void init_set_layout(const char *name) {
+    assert(name);
+
+    const int layout = dir_layout_from_name(name);
+    if (layout < 0) {
+        printf("Unknown layout '%s'\n", name);
+        return;
+    }
+
+    init_layout = (enum dir_layout)layout;
+    init_setting_opts++;
+}
+
+void init_set_durability(const char *name) {
+    assert(name);
+
+    const int durability = dir_durability_from_name(name);
+    if (durability < 0) {
+        printf("Unknown durability mode '%s'\n", name);
+        return;
+    }
+
+    init_durability = (enum dir_durability)durability;
+    init_setting_opts++;
 }
 
 int init_create_project() {
     /* Create project at CWD */
 
-    if (dir_init(CONF_PROJ_DIR) == -1) {
+    if (dir_init(CONF_PROJ_DIR, init_layout, init_durability) == -1) {
 #ifdef DEBUG
         log_err("Project could not be created at desired location:");
         log_err(CONF_PROJ_DIR);
@@ -64,10 +107,10 @@ int init_cmd(const int argc, char *const argv[], const char *proj_path) {
     }
 
     /*
-     * Checking opts_handled is a workable solution to prevent spurious init
-     * attempts for now
+     * Checking every option handled set a layout or durability mode is a
+     * workable solution to prevent spurious init attempts for now
      */
-    if (opts_handled == 0 && init_create_project() == -1) {
+    if (opts_handled == init_setting_opts && init_create_project() == -1) {
         return RET_UNABLE_TO_INIT;
     }
 
@@ -13,7 +13,23 @@
 extern void init_help(void);
 
 /**
- * @brief Create a standard project directory with required files and data
+ * @brief Set the layout items of the new project are stored in
+ * @param name Name of layout
+ * @see dir_layout_from_name
+ */
+extern void init_set_layout(const char *name);
+
+/**
+ * @brief Set the durability mode of writes to the new project
+ * @param name Name of durability mode
+ * @see dir_durability_from_name
+ */
+extern void init_set_durability(const char *name);
+
+/**
+ * @brief Create a standard project directory with required files and data,
+ * storing items in the layout set by init_set_layout and writing in the
+ * durability mode set by init_set_durability
  * @return 0 on success, -1 on failure with errno set
  * @see dir_init
  */
@@ -1,4 +1,5 @@
 #include "list.h"
+#include "dev-utils/test-helpers.h"
 #include "config.h"
 #include "dir.h"
 #include "ds/graph.h"
@@ -10,42 +11,43 @@
 static const struct option list_long_options[] = {
     {"help", no_argument, 0, 'h'},               /* Help option */
     {"all", no_argument, 0, 'a'},                /* List all task items */
+    {"archived", no_argument, 0, 'r'},           /* List archived items */
     {"status", required_argument, 0, 's'},       /* List all task items */
     {"dependencies", required_argument, 0, 'd'}, /* List item dependencies */
     {"dependencies-code", required_argument, 0,
      'c'}, /* List dependencies with code */
     {0, 0, 0, 0}};
 
-static const char *list_short_options = "+has:d:c:";
+static const char *list_short_options = "+hars:d:c:";
 
 static const struct opt_fn list_option_fns[] = {
     {'h', list_help, NULL},
-    {'a', list_all_names, NULL},
-    {'s', NULL, list_by_status},
+    {'a', list_set_all, NULL},
+    {'r', list_archived_names, NULL},
+    {'s', NULL, list_set_status},
     {'d', NULL, list_dependencies},
     {'c', NULL, list_dependencies_code},
     {0, 0, 0}};
 
-int *list_item_code_prefixes(item *const *items) {
-    /* Yes, I've assigned a macro to a variable, its because I'm paranoid */
-    const unsigned int code_len = ITEM_CODE_LEN;
-    size_t num_items = item_count_items(items);
+/* Statuses to list, set by -s */
+static const char *list_status_str = NULL;
+
+/* Whether archived items are listed along with done items, set by -a */
+static int list_with_archive = 0;
 
-    /* Make char list from item codes */
-    const char **codes = (const char **)malloc(sizeof(char *) * num_items);
+static int list_setting_opts = 0; /* Valid setting options handled */
 
-    for (size_t i = 0; i < num_items; i++)
-        /* Create shallow copy in codes array */
-        codes[i] = items[i]->item_code;
+int *list_item_code_prefixes(const char *const *codes, size_t num_codes) {
+    /* Yes, I've assigned a macro to a variable, its because I'm paranoid */
+    const unsigned int code_len = ITEM_CODE_LEN;
 
     /* Array to return */
-    int *code_prefix_lengths = (int *)malloc(sizeof(int) * num_items);
+    int *code_prefix_lengths = (int *)malloc(sizeof(int) * num_codes);
     if (!code_prefix_lengths)
         return code_prefix_lengths;
 
-    shortest_unique_prefix_lengths(codes, num_items, code_len, ITEM_CODE_CHARS,
+    shortest_unique_prefix_lengths(codes, num_codes, code_len, ITEM_CODE_CHARS,
                                    code_prefix_lengths);
-    free(codes);
     return code_prefix_lengths;
 }
 
@@ -53,7 +55,11 @@ void list_help() {
     printf("%s %s - list items in project\n", CONF_NAME_UPPER, LIST_CMD_NAME);
     printf("usage: %s %s [<options>]\n", CONF_CMD_NAME, LIST_CMD_NAME);
     printf("\n");
-    printf("\t-a, --all\tList all current tasks in project\n");
+    printf("\t-a, --all\tList all tasks in project, including archived "
+           "tasks, or\n\t\t\tarchived tasks with the done tasks of -s\n");
+    printf("\t-r, --archived\tList archived done tasks alone\n");
+    printf("\t-s, --status\tList tasks of the given statuses, from 'b', "
+           "'t', 'i' and 'd'\n");
     printf("\t-d, --dependencies\tList all dependencies associated with the "
            "given ID\n");
     printf("\t-c, --dependencies-code\tList all dependencies associated with "
@@ -62,42 +68,222 @@ void list_help() {
 }
 
 /**
- * @brief Print all items in array of item pointers with item code and other
- * given flags
- * @param items Array of item pointers
- * @param item_print_flags
- * @see item_print_fancy for flag options
- * @note Frees all items as well, thus, it is assumed that items is a
- * heap-allocated array
+ * @brief Write data to stdout, retrying partial and interrupted writes
+ * @param data Data to write
+ * @param len Length of data
  */
-static void print_list_items_codes(item **items, long long item_print_flags) {
-    /* Traverse array of items */
-    unsigned int curr_item = 0;
+static_fn void list_out_write(const char *data, size_t len) {
+    size_t written = 0;
+    while (written < len) {
+        ssize_t b = write(STDOUT_FILENO, data + written, len - written);
+        if (b < 0 && errno == EINTR)
+            continue;
+        if (b <= 0)
+            break; /* Output is lost, nothing else can be done */
+        written += b;
+    }
+}
 
-    /* Get the prefixes of the item codes to show in list */
-    int *item_code_prefix_lengths = list_item_code_prefixes(items);
+/**
+ * @brief Write all buffered output to stdout and empty the buffer
+ * @param out Output buffer
+ */
+static_fn void list_out_flush(struct list_out *out) {
+    list_out_write(out->buf, out->len);
+    out->len = 0;
+}
+
+/**
+ * @brief Append len bytes of data to the output buffer, flushing when full
+ * @param out Output buffer
+ * @param data Data to append
+ * @param len Length of data, data longer than LIST_OUT_BUF_SZ (as names of
+ * the binary layout may be) is written straight after the buffered output
+ */
+static_fn void list_out_put(struct list_out *out, const char *data,
+                            size_t len) {
+    if (out->len + len > LIST_OUT_BUF_SZ)
+        list_out_flush(out);
+    if (len > LIST_OUT_BUF_SZ) {
+        list_out_write(data, len);
+        return;
+    }
+    memcpy(out->buf + out->len, data, len);
+    out->len += len;
+}
+
+/* String literal variant of list_out_put */
+#define list_out_puts(out, str) list_out_put((out), (str), sizeof(str) - 1)
+
+/**
+ * @brief Render a single listed item as its ID, code and name fields
+ * @param out Output buffer
+ * @param ref Reference to item to render
+ * @param prefix_len Length of unique code prefix to highlight
+ * @param is_tty Whether colours should be used
+ * @see item_print_fancy for equivalent output of item structs
+ */
+static void list_out_item(struct list_out *out, const struct dir_item_ref *ref,
+                          int prefix_len, int is_tty) {
+    char id_str[16];
+    int id_len = snprintf(id_str, sizeof(id_str), "%d\t", ref->id);
+
+    /* ID */
+    if (is_tty)
+        list_out_puts(out, _ITEM_PRINT_ID_COL);
+    list_out_put(out, id_str, id_len);
+    if (is_tty)
+        list_out_puts(out, _ITEM_PRINT_RESET_COL);
+
+    /* Code with highlighted unique prefix */
+    if (is_tty) {
+        const char *st_col = _ITEM_PRINT_ST_TO_COL(ref->st);
+        list_out_put(out, st_col, strlen(st_col));
+        list_out_put(out, ref->code, prefix_len);
+        list_out_puts(out, _ITEM_PRINT_RESET_COL _ITEM_PRINT_CODE_INACTIVE_COL);
+        list_out_put(out, ref->code + prefix_len, ITEM_CODE_LEN - prefix_len);
+        list_out_puts(out, " " _ITEM_PRINT_RESET_COL);
+    } else {
+        list_out_put(out, ref->code, ITEM_CODE_LEN);
+        list_out_puts(out, " ");
+    }
+
+    /* Name */
+    if (is_tty) {
+        const char *st_col = _ITEM_PRINT_ST_TO_COL(ref->st);
+        list_out_put(out, st_col, strlen(st_col));
+    }
+    list_out_put(out, ref->name, ref->name_len);
+    list_out_puts(out, " ");
+    if (is_tty)
+        list_out_puts(out, _ITEM_PRINT_RESET_COL);
+
+    list_out_puts(out, "\n");
+}
+
+/**
+ * @brief Print all items of the given statuses with item code, ID and name
+ * straight from the stored item entries
+ * @param sts Statuses of items to list, in order
+ * @param num_sts Number of statuses in sts
+ * @param with_archive Non-zero to list archived items, ahead of the done items
+ * of the item store or after every other status if done is not listed
+ * @note Listed codes are saved for use with code prefixes
+ */
+static void print_list_items_codes(const enum status *sts, int num_sts,
+                                   int with_archive) {
+    struct dir_item_view view;
+    struct archive_view archive;
+    int num_hot, num_archived;
+
+    /* Items archived between opening the views would be listed twice */
+    for (int attempt = 0;; attempt++) {
+        const uint64_t gen = dir_read_begin(attempt);
+        memset(&archive, 0, sizeof(archive));
+
+        num_hot = dir_view_open(&view, sts, num_sts);
+        num_archived =
+            num_hot < 0 || !with_archive ? 0 : dir_archive_view_open(&archive);
+        if (!dir_read_changed(gen))
+            break;
+
+        dir_archive_view_close(&archive);
+        dir_view_close(&view);
+    }
+    if (num_hot < 0 || num_archived < 0) {
+        puts("Could not read any items");
+        dir_view_close(&view);
+        return;
+    }
+    const int num_items = num_hot + num_archived;
+
+    /* References to entries, with codes gathered for prefix lengths */
+    struct dir_item_ref *refs = malloc(sizeof(*refs) * (num_items + 1));
+    const char **codes = malloc(sizeof(*codes) * (num_items + 1));
+    struct list_out *out = malloc(sizeof(*out));
+
+    if (!refs || !codes || !out) {
+        free(refs);
+        free(codes);
+        free(out);
+        dir_archive_view_close(&archive);
+        dir_view_close(&view);
+        return;
+    }
 
-    dir_write_item_codes(items, item_code_prefix_lengths);
+    int curr_item = 0, archive_listed = !with_archive;
+    const struct dir_item_ref *ref = NULL;
+    while (curr_item < num_items) {
+        ref = dir_view_next(&view);
+
+        /* Archived items are all done, and older than done items held */
+        if (!archive_listed && (!ref || ref->st == DONE)) {
+            const struct dir_item_ref *archived;
+            while (curr_item < num_items &&
+                   (archived = dir_archive_view_next(&archive)) != NULL) {
+                refs[curr_item] = *archived;
+                codes[curr_item] = archived->code;
+                curr_item++;
+            }
+            archive_listed = 1;
+        }
 
-    /* Print out items */
-    while (items[curr_item] != NULL) {
-        assert(item_code_prefix_lengths[curr_item] > 0);
-        item_print_fancy(items[curr_item], item_print_flags | ITEM_PRINT_CODE,
-                         &item_code_prefix_lengths[curr_item]);
-        item_free(items[curr_item]);
+        if (!ref || curr_item >= num_items)
+            break;
+        refs[curr_item] = *ref;
+        codes[curr_item] = ref->code;
         curr_item++;
     }
 
-    free(items);
+    /* Get the prefixes of the item codes to show in list */
+    int *item_code_prefix_lengths = list_item_code_prefixes(codes, curr_item);
+
+    if (item_code_prefix_lengths) {
+        dir_write_item_codes(refs, curr_item, item_code_prefix_lengths);
+
+        /* Anything already printed must come first */
+        fflush(stdout);
+
+        const int is_tty = isatty(STDOUT_FILENO);
+        out->len = 0;
+        for (int i = 0; i < curr_item; i++) {
+            assert(item_code_prefix_lengths[i] > 0);
+            list_out_item(out, &refs[i], item_code_prefix_lengths[i], is_tty);
+        }
+        list_out_flush(out);
+    }
+
     free(item_code_prefix_lengths);
+    free(out);
+    free(codes);
+    free(refs);
+    dir_archive_view_close(&archive);
+    dir_view_close(&view);
 }
 
-void list_all_names() {
-    item **list_items = dir_read_all_items();
+void list_set_all() {
+    list_with_archive = 1;
+    list_setting_opts++;
+}
 
+void list_set_status(const char *status) {
+    assert(status);
+
+    list_status_str = status;
+    list_setting_opts++;
+}
+
+void list_all_names() {
     printf("Current tasks open in this project:\n");
 
-    print_list_items_codes(list_items, ITEM_PRINT_ID | ITEM_PRINT_NAME);
+    const enum status all_sts[ITEM_STATUS_COUNT] = {BACKLOG, TODO, IN_PROG,
+                                                    DONE};
+    print_list_items_codes(all_sts, ITEM_STATUS_COUNT, 1);
+}
+
+void list_archived_names() {
+    const enum status no_sts[1] = {DONE};
+    print_list_items_codes(no_sts, 0, 1);
 }
 
 /**
@@ -129,13 +315,8 @@ void list_by_status(const char *status_str) {
 
     size_t chars_in_status_str = strlen(status_str);
 
-    /* Set a reasonable capacity */
-    unsigned int list_capacity = 64;
-    unsigned int num_items = 0;
-    item **list_items = item_array_init_empty(list_capacity);
-
-    if (!list_items)
-        return;
+    enum status list_sts[ITEM_STATUS_COUNT];
+    int num_sts = 0;
 
     uint64_t duplicate_mask =
         get_dup_status_chars(status_str, ITEM_STATUS_COUNT);
@@ -149,41 +330,36 @@ void list_by_status(const char *status_str) {
         if ((duplicate_mask >> i) & 1)
             continue; /* Duplicate */
 
-        item **status_items = NULL;
         switch (status_str[i]) {
         case LIST_BACKLOG_CHAR:
-            status_items = dir_read_items_status(BACKLOG);
+            list_sts[num_sts++] = BACKLOG;
             break;
         case LIST_TODO_CHAR:
-            status_items = dir_read_items_status(TODO);
+            list_sts[num_sts++] = TODO;
             break;
         case LIST_IP_CHAR:
-            status_items = dir_read_items_status(IN_PROG);
+            list_sts[num_sts++] = IN_PROG;
             break;
         case LIST_DONE_CHAR:
-            status_items = dir_read_items_status(DONE);
+            list_sts[num_sts++] = DONE;
             break;
         default:
             break; /* Character not expected */
         }
-        if (status_items) {
-            /* There are a couple of potential unsafe operations here */
-            unsigned int new_num_items = item_count_items(status_items);
-            if (num_items + new_num_items > list_capacity) {
-                list_capacity *= 2;
-                list_items = item_array_resize(list_items, list_capacity);
-            }
+    }
 
-            if (!list_items) {
-                return;
-            }
+    /* Archived items are only listed on request, and are otherwise counted */
+    int lists_done = 0;
+    for (int i = 0; i < num_sts; i++)
+        lists_done |= list_sts[i] == DONE;
 
-            item_array_add(list_items, &status_items, SIZE_MAX);
-            num_items += new_num_items;
-        }
-    }
+    print_list_items_codes(list_sts, num_sts, lists_done && list_with_archive);
 
-    print_list_items_codes(list_items, ITEM_PRINT_ID | ITEM_PRINT_NAME);
+    const int num_archived =
+        lists_done && !list_with_archive ? dir_archived_items() : 0;
+    if (num_archived > 0)
+        printf("\n%d archived done items not listed, see %s %s -s %c -a\n",
+               num_archived, CONF_CMD_NAME, LIST_CMD_NAME, LIST_DONE_CHAR);
 
     if (strlen(status_str) > ITEM_STATUS_COUNT) {
         puts("\nOnly the first three specified statuses where listed");
@@ -199,8 +375,22 @@ static void print_dependencies_of_id(sitem_id id, uint64_t item_print_flags) {
         printf("Project does not contain item %d\n", id);
         return;
     }
-    item **project_items = dir_read_all_items();
-    struct dependency_list *project_dependencies = dir_get_all_dependencies();
+    item **project_items = NULL;
+    struct dependency_list *project_dependencies = NULL;
+
+    /* Dependencies must be of the items read */
+    for (int attempt = 0;; attempt++) {
+        const uint64_t gen = dir_read_begin(attempt);
+        project_items = dir_read_all_items();
+        project_dependencies = dir_get_all_dependencies();
+        if (!dir_read_changed(gen))
+            break;
+
+        if (project_items)
+            item_array_free(&project_items, SIZE_MAX);
+        if (project_dependencies)
+            graph_free_dependency_list(&project_dependencies);
+    }
 
     struct graph_of_items *full_proj_dag =
         graph_create_graph(&project_items, &project_dependencies);
@@ -233,6 +423,11 @@ void list_dependencies_code(const char *code_str) {
     } else if (strlen(code_str) < ITEM_CODE_LEN) {
         /* Prefix */
         id = dir_get_id_from_prefix(code_str);
+        if (id == DIR_PREFIX_AMBIGUOUS) {
+            printf("More than one item has code prefix %s\n",
+                   code_str);
+            return;
+        }
     } else {
         printf("Code provided is of an incorrect length");
         return;
@@ -256,7 +451,13 @@ int list_cmd(const int argc, char *const argv[], const char *proj_path) {
         return RET_INVALID_OPTS;
     }
 
-    if (opts_handled == 0) {
+    /* Settings only apply to listings by status */
+    if (opts_handled > 0 && opts_handled == list_setting_opts) {
+        if (list_status_str)
+            list_by_status(list_status_str);
+        else
+            list_all_names();
+    } else if (opts_handled == 0) {
         if (argc == 1)
             /* Ignore backlog by default -- see list_by_status */
             list_by_status((const char[]){LIST_TODO_CHAR, LIST_IP_CHAR,
@@ -2,6 +2,7 @@
 #define LIST_H
 
 #include <assert.h>
+#include <errno.h>
 #include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -24,15 +25,29 @@
 #define LIST_IP_CHAR 'i'
 #define LIST_DONE_CHAR 'd'
 
+/* Size of the buffer list output is rendered into before being written */
+#define LIST_OUT_BUF_SZ (64 * 1024)
+
+/**
+ * @brief Buffered list output, written to stdout in large blocks
+ */
+struct list_out {
+    char buf[LIST_OUT_BUF_SZ];
+    size_t len;
+};
+
 /**
- * @brief Get shortened item codes from the list of items
- * @param items Array of pointers to items which are being listed
+ * @brief Get shortened item codes from the list of item codes
+ * @param codes Array of item codes (each ITEM_CODE_LEN characters) which are
+ * being listed
+ * @param num_codes Number of codes in codes
  * @return Array of heap-allocated ints associated with the (unique) prefix
  * lengths of each item code
  * @note This is a utility function -- not a command
  * @see shortest_unique_prefix_lengths
  */
-extern int *list_item_code_prefixes(item *const *items);
+extern int *list_item_code_prefixes(const char *const *codes,
+                                    size_t num_codes);
 
 /**
  * @brief Show help for list command
@@ -40,15 +55,36 @@ extern int *list_item_code_prefixes(item *const *items);
 extern void list_help(void);
 
 /**
- * @brief List all tasks in project
+ * @brief List archived items along with the done items of any listing by
+ * status, or list all items if no statuses are set
+ * @see list_set_status
+ */
+extern void list_set_all(void);
+
+/**
+ * @brief Set the statuses of items to list
+ * @param status Status characters, as taken by list_by_status
+ */
+extern void list_set_status(const char *status);
+
+/**
+ * @brief List all tasks in project, including archived tasks
  */
 extern void list_all_names(void);
 
+/**
+ * @brief List archived tasks alone, which are all done
+ * @see dir_archive_items
+ */
+extern void list_archived_names(void);
+
 /**
  * @brief List items of a given status
  * @param status Status of items to list, this is taken to represent a series of
  * one or more of the characters 't', 'i', 'd', 'b'; mneumonics for "todo",
  * "in-progress", "done" and "backlog" respectively.
+ * @note Archived items are only listed once set by list_set_all, and are
+ * otherwise counted
  */
 extern void list_by_status(const char *status);
 
@@ -74,4 +110,10 @@ extern void list_dependencies_code(const char *code_str);
  */
 extern int list_cmd(const int argc, char *const argv[], const char *proj_path);
 
+#ifdef TJUNITTEST
+extern void list_out_write(const char *data, size_t len);
+extern void list_out_flush(struct list_out *out);
+extern void list_out_put(struct list_out *out, const char *data, size_t len);
+#endif
+
 #endif
@@ -0,0 +1,97 @@
+#include "migrate.h"
+#include "config.h"
+#include "dir.h"
+#include "opts.h"
+
+#ifdef DEBUG
+#include "dev-utils/debug-out.h"
+#endif
+
+/* Option names */
+static const struct option migrate_long_options[] = {
+    {"help", no_argument, 0, 'h'}, /* Help option */
+    {0, 0, 0, 0}};
+
+static const char *migrate_short_options = "+h";
+
+static const struct opt_fn migrate_option_fns[] = {{'h', migrate_help, NULL},
+                                                   {0, 0, 0}};
+
+void migrate_help() {
+    printf("%s %s - change the layout project items are stored in\n",
+           CONF_NAME_UPPER, MIGRATE_CMD_NAME);
+    printf("usage: %s %s <layout>\n", CONF_CMD_NAME, MIGRATE_CMD_NAME);
+    printf("\n");
+    printf("\t-h, --help\tBring up this help page\n");
+    printf("\n");
+    printf("Layouts:\n");
+    printf("\tfiles\tOne file of items for each status\n");
+    printf("\ttable\tOne table of items, with status changes made in place\n");
+    printf("\tbinary\tBinary records of item metadata, names of any length are "
+           "kept apart\n");
+    printf("\tlsm\tLog of item changes merged with sorted runs of items\n");
+    printf("\tbtree\tB+tree of items keyed by ID, in pages of 4 KiB\n");
+    printf("\tsegments\tOne file of items for each status and range of 1024 "
+           "IDs\n");
+}
+
+int migrate_to_layout(const char *name) {
+    assert(name);
+
+    const int layout = dir_layout_from_name(name);
+    if (layout < 0) {
+        printf("Unknown layout '%s'\n", name);
+        return -1;
+    }
+
+    const enum dir_layout old_layout = dir_get_layout();
+    const int moved = dir_migrate((enum dir_layout)layout);
+
+    if (moved < 0) {
+#ifdef DEBUG
+        log_err("Project items could not be migrated");
+#endif
+        puts("Could not migrate project items");
+        return -1;
+    }
+
+    if (old_layout == (enum dir_layout)layout)
+        printf("Items are already stored in the %s layout\n", name);
+    else
+        printf("Moved %d items from the %s layout to the %s layout\n", moved,
+               dir_layout_name(old_layout), name);
+
+    return 0;
+}
+
+int migrate_cmd(const int argc, char *const argv[], const char *proj_path) {
+    assert(proj_path);
+
+    if (*proj_path == '\0') {
+        printf("Not in a project\n");
+        return RET_NO_PROJ;
+    }
+
+    const int opts_handled = opts_handle_opts(
+        argc, argv, migrate_short_options, migrate_long_options,
+        migrate_option_fns);
+
+    if (opts_handled < 0) {
+        printf("Unknown options provided");
+        return RET_INVALID_OPTS;
+    }
+
+    if (opts_handled != 0)
+        return 0;
+
+    char *const arg = argv[1];
+    if (!arg) {
+        migrate_help();
+        return RET_INVALID_OPTS;
+    }
+
+    if (migrate_to_layout(arg) < 0)
+        return -1;
+
+    return 0;
+}
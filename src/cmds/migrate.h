@@ -0,0 +1,34 @@
+#ifndef MIGRATE_H
+#define MIGRATE_H
+
+#include <assert.h>
+#include <getopt.h>
+#include <stdio.h>
+
+#define MIGRATE_CMD_NAME "migrate"
+
+/**
+ * @brief Show help for migrate command
+ */
+extern void migrate_help(void);
+
+/**
+ * @brief Move all project items into the layout with the given name
+ * @param name Name of layout
+ * @return 0 on success, -1 if the layout is unknown or items could not be
+ * moved
+ * @see dir_migrate
+ */
+extern int migrate_to_layout(const char *name);
+
+/**
+ * @brief Migrate command -- changes the layout project items are stored in
+ * @param argc
+ * @param argv
+ * @param proj_path
+ * @return return code
+ */
+extern int migrate_cmd(const int argc, char *const argv[],
+                       const char *proj_path);
+
+#endif
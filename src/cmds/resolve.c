@@ -64,7 +64,9 @@ void res_item_code(const char *code) {
     } else {
         id = dir_get_id_from_prefix(code);
     }
-    if (id < 0) {
+    if (id == DIR_PREFIX_AMBIGUOUS) {
+        printf("More than one item has code prefix %s\n", code);
+    } else if (id < 0) {
         printf("No item found with code %s\n", code);
     } else {
         if (dir_change_item_status_id(id, DONE) == 0)
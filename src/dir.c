@@ -2,6 +2,15 @@
 #include "dev-utils/test-helpers.h"
 #include "ds/graph.h"
 #include "ds/item.h"
+#include "store/archive.h"
+#include "store/binary.h"
+#include "store/btree.h"
+#include "store/code_index.h"
+#include "store/files.h"
+#include "store/lsm.h"
+#include "store/memory.h"
+#include "store/table.h"
+#include "store/wal.h"
 #ifdef DEBUG
 #include "dev-utils/debug-out.h"
 #endif
@@ -9,17 +18,63 @@
 /* Project directory */
 static char proj_path[MAX_PATH] = {'\0'};
 
-/* Item storage */
+/* Item storage, holding the files of every store */
 static char items_path[MAX_PATH] = {'\0'};
-static char backlog_path[MAX_PATH] = {'\0'};
-static char todo_path[MAX_PATH] = {'\0'};
-static char ip_path[MAX_PATH] = {'\0'};
-static char done_path[MAX_PATH] = {'\0'};
+
+/* Archive of done items, held apart from the item store of any layout */
+static char archive_path[MAX_PATH] = {'\0'};
+
+/* Layout of item storage, DIR_LAYOUT_COUNT until it is read */
+static char layout_path[MAX_PATH] = {'\0'};
+static enum dir_layout proj_layout = DIR_LAYOUT_COUNT;
+
+/* Durability mode of the project, DIR_DURABILITY_COUNT until it is read */
+static char durability_path[MAX_PATH] = {'\0'};
+static enum dir_durability proj_durability = DIR_DURABILITY_COUNT;
+
+/* Log of item changes, and the transaction logged since dir_begin */
+static char wal_path[MAX_PATH] = {'\0'};
+static struct wal_txn proj_txn = {NULL, 0, 0, 0};
+static int txn_open = 0;
+
+/* Lock of the project, open once first taken */
+static char lock_path[MAX_PATH] = {'\0'};
+static int proj_lock_fd = -1;
+static enum dir_lock_mode proj_lock_mode = DIR_LOCK_NONE;
+
+/* Slot held by a writer of records, and the log of its transactions */
+static int proj_slot = -1;
+static char slot_wal_path[MAX_PATH] = {'\0'};
+static const char *txn_wal_path = wal_path;
+
+static int num_locked_records = 0; /* Records locked by a writer of records */
+static int num_reads = 0; /* Reads of items begun and not yet ended */
+
+/* Generation of items, mapped from the lock file once it is open */
+static _Atomic uint64_t *proj_gen = NULL;
+static int items_writes = 0; /* Changes to items begun and not yet ended */
+
+/* Logged changes are being applied, or redone after an interruption */
+static int txn_applying = 0;
+static int txn_recovering = 0;
+
+/* Files written but not yet synced in DIR_DURABILITY_BATCHED */
+static const char *batched_files[_DIR_MAX_BATCHED_FILES];
+static int num_batched_files = 0;
 
 static char next_id_path[MAX_PATH] = {'\0'};      /* Next available item ID */
 static char listed_codes_path[MAX_PATH] = {'\0'}; /* Listed codes */
+static char code_index_path[MAX_PATH] = {'\0'};   /* Index of item codes */
 static char item_dependencies[MAX_PATH] = {'\0'}; /* Item dependencies */
 
+/* Store of each layout, indexed by enum dir_layout */
+static const struct store_ops *const layout_stores[DIR_LAYOUT_COUNT] = {
+    &files_store, &table_store, &binary_store,
+    &lsm_store,   &btree_store, &segments_store};
+
+/* Store holding the items of the project, NULL until it is first used */
+static const struct store_ops *proj_store = NULL;
+
 /**
  * @brief Set up global path variables to default values if not already done
  * so. Should be one of the first calls made by dir_* functions (excluding) for
@@ -36,16 +91,19 @@ static_fn void setup_path_names(const char *const path) {
     if (!*items_path)
         dir_construct_path(proj_path, _DIR_ITEM_PATH_D, items_path, MAX_PATH);
 
-    /* Item file names */
-    if (!*backlog_path)
-        dir_construct_path(items_path, _DIR_ITEM_BACKLOG_F, backlog_path,
+    /* Set up archive path */
+    if (!*archive_path)
+        dir_construct_path(proj_path, _DIR_ARCHIVE_PATH_D, archive_path,
+                           MAX_PATH);
+
+    /* Item storage layout */
+    if (!*layout_path)
+        dir_construct_path(proj_path, _DIR_LAYOUT_F, layout_path, MAX_PATH);
+
+    /* Durability mode */
+    if (!*durability_path)
+        dir_construct_path(proj_path, _DIR_DURABILITY_F, durability_path,
                            MAX_PATH);
-    if (!*todo_path)
-        dir_construct_path(items_path, _DIR_ITEM_TODO_F, todo_path, MAX_PATH);
-    if (!*ip_path)
-        dir_construct_path(items_path, _DIR_ITEM_INPROG_F, ip_path, MAX_PATH);
-    if (!*done_path)
-        dir_construct_path(items_path, _DIR_ITEM_DONE_F, done_path, MAX_PATH);
 
     /* Next ID data */
     if (!*next_id_path)
@@ -54,6 +112,16 @@ static_fn void setup_path_names(const char *const path) {
     if (!*listed_codes_path)
         dir_construct_path(proj_path, _DIR_CODE_LIST_F, listed_codes_path,
                            MAX_PATH);
+    /* Index of item codes */
+    if (!*code_index_path)
+        dir_construct_path(proj_path, _DIR_CODE_INDEX_F, code_index_path,
+                           MAX_PATH);
+    /* Project lock */
+    if (!*lock_path)
+        dir_construct_path(proj_path, _DIR_LOCK_F, lock_path, MAX_PATH);
+    /* Log of item changes */
+    if (!*wal_path)
+        dir_construct_path(proj_path, _DIR_WAL_F, wal_path, MAX_PATH);
     /* Item dependencies */
     if (!*item_dependencies)
         dir_construct_path(proj_path, _DIR_DEPENDENICES_F, item_dependencies,
@@ -77,39 +145,552 @@ static_fn int create_file(const char *const fname) {
 }
 
 /**
- * @brief creates items file, file descriptor is closed immediately if creation
- * is successful
+ * @brief Sync every file recorded by sync_written during this run, registered
+ * with atexit in DIR_DURABILITY_BATCHED and called once logged changes are
+ * applied
+ */
+static_fn void sync_batched_files() {
+    for (int i = 0; i < num_batched_files; i++) {
+        /* Files replaced by a rename are synced by the path they now have */
+        int fd = open(batched_files[i], O_RDONLY);
+        if (fd < 0)
+            continue;
+        fdatasync(fd);
+        close(fd);
+    }
+    num_batched_files = 0;
+}
+
+/**
+ * @brief Make data written to a project file durable as required by the
+ * durability mode of the project, or once every logged change being applied
+ * is applied
+ * @param fd File descriptor the data was written through
+ * @param path Path of the file, which must be one of the static project paths
+ * as it may only be synced at exit
  * @return 0 on success
  * @return -1 on error
- * @see open, close, mkdir
  */
-static_fn int create_items() {
-    setup_path_names(NULL);
+static_fn int sync_written(const int fd, const char *path) {
+    static int batched_registered = 0;
+
+    switch (dir_get_durability()) {
+    case DIR_DURABILITY_FDATASYNC:
+        if (!txn_applying)
+            return fdatasync(fd);
+        /* Fall through */
+    case DIR_DURABILITY_BATCHED:
+        for (int i = 0; i < num_batched_files; i++) {
+            if (batched_files[i] == path)
+                return 0;
+        }
 
-    /* Create directory */
-    int ret = mkdir(items_path, CONF_DIR_PERMS);
+        /* Sync immediately rather than lose track of the file */
+        if (num_batched_files == _DIR_MAX_BATCHED_FILES)
+            return fdatasync(fd);
+
+        if (!batched_registered && atexit(sync_batched_files) != 0)
+            return fdatasync(fd);
+        batched_registered = 1;
+
+        batched_files[num_batched_files++] = path;
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Make a complete replacement file durable before it is renamed over
+ * the file it replaces
+ * @param fd File descriptor of replacement file
+ * @return 0 on success
+ * @return -1 on error
+ * @note Replacements are synced immediately in DIR_DURABILITY_BATCHED too, so
+ * that a rename can never outlive the data it exposes
+ * @note The log of item changes is synced the same way, before the changes it
+ * holds are applied
+ */
+static_fn int sync_replacement(const int fd) {
+    if (dir_get_durability() == DIR_DURABILITY_NONE)
+        return 0;
+
+    return fdatasync(fd);
+}
+
+/* Project state handed to stores */
+static const struct store_env proj_env = {
+    .proj_dir = proj_path,
+    .items_dir = items_path,
+    .sync_written = sync_written,
+    .sync_replacement = sync_replacement,
+};
+
+/**
+ * @brief Get the store of a layout, with the paths of its files set up
+ * @param layout Layout of item storage
+ * @return Store of layout
+ */
+static_fn const struct store_ops *layout_store(const enum dir_layout layout) {
+    assert(layout < DIR_LAYOUT_COUNT);
+
+    const struct store_ops *store = layout_stores[layout];
+    store->setup(&proj_env);
+    return store;
+}
+
+/**
+ * @brief Lock or unlock one byte of the open lock file with an open file
+ * description lock, waiting for any conflicting lock to be released
+ * @param type F_RDLCK, F_WRLCK or F_UNLCK
+ * @param pos Byte of lock file
+ * @return 0 on success
+ * @return -1 on error
+ */
+static_fn int lock_byte(const short type, const off_t pos) {
+    struct flock fl = {
+        .l_type = type, .l_whence = SEEK_SET, .l_start = pos, .l_len = 1};
+
+    int ret;
+    while ((ret = fcntl(proj_lock_fd, F_OFD_SETLKW, &fl)) < 0 && errno == EINTR)
+        ;
+    return ret;
+}
+
+/**
+ * @brief Lock one byte of the open lock file with an open file description
+ * lock, unless a conflicting lock is held
+ * @param type F_RDLCK or F_WRLCK
+ * @param pos Byte of lock file
+ * @return 0 on success
+ * @return -1 if a conflicting lock is held, or on error
+ */
+static_fn int try_lock_byte(const short type, const off_t pos) {
+    struct flock fl = {
+        .l_type = type, .l_whence = SEEK_SET, .l_start = pos, .l_len = 1};
+
+    int ret;
+    while ((ret = fcntl(proj_lock_fd, F_OFD_SETLK, &fl)) < 0 && errno == EINTR)
+        ;
+    return ret;
+}
+
+/**
+ * @brief Take the project lock through the turnstile, which writers hold
+ * while waiting for readers to finish, so that no new readers pass them
+ * @param type F_RDLCK or F_WRLCK
+ * @return 0 on success
+ * @return -1 on error
+ */
+static_fn int lock_project(const short type) {
+    if (lock_byte(type, _DIR_LOCK_TURNSTILE_POS) < 0)
+        return -1;
+
+    const int ret = lock_byte(type, _DIR_LOCK_PROJECT_POS);
+    lock_byte(F_UNLCK, _DIR_LOCK_TURNSTILE_POS);
+    return ret;
+}
+
+/**
+ * @brief Check whether a byte of the lock file is locked through another open
+ * file description
+ * @param pos Byte of lock file
+ * @return Non-zero if locked, or if the lock file is not open
+ */
+static_fn int byte_is_locked(const off_t pos) {
+    struct flock fl = {
+        .l_type = F_WRLCK, .l_whence = SEEK_SET, .l_start = pos, .l_len = 1};
+
+    if (proj_lock_fd < 0 || fcntl(proj_lock_fd, F_OFD_GETLK, &fl) < 0)
+        return proj_lock_fd >= 0;
+    return fl.l_type != F_UNLCK;
+}
+
+/**
+ * @brief Take or release the structural lock while writing records, which is
+ * held by every other lock mode for the whole of a command
+ * @param type F_RDLCK, F_WRLCK or F_UNLCK
+ * @return 0 on success
+ * @return -1 on error
+ */
+static_fn int lock_structure(const short type) {
+    if (proj_lock_mode != DIR_LOCK_RECORDS)
+        return 0;
+    return lock_byte(type, _DIR_LOCK_STRUCTURE_POS);
+}
+
+/**
+ * @brief Construct the path of the log of the writer of records in a slot
+ * @param slot Slot of writer
+ * @param path Buffer of MAX_PATH bytes
+ */
+static_fn void slot_wal(const int slot, char *path) {
+    char base[sizeof(_DIR_WAL_SLOT_F) + 16];
+    snprintf(base, sizeof(base), _DIR_WAL_SLOT_F, slot);
+    dir_construct_path(proj_path, base, path, MAX_PATH);
+}
+
+/**
+ * @brief Check whether a log holds changes
+ * @param path Path of log
+ * @return Non-zero if the log is not empty
+ */
+static_fn int log_has_changes(const char *path) {
+    struct stat sb;
+    return stat(path, &sb) == 0 && sb.st_size > 0;
+}
+
+/**
+ * @brief Mark the items of the project as being changed, counting this run
+ * among the writers of items until every change begun is ended
+ * @note Generations are only kept once the lock file is open, which every
+ * command changing items has done by taking its lock
+ * @see end_items_write
+ */
+static_fn void begin_items_write() {
+    if (proj_gen && items_writes++ == 0)
+        atomic_fetch_add(proj_gen, _DIR_GEN_STEP + 1);
+}
+
+/**
+ * @brief End a change begun with begin_items_write, no longer counting this
+ * run once no other change is being made
+ */
+static_fn void end_items_write() {
+    if (proj_gen && items_writes > 0 && --items_writes == 0)
+        atomic_fetch_add(proj_gen, _DIR_GEN_STEP - 1);
+}
+
+/**
+ * @brief Drop every writer counted in the generation of items, once changes
+ * left by interrupted writers are redone
+ * @note Only made under the exclusive lock, with no other writer running
+ */
+static_fn void reset_items_writers() {
+    if (!proj_gen)
+        return;
+
+    const uint64_t gen = atomic_load(proj_gen);
+    atomic_store(proj_gen, (gen & ~(uint64_t)_DIR_GEN_WRITERS) + _DIR_GEN_STEP);
+    items_writes = 0;
+}
+
+/**
+ * @brief Check whether changes to items were left part way by interrupted
+ * writers
+ * @return Non-zero if a log of no running writer holds changes, or more
+ * writers are counted in the generation of items than are running
+ * @note Writers of records are running while they hold their slot, and no
+ * exclusive writer can be running while any lock other than
+ * DIR_LOCK_OPTIMISTIC is held
+ */
+static_fn int items_left_changing() {
+    const uint64_t writers =
+        proj_gen ? atomic_load(proj_gen) & _DIR_GEN_WRITERS : 0;
+
+    int num_running = 0;
+    for (int slot = 0; slot < _DIR_LOCK_SLOTS; slot++) {
+        if (writers > 0 && slot != proj_slot &&
+            byte_is_locked(_DIR_LOCK_SLOTS_POS + slot)) {
+            num_running++;
+            continue;
+        }
+
+        char path[MAX_PATH];
+        slot_wal(slot, path);
+        if (log_has_changes(path))
+            return 1;
+    }
+
+    return log_has_changes(wal_path) || writers > (uint64_t)num_running;
+}
+
+/**
+ * @brief Take a slot for this run as a writer of records, so that its
+ * transactions are logged apart from those of other writers
+ * @return 0 on success
+ * @return -1 on error
+ * @note A slot is waited for only once every slot is taken
+ */
+static_fn int lock_slot() {
+    int slot = 0;
+    while (slot < _DIR_LOCK_SLOTS &&
+           try_lock_byte(F_WRLCK, _DIR_LOCK_SLOTS_POS + slot) < 0)
+        slot++;
+
+    if (slot == _DIR_LOCK_SLOTS) {
+        slot = (int)(getpid() % _DIR_LOCK_SLOTS);
+        if (lock_byte(F_WRLCK, _DIR_LOCK_SLOTS_POS + slot) < 0)
+            return -1;
+    }
+
+    proj_slot = slot;
+    slot_wal(slot, slot_wal_path);
+    txn_wal_path = slot_wal_path;
+    return 0;
+}
+
+/**
+ * @brief Make the project store hold a logged item, with its logged status
+ * @param rec Record of item in the log
+ * @return 0 on success
+ * @return -1 on error
+ * @note Records are redone in order, and redoing a record any number of times
+ * leaves the store as redoing it once does
+ */
+static_fn int redo_item(const struct wal_record *rec) {
+    assert(proj_store);
+
+    const int st = proj_store->item_status(rec->id);
+    int ret = 0;
+    if (st >= 0 && st != (int)rec->st) {
+        ret = proj_store->change_status(rec->id, rec->st);
+    } else if (st < 0) {
+        /* New, archived, or lost part way through a change of status */
+        item *itp = wal_record_to_item(rec);
+        ret = itp ? proj_store->append_item(itp) : -1;
+        item_free(itp);
+    }
+
+    /*
+     * Archived items are hidden once the store holds them, which may not
+     * have happened before an interruption
+     */
+    if (ret == 0 && (st < 0 || txn_recovering)) {
+        item *archived = archive_read_item(archive_path, rec->id);
+        if (archived)
+            ret = archive_revive(archive_path, rec->id, sync_replacement);
+        item_free(archived);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Redo the changes left in the log by an interrupted run, and clear it
+ * @note Changes that cannot be redone are dropped, so that they are never
+ * redone over later changes
+ */
+static_fn void recover_log() {
+    if (!items_left_changing())
+        return;
+
+    /* Each log holds changes to items no other log changes after it */
+    begin_items_write();
+    txn_applying = txn_recovering = 1;
+    int failed = wal_recover(wal_path, redo_item) < 0;
+    for (int slot = 0; slot < _DIR_LOCK_SLOTS; slot++) {
+        char path[MAX_PATH];
+        slot_wal(slot, path);
+        if (wal_recover(path, redo_item) < 0)
+            failed = 1;
+    }
+    txn_applying = txn_recovering = 0;
 
-    if (ret == -1) {
 #ifdef DEBUG
-        log_err("Could not create items directory");
+    if (failed)
+        log_err("Changes left in the log could not all be redone");
+#else
+    (void)failed;
+#endif
+    sync_batched_files();
+    wal_clear(wal_path);
+    for (int slot = 0; slot < _DIR_LOCK_SLOTS; slot++) {
+        char path[MAX_PATH];
+        slot_wal(slot, path);
+        wal_clear(path);
+    }
+    reset_items_writers();
+}
+
+/**
+ * @brief Redo the changes left in the logs of interrupted writers of records,
+ * whose slots are no longer held, and clear them
+ * @return 0 on success, including if no changes are left
+ * @return -1 on error
+ * @note Made once a record is locked, as its last change may be left in the
+ * log of a writer interrupted after holding it
+ */
+static_fn int recover_slots() {
+    int ret = 0, locked = 0;
+    for (int slot = 0; ret == 0 && slot < _DIR_LOCK_SLOTS; slot++) {
+        char path[MAX_PATH];
+        slot_wal(slot, path);
+        if (slot == proj_slot || !log_has_changes(path) ||
+            try_lock_byte(F_WRLCK, _DIR_LOCK_SLOTS_POS + slot) < 0)
+            continue;
+
+        if (!locked) {
+            ret = lock_structure(F_WRLCK);
+            locked = ret == 0;
+        }
+        if (ret == 0) {
+            /* Changes that cannot be redone are dropped, as by recover_log */
+            txn_applying = txn_recovering = 1;
+            if (wal_recover(path, redo_item) < 0) {
+#ifdef DEBUG
+                log_err("Changes left in a slot could not all be redone");
+#endif
+            }
+            txn_applying = txn_recovering = 0;
+            sync_batched_files();
+            ret = wal_clear(path);
+        }
+        lock_byte(F_UNLCK, _DIR_LOCK_SLOTS_POS + slot);
+    }
+
+    if (locked)
+        lock_structure(F_UNLCK);
+    return ret;
+}
+
+/**
+ * @brief Lock the record of an item while writing records, until the project
+ * is unlocked
+ * @param id ID of item
+ * @return 0 on success
+ * @return -1 on error, or if the record is locked by another writer once this
+ * writer holds other records, as writers waiting on each other never finish
+ */
+static_fn int lock_record(const sitem_id id) {
+    if (proj_lock_mode != DIR_LOCK_RECORDS)
+        return 0;
+
+    const off_t pos = _DIR_LOCK_RECORDS_POS + (off_t)id;
+    const int ret = num_locked_records == 0 ? lock_byte(F_WRLCK, pos)
+                                            : try_lock_byte(F_WRLCK, pos);
+    if (ret < 0) {
+#ifdef DEBUG
+        log_err("Item record is locked by another command");
 #endif
-        /*
-         * Function should only ever be called on new projects
-         * This might have other consequences down the road that I, frankly,
-         * don't want to think about right now
-         */
-        assert(errno != EEXIST);
         return -1;
     }
 
-    /* Open item storage files */
-    int file_creation = (create_file(backlog_path) + create_file(todo_path) +
-                         create_file(ip_path) + create_file(done_path));
+    num_locked_records++;
+    return recover_slots();
+}
 
-    if (file_creation != 0) {
+/**
+ * @brief Get the store holding the items of the project
+ * @return Store of the layout of the project, or the in-memory store once
+ * dir_use_memory_store is called
+ * @note Changes left in the log are redone before the store is first used,
+ * unless the project is locked shared or read optimistically, as they are
+ * then redone by dir_lock
+ */
+static_fn const struct store_ops *proj_items_store() {
+    if (!proj_store) {
+        proj_store = layout_store(dir_get_layout());
+        if (proj_lock_mode == DIR_LOCK_NONE ||
+            proj_lock_mode == DIR_LOCK_EXCLUSIVE)
+            recover_log();
+    }
+
+    return proj_store;
+}
+
+/**
+ * @brief Check whether the items of the project may be archived
+ * @return Non-zero unless items are held in memory, which are never archived
+ */
+static_fn int uses_archive() { return proj_items_store() != &memory_store; }
+
+/**
+ * @brief Check whether changes to the items of the project are logged
+ * @return Non-zero unless items are held in memory, which are never logged
+ */
+static_fn int uses_wal() { return proj_items_store() != &memory_store; }
+
+/**
+ * @brief Commit and apply the changes logged in the open transaction
+ * @return 0 on success, including if no changes are logged
+ * @return -1 on error, in which case the changes are left in the log if they
+ * were committed, to be redone by the next run
+ */
+static_fn int flush_txn() {
+    if (proj_txn.num_records == 0)
+        return 0;
+
+    /* One sync of the log commits every change of the transaction */
+    begin_items_write();
+    const int committed =
+        wal_commit(txn_wal_path, &proj_txn, sync_replacement) == 0;
+    int ret = committed ? 0 : -1;
+    if (committed) {
+        /* Writers of records apply their changes one at a time */
+        ret = lock_structure(F_WRLCK);
+        if (ret == 0) {
+            txn_applying = 1;
+            ret = wal_apply(&proj_txn, redo_item) < 0 ? -1 : 0;
+            txn_applying = 0;
+            lock_structure(F_UNLCK);
+        }
+
+        /* Each file written is synced once, before the log is cleared */
+        sync_batched_files();
+        if (ret == 0)
+            ret = wal_clear(txn_wal_path);
+    }
+
+    /* Changes left in the log are still being made until they are redone */
+    if (ret == 0 || !committed)
+        end_items_write();
+
+    wal_free_txn(&proj_txn);
+    return ret;
+}
+
+/**
+ * @brief Log a changed item in the open transaction, or commit it at once if
+ * no transaction is open
+ * @param itp Item as it is once changed
+ * @return 0 on success
+ * @return -1 on error
+ */
+static_fn int log_item(const item *itp) {
+    if (wal_log_item(&proj_txn, itp) < 0)
+        return -1;
+
+    return txn_open ? 0 : flush_txn();
+}
+
+/**
+ * @brief Record the name of a project setting in its setting file, replacing
+ * the file atomically
+ * @param setting_path Path of setting file
+ * @param name Null-terminated name of setting value
+ * @return 0 on success
+ * @return -1 on error, the setting file is unchanged
+ */
+static_fn int write_setting(const char *setting_path, const char *name) {
+    assert(setting_path);
+    assert(name);
+
+    char tmp_path[MAX_PATH];
+    snprintf(tmp_path, sizeof(tmp_path), "%.*s.tmp", MAX_PATH - 5,
+             setting_path);
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC,
+                  CONF_DIR_PERMS & 0666);
+    if (fd < 0)
+        return -1;
+
+    char setting_entry[_DIR_SETTING_NAME_MAX + _DIR_ITEM_DELIM_LEN + 1];
+    const int b = snprintf(setting_entry, sizeof(setting_entry), "%s%s",
+                           name, _DIR_ITEM_DELIM);
+
+    int ret = pwrite_all(fd, setting_entry, b, 0);
+    if (ret == 0)
+        ret = sync_replacement(fd);
+    close(fd);
+    if (ret == 0)
+        ret = rename(tmp_path, setting_path);
+
+    if (ret != 0) {
 #ifdef DEBUG
-        log_err("Could not create item storage files");
+        log_err("Setting file could not be written");
 #endif
+        unlink(tmp_path);
         return -1;
     }
 
@@ -117,79 +698,132 @@ static_fn int create_items() {
 }
 
 /**
- * @brief Open all item files in items directory and populate item_fds array.
- * @param flags open function flags
- * @param item_fds Array of file descriptors to write open item file
- * descriptors to
- * @note Can only support 'simple' flags that do not require extra arguments,
- * i.e. O_WRONLY or O_RDWR
- * @note Errors with open are not handled
- * @see open
- * @see close_items
+ * @brief Read the name of a project setting from its setting file
+ * @param setting_path Path of setting file
+ * @param name Buffer to write the null-terminated name to
+ * @return 0 on success
+ * @return -1 if the setting file is missing or empty
  */
-static_fn void open_items(const int flags, int item_fds[_DIR_ITEM_NUM_FILES]) {
-    assert(strlen(items_path) >=
-           sizeof(CONF_PROJ_DIR) + sizeof(_DIR_ITEM_PATH_D) - 1);
+static_fn int read_setting(const char *setting_path,
+                           char name[_DIR_SETTING_NAME_MAX + 1]) {
+    assert(setting_path);
+    assert(name);
 
-    if (!item_fds)
-        return;
+    memset(name, '\0', _DIR_SETTING_NAME_MAX + 1);
+
+    int fd = open(setting_path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    const ssize_t b = read(fd, name, _DIR_SETTING_NAME_MAX);
+    close(fd);
+
+    if (b <= 0)
+        return -1;
+
+    name[strcspn(name, _DIR_ITEM_DELIM)] = '\0';
+    return 0;
+}
+
+/**
+ * @brief Record the layout of item storage in the layout file, replacing the
+ * file atomically
+ * @param new_layout Layout of item storage
+ * @return 0 on success
+ * @return -1 on error, the layout file is unchanged
+ */
+static_fn int write_layout(const enum dir_layout new_layout) {
+    assert(new_layout < DIR_LAYOUT_COUNT);
+
+    if (write_setting(layout_path, dir_layout_name(new_layout)) < 0)
+        return -1;
+
+    proj_layout = new_layout;
+    return 0;
+}
 
-    item_fds[0] = open(backlog_path, flags);
-    item_fds[1] = open(todo_path, flags);
-    item_fds[2] = open(ip_path, flags);
-    item_fds[3] = open(done_path, flags);
+/**
+ * @brief Read the layout of item storage from the layout file
+ * @return Layout of item storage
+ * @note Projects created before item storage layouts existed have no layout
+ * file and are stored in DIR_LAYOUT_FILES
+ */
+static_fn enum dir_layout read_layout() {
+    char layout_name[_DIR_SETTING_NAME_MAX + 1];
+    if (read_setting(layout_path, layout_name) < 0)
+        return DIR_LAYOUT_FILES;
 
-    if (errno == ENOTDIR) {
-        puts("No project listed");
+    const int named_layout = dir_layout_from_name(layout_name);
+    if (named_layout < 0) {
 #ifdef DEBUG
-        log_err("open_items called with incorrect path");
+        log_err("Unknown layout in layout file");
 #endif
+        return DIR_LAYOUT_FILES;
     }
+
+    return (enum dir_layout)named_layout;
 }
 
 /**
- * @brief Close all item file descriptors opened by open_items
- * @param item_fds Array of file descriptors of item files
- * @note Errors with close are not handled
- * @see open
- * @see open_items
+ * @brief Read the durability mode of the project, which the environment
+ * variable DIR_DURABILITY_ENV overrides
+ * @return Durability mode
+ * @note Projects without a durability file use DIR_DURABILITY_FDATASYNC
  */
-static_fn void close_items(const int item_fds[_DIR_ITEM_NUM_FILES]) {
-    if (!item_fds)
-        return;
+static_fn enum dir_durability read_durability() {
+    const char *env_name = getenv(DIR_DURABILITY_ENV);
+    if (env_name && *env_name) {
+        const int env_durability = dir_durability_from_name(env_name);
+        if (env_durability >= 0)
+            return (enum dir_durability)env_durability;
+#ifdef DEBUG
+        log_err("Unknown durability mode in environment, ignoring");
+#endif
+    }
 
-    for (int i = 0; i < _DIR_ITEM_NUM_FILES; i++) {
-        close(item_fds[i]);
+    char durability_name[_DIR_SETTING_NAME_MAX + 1];
+    if (read_setting(durability_path, durability_name) < 0)
+        return DIR_DURABILITY_FDATASYNC;
+
+    const int named_durability = dir_durability_from_name(durability_name);
+    if (named_durability < 0) {
+#ifdef DEBUG
+        log_err("Unknown durability mode in durability file");
+#endif
+        return DIR_DURABILITY_FDATASYNC;
     }
+
+    return (enum dir_durability)named_durability;
 }
 
 /**
- * @brief Open file descriptor associated with the items with status st, using
- * flags
- * @param st Status of items to open file descriptor for
- * @param flags Open flags
- * @return open file descriptor
+ * @brief creates items directory and the files storing items in a given
+ * layout, file descriptors are closed immediately if creation is successful
+ * @param layout Layout of item storage
+ * @return 0 on success
  * @return -1 on error
- * @see open
- * @see open_items in the case *all* project items need to be opened/visible
+ * @see open, close, mkdir
  */
-static_fn int open_items_status(enum status st, int flags) {
-    switch (st) {
-    case BACKLOG:
-        return open(backlog_path, flags);
-    case TODO:
-        return open(todo_path, flags);
-    case IN_PROG:
-        return open(ip_path, flags);
-    case DONE:
-        return open(done_path, flags);
-    default:
+static_fn int create_items(const enum dir_layout layout) {
+    setup_path_names(NULL);
+
+    /* Create directory */
+    int ret = mkdir(items_path, CONF_DIR_PERMS);
+
+    if (ret == -1) {
 #ifdef DEBUG
-        log_err("Unknown item state being requested for read");
+        log_err("Could not create items directory");
 #endif
-        break;
+        /*
+         * Function should only ever be called on new projects
+         * This might have other consequences down the road that I, frankly,
+         * don't want to think about right now
+         */
+        assert(errno != EEXIST);
+        return -1;
     }
-    return -1;
+
+    return layout_store(layout)->create();
 }
 
 /*
@@ -350,7 +984,11 @@ void dir_construct_path(const char *const path, const char *base, char *buf,
     strncat(buf, base, max - strlen(buf));
 }
 
-int dir_init(const char *path) {
+int dir_init(const char *path, const enum dir_layout new_layout,
+             const enum dir_durability new_durability) {
+    assert(new_layout < DIR_LAYOUT_COUNT);
+    assert(new_durability < DIR_DURABILITY_COUNT);
+
     /* No absolute paths permitted */
     assert(*path != '/');
     assert(*path != '~');
@@ -363,13 +1001,20 @@ int dir_init(const char *path) {
     /* Set global variables */
     setup_path_names(path);
 
+    /* Files of the new project are written in its own durability mode */
+    proj_durability = new_durability;
+
     /* Items */
-    ret = create_items();
+    ret = create_items(new_layout);
 
-    int file_creation = create_file(next_id_path);
+    int file_creation = (write_layout(new_layout) < 0);
+    file_creation += (write_setting(durability_path,
+                                    dir_durability_name(new_durability)) < 0);
+    file_creation += create_file(next_id_path);
     dir_next_id(); /* Initialise ID */
 
     file_creation += create_file(listed_codes_path);
+    file_creation += create_file(code_index_path);
     file_creation += create_file(item_dependencies);
 
     /* Check file creation */
@@ -383,172 +1028,79 @@ int dir_init(const char *path) {
     return ret;
 }
 
-/**
- * @brief Read an item entry and return all readable data in a freshly
- * allocated item.
- * @param entry Single entry representing item
- * @return Pointer to new item
- * @return NULL in case of error
- * @note Any data that cannot be ascertained from the entry will correspond
- * @see free
- */
-item *entry_to_item(const char entry[DIR_ITEM_ENTRY_LEN + 1]) {
-    item *item = item_init();
-    size_t pos_in_entry = 0;
-    /* Each step *may* be abstracted in the future for clarity */
+int dir_layout_from_name(const char *name) {
+    assert(name);
 
-    /*
-     * Parse item ID:
-     * Delimiter is guaranteed not to be a valid hex digit
-     */
-    const char *id = &entry[pos_in_entry];
-    item->item_id = (sitem_id)strtoll(id, NULL, 16);
-    pos_in_entry += HEX_LEN(sitem_id) + _DIR_ITEM_FIELD_DELIM_LEN;
+    const char *const names[DIR_LAYOUT_COUNT] = _DIR_LAYOUT_NAMES;
 
-    /*
-     * Parse item code
-     */
-    const char *code = &entry[pos_in_entry];
-    memcpy(item->item_code, code, ITEM_CODE_LEN);
-    pos_in_entry += ITEM_CODE_LEN + _DIR_ITEM_FIELD_DELIM_LEN;
+    for (int i = 0; i < DIR_LAYOUT_COUNT; i++) {
+        if (strcmp(name, names[i]) == 0)
+            return i;
+    }
 
-    /*
-     * Parse item name
-     */
-    const char *name = &entry[pos_in_entry];
-    /* pos_in_entry does not change; name is guaranteed to be the last field */
+    return -1;
+}
 
-    int name_len = ITEM_NAME_MAX;
+const char *dir_layout_name(const enum dir_layout layout) {
+    assert(layout < DIR_LAYOUT_COUNT);
 
-    /* Find true length of name, without filling spaces */
-    for (int i = ITEM_NAME_MAX - 1; i > 0; i--) {
-        if (name[i] != ' ') { /* Filler character is ' ' will not be modified */
-            name_len = i + 1;
-            break;
-        }
-    }
+    static const char *const names[DIR_LAYOUT_COUNT] = _DIR_LAYOUT_NAMES;
+    return names[layout];
+}
 
-    /* See item_set_name_deep for null termination expectations */
-    item_set_name_deep(item, name, name_len);
+enum dir_layout dir_get_layout() {
+    setup_path_names(NULL);
 
-    return item;
+    if (proj_layout == DIR_LAYOUT_COUNT)
+        proj_layout = read_layout();
+
+    return proj_layout;
 }
 
-/**
- * @brief Read item at an offset from fd as a new item struct
- * @param entry_off Offset of entry
- * @param fd File descriptor of file of item entries in regular format
- * @return item with data in entries file, heap allocated
- * @note entry_off must be the offset of the *first* byte of the item entry
- */
-static_fn item *fd_read_item_at(int fd, off_t entry_off) {
-    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
-    assert(entry_off >= 0);
+int dir_durability_from_name(const char *name) {
+    assert(name);
 
-    char entry[DIR_ITEM_ENTRY_LEN + 1];
-    entry[DIR_ITEM_ENTRY_LEN] = '\0';
+    const char *const names[DIR_DURABILITY_COUNT] = _DIR_DURABILITY_NAMES;
 
-    if (pread(fd, entry, DIR_ITEM_ENTRY_LEN, entry_off) < 0) {
-        return NULL;
+    for (int i = 0; i < DIR_DURABILITY_COUNT; i++) {
+        if (strcmp(name, names[i]) == 0)
+            return i;
     }
 
-    item *it = entry_to_item(entry);
+    return -1;
+}
+
+const char *dir_durability_name(const enum dir_durability durability) {
+    assert(durability < DIR_DURABILITY_COUNT);
 
-    return it;
+    static const char *const names[DIR_DURABILITY_COUNT] =
+        _DIR_DURABILITY_NAMES;
+    return names[durability];
 }
 
-/**
- * @brief Get the total number of entries found in the file descriptor
- * @param fd File descriptor of entries (of any data)
- * @return Number of entries expected in fd
- * @return -1 on error
- * @note File contents are not read and thus, no entries can be verified
- */
-static_fn int fd_total_items(const int fd, int entry_len) {
-    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+enum dir_durability dir_get_durability() {
+    setup_path_names(NULL);
 
-    /* Use stat */
-    struct stat sb;
-    if (fstat(fd, &sb) < 0)
-        return -1;
+    if (proj_durability == DIR_DURABILITY_COUNT)
+        proj_durability = read_durability();
 
-    return sb.st_size / entry_len;
+    return proj_durability;
 }
 
 int dir_total_items() {
     setup_path_names(NULL);
 
-    /* Open and check item file descriptors */
-    int item_fds[_DIR_ITEM_NUM_FILES];
-
-    open_items(O_RDONLY, item_fds);
-
-    for (int i = 0; i < _DIR_ITEM_NUM_FILES; i++) {
-        if (item_fds[i] < 0) {
-#ifdef DEBUG
-            log_err("Could not open item file for reading");
-#endif
-            return -1;
+    for (int attempt = 0;; attempt++) {
+        const uint64_t gen = dir_read_begin(attempt);
+        int num_items = proj_items_store()->total_items();
+        if (num_items >= 0 && uses_archive()) {
+            const int num_archived = archive_total_items(archive_path);
+            num_items = num_archived < 0 ? -1 : num_items + num_archived;
         }
-    }
-
-    int num_items = 0;
 
-    /* Read entries by examining file sizes of all item files */
-    for (int i = 0; i < _DIR_ITEM_NUM_FILES; i++) {
-        num_items += fd_total_items(item_fds[i], DIR_ITEM_ENTRY_LEN);
+        if (!dir_read_changed(gen))
+            return num_items;
     }
-
-    close_items(item_fds);
-
-    return num_items;
-}
-
-/**
- * @brief Search for an entry with matching raw field data at a given position
- * in the entry given an open, readable file descriptor
- * @param fd Open file descriptor with the ability to read
- * @param entry_len Length of each entry in the file
- * @param pos_in_entry Position in entry (this effectively provides the field
- * being compared)
- * @param data Pointer to data expected in entry (does not have to be
- * null-terminated)
- * @param delim The delimiter to use to compare data to
- * @return Offset of matching entry in file fd
- * @return -1 if no matching entry exists
- * @note Returns the *first instance* where the field data matches the data
- * provided, be cautious (in fact, completely avoid) for fields which are not
- * necessarily unique.
- * @see dir.h For field positions in different entry formats
- * @see fd_search_for_entry_id For more efficient ID-based *item* searching
- */
-static_fn off_t fd_find_entry_with_data(int fd, size_t entry_len,
-                                        off_t pos_in_entry, const char *data,
-                                        const char *delim) {
-    assert(fcntl(fd, F_GETFD) != -1);
-    const int flags = fcntl(fd, F_GETFL) & O_ACCMODE;
-    assert(flags == O_RDWR || flags == O_RDONLY);
-    assert(data);
-    assert(pos_in_entry >= 0);
-
-    int total_entries = fd_total_items(fd, entry_len);
-
-    char curr_entry[entry_len + 1];
-    int entry_found = 1;
-
-    /* Read linearly */
-    for (int i = 0; i < total_entries; i++) {
-        entry_found = 1;
-        pread(fd, curr_entry, sizeof(curr_entry) - 1, i * entry_len);
-        /* Compare field data until next delimiter */
-        char *start_cmp = curr_entry + pos_in_entry;
-        char *end_cmp = strstr(start_cmp, delim);
-        entry_found = strncmp(start_cmp, data, (end_cmp - start_cmp)) == 0;
-        if (entry_found) { /* Matched field data */
-            return i * entry_len;
-        }
-    }
-    return -1;
 }
 
 /**
@@ -584,6 +1136,9 @@ static_fn sitem_id increment_next_id(int fd_next_id) {
 
     ftruncate(fd_next_id, HEX_LEN(sitem_id));
 
+    /* A lost increment would hand out the same ID again after a crash */
+    sync_written(fd_next_id, next_id_path);
+
     return curr_id;
 }
 
@@ -611,62 +1166,87 @@ sitem_id dir_next_id() {
         return ret;
     }
 
-    /* Increment next available ID */
+    /* Increment next available ID, which writers of records do in turn */
+    if (lock_structure(F_WRLCK) < 0) {
+        close(fd_id);
+        return -2;
+    }
     sitem_id curr_id = increment_next_id(fd_id);
+    lock_structure(F_UNLCK);
 
     close(fd_id);
     return curr_id;
 }
 
-int dir_contains_item_with_id(sitem_id id) {
+int dir_name_max() {
     setup_path_names(NULL);
-    if (id < 0)
-        return 0;
 
-    int item_fds[_DIR_ITEM_NUM_FILES];
-    open_items(O_RDONLY, item_fds);
-    char id_str[HEX_LEN(sitem_id) + 1];
-    snprintf(id_str, sizeof(id_str), "%0*X", (int)HEX_LEN(sitem_id), id);
-    for (int i = 0; i < _DIR_ITEM_NUM_FILES; i++) {
-        if (fd_find_entry_with_data(item_fds[i], DIR_ITEM_ENTRY_LEN, 0, id_str,
-                                    _DIR_ITEM_FIELD_DELIM) >= 0) {
-            return 1;
-        }
-    }
-    return 0;
+    /* Archived records are table entries, whatever the store */
+    const int store_max = proj_items_store()->name_max;
+    if (uses_archive() && (store_max == 0 || store_max > ITEM_NAME_MAX))
+        return ITEM_NAME_MAX;
+    return store_max;
 }
 
 item **dir_read_items_status(enum status st) {
     setup_path_names(NULL);
 
-    const int rd_flags = O_RDONLY;
-    int fd = open_items_status(st, rd_flags);
-    if (fd == -1)
-        return NULL;
+    for (int attempt = 0;; attempt++) {
+        const uint64_t gen = dir_read_begin(attempt);
+        item **items = proj_items_store()->read_items_status(st);
+        if (!dir_read_changed(gen))
+            return items;
 
-    int total_items = fd_total_items(fd, DIR_ITEM_ENTRY_LEN);
-    item **items = (item **)malloc(sizeof(item *) * (total_items + 1));
-    if (!items)
-        return NULL;
+        if (items)
+            item_array_free(&items, SIZE_MAX);
+    }
+}
+
+/**
+ * @brief Read all items in project, in order of status
+ * @param with_archive Non-zero to include archived items, ahead of the done
+ * items of the item store
+ * @return Pointer to an array of items allocated on the heap
+ * @return NULL on error
+ */
+static_fn item **read_items(const int with_archive) {
+    item **items_by_st[ITEM_STATUS_COUNT] = {NULL};
+    item **archived = NULL;
+    size_t total_items = 0;
 
-    char item_entry[DIR_ITEM_ENTRY_LEN + 1];
+    /* Each status file is loaded exactly once */
+    for (int i = 0; i < ITEM_STATUS_COUNT; i++) {
+        items_by_st[i] = dir_read_items_status((enum status)i);
+        total_items += item_count_items(items_by_st[i]);
+    }
+    if (with_archive && uses_archive()) {
+        archived = archive_read_items(archive_path);
+        total_items += item_count_items(archived);
+    }
+
+    /* Array of items */
+    item **items = item_array_init_empty(total_items);
 
-    for (int i = 0; i < total_items; i++) {
-        if (pread(fd, item_entry, sizeof(item_entry), i * DIR_ITEM_ENTRY_LEN) <
-            0) {
+    if (!items || (with_archive && uses_archive() && !archived)) {
 #ifdef DEBUG
-            if (errno == EINVAL)
-                log_err("Attempting to read beyond items file");
+        log_err("read_items: malloc call failed, check item entries");
 #endif
-            break; /* Could not read for some reason -- this is ignored */
+        for (int i = 0; i < ITEM_STATUS_COUNT; i++) {
+            if (items_by_st[i])
+                item_array_free(&items_by_st[i], SIZE_MAX);
         }
-        item_entry[DIR_ITEM_ENTRY_LEN] = '\0'; /* Not done by pread */
-        items[i] = entry_to_item(item_entry);  /* Parse entry data */
-        items[i]->item_st = st;                /* Set status */
+        if (archived)
+            item_array_free(&archived, SIZE_MAX);
+        free(items);
+        return NULL;
     }
 
-    /* NULL terminate */
-    items[total_items] = NULL;
+    /* Concatenate in status order, the pointer arrays are freed */
+    for (int i = 0; i < ITEM_STATUS_COUNT; i++) {
+        if (i == DONE && archived)
+            item_array_add(items, &archived, SIZE_MAX);
+        item_array_add(items, &items_by_st[i], SIZE_MAX);
+    }
 
     return items;
 }
@@ -674,464 +1254,631 @@ item **dir_read_items_status(enum status st) {
 item **dir_read_all_items() {
     setup_path_names(NULL);
 
-    int total_items = dir_total_items();
-    /* Array of items */
-    item **items = item_array_init_empty(total_items);
+    for (int attempt = 0;; attempt++) {
+        const uint64_t gen = dir_read_begin(attempt);
+        item **items = read_items(1);
+        if (!dir_read_changed(gen)) {
+            if (!items)
+                puts("Could not read any items");
+            return items;
+        }
 
-    if (!items) {
-        puts("Could not read any items");
-#ifdef DEBUG
-        log_err("dir_read_all_items: malloc call failed, check item entries");
-#endif
-        return NULL;
+        if (items)
+            item_array_free(&items, SIZE_MAX);
     }
+}
+
+int dir_view_open(struct dir_item_view *view, const enum status *sts,
+                  int num_sts) {
+    assert(view);
+    assert(sts);
+    assert(num_sts >= 0 && num_sts <= ITEM_STATUS_COUNT);
+
+    setup_path_names(NULL);
 
-    unsigned int items_read = 0;
+    for (int attempt = 0;; attempt++) {
+        const uint64_t gen = dir_read_begin(attempt);
 
-    /* Iterate for all status types */
+        memset(view, 0, sizeof(*view));
+        memcpy(view->sts, sts, num_sts * sizeof(*sts));
+        view->num_sts = num_sts;
+        view->store = proj_items_store();
+
+        /*
+         * Files are not mapped while read optimistically, so views hold a
+         * copy of the entries they were opened with
+         */
+        const int num_entries = view->store->view_open(view);
+        const int changed = dir_read_changed(gen);
+        if (num_entries < 0 || changed)
+            dir_view_close(view);
+        if (!changed)
+            return num_entries;
+    }
+}
+
+const struct dir_item_ref *dir_view_next(struct dir_item_view *view) {
+    assert(view);
+
+    /* Closed views have no statuses left to iterate */
+    if (!view->store || view->curr_st >= view->num_sts)
+        return NULL;
+
+    return view->store->view_next(view);
+}
+
+void dir_view_close(struct dir_item_view *view) {
+    if (!view)
+        return;
+
+    /* Stores may use buffers beyond num_sts, empty buffers are skipped */
     for (int i = 0; i < ITEM_STATUS_COUNT; i++) {
-        item **items_of_same_st = dir_read_items_status((enum status)i);
+        free_entry_buf(&view->bufs[i]);
+    }
+    view->num_sts = 0;
+}
 
-        /* Copy NULL-terminated pointer array to total collection */
-        for (size_t j = 0; (items[items_read] = items_of_same_st[j]) != NULL;
-             j++) {
-            items[items_read]->item_st = (enum status)i; /* Set status */
-            items_read++;
+int dir_item_status_id(sitem_id id) {
+    setup_path_names(NULL);
+    if (id < 0)
+        return -1;
+
+    /* Changes in the open transaction are seen before they are applied */
+    struct wal_record rec;
+    if (wal_find_item(&proj_txn, id, &rec) == 0)
+        return rec.st;
+
+    for (int attempt = 0;; attempt++) {
+        const uint64_t gen = dir_read_begin(attempt);
+        int st = proj_items_store()->item_status(id);
+        if (st < 0 && uses_archive()) {
+            /* Only done items are archived */
+            item *itp = archive_read_item(archive_path, id);
+            st = itp ? DONE : -1;
+            item_free(itp);
         }
 
-        free(items_of_same_st);
+        if (!dir_read_changed(gen))
+            return st;
     }
+}
 
-    return items;
+int dir_contains_item_with_id(sitem_id id) {
+    return dir_item_status_id(id) >= 0;
 }
 
-/**
- * @brief Write an item entry to buf
- * @param itp Pointer to item to parse data of
- * @param buf Buffer to place data
- * @note Resulting data in buf is null-terminated and guaranteed to at the last
- * position
- */
-static_fn void make_item_entry(const item *const itp,
-                               char buf[DIR_ITEM_ENTRY_LEN + 1]) {
-    /* Field delimiter */
-    const char delim[_DIR_ITEM_FIELD_DELIM_LEN + 1] = _DIR_ITEM_FIELD_DELIM;
-    /* Item terminator */
-    const char term[_DIR_ITEM_DELIM_LEN + 1] = _DIR_ITEM_DELIM;
+item *dir_get_item_with_id(sitem_id id) {
+    setup_path_names(NULL);
+    if (id < 0)
+        return NULL;
+
+    struct wal_record rec;
+    if (wal_find_item(&proj_txn, id, &rec) == 0)
+        return wal_record_to_item(&rec);
+
+    for (int attempt = 0;; attempt++) {
+        const uint64_t gen = dir_read_begin(attempt);
+        item *itp = proj_items_store()->read_item(id);
+        if (!itp && uses_archive())
+            itp = archive_read_item(archive_path, id);
+
+        if (!dir_read_changed(gen))
+            return itp;
+        item_free(itp);
+    }
+}
+
+int dir_append_item(const item *it) {
+    assert(it != NULL);
+    setup_path_names(NULL);
 
-    /* Bytes printed to buf */
-    int b = 0;
-
-    /* Parse item data */
-    b = snprintf(buf, DIR_ITEM_ENTRY_LEN + 1, "%0*X%s%.*s%s%-*s%s",
-                 /* Width and value of ID */
-                 (int)HEX_LEN(sitem_id), itp->item_id, delim, ITEM_CODE_LEN,
-                 itp->item_code, delim, ITEM_NAME_MAX,
-                 itp->item_name, /* Name */
-                 term);
-
-    /* Handle errors */
-    if ((size_t)b < DIR_ITEM_ENTRY_LEN) {
-        printf("Unable to save item, names must be less than %d characters\n",
-               ITEM_NAME_MAX);
+    /* A name that cannot be saved must not reach the log */
+    const int name_max = dir_name_max();
+    if (name_max > 0 && strlen(it->item_name) > (size_t)name_max)
+        return -1;
+
+    if (!uses_wal())
+        return proj_items_store()->append_item(it);
+
+    if (dir_item_status_id(it->item_id) >= 0 || log_item(it) < 0)
+        return -1;
+
+    /* The index is only a hint, so items are added without it if need be */
+    if (lock_structure(F_WRLCK) == 0) {
+        if (code_index_add(code_index_path, it, sync_replacement) < 0) {
 #ifdef DEBUG
-        log_err("make_item_entry could not parse item data correctly");
+            log_err("Item code could not be added to the code index");
 #endif
+        }
+        lock_structure(F_UNLCK);
     }
+    return 0;
 }
 
-/**
- * @brief Helper for fd_search_for_entry_id -- does not assert invariants and is
- * therefore potentially dangerous to use in other contexts
- * @return >= 0 offset if item found
- * @return < 0 offset if item is not found - position of where it *should* be
- * @note Does not deal with empty file case
- */
-static_fn off_t _fd_bin_search_entry_id(const int fd, const sitem_id target,
-                                        off_t start, off_t end) {
-    off_t middle = (start + end) / 2 -
-                   /* Align to item entry offset */
-                   (((start + end) / 2) % DIR_ITEM_ENTRY_LEN);
+int dir_compact_items() {
+    setup_path_names(NULL);
+
+    if (flush_txn() < 0)
+        return -1;
+
+    if (lock_structure(F_WRLCK) < 0)
+        return -1;
+    begin_items_write();
+    const int ret = proj_items_store()->compact();
+    end_items_write();
+
+    /* The code index is rebuilt from every item, archived or not */
+    item **items = uses_archive() ? read_items(1) : NULL;
+    if (items) {
+        if (code_index_write(code_index_path, items, sync_replacement) < 0) {
+#ifdef DEBUG
+            log_err("Code index could not be rebuilt");
+#endif
+        }
+        item_array_free(&items, SIZE_MAX);
+    }
+
+    lock_structure(F_UNLCK);
+    return ret;
+}
 
-    /* This may cause some overhead in *very* large projects; future concern */
-    item *start_item = fd_read_item_at(fd, start);
-    item *mid_item = fd_read_item_at(fd, middle);
-    item *end_item = fd_read_item_at(fd, end);
+int dir_change_item_status_id(const sitem_id id, const enum status new_status) {
+    assert(new_status < ITEM_STATUS_COUNT); /* Validate status */
 
-    sitem_id sid = start_item->item_id;
-    sitem_id mid = mid_item->item_id;
-    sitem_id eid = end_item->item_id;
+    setup_path_names(NULL);
 
-    item_free(start_item);
-    item_free(mid_item);
-    item_free(end_item);
+    if (id < 0)
+        return -1;
 
-    /* Found cases */
-    if (sid == target)
-        return start;
-    if (eid == target)
-        return end;
-    if (start == end && sid == target)
-        return start;
+    if (!uses_wal())
+        return proj_items_store()->change_status(id, new_status);
 
-    /* 'Out of bounds' cases */
-    if (sid > target) {
-        if (start == 0)
-            return OFF_T_MIN; /* "-0" case */
-        return -start;
-    }
-    if (eid < target) {
-        return -(end + DIR_ITEM_ENTRY_LEN);
-    }
-    if (end - start == DIR_ITEM_ENTRY_LEN) {
-        /* Item should be between two others */
-        return -end;
+    /* Archived items are moved back to the store as the change is redone */
+    item *itp = lock_record(id) == 0 ? dir_get_item_with_id(id) : NULL;
+    int ret = itp && itp->item_st != new_status ? 0 : -1;
+    if (ret == 0) {
+        itp->item_st = new_status;
+        ret = log_item(itp);
     }
 
-    if (mid < target)
-        start = middle;
-    else
-        end = middle;
+    item_free(itp);
+    return ret;
+}
+
+int dir_migrate(const enum dir_layout new_layout) {
+    assert(new_layout < DIR_LAYOUT_COUNT);
+
+    setup_path_names(NULL);
+
+    /* Items held in memory belong to no layout */
+    if (proj_items_store() == &memory_store || flush_txn() < 0)
+        return -1;
+
+    const enum dir_layout old_layout = dir_get_layout();
+    if (new_layout == old_layout)
+        return 0;
+
+    item **items = read_items(0);
+    if (!items)
+        return -1;
+    const int num_items = (int)item_count_items(items);
 
-    return _fd_bin_search_entry_id(fd, target, start, end);
-}
+    /* Items stay in the old layout until the layout file is replaced */
+    begin_items_write();
+    const struct store_ops *new_store = layout_store(new_layout);
+    int ret = new_store->create();
+    if (ret == 0)
+        ret = new_store->write_items(items);
+    if (ret == 0)
+        ret = write_layout(new_layout);
 
-/**
- * @brief Search for an entry in a file, regardless of whether it exists or not
- * @param fd Open file descriptor
- * @param target_id Target item ID to find
- * @return >= 0: offset of location of item with target_id in fd;
- * @return < 0: offset of location that an item with target_id *would be*,
- * since "-0" is obviously indistinguishable from 0, OFF_T_MIN represents a
- * 'would-be' insertion offset of 0; this is always returned for an empty file.
- * @return -1 on error (guaranteed not to align with a valid 'negative offset'
- */
-static_fn off_t fd_search_for_entry_id(const int fd, const sitem_id target_id) {
-    /* Conduct binary search on open fd */
-    assert(fcntl(fd, F_GETFD) != -1);
-    int flags = fcntl(fd, F_GETFL) & O_ACCMODE;
+    item_array_free(&items, SIZE_MAX);
 
-    if (flags != O_RDWR && flags != O_RDONLY) {
+    if (ret != 0) {
 #ifdef DEBUG
-        log_err("Incorrect fd flag provided");
+        log_err("Items could not be migrated to new layout");
 #endif
+        new_store->remove();
+        end_items_write();
         return -1;
     }
-    if (target_id < 0)
-        return -1;
 
-    off_t last_off =
-        (fd_total_items(fd, DIR_ITEM_ENTRY_LEN) - 1) * DIR_ITEM_ENTRY_LEN;
-
-    /* Empty file */
-    if (last_off < 0)
-        return OFF_T_MIN;
-
-    /* Commence search on whole file */
-    return _fd_bin_search_entry_id(fd, target_id, 0, last_off);
+    proj_items_store()->remove();
+    proj_store = new_store;
+    end_items_write();
+    return num_items;
 }
 
 /**
- * @brief Find item with matching field data in project
- * @param pos_in_entry Position in entry expected
- * @param data Raw data expected in entry
- * @return Pointer to heap allocated item with corresponding data
- * @return NULL if item cannot be found
+ * @brief Open the lock file if not yet open, and map the generation of items
+ * it holds
+ * @return 0 on success
+ * @return -1 on error
  */
-static_fn item *find_item_matching_field(const off_t pos_in_entry,
-                                         const char *data) {
-    int item_fds[_DIR_ITEM_NUM_FILES];
-
-    item *itp = NULL;
-
-    open_items(O_RDONLY, item_fds);
+static_fn int open_lock_file() {
+    if (proj_lock_fd >= 0)
+        return 0;
 
-    for (int i = 0; i < ITEM_STATUS_COUNT; i++) {
-        if (item_fds[i] < 0) {
-#ifdef DEBUG
-            log_err("Could not open item files for reading and writing");
-#endif
-            return itp;
-        }
+    proj_lock_fd = open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC,
+                        CONF_DIR_PERMS & 0666);
+    if (proj_lock_fd < 0)
+        return -1;
 
-        off_t item_offset = fd_find_entry_with_data(
-            item_fds[i], DIR_ITEM_ENTRY_LEN, pos_in_entry,
-            /* Will not work with *last* field */
-            data, _DIR_ITEM_FIELD_DELIM);
-        if (item_offset >= 0) {
-            char correct_entry[DIR_ITEM_ENTRY_LEN + 1];
-            if (pread(item_fds[i], correct_entry, DIR_ITEM_ENTRY_LEN,
-                      item_offset) < 0)
-                return NULL;
-            itp = entry_to_item(correct_entry);
-        }
-        if (itp)
-            break;
+    /* New lock files are extended to hold a generation, starting at 0 */
+    struct stat sb;
+    void *map = MAP_FAILED;
+    if (fstat(proj_lock_fd, &sb) == 0 &&
+        (sb.st_size >= (off_t)_DIR_LOCK_GEN_LEN ||
+         ftruncate(proj_lock_fd, _DIR_LOCK_GEN_LEN) == 0))
+        map = mmap(NULL, _DIR_LOCK_GEN_LEN, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   proj_lock_fd, 0);
+    if (map == MAP_FAILED) {
+        close(proj_lock_fd);
+        proj_lock_fd = -1;
+        return -1;
     }
 
-    close_items(item_fds);
-
-    return itp;
+    proj_gen = map;
+    return 0;
 }
 
-/**
- * @brief Swap item entries in a file of item entries opened with fd
- * @param fd File descriptor of open file of item entries
- * @param off_a First given offset of entry to swap
- * @param off_b Second given offset of entry to swap
- * @return 0 on success
- * @return -1 if offsets are incorrect or in case of some other error
- * @note Handles case where off_a == off_b
- */
-static_fn int fd_swap_item_entries_at(const int fd, const off_t off_a,
-                                      const off_t off_b) {
-    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+int dir_lock(const enum dir_lock_mode mode) {
+    setup_path_names(NULL);
+
+    if (mode == DIR_LOCK_NONE)
+        return 0;
 
-    /* Check proper flags */
-    if ((fcntl(fd, F_GETFL) & O_ACCMODE) != O_RDWR) {
+    if (open_lock_file() < 0) {
 #ifdef DEBUG
-        log_err("Incorrect fd flag provided");
+        log_err("Lock file could not be opened");
 #endif
         return -1;
     }
 
-    /* Check offsets are valid */
-    off_t total_item_size =
-        fd_total_items(fd, DIR_ITEM_ENTRY_LEN) * DIR_ITEM_ENTRY_LEN;
     /*
-     * NOTE: NULL arg could produce undefined behaviour without previous call
-     * to setup_path_names -- will be amended in future changes
+     * Files read optimistically may be truncated as they are read. Changes
+     * left part way are redone as for other locks, unless a writer may still
+     * be making them, which reads wait for.
      */
-
-    if (off_a < 0 || off_a >= total_item_size || off_b < 0 ||
-        off_b >= total_item_size) {
-        return -1;
+    if (mode == DIR_LOCK_OPTIMISTIC &&
+        (atomic_load(proj_gen) & _DIR_GEN_WRITERS || !items_left_changing())) {
+        store_map_entries(0);
+        proj_lock_mode = DIR_LOCK_OPTIMISTIC;
+        return 0;
     }
 
-    if (off_a == off_b)
-        return 0;
+    for (int healed = 0;; healed = 1) {
+        const enum dir_lock_mode locked =
+            mode == DIR_LOCK_OPTIMISTIC ? DIR_LOCK_SHARED : mode;
+        int ret =
+            lock_project(locked == DIR_LOCK_EXCLUSIVE ? F_WRLCK : F_RDLCK);
+        proj_lock_mode = locked;
+
+        /*
+         * Writers of records hold a slot, and records as they change them.
+         * Readers hold the structure shared, so that no writer of records
+         * applies changes under them.
+         */
+        if (ret == 0 && locked == DIR_LOCK_RECORDS)
+            ret = lock_slot();
+        else if (ret == 0 && locked == DIR_LOCK_SHARED)
+            ret = lock_byte(F_RDLCK, _DIR_LOCK_STRUCTURE_POS);
+        if (ret < 0) {
+#ifdef DEBUG
+            log_err("Project lock could not be taken");
+#endif
+            dir_unlock();
+            return -1;
+        }
 
-    char temp_entry_a[DIR_ITEM_ENTRY_LEN];
-    char temp_entry_b[DIR_ITEM_ENTRY_LEN];
+        /* Files read while writers of records apply changes are copied */
+        store_map_entries(locked != DIR_LOCK_RECORDS);
 
-    /* Read item entries to buffer */
-    if (pread(fd, temp_entry_a, sizeof(temp_entry_a), off_a) < 0 ||
-        pread(fd, temp_entry_b, sizeof(temp_entry_b), off_b) < 0) {
-        return -1;
-    }
+        /*
+         * Writers only leave changes part way if interrupted, which are
+         * redone under an exclusive lock before anything is read. Other
+         * locks are released rather than converted, as commands converting
+         * at once would wait on each other.
+         */
+        if (locked == DIR_LOCK_EXCLUSIVE || healed || !items_left_changing())
+            return 0;
 
-    /* Write back in swapped positions */
-    if (pwrite(fd, temp_entry_b, sizeof(temp_entry_b), off_a) < 0 ||
-        pwrite(fd, temp_entry_a, sizeof(temp_entry_a), off_b) < 0) {
-        return -1;
+        dir_unlock();
+        if (lock_project(F_WRLCK) < 0)
+            return -1;
+        proj_lock_mode = DIR_LOCK_EXCLUSIVE;
+        proj_items_store();
+        recover_log();
+        dir_unlock();
     }
+}
 
-    return 0;
+void dir_unlock() {
+    /* Every lock held through the lock file is released at once */
+    struct flock fl = {
+        .l_type = F_UNLCK, .l_whence = SEEK_SET, .l_start = 0, .l_len = 0};
+    if (proj_lock_fd >= 0 && proj_lock_mode != DIR_LOCK_OPTIMISTIC)
+        fcntl(proj_lock_fd, F_OFD_SETLK, &fl);
+
+    proj_slot = -1;
+    txn_wal_path = wal_path;
+    num_locked_records = 0;
+    num_reads = 0;
+    store_map_entries(1);
+    proj_lock_mode = DIR_LOCK_NONE;
 }
 
-/**
- * @brief Append write the item entry of the item pointed to by itp to the
- * appropriate items file
- * @param itp Pointer to item to write data of
- * @param entry Formatted entry of item to write with terminating NULL
- * character
- * @return 0 on success
- * @return -1 on error
- * @note No 'correctness' checks occur to validate that the entry indeed
- * represents the item pointed to by itp, this is assumed to be the case
- */
-static_fn int append_item_entry(const item *itp,
-                                const char entry[DIR_ITEM_ENTRY_LEN + 1]) {
-    int open_flags = O_RDWR;
-    int fd = open_items_status(itp->item_st, open_flags);
-    if (fd == -1)
-        return -1;
+uint64_t dir_read_begin(const int attempt) {
+    setup_path_names(NULL);
 
-    /* Ensure that the new item is placed in order */
-    off_t new_item_pos = fd_search_for_entry_id(fd, itp->item_id);
-    assert(new_item_pos < 0);
-    /* Make non-negative */
-    new_item_pos = (new_item_pos == OFF_T_MIN) ? 0 : -new_item_pos;
+    /* Writers of records read while no other writer applies changes */
+    if (proj_lock_mode == DIR_LOCK_RECORDS && num_reads++ == 0 &&
+        lock_byte(F_RDLCK, _DIR_LOCK_STRUCTURE_POS) < 0) {
+#ifdef DEBUG
+        log_err("Items could not be read under the structural lock");
+#endif
+    }
 
-    char replaced_entry[DIR_ITEM_ENTRY_LEN];
+    if (proj_lock_mode != DIR_LOCK_OPTIMISTIC)
+        return _DIR_READ_LOCKED;
 
-    /* Read replaced entry */
-    if (pread(fd, replaced_entry, sizeof(replaced_entry), new_item_pos) < 0) {
-        return -1;
+    /* Changes are short, so are waited for rather than read part way */
+    const struct timespec wait = {0, _DIR_READ_WAIT_NS};
+    uint64_t gen = atomic_load_explicit(proj_gen, memory_order_acquire);
+    for (int i = 0; gen & _DIR_GEN_WRITERS && i < _DIR_READ_WAITS; i++) {
+        nanosleep(&wait, NULL);
+        gen = atomic_load_explicit(proj_gen, memory_order_acquire);
     }
-    off_t eof_pos = lseek(fd, 0, SEEK_END);
-    /* Append replaced entry */
-    if (pwrite(fd, replaced_entry, sizeof(replaced_entry), eof_pos) < 0) {
-        return -1;
-    }
-    /* Write new entry in old position */
-    if (pwrite(fd, entry, sizeof(replaced_entry), new_item_pos) < 0) {
-        return -1;
+
+    if (!(gen & _DIR_GEN_WRITERS) && attempt < _DIR_READ_RETRIES) {
+        /* The layout may have been migrated under a retried read */
+        if (attempt > 0 && proj_store != &memory_store) {
+            proj_store = NULL;
+            proj_layout = DIR_LAYOUT_COUNT;
+        }
+        return gen;
     }
 
-    /* Bubble old entry back up */
-    for (off_t i =
-             (fd_total_items(fd, DIR_ITEM_ENTRY_LEN) - 1) * DIR_ITEM_ENTRY_LEN;
-         i > new_item_pos + (off_t)DIR_ITEM_ENTRY_LEN;
-         i -= DIR_ITEM_ENTRY_LEN) {
-        fd_swap_item_entries_at(fd, i, i - DIR_ITEM_ENTRY_LEN);
+    /*
+     * Items changed faster than they are read, or left part way by an
+     * interrupted writer, are read under a shared lock, which waits for
+     * writers and redoes what they left in the layout they left
+     */
+    if (proj_store != &memory_store) {
+        proj_store = NULL;
+        proj_layout = DIR_LAYOUT_COUNT;
     }
-    syncfs(fd);
-    return 0;
+    if (dir_lock(DIR_LOCK_SHARED) < 0) {
+#ifdef DEBUG
+        log_err("Items could not be read under the project lock");
+#endif
+        return gen;
+    }
+    return _DIR_READ_LOCKED;
 }
 
-int dir_append_item(const item *it) {
-    assert(it != NULL);
-    setup_path_names(NULL);
+int dir_read_changed(const uint64_t gen) {
+    if (proj_lock_mode == DIR_LOCK_RECORDS && num_reads > 0 &&
+        --num_reads == 0)
+        lock_byte(F_UNLCK, _DIR_LOCK_STRUCTURE_POS);
 
-    /* Additional + 1 allocated for NULL byte */
-    char item_entry[DIR_ITEM_ENTRY_LEN + 1] = {'\0'};
+    /* Reads begun before falling back to the lock are read again under it */
+    if (proj_lock_mode != DIR_LOCK_OPTIMISTIC)
+        return gen != _DIR_READ_LOCKED;
 
-    make_item_entry(it, item_entry);
+    /* Everything read must be read before the generation is */
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(proj_gen, memory_order_relaxed) != gen;
+}
 
-    /* Write item data to items file */
-    if (append_item_entry(it, item_entry) < 0)
-        return -1;
+void dir_begin() {
+    setup_path_names(NULL);
+    txn_open = 1;
+}
 
-    return 0;
+int dir_commit() {
+    setup_path_names(NULL);
+    txn_open = 0;
+    return flush_txn();
 }
 
-/**
- * @brief Remove entry at given offset
- * @param fd File descriptor of file of entries (of any data) in regular format
- * @param entry_off Offset of entry
- * @param entry_len Length of a single entry in the file opened
- * @return 0 on success
- * @return -1 on error or if file if opened by fd is empty
- * @note entry_off must be the offset of the *first* character of the item
- * entry
- * @note Preserve ordering of entries (besides removed one, obviously)
- */
-static_fn int fd_remove_entry_at(const int fd, const off_t entry_off,
-                                 int entry_len) {
-    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
-    assert(entry_off >= 0);
+int dir_archive_items(const int keep_done, const int min_items) {
+    assert(keep_done >= 0);
 
-    off_t last_off = (fd_total_items(fd, entry_len) - 1) * entry_len;
-    if (entry_off > last_off) {
-#ifdef DEBUG
-        log_err("Entry offset provided too large given item file size");
-#endif
+    setup_path_names(NULL);
+
+    /* Items held in memory are never archived */
+    if (!uses_archive() || flush_txn() < 0)
+        return -1;
+
+    const struct store_ops *store = proj_items_store();
+    item **done = store->read_items_status(DONE);
+    if (!done)
         return -1;
+
+    /* Done items are in order of ID, the oldest are archived */
+    const int num_done = (int)item_count_items(done);
+    const int num_archived = num_done - keep_done;
+    if (num_archived <= 0 || num_archived < min_items) {
+        item_array_free(&done, SIZE_MAX);
+        return 0;
+    }
+
+    begin_items_write();
+    struct entry_buf entries = {NULL, 0, 0};
+    entries.data = malloc((size_t)num_archived * TABLE_ENTRY_LEN + 1);
+    int ret = entries.data ? 0 : -1;
+    for (int i = 0; ret == 0 && i < num_archived; i++) {
+        ret = table_make_entry(done[i], entries.data + entries.len);
+        entries.len += TABLE_ENTRY_LEN;
     }
+    if (ret == 0)
+        ret = archive_add_segment(archive_path, &entries, sync_replacement);
+    free(entries.data);
 
-    /* Bubble entry to end of file */
-    for (off_t i_off = entry_off; i_off < last_off; i_off += entry_len) {
-        fd_swap_item_entries_at(fd, i_off, i_off + entry_len);
+    /*
+     * Items are removed from the store only once archived, items left in
+     * both are found in the store
+     */
+    for (int i = 0; ret == 0 && i < num_archived; i++) {
+        if (store->remove_item(done[i]->item_id) < 0)
+            ret = -1;
     }
+    end_items_write();
+
+    item_array_free(&done, SIZE_MAX);
 
-    /* Truncate file */
-    if (ftruncate(fd, last_off) < 0) {
+    if (ret != 0) {
 #ifdef DEBUG
-        log_err("Item entry file could not be truncated when removing entry");
+        log_err("Done items could not be archived");
 #endif
         return -1;
     }
 
-    return 0;
+    return num_archived;
 }
 
-int dir_change_item_status_id(const sitem_id id, const enum status new_status) {
-    assert(new_status < ITEM_STATUS_COUNT);           /* Validate status */
-    assert(_DIR_ITEM_NUM_FILES == ITEM_STATUS_COUNT); /* Expected structure */
-
+int dir_archived_items() {
     setup_path_names(NULL);
 
-    int item_fds[_DIR_ITEM_NUM_FILES];
-
-    item *itp = NULL;
-
-    /* Find item in project */
-    open_items(O_RDWR, item_fds);
-
-    for (int i = 0; i < ITEM_STATUS_COUNT; i++) {
-        if (item_fds[i] < 0) {
-#ifdef DEBUG
-            log_err("Could not open item files for reading and writing");
-#endif
-            return -1;
-        }
-        off_t item_off = fd_search_for_entry_id(item_fds[i], id);
-
-        if (item_off >= 0) {
-            /* Status is already correct - exit from function */
-            if ((enum status)i == new_status)
-                break;
+    for (int attempt = 0;; attempt++) {
+        const uint64_t gen = dir_read_begin(attempt);
+        const int num_archived =
+            uses_archive() ? archive_total_items(archive_path) : 0;
+        if (!dir_read_changed(gen))
+            return num_archived;
+    }
+}
 
-            int fd = item_fds[i];
+int dir_archive_view_open(struct archive_view *view) {
+    assert(view);
 
-            /* Remove item from current location */
-            itp = fd_read_item_at(fd, item_off);
+    setup_path_names(NULL);
 
-            if (!itp) { /* Could not read item */
-                close_items(item_fds);
-                return -1;
-            }
+    if (!uses_archive()) {
+        memset(view, 0, sizeof(*view));
+        return 0;
+    }
 
-            fd_remove_entry_at(fd, item_off, DIR_ITEM_ENTRY_LEN);
-        }
-#ifdef DEBUG
-        else if (item_off == -1) {
-            log_err("Issue when searching for item");
-        }
-#endif
+    /* Segments are never modified, so only opening a view is retried */
+    for (int attempt = 0;; attempt++) {
+        const uint64_t gen = dir_read_begin(attempt);
+        const int num_entries = archive_view_open(archive_path, view);
+        const int changed = dir_read_changed(gen);
+        if (num_entries >= 0 && changed)
+            archive_view_close(view);
+        if (!changed)
+            return num_entries;
     }
+}
 
-    /* Item does not exist */
-    if (!itp)
-        return -1;
+const struct dir_item_ref *dir_archive_view_next(struct archive_view *view) {
+    assert(view);
+    return archive_view_next(view);
+}
 
-    /* Update status */
-    itp->item_st = new_status;
+void dir_archive_view_close(struct archive_view *view) {
+    archive_view_close(view);
+}
 
-    /* Add to new location */
-    dir_append_item(itp);
+int dir_use_memory_store() {
+    setup_path_names(NULL);
 
-    close_items(item_fds);
+    if (flush_txn() < 0)
+        return -1;
 
-    item_free(itp);
+    proj_store = &memory_store;
+    proj_store->setup(&proj_env);
+    return proj_store->create();
+}
 
-    return 0;
+/**
+ * @brief Order listed code entries by code
+ */
+static_fn int compare_code_entries(const void *a, const void *b) {
+    return memcmp(a, b, ITEM_CODE_LEN);
 }
 
-void dir_write_item_codes(item *const *items, const int *prefix_lengths) {
-    assert(items != NULL);
-    assert(prefix_lengths != NULL);
+void dir_write_item_codes(const struct dir_item_ref *refs,
+                          size_t num_refs, const int *prefix_lengths) {
+    assert(refs != NULL || num_refs == 0);
+    assert(prefix_lengths != NULL || num_refs == 0);
 
     setup_path_names(NULL);
 
-    int fd_item_codes = open(listed_codes_path, O_WRONLY | O_TRUNC);
-    /* Item codes will be structured according to the following: */
-    char curr_code_entry[_DIR_CODE_ENTRY_LEN + 1];
+    /* Entries follow the header, which is filled in once they are sorted */
+    char *code_list = malloc((num_refs + 1) * _DIR_CODE_ENTRY_LEN + 1);
+    if (!code_list)
+        return;
+    char *code_entries = code_list + _DIR_CODE_ENTRY_LEN;
 
-    for (int i = 0; items[i]; i++) {
-        int pref_len = prefix_lengths[i];
+    for (size_t i = 0; i < num_refs; i++) {
         assert(prefix_lengths[i] > 0 && prefix_lengths[i] <= ITEM_CODE_CHARS);
 
-        int b = snprintf(curr_code_entry, sizeof(curr_code_entry),
-                         "%0*X%s%-*.*s%*s%s", (int)HEX_LEN(sitem_id),
-                         items[i]->item_id, _DIR_ITEM_FIELD_DELIM, pref_len,
-                         pref_len, items[i]->item_code,
-                         ITEM_CODE_LEN - pref_len, "", _DIR_ITEM_DELIM);
-
-        if ((size_t)b < sizeof(curr_code_entry) - 1) {
+        /* Locations past the largest ID are not recorded */
+        const sitem_id loc =
+            refs[i].loc >= 0 && refs[i].loc <= INT32_MAX ? refs[i].loc : -1;
+        snprintf(code_entries + i * _DIR_CODE_ENTRY_LEN,
+                 _DIR_CODE_ENTRY_LEN + 1, "%.*s%s%d%s%0*X%s%d%s%0*X%s",
+                 ITEM_CODE_LEN, refs[i].code, _DIR_ITEM_FIELD_DELIM,
+                 prefix_lengths[i], _DIR_ITEM_FIELD_DELIM,
+                 (int)HEX_LEN(sitem_id), refs[i].id, _DIR_ITEM_FIELD_DELIM,
+                 (int)refs[i].st, _DIR_ITEM_FIELD_DELIM, (int)HEX_LEN(sitem_id),
+                 loc, _DIR_ITEM_DELIM);
+    }
+    qsort(code_entries, num_refs, _DIR_CODE_ENTRY_LEN, compare_code_entries);
+
+    char hdr[_DIR_CODE_ENTRY_LEN + 1];
+    snprintf(hdr, sizeof(hdr), "%s%s%d%s%0*X%s%d%s%0*X%s", _DIR_CODE_LIST_HDR,
+             _DIR_ITEM_FIELD_DELIM, _DIR_CODE_LIST_VERSION,
+             _DIR_ITEM_FIELD_DELIM, (int)HEX_LEN(sitem_id), (sitem_id)num_refs,
+             _DIR_ITEM_FIELD_DELIM, 0, _DIR_ITEM_FIELD_DELIM,
+             (int)HEX_LEN(sitem_id), 0, _DIR_ITEM_DELIM);
+    memcpy(code_list, hdr, _DIR_CODE_ENTRY_LEN);
+
+    /* Listings run concurrently, and replace the listed codes in turn */
+    const int locked =
+        proj_lock_fd >= 0 && lock_byte(F_WRLCK, _DIR_LOCK_CODES_POS) == 0;
+    if (replace_file(listed_codes_path, code_list,
+                     (num_refs + 1) * _DIR_CODE_ENTRY_LEN,
+                     sync_replacement) < 0) {
 #ifdef DEBUG
-            log_err("A code entry could not be created for listed entries");
+        log_err("Listed codes could not be written");
 #endif
-            break;
-        }
+    }
+    if (locked)
+        lock_byte(F_UNLCK, _DIR_LOCK_CODES_POS);
 
-        if (write(fd_item_codes, curr_code_entry, sizeof(curr_code_entry) - 1) <
-            0)
-            break;
+    free(code_list);
+}
+
+/**
+ * @brief Load the listed codes with a single mapping (or read)
+ * @param buf Set to the header and entries of the listed codes
+ * @return Number of entries following the header
+ * @return -1 if nothing has been listed, or the listed codes are of another
+ * version, in which case buf is left empty
+ */
+static_fn int load_listed_codes(struct entry_buf *buf) {
+    buf->data = NULL;
+    buf->len = 0;
+    buf->is_mapped = 0;
+
+    const int fd = open(listed_codes_path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    const int num_entries = fd_load_entries(fd, _DIR_CODE_ENTRY_LEN, buf) - 1;
+    close(fd);
+
+    if (num_entries < 0 ||
+        memcmp(buf->data, _DIR_CODE_LIST_HDR, ITEM_CODE_LEN) != 0 ||
+        buf->data[_DIR_CODE_PREFIX_POS] != '0' + _DIR_CODE_LIST_VERSION ||
+        hex_field_to_id(buf->data + _DIR_CODE_ID_POS) != num_entries) {
+        free_entry_buf(buf);
+        return -1;
     }
 
-    close(fd_item_codes);
+    return num_entries;
 }
 
 /**
@@ -1157,39 +1904,116 @@ static_fn int code_prefix_matches(const char *prefix, const char *expected) {
     return matches;
 }
 
-sitem_id dir_get_id_from_prefix(const char *code_prefix) {
-    if (!code_prefix)
+/**
+ * @brief Hint the location an item was listed at to the item store
+ * @param id ID of item
+ * @param entry Listed code entry of the item
+ * @note The store verifies the location before using it, so a location the
+ * item has since moved from only costs the read verifying it
+ */
+static_fn void hint_listed_location(const sitem_id id, const char *entry) {
+    const struct store_ops *store = proj_items_store();
+    const int st = entry[_DIR_CODE_ST_POS] - '0';
+    const sitem_id loc = hex_field_to_id(entry + _DIR_CODE_LOC_POS);
+
+    if (store->hint_location && id >= 0 && st >= 0 &&
+        st < ITEM_STATUS_COUNT && loc >= 0)
+        store->hint_location(id, (enum status)st, loc);
+}
+
+/**
+ * @brief Find the listed item whose code starts with a prefix
+ * @return ID of item, or DIR_PREFIX_AMBIGUOUS or -1 as dir_get_id_from_prefix
+ */
+static_fn sitem_id find_listed_prefix(const char *code_prefix) {
+    struct entry_buf buf;
+    const int num_entries = load_listed_codes(&buf);
+    if (num_entries <= 0)
         return -1;
 
-    setup_path_names(NULL);
+    /* Find the first listed code not ordered before the prefix */
+    const char *entries = buf.data + _DIR_CODE_ENTRY_LEN;
+    const size_t prefix_len = strnlen(code_prefix, ITEM_CODE_LEN);
+    int lo = 0, hi = num_entries;
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if (memcmp(entries + (size_t)mid * _DIR_CODE_ENTRY_LEN, code_prefix,
+                   prefix_len) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
 
-    struct stat sb;
-    if (stat(listed_codes_path, &sb) < 0)
-        return -1;
-    if (sb.st_size == 0)
+    /*
+     * Codes starting with the prefix follow each other. Of several, the one
+     * listed with the prefix is found, as listed prefixes are only unique
+     * among the codes listed before them.
+     */
+    const char *found = NULL, *listed = NULL;
+    int num_found = 0, num_listed = 0;
+    for (const char *entry = entries + (size_t)lo * _DIR_CODE_ENTRY_LEN;
+         lo < num_entries && code_prefix_matches(entry, code_prefix);
+         lo++, entry += _DIR_CODE_ENTRY_LEN) {
+        found = entry;
+        num_found++;
+        if ((size_t)(entry[_DIR_CODE_PREFIX_POS] - '0') == prefix_len) {
+            listed = entry;
+            num_listed++;
+        }
+    }
+
+    const char *match = num_found == 1    ? found
+                        : num_listed == 1 ? listed
+                                          : NULL;
+    sitem_id found_id = num_found == 0 ? -1 : DIR_PREFIX_AMBIGUOUS;
+    if (match) {
+        found_id = hex_field_to_id(match + _DIR_CODE_ID_POS);
+        hint_listed_location(found_id, match);
+    }
+
+    free_entry_buf(&buf);
+    return found_id;
+}
+
+/**
+ * @brief Find the one item of the project whose code starts with a prefix,
+ * using the code index
+ * @return ID of item, or DIR_PREFIX_AMBIGUOUS or -1 as dir_get_id_from_prefix
+ */
+static_fn sitem_id find_indexed_prefix(const char *code_prefix) {
+    const size_t prefix_len = strnlen(code_prefix, ITEM_CODE_LEN);
+    const sitem_id id =
+        code_index_find_prefix(code_index_path, code_prefix, prefix_len);
+    if (id == CODE_INDEX_AMBIGUOUS)
+        return DIR_PREFIX_AMBIGUOUS;
+
+    /* The index is only a hint, so the item must still have the code */
+    item *itp = dir_get_item_with_id(id);
+    const int matches =
+        itp && memcmp(itp->item_code, code_prefix, prefix_len) == 0;
+    item_free(itp);
+    return matches ? id : -1;
+}
+
+sitem_id dir_get_id_from_prefix(const char *code_prefix) {
+    if (!code_prefix)
         return -1;
 
-    sitem_id found_id = -1;
+    setup_path_names(NULL);
 
-    /* Search last listed code prefixes */
-    int fd_listed_prefixes = open(listed_codes_path, O_RDONLY);
-    char curr_code_entry[_DIR_CODE_ENTRY_LEN];
-    int num_items_listed = sb.st_size / sizeof(curr_code_entry);
+    /* Prefixes shown by the last listing are only unique among its items */
+    const sitem_id id = find_listed_prefix(code_prefix);
+    return id != -1 ? id : find_indexed_prefix(code_prefix);
+}
 
-    for (int i = 0; i < num_items_listed; i++) {
-        pread(fd_listed_prefixes, curr_code_entry, sizeof(curr_code_entry),
-              i * sizeof(curr_code_entry));
+int dir_get_code_prefix_len(const char *full_code) {
+    assert(full_code);
 
-        if (code_prefix_matches(
-                &curr_code_entry[HEX_LEN(sitem_id) + _DIR_ITEM_FIELD_DELIM_LEN],
-                code_prefix)) {
-            found_id = strtoll(curr_code_entry, NULL, 16);
-            break;
-        }
-    }
-    close(fd_listed_prefixes);
+    setup_path_names(NULL);
 
-    return found_id;
+    if (item_is_valid_code(full_code) < 0)
+        return -1;
+    return code_index_prefix_len(code_index_path, full_code);
 }
 
 sitem_id dir_get_id_from_full_code(const char *full_code) {
@@ -1202,16 +2026,77 @@ sitem_id dir_get_id_from_full_code(const char *full_code) {
     return id;
 }
 
+/**
+ * @brief Get the item with an ID if it has a given code
+ * @param id ID of item, may be -1
+ * @param full_code Full ITEM_CODE_LEN code
+ * @return Heap-allocated item
+ * @return NULL if there is no item with the ID, or it has another code
+ */
+static_fn item *get_item_with_id_and_code(const sitem_id id,
+                                          const char *full_code) {
+    item *itp = id >= 0 ? dir_get_item_with_id(id) : NULL;
+    if (itp && memcmp(itp->item_code, full_code, ITEM_CODE_LEN) != 0) {
+        item_free(itp);
+        return NULL;
+    }
+    return itp;
+}
+
+/**
+ * @brief Find the ID of the item with a code by reading every item, archived
+ * or not
+ * @param full_code Full ITEM_CODE_LEN code
+ * @return ID of item
+ * @return -1 if no item has the code
+ */
+static_fn sitem_id find_id_with_code(const char *full_code) {
+    const enum status sts[] = {BACKLOG, TODO, IN_PROG, DONE};
+    sitem_id id = -1;
+
+    struct dir_item_view view;
+    if (dir_view_open(&view, sts, ITEM_STATUS_COUNT) >= 0) {
+        for (const struct dir_item_ref *ref;
+             id < 0 && (ref = dir_view_next(&view));) {
+            if (memcmp(ref->code, full_code, ITEM_CODE_LEN) == 0)
+                id = ref->id;
+        }
+        dir_view_close(&view);
+    }
+
+    struct archive_view archived;
+    if (id < 0 && dir_archive_view_open(&archived) >= 0) {
+        for (const struct dir_item_ref *ref;
+             id < 0 && (ref = dir_archive_view_next(&archived));) {
+            if (memcmp(ref->code, full_code, ITEM_CODE_LEN) == 0)
+                id = ref->id;
+        }
+        dir_archive_view_close(&archived);
+    }
+
+    return id;
+}
+
 item *dir_get_item_with_code(const char *full_code) {
     assert(full_code);
 
+    setup_path_names(NULL);
+
     if (item_is_valid_code(full_code) < 0)
         return NULL;
 
-    setup_path_names(NULL);
-
-    item *itp = find_item_matching_field(
-        HEX_LEN(sitem_id) + _DIR_ITEM_FIELD_DELIM_LEN, full_code);
+    /*
+     * Codes are found in the code index, then decoded to the ID they are
+     * generated from, and only then found by reading every item, should the
+     * code have been generated differently
+     */
+    item *itp = get_item_with_id_and_code(
+        code_index_find(code_index_path, full_code), full_code);
+    if (!itp)
+        itp = get_item_with_id_and_code(item_code_to_id(full_code), full_code);
+    if (!itp)
+        itp = get_item_with_id_and_code(find_id_with_code(full_code),
+                                        full_code);
 
     return itp;
 }
@@ -1265,15 +2150,32 @@ static_fn void dependency_to_entry(const struct dependency *const dep,
 #endif
 }
 
-struct dependency_list *dir_get_all_dependencies() {
-    setup_path_names(NULL);
+/**
+ * @brief Read every dependency of the project
+ * @return Dependency list allocated on the heap
+ * @return NULL on error
+ */
+static_fn struct dependency_list *read_dependencies() {
+    /* Stores holding dependencies alongside their items */
+    const struct store_ops *store = proj_items_store();
+    if (store->read_dependencies)
+        return store->read_dependencies();
 
     int fd = open(item_dependencies, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct entry_buf buf;
     const int total_dependencies =
-        fd_total_items(fd, _DIR_DEPENDENCY_ENTRY_LEN);
-    if (total_dependencies < 0)
+        fd_load_entries(fd, _DIR_DEPENDENCY_ENTRY_LEN, &buf);
+    close(fd);
+
+    if (total_dependencies < 0) {
+#ifdef DEBUG
+        log_err("Unable to read item dependencies");
+#endif
         return NULL;
-    char dependency_entry[_DIR_DEPENDENCY_ENTRY_LEN] = {0};
+    }
 
     struct dependency_list *list =
         graph_init_dependency_list(total_dependencies);
@@ -1281,22 +2183,33 @@ struct dependency_list *dir_get_all_dependencies() {
     struct dependency *new_dependency = NULL;
 
     for (int i = 0; i < total_dependencies; i++) {
+        const char *entry = buf.data + (size_t)i * _DIR_DEPENDENCY_ENTRY_LEN;
+        if (entry[_DIR_DEPENDENCY_GHOST_POS] == _DIR_DEAD_DEPENDENCY_CHAR)
+            continue;
+
         new_dependency = graph_new_dependency(-1, -1, 0);
-        if (pread(fd, dependency_entry, sizeof(dependency_entry),
-                  i * _DIR_DEPENDENCY_ENTRY_LEN) == -1) {
-#ifdef DEBUG
-            log_err("Unable to read item dependencies");
-#endif
-            close(fd);
-            return NULL;
-        }
-        read_dependency(new_dependency, dependency_entry);
+        read_dependency(new_dependency, entry);
         graph_new_dependency_to_list(list, &new_dependency);
     }
-    close(fd);
+
+    free_entry_buf(&buf);
     return list;
 }
 
+struct dependency_list *dir_get_all_dependencies() {
+    setup_path_names(NULL);
+
+    for (int attempt = 0;; attempt++) {
+        const uint64_t gen = dir_read_begin(attempt);
+        struct dependency_list *list = read_dependencies();
+        if (!dir_read_changed(gen))
+            return list;
+
+        if (list)
+            graph_free_dependency_list(&list);
+    }
+}
+
 void dir_add_dependency_list(const struct dependency_list *const list) {
     assert(list);
     for (unsigned int i = 0; i < list->count; i++) {
@@ -1315,6 +2228,18 @@ void dir_add_dependency(const struct dependency *const dep) {
 
     setup_path_names(NULL);
 
+    const struct store_ops *store = proj_items_store();
+    begin_items_write();
+    if (store->add_dependency) {
+        if (store->add_dependency(dep) < 0) {
+#ifdef DEBUG
+            log_err("Unable to write dependency");
+#endif
+        }
+        end_items_write();
+        return;
+    }
+
     int fd = open(item_dependencies, O_WRONLY | O_APPEND);
     char dependency_entry[_DIR_DEPENDENCY_ENTRY_LEN + 1];
     dependency_to_entry(dep, dependency_entry);
@@ -1323,8 +2248,11 @@ void dir_add_dependency(const struct dependency *const dep) {
 #ifdef DEBUG
         log_err("Unable to write dependency");
 #endif
+    } else {
+        sync_written(fd, item_dependencies);
     }
     close(fd);
+    end_items_write();
 }
 
 int dir_rm_dependency(const struct dependency *const dep) {
@@ -1335,21 +2263,50 @@ int dir_rm_dependency(const struct dependency *const dep) {
 #endif
         return -1;
     }
-    int fd = open(item_dependencies, O_WRONLY);
 
-    char entry[_DIR_DEPENDENCY_ENTRY_LEN];
-    dependency_to_entry(dep, entry);
-    off_t entry_pos = fd_find_entry_with_data(fd, _DIR_DEPENDENCY_ENTRY_LEN, 0,
-                                              entry, _DIR_ITEM_DELIM);
-    if (entry_pos < 0) {
-        return -1;
+    setup_path_names(NULL);
+
+    const struct store_ops *store = proj_items_store();
+    if (store->rm_dependency) {
+        begin_items_write();
+        const int ret = store->rm_dependency(dep);
+        end_items_write();
+        return ret;
     }
 
-    if (fd_remove_entry_at(fd, entry_pos, _DIR_ITEM_FIELD_DELIM_LEN) < 0) {
+    int fd = open(item_dependencies, O_RDWR);
+    if (fd < 0)
+        return -2;
+
+    /* Dependencies are matched on both IDs, ghost or not */
+    char entry[_DIR_DEPENDENCY_ENTRY_LEN + 1];
+    dependency_to_entry(dep, entry);
+
+    begin_items_write();
+    struct entry_buf buf;
+    const int total_dependencies =
+        fd_load_entries(fd, _DIR_DEPENDENCY_ENTRY_LEN, &buf);
+    off_t entry_off = -1;
+    for (int i = 0; i < total_dependencies && entry_off < 0; i++) {
+        const char *curr = buf.data + (size_t)i * _DIR_DEPENDENCY_ENTRY_LEN;
+        if (curr[_DIR_DEPENDENCY_GHOST_POS] != _DIR_DEAD_DEPENDENCY_CHAR &&
+            memcmp(curr, entry, _DIR_DEPENDENCY_GHOST_POS) == 0)
+            entry_off = (off_t)i * _DIR_DEPENDENCY_ENTRY_LEN;
+    }
+    free_entry_buf(&buf);
+
+    /* The entry is left in place as a tombstone, skipped when read */
+    const char dead = _DIR_DEAD_DEPENDENCY_CHAR;
+    int ret = total_dependencies < 0 ? -2 : entry_off < 0 ? -1 : 0;
+    if (ret == 0 &&
+        (pwrite_all(fd, &dead, 1, entry_off + _DIR_DEPENDENCY_GHOST_POS) < 0 ||
+         sync_written(fd, item_dependencies) < 0)) {
 #ifdef DEBUG
-        log_err("Could not remove entry at given location");
+        log_err("Could not remove dependency");
 #endif
-        return -2;
+        ret = -2;
     }
-    return 0;
+    end_items_write();
+    close(fd);
+    return ret;
 }
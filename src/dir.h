@@ -13,7 +13,7 @@
 #define DIR_H
 
 #ifndef _GNU_SOURCE
-#define _GNU_SOURCE /* Used for syncfs file synchronisation */
+#define _GNU_SOURCE
 #endif
 
 #include <assert.h>
@@ -22,30 +22,63 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <pwd.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "config.h"
 #include "ds/graph.h"
 #include "ds/item.h"
+#include "store/archive.h"
+#include "store/store.h"
+#include "store/wal.h"
 
 /*
  * Project directory substructure
  * This should be considered only internally and not part of the dir interface
  */
 #define _DIR_ITEM_PATH_D "items"      /* Items directory */
-#define _DIR_ITEM_BACKLOG_F "backlog" /* Backlog or *future* items */
-#define _DIR_ITEM_TODO_F "todo"       /* Items staged for completion */
-#define _DIR_ITEM_INPROG_F "ip"       /* Items currently mared as in progress */
-#define _DIR_ITEM_DONE_F "done"       /* Complete items */
+#define _DIR_ARCHIVE_PATH_D "archive" /* Archived done items, see archive.h */
+
+#define _DIR_LAYOUT_F "LAYOUT"           /* Layout of item storage */
+#define _DIR_DURABILITY_F "DURABILITY"   /* Durability mode of writes */
+#define _DIR_NEXT_ID_F "NEXT_ID"         /* Next available item ID */
+#define _DIR_CODE_LIST_F "LISTED_CODES"  /* Codes listed in previous list */
+#define _DIR_CODE_INDEX_F "CODE_INDEX"   /* Codes of items, see code_index.h */
+#define _DIR_WAL_F "WAL"                 /* Item changes not yet applied */
+#define _DIR_WAL_SLOT_F _DIR_WAL_F ".%d" /* Log of the writer in a slot */
+#define _DIR_LOCK_F "LOCK"               /* Locked by each command run */
+
+/* Bytes of the lock file locked to take the project lock */
+#define _DIR_LOCK_TURNSTILE_POS 0 /* Held by writers waiting for readers */
+#define _DIR_LOCK_PROJECT_POS 1   /* Held for the whole of a command */
+#define _DIR_LOCK_STRUCTURE_POS 2 /* Held while writers of records apply */
+#define _DIR_LOCK_SLOTS_POS 3     /* Slot held by each writer of records */
+#define _DIR_LOCK_SLOTS 16        /* Writers of records running at once */
+#define _DIR_LOCK_CODES_POS 19    /* Held while listed codes are replaced */
+#define _DIR_LOCK_RECORDS_POS 64  /* Followed by one byte for each item ID */
 
-#define _DIR_ITEM_NUM_FILES 4 /* Number of item files categorised */
+/*
+ * The lock file holds the generation of the items, a uint64_t in host byte
+ * order shared through a mapping of the file: its low bits count the writers
+ * changing items, and the rest is bumped as each change begins and ends
+ */
+#define _DIR_LOCK_GEN_LEN sizeof(uint64_t)
+#define _DIR_GEN_WRITERS 0xFFFFu /* Mask of the count of writers */
+#define _DIR_GEN_STEP 0x10000u   /* Bump of the generation */
+
+/* Reads made without a lock, see DIR_LOCK_OPTIMISTIC */
+#define _DIR_READ_RETRIES 8         /* Reads retried before locking */
+#define _DIR_READ_WAITS 16          /* Waits for a change to be made per read */
+#define _DIR_READ_WAIT_NS 100000L   /* Length of each wait */
+#define _DIR_READ_LOCKED UINT64_MAX /* Generation of reads made under a lock */
 
-#define _DIR_NEXT_ID_F "NEXT_ID"        /* Next available item ID */
-#define _DIR_CODE_LIST_F "LISTED_CODES" /* Codes listed in previous list */
 #define _DIR_DEPENDENICES_F                                                    \
     "ITEM_DEPENDENCIES" /* Dependencies listed as a pair of item IDs*/
 
@@ -61,22 +94,31 @@
 #define _DIR_ITEM_FIELD_DELIM ":" /* Item field delimiter */
 #define _DIR_ITEM_FIELD_DELIM_LEN (sizeof(_DIR_ITEM_FIELD_DELIM) - 1)
 
-/* Item entry format */
-#define DIR_ITEM_ENTRY_LEN                                                     \
-    (                                                /* Item ID */             \
-     HEX_LEN(sitem_id) + _DIR_ITEM_FIELD_DELIM_LEN + /* Item character code */ \
-     ITEM_CODE_LEN + _DIR_ITEM_FIELD_DELIM_LEN +     /* Item name */           \
-     ITEM_NAME_MAX + _DIR_ITEM_DELIM_LEN)
-
+/*
+ * Listed codes are a header followed by an entry of each listed item in order
+ * of code: the code, the length of its listed prefix, the hex ID, the status
+ * and the hex location of the item in the store when listed (all F if
+ * unknown), each followed by a delimiter. The header holds _DIR_CODE_LIST_HDR,
+ * the version of the entries and the hex number of entries in the same fields.
+ */
+#define _DIR_CODE_LIST_HDR "#LISTED" /* Never a code, which is only letters */
+#define _DIR_CODE_LIST_VERSION 2
+#define _DIR_CODE_PREFIX_POS (ITEM_CODE_LEN + _DIR_ITEM_FIELD_DELIM_LEN)
+#define _DIR_CODE_ID_POS (_DIR_CODE_PREFIX_POS + 1 + _DIR_ITEM_FIELD_DELIM_LEN)
+#define _DIR_CODE_ST_POS                                                       \
+    (_DIR_CODE_ID_POS + HEX_LEN(sitem_id) + _DIR_ITEM_FIELD_DELIM_LEN)
+#define _DIR_CODE_LOC_POS (_DIR_CODE_ST_POS + 1 + _DIR_ITEM_FIELD_DELIM_LEN)
 #define _DIR_CODE_ENTRY_LEN                                                    \
-    (                                                /* Item ID */             \
-     HEX_LEN(sitem_id) + _DIR_ITEM_FIELD_DELIM_LEN + /* Item character code */ \
-     ITEM_CODE_LEN + _DIR_ITEM_DELIM_LEN)
+    (_DIR_CODE_LOC_POS + HEX_LEN(sitem_id) + _DIR_ITEM_DELIM_LEN)
+
+/* Returned for a code prefix of more than one listed item */
+#define DIR_PREFIX_AMBIGUOUS -2
 
 /* Writing item dependencies */
 
 #define _DIR_GHOST_DEPENDENCY_CHAR '1'
 #define _DIR_NO_GHOST_DEPENDENCY_CHAR '0'
+#define _DIR_DEAD_DEPENDENCY_CHAR 'x' /* Ghost field of removed dependency */
 
 #define _DIR_DEPENDENCY_ENTRY_LEN                                              \
     (/* Item ID of dependee */                                                 \
@@ -85,8 +127,67 @@
      HEX_LEN(sitem_id) + _DIR_ITEM_FIELD_DELIM_LEN + /* Ghost or not */        \
      1 + _DIR_ITEM_DELIM_LEN)
 
-/* Other macros */
-#define OFF_T_MIN ((off_t)(((off_t)1) << (sizeof(off_t) * 8 - 1)))
+/* Position of the ghost field, following both IDs */
+#define _DIR_DEPENDENCY_GHOST_POS                                              \
+    (2 * (HEX_LEN(sitem_id) + _DIR_ITEM_FIELD_DELIM_LEN))
+
+/* Name of each item storage layout, as written to the layout file */
+#define _DIR_LAYOUT_NAMES                                                      \
+    {"files", "table", "binary", "lsm", "btree", "segments"}
+
+/* Name of each durability mode, as written to the durability file */
+#define _DIR_DURABILITY_NAMES {"none", "fdatasync", "batched"}
+
+/* Longest name of a setting (layout or durability mode) */
+#define _DIR_SETTING_NAME_MAX 16
+
+/* Environment variable overriding the durability mode of a project */
+#define DIR_DURABILITY_ENV "TOJO_DURABILITY"
+
+/* Distinct files tracked for syncing at exit in DIR_DURABILITY_BATCHED */
+#define _DIR_MAX_BATCHED_FILES 16
+
+/**
+ * @brief Layouts in which the items of a project can be stored
+ * @note Projects without a layout file use DIR_LAYOUT_FILES
+ */
+enum dir_layout {
+    DIR_LAYOUT_FILES,    /* One file of items sorted by ID for each status */
+    DIR_LAYOUT_TABLE,    /* One table of items indexed by ID, with statuses */
+    DIR_LAYOUT_BINARY,   /* Binary records indexed by ID, after a header */
+    DIR_LAYOUT_LSM,      /* Log of item entries merged with sorted runs */
+    DIR_LAYOUT_BTREE,    /* B+tree of item entries keyed by ID, in pages */
+    DIR_LAYOUT_SEGMENTS, /* Files of each status split into ID ranges */
+    DIR_LAYOUT_COUNT,
+};
+
+/**
+ * @brief Modes in which data written to project files is made durable
+ * @note Projects without a durability file use DIR_DURABILITY_FDATASYNC
+ */
+enum dir_durability {
+    DIR_DURABILITY_NONE,      /* Never synced, flushed by the kernel alone */
+    DIR_DURABILITY_FDATASYNC, /* Each written file synced after writing */
+    DIR_DURABILITY_BATCHED,   /* Written files synced once at exit */
+    DIR_DURABILITY_COUNT,
+};
+
+/**
+ * @brief Modes in which a command locks the project for the whole of its run
+ * @note Writers are counted in the generation of items while changing them,
+ * so that readers holding no lock can tell whether anything they read was
+ * changed under them
+ * @note Writers of records lock the record of each item they change, log
+ * their changes apart from each other, and apply them one at a time under the
+ * short structural lock, which also covers the allocation of IDs
+ */
+enum dir_lock_mode {
+    DIR_LOCK_NONE,       /* Not locked, for commands run outside a project */
+    DIR_LOCK_OPTIMISTIC, /* Not locked, reads are retried if items change */
+    DIR_LOCK_SHARED,     /* Shared with other readers, excluding writers */
+    DIR_LOCK_RECORDS,    /* Shared with other writers of records */
+    DIR_LOCK_EXCLUSIVE,  /* Excluding every other command */
+};
 
 /**
  * @brief Check if directory is a current project
@@ -115,14 +216,83 @@ extern void dir_construct_path(const char *const path, const char *base,
 /**
  * @brief Initialise project directory at path
  * @param path Path to initialise project at, path must be a relative path
+ * @param layout Layout to store project items in
+ * @param durability Durability mode of writes to project files
  * @return 0 on success, -1 otherwise
  * @see mkdir
  */
-extern int dir_init(const char *path);
+extern int dir_init(const char *path, const enum dir_layout layout,
+                    const enum dir_durability durability);
+
+/**
+ * @brief Find the layout with a given name
+ * @param name Null-terminated layout name
+ * @return Layout with the name
+ * @return -1 if no layout has the name
+ */
+extern int dir_layout_from_name(const char *name);
+
+/**
+ * @brief Get the name of a layout
+ * @param layout Layout
+ * @return Null-terminated name of layout in static storage
+ */
+extern const char *dir_layout_name(const enum dir_layout layout);
+
+/**
+ * @brief Get the layout the items of the current project are stored in
+ * @return Layout of project
+ */
+extern enum dir_layout dir_get_layout(void);
+
+/**
+ * @brief Find the durability mode with a given name
+ * @param name Null-terminated durability mode name
+ * @return Durability mode with the name
+ * @return -1 if no durability mode has the name
+ */
+extern int dir_durability_from_name(const char *name);
+
+/**
+ * @brief Get the name of a durability mode
+ * @param durability Durability mode
+ * @return Null-terminated name of durability mode in static storage
+ */
+extern const char *dir_durability_name(const enum dir_durability durability);
+
+/**
+ * @brief Get the durability mode of writes to the current project, taken from
+ * DIR_DURABILITY_ENV if it names a mode and the durability file otherwise
+ * @return Durability mode of project
+ */
+extern enum dir_durability dir_get_durability(void);
+
+/**
+ * @brief Move all project items into a different layout
+ * @param new_layout Layout to store items in
+ * @return Number of items moved, 0 if items are already stored in new_layout
+ * @return -1 on error, in which case items are left in the previous layout
+ * @note The layout file is only replaced once all items are stored in the new
+ * layout
+ * @note Fails while items are held in memory
+ * @note Archived items are left in the archive, which no layout holds
+ * @see dir_use_memory_store
+ */
+extern int dir_migrate(const enum dir_layout new_layout);
+
+/**
+ * @brief Hold the items and dependencies of the project in memory for the
+ * rest of the run, starting with none, instead of in the project layout
+ * @return 0 on success
+ * @return -1 on error
+ * @note Nothing is written to the items directory, intended for tests and
+ * benchmarks
+ */
+extern int dir_use_memory_store(void);
 
 /**
  * @brief Count the total number of items added to the project, regardless of
- * status
+ * status, including archived items
  * @return Number of items
  * @return Negative value in case of error
  */
@@ -135,9 +305,17 @@ extern int dir_total_items(void);
  * @return If called on new project, ID of -1 is returned, subsequent calls will
  * index from 0
  * @return -2 on error
+ * @note Writers of records allocate IDs under the structural lock
  */
 extern sitem_id dir_next_id(void);
 
+/**
+ * @brief Get the longest name an item of the project can be saved with
+ * @return Maximum name length, 0 if names are not limited
+ * @note Names are checked against this before an ID is allocated for the item
+ */
+extern int dir_name_max(void);
+
 /**
  * @brief Check if the project contains an item with the given ID
  * @param id ID to find
@@ -147,14 +325,30 @@ extern sitem_id dir_next_id(void);
 extern int dir_contains_item_with_id(sitem_id id);
 
 /**
- * @brief Read items of a single given status
+ * @brief Get the status of the item with the given ID
+ * @param id ID of item
+ * @return Status of item
+ * @return -1 if the project contains no item with the ID
+ */
+extern int dir_item_status_id(sitem_id id);
+
+/**
+ * @brief Retrieve the item in the project with the given ID
+ * @param id ID of item
+ * @return Heap-allocated pointer to item with the ID
+ * @return NULL if the project contains no item with the ID
+ */
+extern item *dir_get_item_with_id(sitem_id id);
+
+/**
+ * @brief Read items of a single given status, excluding archived items
  * @param st Status of items to read
  * @return NULL-terminated array of item pointers allocated on the heap
  */
 extern item **dir_read_items_status(enum status st);
 
 /**
- * @brief Read all items in project at path
+ * @brief Read all items in project at path, including archived items
  * @return Pointer to an array of items allocated on the heap with a
  * terminating all zero/NULL item
  * @note Function *only* extracts names as of now which are assumed to be
@@ -162,11 +356,105 @@ extern item **dir_read_items_status(enum status st);
  */
 extern item **dir_read_all_items(void);
 
+/**
+ * @brief Open a read-only view over the items of the given statuses without
+ * creating any item structs, excluding archived items
+ * @param view View to open, must be closed with dir_view_close
+ * @param sts Statuses to view, items are iterated in this order of statuses
+ * @param num_sts Number of statuses in sts, at most ITEM_STATUS_COUNT
+ * @return Total number of entries in the view, an upper bound on the number
+ * of items that will be visited
+ * @return -1 on error, view does not need to be closed
+ * @see dir_view_next
+ */
+extern int dir_view_open(struct dir_item_view *view, const enum status *sts,
+                         int num_sts);
+
+/**
+ * @brief Advance an open item view to its next item
+ * @param view View opened with dir_view_open
+ * @return Pointer to reference of the next item, overwritten by the next call
+ * @return NULL once all items in the view have been visited
+ */
+extern const struct dir_item_ref *dir_view_next(struct dir_item_view *view);
+
+/**
+ * @brief Close an item view, invalidating all references yielded by it
+ * @param view View opened with dir_view_open
+ */
+extern void dir_view_close(struct dir_item_view *view);
+
+/**
+ * @brief Lock the project, waiting for any conflicting lock to be released
+ * @param mode Mode of lock, held until dir_unlock or exit
+ * @return 0 on success
+ * @return -1 on error
+ * @note Changes left in the log by an interrupted run are redone, under an
+ * exclusive lock, before a shared lock is returned or optimistic reads are
+ * made
+ * @note Waiting writers are never passed by readers arriving after them
+ * @note A lock is held by the open file of the lock file, so is not shared
+ * by processes forked before it is first taken
+ */
+extern int dir_lock(const enum dir_lock_mode mode);
+
+/**
+ * @brief Release the lock taken by dir_lock
+ */
+extern void dir_unlock(void);
+
+/**
+ * @brief Begin a read of items that must see them all as of one moment,
+ * validated with dir_read_changed
+ * @param attempt Number of times the read has already been retried
+ * @return Generation of items the read is made at, or _DIR_READ_LOCKED if it
+ * is made under a lock
+ * @note Without DIR_LOCK_OPTIMISTIC, or once a read has been retried
+ * _DIR_READ_RETRIES times, the project is locked shared for the rest of the
+ * command so that the read cannot be changed under it
+ * @note Every dir_* read made alone is already retried, this is only needed
+ * to read several as one
+ */
+extern uint64_t dir_read_begin(const int attempt);
+
+/**
+ * @brief Check whether items were changed during a read
+ * @param gen Generation returned by dir_read_begin
+ * @return Non-zero if anything read since dir_read_begin must be discarded
+ * and read again
+ * @return 0 if the read saw the items as of one moment
+ */
+extern int dir_read_changed(const uint64_t gen);
+
+/**
+ * @brief Start a transaction, in which every item added or changed is logged
+ * and only applied once the transaction is committed
+ * @note Items added or changed are read back by ID in the transaction, but
+ * are not counted, listed or viewed until it is committed
+ * @see dir_commit
+ */
+extern void dir_begin(void);
+
+/**
+ * @brief Commit the open transaction, making every change logged in it
+ * durable with a single sync of the log before applying them
+ * @return 0 on success, including if no changes were logged
+ * @return -1 on error, in which case changes are either discarded or redone
+ * in full by the next run, never applied in part
+ * @see wal.h
+ */
+extern int dir_commit(void);
+
 /**
  * @brief Append write the item it to the project.
  * @param it Pointer to item to write
  * @return 0 on success
- * @return -1 on error
+ * @return -1 on error, or if the name is longer than dir_name_max allows
+ * @note Logged as part of the open transaction, or committed at once if no
+ * transaction is open
+ * @note The code of the item is added to the code index at once
+ * @see dir_begin
+ * @see code_index.h
  */
 extern int dir_append_item(const item *it);
 
@@ -176,25 +464,100 @@ extern int dir_append_item(const item *it);
  * @param new_status Status to change item to
  * @return 0 if item status change was succesful
  * @return -1 if item status could not be changed
+ * @note Archived items changing status are moved back out of the archive
+ * @note Logged as part of the open transaction, or committed at once if no
+ * transaction is open
+ * @note Writers of records lock the record of the item until dir_unlock,
+ * waiting for it only if no other record is locked, so that writers never
+ * wait on each other in a cycle
+ * @see dir_begin
  */
 extern int dir_change_item_status_id(const sitem_id id,
                                      const enum status new_status);
 
+/**
+ * @brief Compact all item files, permanently removing entries left behind by
+ * items changing status, once changes logged in the open transaction are
+ * applied, and rebuild the code index from every item
+ * @return Number of dead entries removed
+ * @return -1 on error
+ */
+extern int dir_compact_items(void);
+
+/**
+ * @brief Move done items, oldest by ID first, out of the item store and into
+ * a new archive segment
+ * @param keep_done Number of the newest done items left in the store
+ * @param min_items Fewest items worth a new segment, nothing is archived if
+ * fewer done items are beyond keep_done
+ * @return Number of items archived
+ * @return -1 on error, in which case items may be held by both the store and
+ * the archive, but none are lost
+ * @note Fails while items are held in memory
+ * @see archive.h
+ */
+extern int dir_archive_items(const int keep_done, const int min_items);
+
+/**
+ * @brief Count the archived items of the project
+ * @return Number of items
+ * @return -1 on error
+ */
+extern int dir_archived_items(void);
+
+/**
+ * @brief Open a read-only view over archived items, in order of ID
+ * @param view View to open, must be closed with dir_archive_view_close
+ * @return Number of archived entries, an upper bound on the number of items
+ * that will be visited
+ * @return -1 on error, view does not need to be closed
+ * @see dir_archive_view_next
+ */
+extern int dir_archive_view_open(struct archive_view *view);
+
+/**
+ * @brief Advance an open archive view to its next item, decompressing the
+ * archive one block at a time
+ * @param view View opened with dir_archive_view_open
+ * @return Pointer to reference of the next item, overwritten by the next call
+ * @return NULL once all items in the view have been visited
+ */
+extern const struct dir_item_ref *
+dir_archive_view_next(struct archive_view *view);
+
+/**
+ * @brief Close an archive view, invalidating all references yielded by it
+ * @param view View opened with dir_archive_view_open
+ */
+extern void dir_archive_view_close(struct archive_view *view);
+
 /**
  * @brief Store item codes of items in project
- * @param items List of item pointers, terminated by a NULL pointer
+ * @param refs Array of references to listed items
+ * @param num_refs Number of references in refs
  * @param prefix_lengths List of unique prefix lengths of codes, corresponding
- * to elements in items
+ * to elements in refs
+ * @note The listed codes are replaced at once, sorted by code, so that
+ * commands resolving a prefix never see them part written
  * @see dir_get_id_from_prefix
  */
-extern void dir_write_item_codes(item *const *items, const int *prefix_lengths);
+extern void dir_write_item_codes(const struct dir_item_ref *refs,
+                                 size_t num_refs, const int *prefix_lengths);
 
 /**
- * @brief Return the ID of the item associated with the listed code prefix
+ * @brief Return the ID of the item associated with the code prefix, from the
+ * items last listed, or from every item in the project if no listed item has
+ * a code starting with the prefix
  * @param code_prefix Prefix string terminated with a null character
  * @return ID of associated item
- * @return -1 if no items have been listed in this project or code_prefix is
- * NULL
+ * @return DIR_PREFIX_AMBIGUOUS if the codes of more than one listed item
+ * start with code_prefix, unless exactly one of them was listed with it, or
+ * if no listed item has such a code but more than one item of the project has
+ * @return -1 if no item has a code starting with code_prefix or code_prefix
+ * is NULL
+ * @note Listed codes are loaded at once and binary searched, and the location
+ * the item was listed at is hinted to the item store, so that changing the
+ * item next finds it without a search if it has not moved since
  * @note Not suitable for full (ITEM_CODE_LEN) codes, only listed *prefixes*
  * (which may technically be ITEM_CODE_LEN characters long)
  * @see dir_get_item_with_code
@@ -202,6 +565,17 @@ extern void dir_write_item_codes(item *const *items, const int *prefix_lengths);
  */
 extern sitem_id dir_get_id_from_prefix(const char *code_prefix);
 
+/**
+ * @brief Get the length of the shortest prefix of a code that the code of no
+ * other item in the project starts with
+ * @param full_code Full ITEM_CODE_LEN code (may or may not be null terminated)
+ * @return Length of prefix, which dir_get_id_from_prefix resolves to the item
+ * of the code unless the items last listed hold another code with the prefix
+ * @return -1 if full_code is invalid or the project has no code index
+ * @see code_index_prefix_len
+ */
+extern int dir_get_code_prefix_len(const char *full_code);
+
 /**
  * @brief Return the ID of the item associated with the full code provided
  * @param full_code Full item code (of appropriate length)
@@ -216,6 +590,8 @@ extern sitem_id dir_get_id_from_full_code(const char *full_code);
  * @brief Retrieve the item in the project with the given code
  * @param full_code Full ITEM_CODE_LEN code (may or may not be null terminated).
  * @return Heap-allocated pointer to item with associated code
+ * @note Codes are found with the code index, or the ID they are generated
+ * from, and only then by reading every item
  */
 extern item *dir_get_item_with_code(const char *full_code);
 
@@ -239,7 +615,9 @@ extern void dir_add_dependency_list(const struct dependency_list *const list);
 extern void dir_add_dependency(const struct dependency *const dep);
 
 /**
- * @brief
+ * @brief Remove a dependency from the project, leaving its entry in the
+ * dependency file as a tombstone
+ * @param dep Dependency between items to remove, matched on both IDs
  * @return 0 if dependency is removed
  * @return -1 if dependency does not exist
  * @return -2 if some other error occurs
@@ -249,10 +627,40 @@ extern int dir_rm_dependency(const struct dependency *const dep);
 #ifdef TJUNITTEST
 extern void setup_path_names(const char *const path);
 extern int create_file(const char *const fname);
-extern int create_items(void);
-extern void open_items(const int flags, int item_fds[_DIR_ITEM_NUM_FILES]);
-extern void close_items(const int item_fds[_DIR_ITEM_NUM_FILES]);
-extern int open_items_status(enum status st, int flags);
+extern void sync_batched_files(void);
+extern int sync_written(const int fd, const char *path);
+extern int sync_replacement(const int fd);
+extern const struct store_ops *layout_store(const enum dir_layout layout);
+extern const struct store_ops *proj_items_store(void);
+extern int lock_byte(const short type, const off_t pos);
+extern int try_lock_byte(const short type, const off_t pos);
+extern int lock_project(const short type);
+extern int byte_is_locked(const off_t pos);
+extern int lock_structure(const short type);
+extern void slot_wal(const int slot, char *path);
+extern int log_has_changes(const char *path);
+extern int open_lock_file(void);
+extern void begin_items_write(void);
+extern void end_items_write(void);
+extern void reset_items_writers(void);
+extern int items_left_changing(void);
+extern int lock_slot(void);
+extern int redo_item(const struct wal_record *rec);
+extern void recover_log(void);
+extern int recover_slots(void);
+extern int lock_record(const sitem_id id);
+extern int uses_archive(void);
+extern int uses_wal(void);
+extern int flush_txn(void);
+extern int log_item(const item *itp);
+extern item **read_items(const int with_archive);
+extern int write_setting(const char *setting_path, const char *name);
+extern int read_setting(const char *setting_path,
+                        char name[_DIR_SETTING_NAME_MAX + 1]);
+extern int write_layout(const enum dir_layout layout);
+extern enum dir_layout read_layout(void);
+extern enum dir_durability read_durability(void);
+extern int create_items(const enum dir_layout layout);
 extern char *get_home_directory(void);
 extern int is_accessible_directory(const char *path);
 extern int move_up_directory(char *path);
@@ -260,25 +668,18 @@ extern void build_relative_path(char *dest, int levels_up,
                                 const char *target_dir);
 extern int find_target_directory(const char *start_path, const char *home_dir,
                                  const char *target_dir, int *levels_up);
-extern item *fd_read_item_at(int fd, off_t entry_off);
-extern int fd_total_items(const int fd, int entry_len);
-extern off_t fd_find_entry_with_data(int fd, size_t entry_len,
-                                     off_t pos_in_entry, const char *data,
-                                     const char *delim);
 extern sitem_id increment_next_id(int fd_next_id);
-extern void make_item_entry(const item *const itp,
-                            char buf[DIR_ITEM_ENTRY_LEN + 1]);
-extern off_t fd_search_for_entry_id(const int fd, const sitem_id target_id);
-extern item *find_item_matching_field(const off_t pos_in_entry,
-                                      const char *data);
-extern int fd_swap_item_entries_at(const int fd, const off_t off_a,
-                                   const off_t off_b);
-extern int append_item_entry(const item *itp,
-                             const char entry[DIR_ITEM_ENTRY_LEN + 1]);
-extern int fd_remove_entry_at(const int fd, const off_t entry_off,
-                              int entry_len);
+extern int compare_code_entries(const void *a, const void *b);
+extern int load_listed_codes(struct entry_buf *buf);
+extern void hint_listed_location(const sitem_id id, const char *entry);
+extern sitem_id find_listed_prefix(const char *code_prefix);
+extern sitem_id find_indexed_prefix(const char *code_prefix);
 extern int code_prefix_matches(const char *prefix, const char *expected);
+extern item *get_item_with_id_and_code(const sitem_id id,
+                                       const char *full_code);
+extern sitem_id find_id_with_code(const char *full_code);
 extern void read_dependency(struct dependency *dep, const char *buf);
+extern struct dependency_list *read_dependencies(void);
 extern void dependency_to_entry(const struct dependency *const dep, char *buf);
 #endif
 
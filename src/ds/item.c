@@ -149,38 +149,27 @@ static_fn char *trim_name_whitespace(char *name) {
 }
 
 void item_set_name_deep(item *itp, const char *name, size_t len) {
-    assert(itp->item_name != NULL);
+    assert(itp != NULL);
     assert(name != NULL); /* Represents an incorrect call */
                           /* see item_set_name */
-    assert(len <= ITEM_NAME_MAX);
-    len++; /* This is very lazy */
+
+    /* Names end at len characters or an earlier null byte */
+    const char *name_end = memchr(name, '\0', len);
+    if (name_end)
+        len = name_end - name;
 
     char *new_name = malloc((len + 1) * sizeof(char));
     if (!new_name)
         return;
-    strncpy(new_name, name, len);
+    memcpy(new_name, name, len);
     new_name[len] = '\0';
-    char *new_start = trim_name_whitespace(new_name);
 
-    if (new_start - new_name > 0) {
-        char *tmp = malloc((strlen(new_start) + 1) * sizeof(char));
-        if (!tmp) {
-            free(new_name);
-            return;
-        }
-        strcpy(tmp, new_start);
-        free(new_name);
-        new_name = tmp;
-        new_start = NULL;
-    }
+    char *new_start = trim_name_whitespace(new_name);
+    if (new_start != new_name)
+        memmove(new_name, new_start, strlen(new_start) + 1);
 
-    strncpy(itp->item_name, new_name, len);
-    /* Insert null byte if not present at correct location */
-    if (strlen(new_name) > len - 1 && new_name[len - 1] != '\0') {
-        /* I believe there is an edge-case if the name is 'full' */
-        itp->item_name[len - 1] = '\0';
-    }
-    free(new_name);
+    /* Names of any length replace the previous name buffer */
+    item_set_name(itp, &new_name);
 }
 
 void item_set_code(item *itp) {
@@ -200,7 +189,7 @@ void item_set_code(item *itp) {
      * greater than ITEM_CODE_CHARS ^ ITEM_CODE_LEN.
      * Large primes are thus the best candidate for this task.
      */
-    const unsigned int generator = 1225022963;
+    const unsigned int generator = _ITEM_CODE_GENERATOR;
     uint64_t code_index = itp->item_id * generator;
 
     for (int i = 0; i < ITEM_CODE_LEN; i++) {
@@ -209,6 +198,31 @@ void item_set_code(item *itp) {
     }
 }
 
+sitem_id item_code_to_id(const char *code) {
+    assert(code);
+
+    /* Read base ITEM_CODE_CHARS digits, least significant (first) first */
+    uint64_t code_index = 0;
+    uint64_t place = 1;
+    for (int i = 0; i < ITEM_CODE_LEN; i++) {
+        const char *digit = code[i] ? strchr(item_code_chars, code[i]) : NULL;
+        if (!digit)
+            return -1;
+        code_index += (digit - item_code_chars) * place;
+        place *= ITEM_CODE_CHARS;
+    }
+
+    /* Only 32-bit products of the generator are ever encoded */
+    if (code_index > UINT32_MAX)
+        return -1;
+
+    const uint32_t id = (uint32_t)code_index * _ITEM_CODE_GENERATOR_INV;
+    if (id > INT32_MAX)
+        return -1;
+
+    return (sitem_id)id;
+}
+
 int item_is_valid_code(const char *code) {
     if (!code) {
 #ifdef DEBUG
@@ -256,7 +270,7 @@ void item_print_fancy(const item *itp, uint64_t print_flags, void *arg) {
                    itp->item_code, ITEM_CODE_LEN - highlight_chars,
                    itp->item_code + highlight_chars);
         else
-            printf("%s ", itp->item_name);
+            printf("%.*s ", ITEM_CODE_LEN, itp->item_code);
     }
     if (print_flags & ITEM_PRINT_NAME) {
         /* Name */
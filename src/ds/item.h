@@ -10,11 +10,19 @@
 #include <sys/types.h>
 #include <unistd.h>
 
-#define ITEM_NAME_MAX 256 /* Maximum item name length */
+#define ITEM_NAME_MAX 256 /* Maximum name length of fixed-width entries */
 
 #define ITEM_CODE_LEN 7    /* Length of an item code */
 #define ITEM_CODE_CHARS 26 /* Number of usable item code characters */
 
+/*
+ * Item codes are the base ITEM_CODE_CHARS digits (least significant first) of
+ * the ID multiplied by the generator modulo 2^32. The generator is odd, so its
+ * inverse modulo 2^32 maps a code straight back to its ID.
+ */
+#define _ITEM_CODE_GENERATOR 1225022963u
+#define _ITEM_CODE_GENERATOR_INV 2351530811u
+
 /**
  * Signed item ID type
  */
@@ -51,6 +59,12 @@ struct item {
      */
 };
 
+/**
+ * @brief Characters of item codes, each the digit of its position
+ * @note This is a null-terminated string of ITEM_CODE_CHARS characters
+ */
+extern const char item_code_chars[ITEM_CODE_CHARS + 1];
+
 /**
  * @brief Allocate heap memory for an new item
  * @note Item name is also heap allocated
@@ -152,6 +166,8 @@ extern void item_set_name(item *itp, char **name);
  * @see item_set_name for a simple use of the name reference
  * @note Will insert null byte if the string name of size len characters is
  * not already null terminated (that is if name[len - 1] != '\0')
+ * @note Names are not limited to ITEM_NAME_MAX characters, the previous name
+ * is freed and replaced by a buffer fitting the new name
  */
 extern void item_set_name_deep(item *itp, const char *name, size_t len);
 
@@ -162,6 +178,16 @@ extern void item_set_name_deep(item *itp, const char *name, size_t len);
  */
 extern void item_set_code(item *itp);
 
+/**
+ * @brief Find the ID of the item with a given code, the inverse of
+ * item_set_code
+ * @param code Full ITEM_CODE_LEN code (need not be null-terminated)
+ * @return ID that item_set_code maps to code
+ * @return -1 if code is not the code of any valid ID
+ * @note Whether a project contains an item with the ID is not checked
+ */
+extern sitem_id item_code_to_id(const char *code);
+
 /**
  * @brief Check that the code provided is a valid item code, i.e. contains only
  * valid characters and is *less than or equal to* a full code length.
@@ -5,175 +5,114 @@
 #endif
 
 /**
- * @brief Make an array of node pointers num long
- * @param num Length of pointer array
- * @return Pointer to head of array
- * @note Not tested
+ * @brief Sort strings of digits with a stable counting sort of each position,
+ * last position first
+ * @param digits Digits of each string, len digits to a string
+ * @param num_strings Number of strings in digits
+ * @param len Length of each string
+ * @param uniq_chars Number of values of a digit
+ * @param order Set to the index of each string in sorted order
+ * @param tmp Scratch space of num_strings indices
+ * @param counts Scratch space of uniq_chars + 1 counts
  */
-static inline struct prefix_trie_node **make_child_ptrs(unsigned int num) {
-    return (struct prefix_trie_node **)malloc(
-        sizeof(struct prefix_trie_node *) * num);
-}
-
-/**
- * @brief Initialise a prefix trie node
- * @return Prefix trie node with set of children set to NULL (uninitialised)
- * @return NULL if allocation fails
- * @see malloc
- */
-static_fn struct prefix_trie_node *init_node(const int num_children) {
-    struct prefix_trie_node *node =
-        (struct prefix_trie_node *)malloc(sizeof(struct prefix_trie_node));
-
-    if (!node)
-        return node;
-
-    node->initialised_children = 0;
-    if (num_children == 0) {
-        /* No children */
-        node->children = NULL;
-        node->tok = '\0';
-    } else if (num_children > 0) {
-        node->children = make_child_ptrs(num_children);
-        if (!node->children) { /* Unlikely */
-#ifdef DEBUG
-            log_err("Trie node could not be initialised with children");
-#endif
-            return node;
-        }
-        for (int i = 0; i < num_children; i++) {
-            /* Children yet to be initialised */
-            node->children[i] = NULL;
+static_fn void radix_sort_digits(const unsigned char *digits,
+                                 const int num_strings, const int len,
+                                 const int uniq_chars, int *order, int *tmp,
+                                 int *counts) {
+    for (int i = 0; i < num_strings; i++)
+        order[i] = i;
+
+    for (int pos = len - 1; pos >= 0; pos--) {
+        memset(counts, 0, sizeof(*counts) * (uniq_chars + 1));
+        for (int i = 0; i < num_strings; i++)
+            counts[digits[(size_t)i * len + pos] + 1]++;
+        for (int d = 0; d < uniq_chars; d++)
+            counts[d + 1] += counts[d];
+
+        /* Strings keep their order of the positions after pos */
+        for (int i = 0; i < num_strings; i++) {
+            const int str = order[i];
+            tmp[counts[digits[(size_t)str * len + pos]]++] = str;
         }
-        node->tok = '\0';
-    }
-
-    return node;
-}
-
-/**
- * @brief Free a node and associated resources
- * @param node Node to free
- * @note children are 'let' go, this may result in a memory leak if called
- * incorrectly; use carefully!
- */
-static_fn void free_node(struct prefix_trie_node *node) {
-    if (!node)
-        return;
 
-    free(node->children);
-    free(node);
-}
-
-/**
- * @brief Free the trie and associated resources
- * @param root Root of the trie
- */
-static_fn void free_trie(struct prefix_trie_node *root) {
-    if (!root)
-        return;
-
-    for (unsigned int i = 0; i < root->initialised_children; i++) {
-        free_trie(root->children[i]);
+        int *sorted = tmp;
+        tmp = order;
+        order = sorted;
     }
 
-    free_node(root);
+    /* Sorted indices end in the scratch space after an odd number of passes */
+    if (len % 2 == 1)
+        memcpy(tmp, order, sizeof(*order) * num_strings);
 }
 
 /**
- * @brief Add a child, involves initialising a new node with 0 children
- * appropriately
- * @param parent Parent to which to add new child
- * @param tok Token (char) of new child
- * @param max Maximum number of children available in the parent
+ * @brief Get the number of leading digits two strings of digits share
  */
-static_fn void add_child(struct prefix_trie_node *parent, const char tok,
-                      unsigned int max) {
-    /* No children initialised for child by default */
-    struct prefix_trie_node *child = init_node(0);
-
-    if (!child) {
-#ifdef DEBUG
-        log_err("Child of trie could not be added -- malloc failed");
-#endif
-        return;
-    }
-
-    /* Insertion position */
-    const unsigned pos = parent->initialised_children;
-
-    if (pos >= max) {
-#ifdef DEBUG
-        log_err("Position too large for trie node entry");
-#endif
-        return;
-    }
-
-    if (!parent->children) {
-        /* Initialise child pointers in parent (if non-existent) */
-        parent->children = make_child_ptrs(max);
-    }
-
-    child->tok = tok;
-    parent->children[pos] = child;
-    parent->initialised_children++;
-}
-
-/**
- * @brief Find the child of the trie node with the target token
- * @param parent Node to find child of
- * @param tok Target token
- * @return Pointer to child
- * @return NULL if the parent does not have a matching child
- */
-static_fn struct prefix_trie_node *get_child(const struct prefix_trie_node *parent,
-                                          const char tok) {
-    struct prefix_trie_node *curr_child = NULL;
-    unsigned int num_children = parent->initialised_children;
-    for (unsigned int i = 0; i < num_children; i++) {
-        curr_child = parent->children[i];
-        if (curr_child->tok == tok)
-            return curr_child;
-    }
-    return NULL;
+static_fn int common_prefix_len(const unsigned char *a, const unsigned char *b,
+                                const int len) {
+    int common = 0;
+    while (common < len && a[common] == b[common])
+        common++;
+    return common;
 }
 
 void shortest_unique_prefix_lengths(const char *const *strings,
                                     const int num_strings, const int len,
                                     const int uniq_chars, int *prefix_lengths) {
-    if (!strings) {
+    if (!strings || num_strings <= 0)
         return;
-    }
 
     /* Result array */
     assert(prefix_lengths != NULL);
+    assert(len > 0);
+    assert(uniq_chars > 0 && uniq_chars <= ITEM_CODE_CHARS);
+
+    /* Sorted order, scratch indices and counts, then the digits of strings */
+    const size_t num_ints = 2 * (size_t)num_strings + uniq_chars + 1;
+    int *order = malloc(sizeof(int) * num_ints + (size_t)num_strings * len);
+    if (!order) {
+#ifdef DEBUG
+        log_err("Strings could not be sorted for their prefixes");
+#endif
+        for (int i = 0; i < num_strings; i++)
+            prefix_lengths[i] = len;
+        return;
+    }
+    int *tmp = order + num_strings;
+    int *counts = tmp + num_strings;
+    unsigned char *digits = (unsigned char *)(order + num_ints);
 
-    /* Initialise trie */
-    struct prefix_trie_node *const root = init_node(uniq_chars);
-    assert(root != NULL);
-    struct prefix_trie_node *curr;
+    unsigned char digit_of[UCHAR_MAX + 1] = {0};
+    for (int d = 0; d < uniq_chars; d++)
+        digit_of[(unsigned char)item_code_chars[d]] = (unsigned char)d;
 
     for (int i = 0; i < num_strings; i++) {
-        curr = root;
-        int prefix_len = 0;
+        assert(strings[i]);
         for (int j = 0; j < len; j++) {
-            assert(strings[i]);
             assert(strings[i][j] != '\0');
+            digits[(size_t)i * len + j] =
+                digit_of[(unsigned char)strings[i][j]];
+        }
+    }
 
-            prefix_len++;
-            struct prefix_trie_node *new_child = get_child(curr, strings[i][j]);
+    radix_sort_digits(digits, num_strings, len, uniq_chars, order, tmp,
+                      counts);
 
-            if (!new_child) {
-                /* Sequence is new -- we can move to the next string */
-                add_child(curr, strings[i][j], uniq_chars);
-                prefix_lengths[i] = prefix_len;
-                break;
-            } else {
-                /* Continue down trie */
-                curr = new_child;
-            }
-        }
+    /* Each string shares the most with the strings sorted either side of it */
+    int prev_common = 0;
+    for (int i = 0; i < num_strings; i++) {
+        const unsigned char *curr = digits + (size_t)order[i] * len;
+        const int next_common =
+            i + 1 < num_strings
+                ? common_prefix_len(curr, digits + (size_t)order[i + 1] * len,
+                                    len)
+                : 0;
+        const int common =
+            prev_common > next_common ? prev_common : next_common;
+
+        prefix_lengths[order[i]] = common < len ? common + 1 : len;
+        prev_common = next_common;
     }
 
-    free_trie(root);
+    free(order);
 }
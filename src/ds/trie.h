@@ -2,23 +2,17 @@
 #define TRIE_H
 
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
 
 #include "item.h"
 
-struct prefix_trie_node {
-    /* Array of pointers to child nodes in the trie */
-    struct prefix_trie_node **children;
-    /* Token on node (disreguarded for root) */
-    char tok;
-    /*
-     * Number of initialised children:
-     * It is assumed that the children of a prefix_trie_node are initialised in
-     * order, from 0, this this effectively provides an insertion position for
-     * new children
-     */
-    unsigned int initialised_children;
-};
+/*
+ * Shortest unique prefixes are found without building a trie: strings are
+ * radix sorted, so that the strings sharing the longest prefix with any string
+ * are next to it, and each prefix is one character longer than the longest
+ * prefix a string shares with the strings either side of it.
+ */
 
 /**
  * @brief Find the associated array of prefix lengths of each of the strings
@@ -26,10 +20,14 @@ struct prefix_trie_node {
  * @param strings Array of strings (const char *) of which to find prefixes
  * @param num_strings Number of strings in strings
  * @param len Length of each string
- * @param uniq_chars Number of unique characters possible in a string
+ * @param uniq_chars Number of unique characters possible in a string, the
+ * first uniq_chars of item_code_chars
  * @param prefix_lengths Array to read into; expected to be the same length as
  * strings.
- * @note All strings are assumed to be unique
+ * @note Prefixes are unique among all strings, whatever their order, and a
+ * string repeated in strings has a prefix of its whole length
+ * @note Strings are copied and sorted in one allocation, should it fail every
+ * prefix is the whole length of its string
  */
 extern void shortest_unique_prefix_lengths(const char *const *strings,
                                            const int num_strings, const int len,
@@ -37,13 +35,12 @@ extern void shortest_unique_prefix_lengths(const char *const *strings,
                                            int *prefix_lengths);
 
 #ifdef TJUNITTEST
-extern struct prefix_trie_node *init_node(const int num_children);
-extern void free_node(struct prefix_trie_node *node);
-extern void free_trie(struct prefix_trie_node *root);
-extern void add_child(struct prefix_trie_node *parent, const char tok,
-                      unsigned int max);
-extern struct prefix_trie_node *get_child(const struct prefix_trie_node *parent,
-                                          const char tok);
+extern void radix_sort_digits(const unsigned char *digits,
+                              const int num_strings, const int len,
+                              const int uniq_chars, int *order, int *tmp,
+                              int *counts);
+extern int common_prefix_len(const unsigned char *a, const unsigned char *b,
+                             const int len);
 #endif
 
 #endif
@@ -0,0 +1,873 @@
+#include "archive.h"
+#include "dev-utils/test-helpers.h"
+#ifdef DEBUG
+#include "dev-utils/debug-out.h"
+#endif
+
+/**
+ * @brief Construct the path of the segment with a given sequence number
+ */
+static inline void archive_segment_path(const char *dir, const sitem_id seq,
+                                        char path[MAX_PATH]) {
+    snprintf(path, MAX_PATH, "%.*s/%s%0*X", MAX_PATH - 64, dir,
+             _ARCHIVE_SEGMENT_PREFIX, (int)HEX_LEN(sitem_id), seq);
+}
+
+/**
+ * @brief Open a file of the archive
+ */
+static inline int archive_open(const char *dir, const char *base, int flags) {
+    char path[MAX_PATH];
+    store_path(dir, base, path);
+    return open(path, flags, CONF_DIR_PERMS & 0666);
+}
+
+/**
+ * @brief Append literal bytes, in as few runs of literals as possible
+ * @return Offset in dest following the literals
+ */
+static inline size_t archive_put_literals(const char *src, size_t len,
+                                          char *dest, size_t out) {
+    while (len > 0) {
+        const size_t chunk =
+            len < _ARCHIVE_MAX_LITERALS ? len : _ARCHIVE_MAX_LITERALS;
+        dest[out++] = (char)(chunk - 1);
+        memcpy(dest + out, src, chunk);
+        out += chunk;
+        src += chunk;
+        len -= chunk;
+    }
+    return out;
+}
+
+size_t archive_compress(const char *src, const size_t len, char *dest) {
+    assert(src || len == 0);
+    assert(dest);
+
+    size_t in = 0, out = 0, literals = 0;
+    while (in < len) {
+        size_t run = 1;
+        while (in + run < len && run < _ARCHIVE_MAX_RUN &&
+               src[in + run] == src[in])
+            run++;
+
+        /* Short runs cost less as literals */
+        if (run < _ARCHIVE_MIN_RUN) {
+            in += run;
+            continue;
+        }
+
+        out = archive_put_literals(src + literals, in - literals, dest, out);
+        dest[out++] = (char)(128 + run - _ARCHIVE_MIN_RUN);
+        dest[out++] = src[in];
+        in += run;
+        literals = in;
+    }
+
+    return archive_put_literals(src + literals, len - literals, dest, out);
+}
+
+ssize_t archive_decompress(const char *src, const size_t len, char *dest,
+                           const size_t dest_len) {
+    assert(src || len == 0);
+    assert(dest);
+
+    size_t in = 0, out = 0;
+    while (in < len) {
+        const unsigned char control = (unsigned char)src[in++];
+
+        if (control < 128) {
+            const size_t num_literals = (size_t)control + 1;
+            if (num_literals > len - in || num_literals > dest_len - out)
+                return -1;
+            memcpy(dest + out, src + in, num_literals);
+            in += num_literals;
+            out += num_literals;
+        } else {
+            const size_t run = (size_t)control - 128 + _ARCHIVE_MIN_RUN;
+            if (in >= len || run > dest_len - out)
+                return -1;
+            memset(dest + out, src[in++], run);
+            out += run;
+        }
+    }
+
+    return (ssize_t)out;
+}
+
+/**
+ * @brief Read the sequence numbers of the segments listed in the manifest
+ * @param dir Archive directory
+ * @param seqs Set to a heap-allocated array of sequence numbers, oldest first
+ * @return Number of segments, 0 if nothing has been archived
+ * @return -1 on error, seqs is left unset
+ */
+static_fn int archive_read_segments(const char *dir, sitem_id **seqs) {
+    assert(seqs);
+
+    struct entry_buf buf = {NULL, 0, 0};
+    int num_segs = 0;
+
+    int fd = archive_open(dir, _ARCHIVE_SEGMENTS_F, O_RDONLY);
+    if (fd >= 0) {
+        num_segs = fd_load_entries(fd, _ARCHIVE_SEGMENTS_ENTRY_LEN, &buf);
+        close(fd);
+    } else if (errno != ENOENT) {
+        return -1;
+    }
+    if (num_segs < 0)
+        return -1;
+
+    *seqs = malloc(sizeof(**seqs) * (num_segs + 1));
+    if (!*seqs) {
+        free_entry_buf(&buf);
+        return -1;
+    }
+
+    for (int i = 0; i < num_segs; i++)
+        (*seqs)[i] =
+            hex_field_to_id(buf.data + i * _ARCHIVE_SEGMENTS_ENTRY_LEN);
+
+    free_entry_buf(&buf);
+    return num_segs;
+}
+
+/**
+ * @brief Replace the manifest with a list of segments
+ * @param dir Archive directory
+ * @param seqs Sequence numbers of segments, oldest first
+ * @param num_segs Number of segments
+ * @param sync Function syncing the manifest before it is replaced, NULL to
+ * not sync
+ * @return 0 on success
+ * @return -1 on error, the manifest is unchanged
+ */
+static_fn int archive_write_segments(const char *dir, const sitem_id *seqs,
+                                     const int num_segs,
+                                     int (*sync)(const int fd)) {
+    char *entries = malloc((size_t)num_segs * _ARCHIVE_SEGMENTS_ENTRY_LEN + 1);
+    if (!entries)
+        return -1;
+
+    for (int i = 0; i < num_segs; i++) {
+        snprintf(entries + i * _ARCHIVE_SEGMENTS_ENTRY_LEN,
+                 _ARCHIVE_SEGMENTS_ENTRY_LEN + 1, "%0*X\n",
+                 (int)HEX_LEN(sitem_id), seqs[i]);
+    }
+
+    char path[MAX_PATH];
+    store_path(dir, _ARCHIVE_SEGMENTS_F, path);
+    const int ret = replace_file(
+        path, entries, (size_t)num_segs * _ARCHIVE_SEGMENTS_ENTRY_LEN, sync);
+    free(entries);
+    return ret;
+}
+
+/**
+ * @brief Close a segment opened with archive_open_segment
+ */
+static_fn void archive_close_segment(struct archive_segment *seg) {
+    if (seg->fd >= 0)
+        close(seg->fd);
+    free(seg->index);
+    seg->fd = -1;
+    seg->index = NULL;
+}
+
+/**
+ * @brief Open a segment, validating its header and loading its sparse index
+ * @param dir Archive directory
+ * @param seq Sequence number of segment
+ * @param seg Segment to fill, closed with archive_close_segment
+ * @return 0 on success
+ * @return -1 on error or if the segment is damaged, seg is left closed
+ */
+static_fn int archive_open_segment(const char *dir, const sitem_id seq,
+                                   struct archive_segment *seg) {
+    assert(seg);
+
+    memset(seg, 0, sizeof(*seg));
+    seg->seq = seq;
+
+    char path[MAX_PATH];
+    archive_segment_path(dir, seq, path);
+    seg->fd = open(path, O_RDONLY);
+    if (seg->fd < 0)
+        return -1;
+
+    char hdr[ARCHIVE_HDR_LEN];
+    if (pread(seg->fd, hdr, ARCHIVE_HDR_LEN, 0) != ARCHIVE_HDR_LEN ||
+        memcmp(hdr, _ARCHIVE_MAGIC, _ARCHIVE_MAGIC_LEN) != 0 ||
+        load_le(hdr + ARCHIVE_HDR_VERSION_POS, 4) != ARCHIVE_VERSION) {
+#ifdef DEBUG
+        log_err("Archive segment has no valid header");
+#endif
+        archive_close_segment(seg);
+        return -1;
+    }
+
+    seg->num_items = (uint32_t)load_le(hdr + ARCHIVE_HDR_ITEMS_POS, 4);
+    seg->num_blocks = (uint32_t)load_le(hdr + ARCHIVE_HDR_BLOCKS_POS, 4);
+
+    const size_t index_len = (size_t)seg->num_blocks * ARCHIVE_INDEX_ENTRY_LEN;
+    seg->index = malloc(index_len + 1);
+    if (!seg->index ||
+        pread(seg->fd, seg->index, index_len,
+              (off_t)load_le(hdr + ARCHIVE_HDR_INDEX_POS, 4)) !=
+            (ssize_t)index_len) {
+        archive_close_segment(seg);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Read and decompress one block of a segment
+ * @param seg Open segment
+ * @param block Index of block
+ * @param num_entries Set to the number of records in the block
+ * @return Heap-allocated records of the block
+ * @return NULL on error or if the block is damaged
+ */
+static_fn char *archive_read_block(const struct archive_segment *seg,
+                                   const uint32_t block, int *num_entries) {
+    assert(block < seg->num_blocks);
+    assert(num_entries);
+
+    const char *index_entry = seg->index + block * ARCHIVE_INDEX_ENTRY_LEN;
+    const uint32_t entries =
+        (uint32_t)load_le(index_entry + ARCHIVE_INDEX_ENTRIES_POS, 4);
+    const uint32_t len =
+        (uint32_t)load_le(index_entry + ARCHIVE_INDEX_LEN_POS, 4);
+    const size_t raw_len = (size_t)entries * TABLE_ENTRY_LEN;
+
+    if (entries == 0 || entries > ARCHIVE_BLOCK_ENTRIES ||
+        len > ARCHIVE_COMPRESS_BOUND(raw_len))
+        return NULL;
+
+    char *compressed = malloc(len + 1);
+    char *raw = malloc(raw_len);
+    if (!compressed || !raw ||
+        pread(seg->fd, compressed, len,
+              (off_t)load_le(index_entry + ARCHIVE_INDEX_OFF_POS, 4)) !=
+            (ssize_t)len ||
+        archive_decompress(compressed, len, raw, raw_len) != (ssize_t)raw_len) {
+#ifdef DEBUG
+        log_err("Archive block could not be read");
+#endif
+        free(compressed);
+        free(raw);
+        return NULL;
+    }
+
+    free(compressed);
+    *num_entries = (int)entries;
+    return raw;
+}
+
+/**
+ * @brief Write records to a new segment, replacing any file with its name
+ * atomically
+ * @param dir Archive directory
+ * @param seq Sequence number of segment
+ * @param entries Table records sorted by ID
+ * @param num_entries Number of records
+ * @param sync Function syncing the segment before it is named, NULL to not
+ * sync
+ * @return 0 on success
+ * @return -1 on error
+ */
+static_fn int archive_write_segment(const char *dir, const sitem_id seq,
+                                    const char *entries, const int num_entries,
+                                    int (*sync)(const int fd)) {
+    const uint32_t num_blocks =
+        (uint32_t)((num_entries + ARCHIVE_BLOCK_ENTRIES - 1) /
+                   ARCHIVE_BLOCK_ENTRIES);
+    const size_t raw_len = (size_t)num_entries * TABLE_ENTRY_LEN;
+
+    /* Each block is bounded on its own, adding at most one byte to the bound */
+    char *data = malloc(ARCHIVE_HDR_LEN + ARCHIVE_COMPRESS_BOUND(raw_len) +
+                        (size_t)num_blocks * (1 + ARCHIVE_INDEX_ENTRY_LEN));
+    char *index = malloc((size_t)num_blocks * ARCHIVE_INDEX_ENTRY_LEN + 1);
+    if (!data || !index) {
+        free(data);
+        free(index);
+        return -1;
+    }
+
+    size_t len = ARCHIVE_HDR_LEN;
+    for (uint32_t i = 0; i < num_blocks; i++) {
+        const int first = (int)i * ARCHIVE_BLOCK_ENTRIES;
+        const int block_entries = num_entries - first < ARCHIVE_BLOCK_ENTRIES
+                                      ? num_entries - first
+                                      : ARCHIVE_BLOCK_ENTRIES;
+        const char *block = entries + (size_t)first * TABLE_ENTRY_LEN;
+
+        char *index_entry = index + i * ARCHIVE_INDEX_ENTRY_LEN;
+        store_le(index_entry + ARCHIVE_INDEX_ID_POS,
+                 (uint32_t)hex_field_to_id(block), 4);
+        store_le(index_entry + ARCHIVE_INDEX_ENTRIES_POS, block_entries, 4);
+        store_le(index_entry + ARCHIVE_INDEX_OFF_POS, len, 4);
+
+        const size_t block_len = archive_compress(
+            block, (size_t)block_entries * TABLE_ENTRY_LEN, data + len);
+        store_le(index_entry + ARCHIVE_INDEX_LEN_POS, block_len, 4);
+        len += block_len;
+    }
+
+    /* The index follows the blocks */
+    memcpy(data, _ARCHIVE_MAGIC, _ARCHIVE_MAGIC_LEN);
+    store_le(data + ARCHIVE_HDR_VERSION_POS, ARCHIVE_VERSION, 4);
+    store_le(data + ARCHIVE_HDR_ITEMS_POS, (uint32_t)num_entries, 4);
+    store_le(data + ARCHIVE_HDR_BLOCKS_POS, num_blocks, 4);
+    store_le(data + ARCHIVE_HDR_INDEX_POS, len, 4);
+    memcpy(data + len, index, (size_t)num_blocks * ARCHIVE_INDEX_ENTRY_LEN);
+    len += (size_t)num_blocks * ARCHIVE_INDEX_ENTRY_LEN;
+
+    char path[MAX_PATH];
+    archive_segment_path(dir, seq, path);
+    const int ret = replace_file(path, data, len, sync);
+
+    free(index);
+    free(data);
+    return ret;
+}
+
+/**
+ * @brief Compare revival entries by ID, then by sequence number
+ */
+static int archive_cmp_revivals(const void *a, const void *b) {
+    const sitem_id *rev_a = a;
+    const sitem_id *rev_b = b;
+
+    if (rev_a[0] != rev_b[0])
+        return rev_a[0] < rev_b[0] ? -1 : 1;
+    return (rev_a[1] > rev_b[1]) - (rev_a[1] < rev_b[1]);
+}
+
+/**
+ * @brief Load every revival entry
+ * @param dir Archive directory
+ * @param revivals Set to a heap-allocated array of ID and sequence number
+ * pairs, sorted
+ * @return Number of revival entries
+ * @return -1 on error, revivals is left unset
+ */
+static_fn int archive_load_revivals(const char *dir, sitem_id **revivals) {
+    assert(revivals);
+
+    struct entry_buf buf = {NULL, 0, 0};
+    int num_revivals = 0;
+
+    int fd = archive_open(dir, _ARCHIVE_REVIVALS_F, O_RDONLY);
+    if (fd >= 0) {
+        num_revivals = fd_load_entries(fd, _ARCHIVE_REVIVAL_ENTRY_LEN, &buf);
+        close(fd);
+    } else if (errno != ENOENT) {
+        return -1;
+    }
+    if (num_revivals < 0)
+        return -1;
+
+    *revivals = malloc(sizeof(**revivals) * (2 * (size_t)num_revivals + 1));
+    if (!*revivals) {
+        free_entry_buf(&buf);
+        return -1;
+    }
+
+    for (int i = 0; i < num_revivals; i++) {
+        const char *entry = buf.data + (size_t)i * _ARCHIVE_REVIVAL_ENTRY_LEN;
+        (*revivals)[2 * i] = hex_field_to_id(entry);
+        (*revivals)[2 * i + 1] =
+            hex_field_to_id(entry + _ARCHIVE_REVIVAL_SEQ_POS);
+    }
+    qsort(*revivals, num_revivals, 2 * sizeof(**revivals),
+          archive_cmp_revivals);
+
+    free_entry_buf(&buf);
+    return num_revivals;
+}
+
+int archive_total_items(const char *dir) {
+    assert(dir);
+
+    sitem_id *seqs = NULL;
+    const int num_segs = archive_read_segments(dir, &seqs);
+    if (num_segs <= 0) {
+        free(seqs);
+        return num_segs;
+    }
+
+    int num_items = 0;
+    for (int i = 0; i < num_segs && num_items >= 0; i++) {
+        struct archive_segment seg;
+        if (archive_open_segment(dir, seqs[i], &seg) < 0) {
+            num_items = -1;
+            break;
+        }
+        num_items += (int)seg.num_items;
+        archive_close_segment(&seg);
+    }
+
+    /*
+     * Each revival entry hides one record; entries older than every segment
+     * hid records since dropped by a merge
+     */
+    sitem_id *revivals = NULL;
+    const int num_revivals = archive_load_revivals(dir, &revivals);
+    for (int i = 0; i < num_revivals && num_items >= 0; i++) {
+        if (revivals[2 * i + 1] >= seqs[0])
+            num_items--;
+    }
+    if (num_revivals < 0)
+        num_items = -1;
+
+    free(revivals);
+    free(seqs);
+    return num_items;
+}
+
+/**
+ * @brief Search an open segment for the record of an item, decompressing the
+ * one block that may hold it
+ * @return 0 on success
+ * @return -1 if the segment holds no record of the item
+ */
+static inline int archive_search_segment(const struct archive_segment *seg,
+                                         const sitem_id id,
+                                         char entry[TABLE_ENTRY_LEN]) {
+    /* The last block starting at or before the ID */
+    int lo = 0, hi = (int)seg->num_blocks - 1, block = -1;
+    while (lo <= hi) {
+        const int mid = lo + (hi - lo) / 2;
+        const sitem_id first_id = (sitem_id)load_le(
+            seg->index + mid * ARCHIVE_INDEX_ENTRY_LEN + ARCHIVE_INDEX_ID_POS,
+            4);
+        if (first_id <= id) {
+            block = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    if (block < 0)
+        return -1;
+
+    int num_entries = 0;
+    char *records = archive_read_block(seg, (uint32_t)block, &num_entries);
+    if (!records)
+        return -1;
+
+    lo = 0;
+    hi = num_entries - 1;
+    int ret = -1;
+    while (lo <= hi && ret < 0) {
+        const int mid = lo + (hi - lo) / 2;
+        const char *record = records + (size_t)mid * TABLE_ENTRY_LEN;
+        const sitem_id mid_id = hex_field_to_id(record);
+        if (mid_id < id) {
+            lo = mid + 1;
+        } else if (mid_id > id) {
+            hi = mid - 1;
+        } else {
+            memcpy(entry, record, TABLE_ENTRY_LEN);
+            ret = 0;
+        }
+    }
+
+    free(records);
+    return ret;
+}
+
+item *archive_read_item(const char *dir, const sitem_id id) {
+    assert(dir);
+
+    if (id < 0)
+        return NULL;
+
+    sitem_id *seqs = NULL;
+    const int num_segs = archive_read_segments(dir, &seqs);
+    item *itp = NULL;
+
+    /* Segments are searched newest first */
+    for (int i = num_segs - 1; i >= 0 && !itp; i--) {
+        struct archive_segment seg;
+        if (archive_open_segment(dir, seqs[i], &seg) < 0)
+            continue;
+
+        char entry[TABLE_ENTRY_LEN];
+        if (archive_search_segment(&seg, id, entry) == 0)
+            itp = table_entry_to_item(entry);
+        archive_close_segment(&seg);
+    }
+
+    free(seqs);
+    return itp;
+}
+
+int archive_view_open(const char *dir, struct archive_view *view) {
+    assert(dir);
+    assert(view);
+
+    memset(view, 0, sizeof(*view));
+
+    sitem_id *seqs = NULL;
+    const int num_segs = archive_read_segments(dir, &seqs);
+    if (num_segs < 0)
+        return -1;
+
+    view->cursors = calloc(num_segs + 1, sizeof(*view->cursors));
+    if (!view->cursors) {
+        free(seqs);
+        return -1;
+    }
+
+    int num_entries = 0;
+    for (int i = 0; i < num_segs; i++) {
+        if (archive_open_segment(dir, seqs[i], &view->cursors[i].seg) < 0) {
+            free(seqs);
+            archive_view_close(view);
+            return -1;
+        }
+        view->num_cursors++;
+        num_entries += (int)view->cursors[i].seg.num_items;
+    }
+    free(seqs);
+
+    view->num_revivals = archive_load_revivals(dir, &view->revivals);
+    if (view->num_revivals < 0) {
+        view->revivals = NULL;
+        archive_view_close(view);
+        return -1;
+    }
+
+    return num_entries;
+}
+
+/**
+ * @brief Check whether the record of an item in a segment is hidden by a
+ * revival entry
+ * @param view Open view
+ * @param id ID of item
+ * @param seq Sequence number of segment holding the record
+ * @return Non-zero if the record is hidden
+ */
+static_fn int archive_is_hidden(const struct archive_view *view,
+                                const sitem_id id, const sitem_id seq) {
+    /* The last revival entry of the ID has the newest sequence number */
+    int lo = 0, hi = view->num_revivals - 1, last = -1;
+    while (lo <= hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if (view->revivals[2 * mid] <= id) {
+            last = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    return last >= 0 && view->revivals[2 * last] == id &&
+           view->revivals[2 * last + 1] >= seq;
+}
+
+/**
+ * @brief Move a cursor on to its next block once its current block is
+ * exhausted, keeping the block in the view
+ * @return Non-zero if the cursor has a record left
+ */
+static inline int archive_cursor_fill(struct archive_view *view,
+                                      struct archive_cursor *cursor) {
+    while (cursor->pos >= cursor->block_entries &&
+           cursor->next_block < cursor->seg.num_blocks) {
+        if (view->num_blocks == view->blocks_cap) {
+            const int cap = view->blocks_cap ? 2 * view->blocks_cap : 16;
+            char **blocks = realloc(view->blocks, sizeof(*blocks) * cap);
+            if (!blocks)
+                return 0;
+            view->blocks = blocks;
+            view->blocks_cap = cap;
+        }
+
+        /* A damaged block ends the segment */
+        int num_entries = 0;
+        char *block =
+            archive_read_block(&cursor->seg, cursor->next_block, &num_entries);
+        if (!block) {
+            cursor->next_block = cursor->seg.num_blocks;
+            return 0;
+        }
+
+        view->blocks[view->num_blocks++] = block;
+        cursor->block = block;
+        cursor->block_entries = num_entries;
+        cursor->pos = 0;
+        cursor->next_block++;
+    }
+
+    return cursor->pos < cursor->block_entries;
+}
+
+/**
+ * @brief Advance a view to its next record not hidden, merging the records
+ * of every segment in order of ID
+ * @return Next record
+ * @return NULL once all records in the view have been visited
+ */
+static_fn const char *archive_view_next_entry(struct archive_view *view) {
+    for (;;) {
+        /* The newest segment holding the smallest ID provides its record */
+        int min_cursor = -1;
+        sitem_id min_id = -1;
+        for (int i = 0; i < view->num_cursors; i++) {
+            struct archive_cursor *cursor = &view->cursors[i];
+            if (!archive_cursor_fill(view, cursor))
+                continue;
+            const sitem_id id = hex_field_to_id(
+                cursor->block + (size_t)cursor->pos * TABLE_ENTRY_LEN);
+            if (min_cursor < 0 || id <= min_id) {
+                min_cursor = i;
+                min_id = id;
+            }
+        }
+        if (min_cursor < 0)
+            return NULL;
+
+        struct archive_cursor *cursor = &view->cursors[min_cursor];
+        const char *entry =
+            cursor->block + (size_t)cursor->pos * TABLE_ENTRY_LEN;
+
+        /* Older records of the item are shadowed */
+        for (int i = 0; i < view->num_cursors; i++) {
+            struct archive_cursor *other = &view->cursors[i];
+            if (other->pos < other->block_entries &&
+                hex_field_to_id(other->block +
+                                (size_t)other->pos * TABLE_ENTRY_LEN) ==
+                    min_id)
+                other->pos++;
+        }
+
+        if (!archive_is_hidden(view, min_id, cursor->seg.seq))
+            return entry;
+    }
+}
+
+const struct dir_item_ref *archive_view_next(struct archive_view *view) {
+    assert(view);
+
+    const char *entry = archive_view_next_entry(view);
+    if (!entry)
+        return NULL;
+
+    /* Fields are referenced in place, in the kept block */
+    view->ref.id = hex_field_to_id(entry);
+    view->ref.st = DONE;
+    view->ref.code = entry + TABLE_CODE_POS;
+    view->ref.name = entry + TABLE_NAME_POS;
+    view->ref.name_len = entry_name_len(entry + TABLE_NAME_POS);
+    view->ref.loc = -1;
+
+    return &view->ref;
+}
+
+void archive_view_close(struct archive_view *view) {
+    if (!view)
+        return;
+
+    for (int i = 0; i < view->num_cursors; i++)
+        archive_close_segment(&view->cursors[i].seg);
+    for (int i = 0; i < view->num_blocks; i++)
+        free(view->blocks[i]);
+    free(view->cursors);
+    free(view->blocks);
+    free(view->revivals);
+    memset(view, 0, sizeof(*view));
+}
+
+item **archive_read_items(const char *dir) {
+    struct archive_view view;
+    const int num_entries = archive_view_open(dir, &view);
+    if (num_entries < 0)
+        return NULL;
+
+    item **items = (item **)malloc(sizeof(item *) * (num_entries + 1));
+    if (!items) {
+        archive_view_close(&view);
+        return NULL;
+    }
+
+    int num_items = 0;
+    for (const char *entry;
+         num_items < num_entries && (entry = archive_view_next_entry(&view));) {
+        items[num_items] = table_entry_to_item(entry);
+        if (items[num_items])
+            num_items++;
+    }
+    items[num_items] = NULL;
+
+    archive_view_close(&view);
+    return items;
+}
+
+/**
+ * @brief Merge every record not hidden with records to be archived
+ * @param dir Archive directory
+ * @param entries Table records sorted by ID, which shadow archived records
+ * @param merged Set to heap-allocated records sorted by ID
+ * @return Number of records in merged
+ * @return -1 on error, merged is left unset
+ */
+static_fn int archive_merge(const char *dir, const struct entry_buf *entries,
+                            char **merged) {
+    assert(merged);
+
+    struct archive_view view;
+    const int num_archived = archive_view_open(dir, &view);
+    if (num_archived < 0)
+        return -1;
+
+    const int num_new = (int)(entries->len / TABLE_ENTRY_LEN);
+    *merged = malloc((size_t)(num_archived + num_new) * TABLE_ENTRY_LEN + 1);
+    if (!*merged) {
+        archive_view_close(&view);
+        return -1;
+    }
+
+    int num_merged = 0, new_idx = 0;
+    const char *archived = archive_view_next_entry(&view);
+    while (archived || new_idx < num_new) {
+        const char *new_entry =
+            new_idx < num_new
+                ? entries->data + (size_t)new_idx * TABLE_ENTRY_LEN
+                : NULL;
+
+        const char *next;
+        if (!archived || (new_entry && hex_field_to_id(new_entry) <=
+                                           hex_field_to_id(archived))) {
+            if (archived &&
+                hex_field_to_id(new_entry) == hex_field_to_id(archived))
+                archived = archive_view_next_entry(&view);
+            next = new_entry;
+            new_idx++;
+        } else {
+            next = archived;
+            archived = archive_view_next_entry(&view);
+        }
+
+        memcpy(*merged + (size_t)num_merged * TABLE_ENTRY_LEN, next,
+               TABLE_ENTRY_LEN);
+        num_merged++;
+    }
+
+    archive_view_close(&view);
+    return num_merged;
+}
+
+int archive_add_segment(const char *dir, const struct entry_buf *entries,
+                        int (*sync)(const int fd)) {
+    assert(dir);
+    assert(entries);
+
+    if (entries->len == 0)
+        return 0;
+
+    if (mkdir(dir, CONF_DIR_PERMS) < 0 && errno != EEXIST)
+        return -1;
+
+    sitem_id *seqs = NULL;
+    const int num_segs = archive_read_segments(dir, &seqs);
+    if (num_segs < 0)
+        return -1;
+
+    /* Sequence numbers only grow, so segments are never overwritten */
+    const sitem_id new_seq = num_segs > 0 ? seqs[num_segs - 1] + 1 : 0;
+    const int merge = num_segs + 1 > _ARCHIVE_MAX_SEGMENTS;
+
+    char *merged = NULL;
+    const char *data = entries->data;
+    int num_entries = (int)(entries->len / TABLE_ENTRY_LEN);
+    if (merge) {
+        num_entries = archive_merge(dir, entries, &merged);
+        data = merged;
+    }
+
+    int ret = num_entries < 0 ? -1
+                              : archive_write_segment(dir, new_seq, data,
+                                                      num_entries, sync);
+    if (ret == 0 && merge) {
+        ret = archive_write_segments(dir, &new_seq, 1, sync);
+    } else if (ret == 0) {
+        seqs[num_segs] = new_seq;
+        ret = archive_write_segments(dir, seqs, num_segs + 1, sync);
+    }
+
+    char path[MAX_PATH];
+    if (ret != 0 && num_entries >= 0) {
+        archive_segment_path(dir, new_seq, path);
+        unlink(path);
+    }
+
+    /* Merged segments and the records hidden in them are no longer listed */
+    for (int i = 0; ret == 0 && merge && i < num_segs; i++) {
+        archive_segment_path(dir, seqs[i], path);
+        unlink(path);
+    }
+    if (ret == 0 && merge) {
+        store_path(dir, _ARCHIVE_REVIVALS_F, path);
+        unlink(path);
+    }
+
+    free(merged);
+    free(seqs);
+
+    if (ret != 0) {
+#ifdef DEBUG
+        log_err("Archive segment could not be written");
+#endif
+        return -1;
+    }
+
+    return 0;
+}
+
+int archive_revive(const char *dir, const sitem_id id,
+                   int (*sync)(const int fd)) {
+    assert(dir);
+
+    sitem_id *seqs = NULL;
+    const int num_segs = archive_read_segments(dir, &seqs);
+    const sitem_id newest_seq = num_segs > 0 ? seqs[num_segs - 1] : -1;
+    free(seqs);
+    if (newest_seq < 0 || id < 0)
+        return -1;
+
+    /* Revival entries are only written once for each newest segment */
+    sitem_id *revivals = NULL;
+    const int num_revivals = archive_load_revivals(dir, &revivals);
+    int revived = 0;
+    for (int i = 0; i < num_revivals && !revived; i++)
+        revived = revivals[2 * i] == id && revivals[2 * i + 1] == newest_seq;
+    free(revivals);
+    if (num_revivals < 0)
+        return -1;
+    if (revived)
+        return 0;
+
+    int fd = archive_open(dir, _ARCHIVE_REVIVALS_F,
+                          O_WRONLY | O_CREAT | O_APPEND);
+    if (fd < 0)
+        return -1;
+
+    char entry[_ARCHIVE_REVIVAL_ENTRY_LEN + 1];
+    snprintf(entry, sizeof(entry), "%0*X:%0*X\n", (int)HEX_LEN(sitem_id), id,
+             (int)HEX_LEN(sitem_id), newest_seq);
+
+    int ret = write(fd, entry, _ARCHIVE_REVIVAL_ENTRY_LEN) ==
+                      _ARCHIVE_REVIVAL_ENTRY_LEN
+                  ? 0
+                  : -1;
+    if (ret == 0 && sync)
+        ret = sync(fd);
+    close(fd);
+    return ret;
+}
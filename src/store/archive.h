@@ -0,0 +1,237 @@
+/**
+ * @brief Archive of done items: done items moved out of the item store of a
+ * project are kept in immutable, compressed segments, so that the store, and
+ * every default listing of it, only holds the items still being worked on.
+ *
+ * A segment holds the item table records (see table.h) of archived items
+ * sorted by ID, in blocks of up to ARCHIVE_BLOCK_ENTRIES records which are
+ * each compressed on their own, followed by a sparse index of the first ID,
+ * number of records, offset and compressed length of every block. An item is
+ * found with a binary search of the index and by decompressing one block, and
+ * views decompress each block only once they reach it.
+ *
+ * Segments are listed oldest first in a manifest and are never modified once
+ * written. Once more than _ARCHIVE_MAX_SEGMENTS exist, every segment is merged
+ * with the next one written.
+ *
+ * An archived item changing status is moved back to the item store, and its
+ * archived record is hidden by a revival entry of its ID and the sequence
+ * number of the newest segment at the time: the entry hides the records of
+ * the ID in that segment and every older one. Hidden records are dropped when
+ * segments are merged. Lookups are only made for items the store does not
+ * hold, whose newest archived record is never hidden.
+ *
+ * Records are compressed with run-length encoding, as the names of records
+ * are padded to ITEM_NAME_MAX: a control byte c below 128 is followed by c + 1
+ * literal bytes, and any other control byte by one byte repeated
+ * c - 128 + _ARCHIVE_MIN_RUN times. Integers are stored little-endian.
+ *
+ * Functions are prefixed with archive_, and take the path of the archive
+ * directory
+ * @note This should be considered only internally and not part of the dir
+ * interface
+ */
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include "store/store.h"
+#include "store/table.h"
+
+#define _ARCHIVE_SEGMENTS_F "manifest" /* Segments, oldest first */
+#define _ARCHIVE_REVIVALS_F "revived"  /* Revival entries of hidden records */
+#define _ARCHIVE_SEGMENT_PREFIX "seg." /* Followed by hex sequence number */
+
+#define _ARCHIVE_MAGIC "TOJOARCH" /* First bytes of each segment */
+#define _ARCHIVE_MAGIC_LEN (sizeof(_ARCHIVE_MAGIC) - 1)
+#define ARCHIVE_VERSION 1 /* Version of the segment format written */
+
+/* Each manifest entry is the hex sequence number of a segment */
+#define _ARCHIVE_SEGMENTS_ENTRY_LEN (HEX_LEN(sitem_id) + 1)
+
+/* Each revival entry is a hex ID and sequence number, ID:SEQ */
+#define _ARCHIVE_REVIVAL_SEQ_POS (HEX_LEN(sitem_id) + 1)
+#define _ARCHIVE_REVIVAL_ENTRY_LEN (2 * HEX_LEN(sitem_id) + 2)
+
+#define ARCHIVE_BLOCK_ENTRIES 64 /* Records compressed together in a block */
+#define _ARCHIVE_MAX_SEGMENTS 8  /* Segments kept before all are merged */
+
+/* Segment header field positions, all uint32_t */
+#define ARCHIVE_HDR_VERSION_POS _ARCHIVE_MAGIC_LEN
+#define ARCHIVE_HDR_ITEMS_POS (ARCHIVE_HDR_VERSION_POS + 4)
+#define ARCHIVE_HDR_BLOCKS_POS (ARCHIVE_HDR_ITEMS_POS + 4)
+#define ARCHIVE_HDR_INDEX_POS (ARCHIVE_HDR_BLOCKS_POS + 4)
+#define ARCHIVE_HDR_LEN (ARCHIVE_HDR_INDEX_POS + 4)
+
+/* Sparse index entry field positions, all uint32_t */
+#define ARCHIVE_INDEX_ID_POS 0       /* ID of first record of block */
+#define ARCHIVE_INDEX_ENTRIES_POS 4  /* Records in block */
+#define ARCHIVE_INDEX_OFF_POS 8      /* Offset of block in segment */
+#define ARCHIVE_INDEX_LEN_POS 12     /* Compressed length of block */
+#define ARCHIVE_INDEX_ENTRY_LEN 16
+
+/* Runs shorter than this are kept as literal bytes */
+#define _ARCHIVE_MIN_RUN 3
+#define _ARCHIVE_MAX_RUN (127 + _ARCHIVE_MIN_RUN)
+#define _ARCHIVE_MAX_LITERALS 128
+
+/* Largest compressed length of len bytes */
+#define ARCHIVE_COMPRESS_BOUND(len)                                            \
+    ((len) + ((len) + _ARCHIVE_MAX_LITERALS - 1) / _ARCHIVE_MAX_LITERALS)
+
+/**
+ * @brief Segment opened for reading, with its sparse index loaded
+ */
+struct archive_segment {
+    int fd;              /* Segment file opened for reading */
+    uint32_t num_items;  /* Records in segment */
+    uint32_t num_blocks; /* Blocks in segment */
+    char *index;         /* Sparse index, on the heap */
+    sitem_id seq;        /* Sequence number of segment */
+};
+
+/**
+ * @brief Position of a view in one segment
+ */
+struct archive_cursor {
+    struct archive_segment seg;
+    uint32_t next_block; /* Next block to decompress */
+    const char *block;   /* Records of the current block */
+    int block_entries;   /* Records in block */
+    int pos;             /* Index of next record in block */
+};
+
+/**
+ * @brief Read-only view over every archived item not hidden, in order of ID
+ * @note Decompressed blocks are kept until the view is closed, so that every
+ * reference it yields remains valid until then
+ */
+struct archive_view {
+    struct archive_cursor *cursors; /* Cursor of each segment */
+    int num_cursors;
+    char **blocks; /* Every decompressed block */
+    int num_blocks;
+    int blocks_cap;
+    sitem_id *revivals; /* ID and sequence number pairs, sorted */
+    int num_revivals;
+    struct dir_item_ref ref; /* Reference yielded by archive_view_next */
+};
+
+/**
+ * @brief Compress bytes with run-length encoding
+ * @param src Bytes to compress
+ * @param len Bytes in src
+ * @param dest Buffer of at least ARCHIVE_COMPRESS_BOUND(len) bytes
+ * @return Compressed length
+ */
+extern size_t archive_compress(const char *src, const size_t len, char *dest);
+
+/**
+ * @brief Decompress bytes compressed with archive_compress
+ * @param src Compressed bytes
+ * @param len Bytes in src
+ * @param dest Buffer to decompress into
+ * @param dest_len Bytes in dest
+ * @return Decompressed length
+ * @return -1 if src is damaged or decompresses to more than dest_len bytes
+ */
+extern ssize_t archive_decompress(const char *src, const size_t len,
+                                  char *dest, const size_t dest_len);
+
+/**
+ * @brief Count the archived items not hidden by revival entries
+ * @param dir Archive directory
+ * @return Number of items, 0 if nothing has been archived
+ * @return -1 on error
+ */
+extern int archive_total_items(const char *dir);
+
+/**
+ * @brief Read the newest archived record of an item
+ * @param dir Archive directory
+ * @param id ID of item
+ * @return Heap-allocated item
+ * @return NULL if no segment holds a record of the item
+ */
+extern item *archive_read_item(const char *dir, const sitem_id id);
+
+/**
+ * @brief Read every archived item not hidden, in order of ID
+ * @param dir Archive directory
+ * @return NULL-terminated array of item pointers allocated on the heap
+ * @return NULL on error
+ */
+extern item **archive_read_items(const char *dir);
+
+/**
+ * @brief Write records to a new segment, merging every segment into one if
+ * there are too many, and create the archive directory if needed
+ * @param dir Archive directory
+ * @param entries Table records sorted by ID
+ * @param sync Function syncing the segment and the manifest before they
+ * replace the files they hold, NULL to not sync
+ * @return 0 on success
+ * @return -1 on error, the archive is unchanged
+ */
+extern int archive_add_segment(const char *dir,
+                               const struct entry_buf *entries,
+                               int (*sync)(const int fd));
+
+/**
+ * @brief Hide the archived records of an item moved back to the item store
+ * @param dir Archive directory
+ * @param id ID of item
+ * @param sync Function syncing the revival entry, NULL to not sync
+ * @return 0 on success, including if the item is already revived since the
+ * newest segment was written
+ * @return -1 on error
+ */
+extern int archive_revive(const char *dir, const sitem_id id,
+                          int (*sync)(const int fd));
+
+/**
+ * @brief Open a view over the archive
+ * @param dir Archive directory
+ * @param view View to open, must be closed with archive_view_close
+ * @return Number of records in the view, an upper bound on the number of
+ * items that will be visited
+ * @return -1 on error, view does not need to be closed
+ */
+extern int archive_view_open(const char *dir, struct archive_view *view);
+
+/**
+ * @brief Advance an open view to its next item, decompressing blocks as they
+ * are reached
+ * @param view View opened with archive_view_open
+ * @return Pointer to reference of the next item, overwritten by the next call
+ * @return NULL once all items in the view have been visited
+ */
+extern const struct dir_item_ref *archive_view_next(struct archive_view *view);
+
+/**
+ * @brief Close a view, invalidating all references yielded by it
+ * @param view View opened with archive_view_open
+ */
+extern void archive_view_close(struct archive_view *view);
+
+#ifdef TJUNITTEST
+extern int archive_read_segments(const char *dir, sitem_id **seqs);
+extern int archive_write_segments(const char *dir, const sitem_id *seqs,
+                                  const int num_segs,
+                                  int (*sync)(const int fd));
+extern int archive_open_segment(const char *dir, const sitem_id seq,
+                                struct archive_segment *seg);
+extern void archive_close_segment(struct archive_segment *seg);
+extern char *archive_read_block(const struct archive_segment *seg,
+                                const uint32_t block, int *num_entries);
+extern int archive_write_segment(const char *dir, const sitem_id seq,
+                                 const char *entries, const int num_entries,
+                                 int (*sync)(const int fd));
+extern int archive_load_revivals(const char *dir, sitem_id **revivals);
+extern int archive_is_hidden(const struct archive_view *view,
+                             const sitem_id id, const sitem_id seq);
+extern const char *archive_view_next_entry(struct archive_view *view);
+extern int archive_merge(const char *dir, const struct entry_buf *entries,
+                         char **merged);
+#endif
+
+#endif
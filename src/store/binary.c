@@ -0,0 +1,904 @@
+#include "binary.h"
+#include "dev-utils/test-helpers.h"
+#ifdef DEBUG
+#include "dev-utils/debug-out.h"
+#endif
+
+/**
+ * @brief Get the offset of the record of an item with a given ID
+ */
+static inline off_t binary_record_off(const sitem_id id,
+                                      const uint32_t record_size) {
+    return ((off_t)id + 1) * record_size;
+}
+
+int binary_init(const int fd) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+
+    char hdr[BINARY_RECORD_SIZE] = {'\0'};
+    memcpy(hdr, _BINARY_MAGIC, _BINARY_MAGIC_LEN);
+    store_le(hdr + BINARY_HDR_VERSION_POS, BINARY_VERSION, 4);
+    store_le(hdr + BINARY_HDR_SIZE_POS, BINARY_RECORD_SIZE, 4);
+    store_le(hdr + BINARY_HDR_COUNT_POS, 0, 4);
+
+    return pwrite_all(fd, hdr, BINARY_RECORD_SIZE, 0);
+}
+
+int binary_parse_header(const char *data, struct binary_header *hdr) {
+    assert(data);
+    assert(hdr);
+
+    if (memcmp(data, _BINARY_MAGIC, _BINARY_MAGIC_LEN) != 0)
+        return -1;
+
+    hdr->version = load_le(data + BINARY_HDR_VERSION_POS, 4);
+    hdr->record_size = load_le(data + BINARY_HDR_SIZE_POS, 4);
+    hdr->record_count = load_le(data + BINARY_HDR_COUNT_POS, 4);
+
+    const int is_v1 = hdr->version == 1 &&
+                      hdr->record_size == _BINARY_V1_RECORD_SIZE;
+    const int is_current = hdr->version == BINARY_VERSION &&
+                           hdr->record_size == BINARY_RECORD_SIZE;
+    if (!is_v1 && !is_current) {
+#ifdef DEBUG
+        log_err("Unsupported version or record size of binary records");
+#endif
+        return -1;
+    }
+
+    return 0;
+}
+
+int binary_read_header(const int fd, struct binary_header *hdr) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+
+    char data[BINARY_RECORD_SIZE];
+    if (pread(fd, data, BINARY_RECORD_SIZE, 0) != BINARY_RECORD_SIZE)
+        return -1;
+
+    return binary_parse_header(data, hdr);
+}
+
+/**
+ * @brief Record the number of records following the header
+ * @return 0 on success
+ * @return -1 on error
+ */
+static inline int binary_write_count(const int fd, const uint32_t count) {
+    char count_field[4];
+    store_le(count_field, count, 4);
+    return pwrite_all(fd, count_field, 4, BINARY_HDR_COUNT_POS);
+}
+
+int binary_record_status(const char *record) {
+    assert(record);
+
+    if (!(record[BINARY_FLAGS_POS] & _BINARY_FLAG_PRESENT))
+        return -1;
+
+    const unsigned char st = (unsigned char)record[BINARY_ST_POS];
+    return st < ITEM_STATUS_COUNT ? (int)st : -1;
+}
+
+sitem_id binary_record_id(const char *record) {
+    assert(record);
+    return (sitem_id)load_le(record + BINARY_ID_POS, 4);
+}
+
+uint64_t binary_record_name_off(const char *record) {
+    assert(record);
+    return load_le(record + BINARY_NAME_OFF_POS, 8);
+}
+
+uint32_t binary_record_name_len(const char *record) {
+    assert(record);
+    return (uint32_t)load_le(record + BINARY_NAME_LEN_POS, 4);
+}
+
+/**
+ * @brief Allocate an item holding the ID, status and code of a record, with
+ * no name
+ * @return Pointer to new item
+ * @return NULL if the record holds no item or in case of error
+ */
+static inline item *binary_record_to_nameless_item(const char *record) {
+    const int st = binary_record_status(record);
+    if (st < 0)
+        return NULL;
+
+    item *itp = item_init();
+    if (!itp)
+        return NULL;
+
+    itp->item_id = binary_record_id(record);
+    itp->item_st = (enum status)st;
+    memcpy(itp->item_code, record + BINARY_CODE_POS, ITEM_CODE_LEN);
+
+    return itp;
+}
+
+item *binary_record_to_item(const char *record, const char *names,
+                            const size_t names_len) {
+    assert(record);
+
+    const uint64_t name_off = binary_record_name_off(record);
+    const uint32_t name_len = binary_record_name_len(record);
+    if (name_off > names_len || name_len > names_len - name_off) {
+#ifdef DEBUG
+        log_err("Binary record refers to a name outside the name heap");
+#endif
+        return NULL;
+    }
+
+    item *itp = binary_record_to_nameless_item(record);
+    if (itp)
+        item_set_name_deep(itp, names + name_off, name_len);
+
+    return itp;
+}
+
+/**
+ * @brief Write the binary record of an item to buf
+ * @param itp Pointer to item to parse data of
+ * @param name_off Offset of the name of the item in the name heap
+ * @param buf Buffer of BINARY_RECORD_SIZE bytes to place data
+ * @return 0 on success
+ * @return -1 if the item cannot be represented by a record
+ */
+static_fn int make_binary_record(const item *const itp,
+                                 const uint64_t name_off,
+                                 char buf[BINARY_RECORD_SIZE]) {
+    assert(itp);
+    assert(itp->item_st < ITEM_STATUS_COUNT);
+
+    const size_t name_len = itp->item_name ? strlen(itp->item_name) : 0;
+    if (name_len > UINT32_MAX) {
+#ifdef DEBUG
+        log_err("make_binary_record could not record name length");
+#endif
+        return -1;
+    }
+
+    memset(buf, '\0', BINARY_RECORD_SIZE);
+    store_le(buf + BINARY_ID_POS, (uint32_t)itp->item_id, 4);
+    buf[BINARY_ST_POS] = (char)itp->item_st;
+    buf[BINARY_FLAGS_POS] = _BINARY_FLAG_PRESENT;
+    memcpy(buf + BINARY_CODE_POS, itp->item_code, ITEM_CODE_LEN);
+    store_le(buf + BINARY_NAME_OFF_POS, name_off, 8);
+    store_le(buf + BINARY_NAME_LEN_POS, name_len, 4);
+
+    return 0;
+}
+
+/**
+ * @brief Ensure space is allocated for a number of records following the
+ * header, preallocating _BINARY_GROW_RECORDS records at a time
+ * @param fd File descriptor of records opened for writing
+ * @param num_records Records that must fit in the file
+ * @return 0 on success
+ * @return -1 on error
+ * @note File systems without fallocate support are left to grow as records
+ * are written
+ */
+static_fn int binary_reserve_records(const int fd, const uint32_t num_records) {
+    struct stat sb;
+    if (fstat(fd, &sb) < 0)
+        return -1;
+
+    const off_t needed =
+        binary_record_off((sitem_id)num_records, BINARY_RECORD_SIZE);
+    if (sb.st_size >= needed)
+        return 0;
+
+    /* Round up to a whole number of growth steps */
+    const off_t step = (off_t)_BINARY_GROW_RECORDS * BINARY_RECORD_SIZE;
+    const off_t new_size = ((needed + step - 1) / step) * step;
+
+    if (fallocate(fd, 0, sb.st_size, new_size - sb.st_size) < 0 &&
+        errno != EOPNOTSUPP) {
+#ifdef DEBUG
+        log_err("Could not preallocate binary records");
+#endif
+        return -1;
+    }
+
+    return 0;
+}
+
+int binary_read_status(const int fd, const sitem_id id) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+
+    if (id < 0)
+        return -1;
+
+    /* Status and flags are adjacent, both are read at once */
+    char st_flags[2];
+    if (pread(fd, st_flags, 2,
+              binary_record_off(id, BINARY_RECORD_SIZE) + BINARY_ST_POS) != 2)
+        return -1;
+
+    if (!(st_flags[1] & _BINARY_FLAG_PRESENT))
+        return -1;
+
+    const unsigned char st = (unsigned char)st_flags[0];
+    return st < ITEM_STATUS_COUNT ? (int)st : -1;
+}
+
+item *binary_read_item(const struct binary_files *bf, const sitem_id id) {
+    assert(bf);
+    assert(fcntl(bf->fd, F_GETFD) != -1); /* File descriptor is valid */
+
+    if (id < 0)
+        return NULL;
+
+    char record[BINARY_RECORD_SIZE];
+    if (pread(bf->fd, record, BINARY_RECORD_SIZE,
+              binary_record_off(id, BINARY_RECORD_SIZE)) != BINARY_RECORD_SIZE)
+        return NULL;
+
+    item *itp = binary_record_to_nameless_item(record);
+    if (!itp)
+        return NULL;
+
+    const uint32_t name_len = binary_record_name_len(record);
+    char *name = malloc((size_t)name_len + 1);
+    if (!name || pread(bf->names_fd, name, name_len,
+                       (off_t)binary_record_name_off(record)) !=
+                     (ssize_t)name_len) {
+        free(name);
+        item_free(itp);
+        return NULL;
+    }
+
+    item_set_name_deep(itp, name, name_len);
+    free(name);
+    return itp;
+}
+
+int binary_write_item(const struct binary_files *bf, const item *itp) {
+    assert(bf);
+    assert(fcntl(bf->fd, F_GETFD) != -1); /* File descriptor is valid */
+    assert(itp);
+
+    if (itp->item_id < 0)
+        return -1;
+
+    struct binary_header hdr;
+    if (binary_read_header(bf->fd, &hdr) < 0 ||
+        hdr.version != BINARY_VERSION)
+        return -1;
+
+    /* Names are appended to the end of the heap */
+    struct stat sb;
+    if (fstat(bf->names_fd, &sb) < 0)
+        return -1;
+
+    char record[BINARY_RECORD_SIZE];
+    if (make_binary_record(itp, (uint64_t)sb.st_size, record) < 0)
+        return -1;
+
+    const uint32_t name_len = binary_record_name_len(record);
+    if (name_len > 0 &&
+        pwrite_all(bf->names_fd, itp->item_name, name_len, sb.st_size) < 0)
+        return -1;
+
+    const uint32_t min_count = (uint32_t)itp->item_id + 1;
+    if (min_count > hdr.record_count &&
+        binary_reserve_records(bf->fd, min_count) < 0)
+        return -1;
+
+    if (pwrite_all(bf->fd, record, BINARY_RECORD_SIZE,
+                   binary_record_off(itp->item_id, BINARY_RECORD_SIZE)) < 0)
+        return -1;
+
+    /* The count only ever covers records that have been written */
+    if (min_count > hdr.record_count)
+        return binary_write_count(bf->fd, min_count);
+
+    return 0;
+}
+
+int binary_write_status(const int fd, const sitem_id id, const enum status st) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+    assert(st < ITEM_STATUS_COUNT);
+
+    if (id < 0)
+        return -1;
+
+    const char st_byte = (char)st;
+    return pwrite_all(fd, &st_byte, 1,
+                      binary_record_off(id, BINARY_RECORD_SIZE) +
+                          BINARY_ST_POS);
+}
+
+int binary_clear_record(const int fd, const sitem_id id) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+
+    if (id < 0)
+        return -1;
+
+    const char flags = 0;
+    return pwrite_all(fd, &flags, 1,
+                      binary_record_off(id, BINARY_RECORD_SIZE) +
+                          BINARY_FLAGS_POS);
+}
+
+/**
+ * @brief Load every record of a file, validating its header
+ * @param fd File descriptor of records opened for reading
+ * @param buf Entry buffer to load records into, including the header
+ * @return Number of records following the header which may hold items
+ * @return -1 on error or if the records are not of the current version, buf is
+ * left empty
+ */
+static_fn int binary_load_records(const int fd, struct entry_buf *buf) {
+    const int total_records = fd_load_entries(fd, BINARY_RECORD_SIZE, buf);
+    if (total_records < 1)
+        return -1;
+
+    struct binary_header hdr;
+    if (binary_parse_header(buf->data, &hdr) < 0 ||
+        hdr.version != BINARY_VERSION) {
+        free_entry_buf(buf);
+        return -1;
+    }
+
+    /* Preallocated records past the count are never read */
+    if (hdr.record_count < (uint32_t)(total_records - 1))
+        return (int)hdr.record_count;
+    return total_records - 1;
+}
+
+int binary_total_items(const int fd) {
+    struct entry_buf buf;
+    const int num_records = binary_load_records(fd, &buf);
+    if (num_records < 0)
+        return -1;
+
+    int num_items = 0;
+    for (int i = 1; i <= num_records; i++) {
+        if (binary_record_status(buf.data + (size_t)i * BINARY_RECORD_SIZE) >=
+            0)
+            num_items++;
+    }
+
+    free_entry_buf(&buf);
+    return num_items;
+}
+
+item **binary_read_items_status(const struct binary_files *bf,
+                                const enum status st) {
+    assert(bf);
+    assert(st < ITEM_STATUS_COUNT);
+
+    struct entry_buf buf;
+    const int num_records = binary_load_records(bf->fd, &buf);
+    if (num_records < 0)
+        return NULL;
+
+    /* Only the names of matching records are ever read from the heap */
+    struct entry_buf names;
+    if (fd_load_entries(bf->names_fd, 1, &names) < 0) {
+        free_entry_buf(&buf);
+        return NULL;
+    }
+
+    item **items = (item **)malloc(sizeof(item *) * (num_records + 1));
+    if (!items) {
+        free_entry_buf(&names);
+        free_entry_buf(&buf);
+        return NULL;
+    }
+
+    int num_items = 0;
+    for (int i = 1; i <= num_records; i++) {
+        const char *record = buf.data + (size_t)i * BINARY_RECORD_SIZE;
+        if (binary_record_status(record) != (int)st)
+            continue;
+        items[num_items] = binary_record_to_item(record, names.data, names.len);
+        if (items[num_items])
+            num_items++;
+    }
+    items[num_items] = NULL;
+
+    free_entry_buf(&names);
+    free_entry_buf(&buf);
+    return items;
+}
+
+item **binary_read_v1_items(const int fd) {
+    struct entry_buf buf;
+    const int total_records = fd_load_entries(fd, _BINARY_V1_RECORD_SIZE, &buf);
+    if (total_records < 1)
+        return NULL;
+
+    struct binary_header hdr;
+    if (binary_parse_header(buf.data, &hdr) < 0 || hdr.version != 1) {
+        free_entry_buf(&buf);
+        return NULL;
+    }
+
+    int num_records = total_records - 1;
+    if (hdr.record_count < (uint32_t)num_records)
+        num_records = (int)hdr.record_count;
+
+    item **items = (item **)malloc(sizeof(item *) * (num_records + 1));
+    if (!items) {
+        free_entry_buf(&buf);
+        return NULL;
+    }
+
+    /* Status, flags, ID and code share positions with the current version */
+    int num_items = 0;
+    for (int i = 1; i <= num_records; i++) {
+        const char *record = buf.data + (size_t)i * _BINARY_V1_RECORD_SIZE;
+        item *itp = binary_record_to_nameless_item(record);
+        if (!itp)
+            continue;
+
+        size_t name_len = load_le(record + _BINARY_V1_NAME_LEN_POS, 2);
+        if (name_len > _BINARY_V1_RECORD_SIZE - _BINARY_V1_NAME_POS)
+            name_len = _BINARY_V1_RECORD_SIZE - _BINARY_V1_NAME_POS;
+        item_set_name_deep(itp, record + _BINARY_V1_NAME_POS, name_len);
+
+        items[num_items++] = itp;
+    }
+    items[num_items] = NULL;
+
+    free_entry_buf(&buf);
+    return items;
+}
+
+/* Store */
+
+static const struct store_env *binary_env = NULL;
+static char binary_path[MAX_PATH] = {'\0'};
+static char binary_names_path[MAX_PATH] = {'\0'};
+
+static_fn void binary_store_setup(const struct store_env *env) {
+    assert(env);
+
+    binary_env = env;
+    if (!*binary_path)
+        store_path(env->items_dir, _BINARY_F, binary_path);
+    if (!*binary_names_path)
+        store_path(env->items_dir, _BINARY_NAMES_F, binary_names_path);
+}
+
+/**
+ * @brief Close the files of binary item storage
+ * @param bf Binary item storage opened by binary_open
+ */
+static_fn void binary_close(struct binary_files *bf) {
+    if (bf->fd >= 0)
+        close(bf->fd);
+    if (bf->names_fd >= 0)
+        close(bf->names_fd);
+    bf->fd = -1;
+    bf->names_fd = -1;
+}
+
+/**
+ * @brief Construct the path of a file written to take the place of a file of
+ * binary item storage
+ */
+static inline void binary_side_path(const char *path, const char *ext,
+                                    char side_path[MAX_PATH]) {
+    snprintf(side_path, MAX_PATH, "%.*s%s", MAX_PATH - 5, path, ext);
+}
+
+/**
+ * @brief Write items to new records and a new name heap, syncing both
+ * @param items NULL-terminated array of items to write
+ * @param tmp_path Path of new records, replaced if it exists
+ * @param tmp_names_path Path of new name heap, replaced if it exists
+ * @return 0 on success
+ * @return -1 on error
+ */
+static_fn int binary_write_files(item **items, const char *tmp_path,
+                                 const char *tmp_names_path) {
+    struct binary_files bf;
+    bf.fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, CONF_DIR_PERMS & 0666);
+    bf.names_fd = open(tmp_names_path, O_RDWR | O_CREAT | O_TRUNC,
+                       CONF_DIR_PERMS & 0666);
+
+    int ret = (bf.fd < 0 || bf.names_fd < 0) ? -1 : binary_init(bf.fd);
+    for (size_t i = 0; items[i] && ret == 0; i++)
+        ret = binary_write_item(&bf, items[i]);
+    if (ret == 0)
+        ret = binary_env->sync_replacement(bf.names_fd);
+    if (ret == 0)
+        ret = binary_env->sync_replacement(bf.fd);
+    binary_close(&bf);
+    return ret;
+}
+
+/**
+ * @brief Rewrite binary records of an earlier version as current records and a
+ * name heap, replacing the records atomically
+ * @return 0 on success
+ * @return -1 on error, the records are unchanged
+ */
+static_fn int binary_upgrade() {
+    int fd = open(binary_path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    item **items = binary_read_v1_items(fd);
+    close(fd);
+    if (!items)
+        return -1;
+
+    char tmp_path[MAX_PATH];
+    char tmp_names_path[MAX_PATH];
+    binary_side_path(binary_path, ".tmp", tmp_path);
+    binary_side_path(binary_names_path, ".tmp", tmp_names_path);
+
+    int ret = binary_write_files(items, tmp_path, tmp_names_path);
+    item_array_free(&items, SIZE_MAX);
+
+    /* Earlier versions have no name heap, so it can be replaced first */
+    if (ret == 0)
+        ret = rename(tmp_names_path, binary_names_path);
+    if (ret == 0)
+        ret = rename(tmp_path, binary_path);
+
+    if (ret != 0) {
+#ifdef DEBUG
+        log_err("Binary records could not be upgraded");
+#endif
+        unlink(tmp_path);
+        unlink(tmp_names_path);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Move the new name heap and records of a compaction into place, if
+ * its new records were complete
+ * @return 0 on success, or if no compaction is left to finish
+ * @return -1 on error
+ * @note A compaction interrupted while its files replace the old ones is
+ * finished by the next binary_open
+ */
+static_fn int binary_finish_compact() {
+    char new_path[MAX_PATH];
+    char tmp_names_path[MAX_PATH];
+    binary_side_path(binary_path, ".new", new_path);
+    binary_side_path(binary_names_path, ".tmp", tmp_names_path);
+
+    if (access(new_path, F_OK) < 0)
+        return 0;
+
+    /* The name heap may have been replaced before the interruption */
+    if (rename(tmp_names_path, binary_names_path) < 0 && errno != ENOENT)
+        return -1;
+    return rename(new_path, binary_path);
+}
+
+/**
+ * @brief Rewrite the name heap with only the names of items held by records,
+ * and the records with the new offsets of their names
+ * @param items NULL-terminated array of every item held by records
+ * @return 0 on success
+ * @return -1 on error, the records and name heap are unchanged
+ * @note The new records are renamed once both files are written, marking the
+ * compaction as complete before either file is replaced
+ */
+static_fn int binary_compact_names(item **items) {
+    char tmp_path[MAX_PATH];
+    char tmp_names_path[MAX_PATH];
+    char new_path[MAX_PATH];
+    binary_side_path(binary_path, ".tmp", tmp_path);
+    binary_side_path(binary_names_path, ".tmp", tmp_names_path);
+    binary_side_path(binary_path, ".new", new_path);
+
+    int ret = binary_write_files(items, tmp_path, tmp_names_path);
+    if (ret == 0)
+        ret = rename(tmp_path, new_path);
+    if (ret == 0)
+        return binary_finish_compact();
+
+#ifdef DEBUG
+    log_err("Name heap could not be compacted");
+#endif
+    unlink(tmp_path);
+    unlink(tmp_names_path);
+    return -1;
+}
+
+/**
+ * @brief Open the files of binary item storage using flags, upgrading records
+ * of an earlier version first
+ * @param flags Open flags, which must allow reading
+ * @param bf Binary item storage to open, release with binary_close
+ * @return 0 on success
+ * @return -1 on error, no files are left open
+ */
+static_fn int binary_open(int flags, struct binary_files *bf) {
+    struct binary_header hdr;
+
+    bf->names_fd = -1;
+    if (binary_finish_compact() < 0) {
+#ifdef DEBUG
+        log_err("Interrupted compaction of name heap could not be finished");
+#endif
+        return -1;
+    }
+    bf->fd = open(binary_path, flags);
+
+    /* Records of earlier versions are upgraded once, when first opened */
+    if (bf->fd >= 0 && binary_read_header(bf->fd, &hdr) == 0 &&
+        hdr.version != BINARY_VERSION) {
+        close(bf->fd);
+        bf->fd = binary_upgrade() == 0 ? open(binary_path, flags) : -1;
+    }
+
+    if (bf->fd < 0 || binary_read_header(bf->fd, &hdr) < 0) {
+        printf("Item records are damaged or of an unknown version\n");
+        binary_close(bf);
+        return -1;
+    }
+
+    bf->names_fd = open(binary_names_path, flags);
+    if (bf->names_fd < 0) {
+        binary_close(bf);
+        return -1;
+    }
+
+    return 0;
+}
+
+static_fn int binary_store_create() {
+    int fd = open(binary_path, O_WRONLY | O_CREAT | O_TRUNC,
+                  CONF_DIR_PERMS & 0666);
+
+    /* Records are preceded by a header, even when empty */
+    int ret = fd < 0 ? -1 : binary_init(fd);
+    if (fd >= 0)
+        close(fd);
+    if (ret < 0)
+        return -1;
+
+    fd = open(binary_names_path, O_WRONLY | O_CREAT | O_TRUNC,
+              CONF_DIR_PERMS & 0666);
+    if (fd < 0)
+        return -1;
+    close(fd);
+    return 0;
+}
+
+static_fn void binary_store_remove() {
+    unlink(binary_path);
+    unlink(binary_names_path);
+}
+
+static_fn int binary_store_total_items() {
+    struct binary_files bf;
+    if (binary_open(O_RDONLY, &bf) < 0)
+        return -1;
+    const int num_items = binary_total_items(bf.fd);
+    binary_close(&bf);
+    return num_items;
+}
+
+static_fn int binary_store_item_status(const sitem_id id) {
+    struct binary_files bf;
+    if (binary_open(O_RDONLY, &bf) < 0)
+        return -1;
+    const int st = binary_read_status(bf.fd, id);
+    binary_close(&bf);
+    return st;
+}
+
+static_fn item *binary_store_read_item(const sitem_id id) {
+    struct binary_files bf;
+    if (binary_open(O_RDONLY, &bf) < 0)
+        return NULL;
+    item *itp = binary_read_item(&bf, id);
+    binary_close(&bf);
+    return itp;
+}
+
+static_fn item **binary_store_read_items_status(const enum status st) {
+    struct binary_files bf;
+    if (binary_open(O_RDONLY, &bf) < 0)
+        return NULL;
+    item **items = binary_read_items_status(&bf, st);
+    binary_close(&bf);
+    return items;
+}
+
+/**
+ * @brief Records are loaded into bufs[0], after the header, and the name heap
+ * into bufs[1], so that names are only read if used
+ */
+static_fn int binary_store_view_open(struct dir_item_view *view) {
+    struct binary_files bf;
+    if (binary_open(O_RDONLY, &bf) < 0)
+        return -1;
+
+    int num_entries = fd_load_entries(bf.fd, BINARY_RECORD_SIZE,
+                                      &view->bufs[0]);
+    if (num_entries >= 0 &&
+        fd_load_entries(bf.names_fd, 1, &view->bufs[1]) < 0)
+        num_entries = -1;
+    binary_close(&bf);
+
+    /* The header is not an entry */
+    view->curr_off = BINARY_RECORD_SIZE;
+    return num_entries > 0 ? num_entries - 1 : num_entries;
+}
+
+/**
+ * @brief Check whether a record holds an item of the status being iterated by
+ * a view, with a name inside the name heap of the view
+ */
+static_fn int binary_record_is_visible(const struct dir_item_view *view,
+                                       const char *record) {
+    /* Records naming bytes outside the name heap are damaged */
+    const uint64_t name_off = binary_record_name_off(record);
+    return binary_record_status(record) == (int)view->sts[view->curr_st] &&
+           name_off <= view->bufs[1].len &&
+           binary_record_name_len(record) <= view->bufs[1].len - name_off;
+}
+
+static_fn const struct dir_item_ref *
+binary_store_view_next(struct dir_item_view *view) {
+    const char *record =
+        view_next_entry(view, BINARY_RECORD_SIZE, BINARY_RECORD_SIZE, 0,
+                        binary_record_is_visible);
+    if (!record)
+        return NULL;
+
+    /* Names are held in the name heap, with their length */
+    view->ref.id = binary_record_id(record);
+    view->ref.st = view->sts[view->curr_st];
+    view->ref.code = record + BINARY_CODE_POS;
+    view->ref.name = view->bufs[1].data + binary_record_name_off(record);
+    view->ref.name_len = (int)binary_record_name_len(record);
+    view->ref.loc = -1;
+
+    return &view->ref;
+}
+
+static_fn int binary_store_append_item(const item *itp) {
+    struct binary_files bf;
+    if (binary_open(O_RDWR, &bf) < 0)
+        return -1;
+
+    /* At most one record is held for any ID */
+    int ret = -1;
+    if (binary_read_status(bf.fd, itp->item_id) < 0)
+        ret = binary_write_item(&bf, itp);
+
+    if (ret == 0)
+        ret = binary_env->sync_written(bf.names_fd, binary_names_path);
+    if (ret == 0)
+        ret = binary_env->sync_written(bf.fd, binary_path);
+    binary_close(&bf);
+    return ret;
+}
+
+static_fn int binary_store_change_status(const sitem_id id,
+                                         const enum status st) {
+    struct binary_files bf;
+    if (binary_open(O_RDWR, &bf) < 0)
+        return -1;
+
+    /* Only the status byte of the record is rewritten */
+    const int old_st = binary_read_status(bf.fd, id);
+    int ret = -1;
+    if (old_st >= 0 && (enum status)old_st != st)
+        ret = binary_write_status(bf.fd, id, st);
+
+    if (ret == 0)
+        ret = binary_env->sync_written(bf.fd, binary_path);
+    binary_close(&bf);
+    return ret;
+}
+
+static_fn int binary_store_remove_item(const sitem_id id) {
+    struct binary_files bf;
+    if (binary_open(O_RDWR, &bf) < 0)
+        return -1;
+
+    /* Only the flags byte of the record is rewritten */
+    int ret = -1;
+    if (binary_read_status(bf.fd, id) >= 0)
+        ret = binary_clear_record(bf.fd, id);
+
+    if (ret == 0)
+        ret = binary_env->sync_written(bf.fd, binary_path);
+    binary_close(&bf);
+    return ret;
+}
+
+/**
+ * @brief Status changes and removals are made in place, leaving nothing
+ * behind in records, but the names of removed and rewritten items are left
+ * in the name heap until it is rewritten once they make up most of it
+ */
+static_fn int binary_store_compact() {
+    struct binary_files bf;
+    if (binary_open(O_RDONLY, &bf) < 0)
+        return -1;
+
+    struct entry_buf buf;
+    struct entry_buf names;
+    int num_records = binary_load_records(bf.fd, &buf);
+    if (num_records >= 0 && fd_load_entries(bf.names_fd, 1, &names) < 0) {
+        free_entry_buf(&buf);
+        num_records = -1;
+    }
+    binary_close(&bf);
+    if (num_records < 0)
+        return -1;
+
+    item **items = (item **)malloc(sizeof(item *) * (num_records + 1));
+    int ret = items ? 0 : -1;
+    size_t num_items = 0;
+    uint64_t live_len = 0;
+    for (int i = 1; i <= num_records && ret == 0; i++) {
+        const char *record = buf.data + (size_t)i * BINARY_RECORD_SIZE;
+        if (binary_record_status(record) < 0)
+            continue;
+
+        /* A damaged name leaves the heap as it is, rather than lose it */
+        items[num_items] = binary_record_to_item(record, names.data, names.len);
+        if (!items[num_items])
+            ret = -1;
+        else
+            num_items++;
+        live_len += binary_record_name_len(record);
+    }
+
+    if (items)
+        items[num_items] = NULL;
+
+    /* The heap is rewritten once most of it is no longer referred to */
+    if (ret == 0 && live_len * 2 < names.len)
+        ret = binary_compact_names(items);
+
+    if (items)
+        item_array_free(&items, SIZE_MAX);
+    free_entry_buf(&names);
+    free_entry_buf(&buf);
+    return ret;
+}
+
+static_fn int binary_store_write_items(item **items) {
+    struct binary_files bf;
+    if (binary_open(O_RDWR, &bf) < 0)
+        return -1;
+
+    int ret = 0;
+    for (size_t i = 0; items[i] && ret == 0; i++)
+        ret = binary_write_item(&bf, items[i]);
+
+    if (ret == 0)
+        ret = binary_env->sync_replacement(bf.names_fd);
+    if (ret == 0)
+        ret = binary_env->sync_replacement(bf.fd);
+    binary_close(&bf);
+    return ret;
+}
+
+const struct store_ops binary_store = {
+    .setup = binary_store_setup,
+    .create = binary_store_create,
+    .remove = binary_store_remove,
+    .total_items = binary_store_total_items,
+    .item_status = binary_store_item_status,
+    .read_item = binary_store_read_item,
+    .read_items_status = binary_store_read_items_status,
+    .view_open = binary_store_view_open,
+    .view_next = binary_store_view_next,
+    .name_max = 0,
+    .append_item = binary_store_append_item,
+    .change_status = binary_store_change_status,
+    .remove_item = binary_store_remove_item,
+    .compact = binary_store_compact,
+    .write_items = binary_store_write_items,
+};
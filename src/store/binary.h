@@ -0,0 +1,264 @@
+/**
+ * @brief Binary record layout: every item of a project is stored as a small
+ * fixed-size binary record of metadata indexed by item ID, following a
+ * versioned header, with names kept apart in an append-only name heap.
+ *
+ * Records are BINARY_RECORD_SIZE bytes, a power of two, so that no record
+ * straddles a page. The header takes the place of the first record, so the
+ * record of an item with ID id is found at (id + 1) * BINARY_RECORD_SIZE.
+ * Integers are stored little-endian; a record holds an item only if its flags
+ * have _BINARY_FLAG_PRESENT set, so records never written (holes and space
+ * preallocated for growth) hold no item.
+ *
+ * A record refers to its name by offset and length in the name heap, so names
+ * have no fixed limit and scans of IDs, codes or statuses never read a name.
+ * Rewriting a record appends a new name, leaving the old one unreferenced
+ * until the name heap is compacted, once most of it is unreferenced.
+ *
+ * Version 1 records held names inline in 512 byte records; these can only be
+ * read in full, with binary_read_v1_items, so that they can be upgraded.
+ *
+ * Functions are prefixed with binary_
+ * @note This should be considered only internally and not part of the dir
+ * interface
+ */
+#ifndef BINARY_H
+#define BINARY_H
+
+#include "store/store.h"
+
+#define _BINARY_F "records"     /* Binary records in items directory */
+#define _BINARY_NAMES_F "names" /* Name heap in items directory */
+
+#define _BINARY_MAGIC "TOJOITEM" /* First bytes of the file */
+#define _BINARY_MAGIC_LEN (sizeof(_BINARY_MAGIC) - 1)
+#define BINARY_VERSION 2 /* Version of the record format written */
+
+#define BINARY_RECORD_SIZE 32 /* Bytes in each record, a power of two */
+
+/* Records preallocated at once as the file grows, one page of records */
+#define _BINARY_GROW_RECORDS (4096 / BINARY_RECORD_SIZE)
+
+/* Header field positions */
+#define BINARY_HDR_VERSION_POS _BINARY_MAGIC_LEN
+#define BINARY_HDR_SIZE_POS (BINARY_HDR_VERSION_POS + 4)
+#define BINARY_HDR_COUNT_POS (BINARY_HDR_SIZE_POS + 4)
+
+/* Record field positions */
+#define BINARY_ID_POS 0                      /* uint32_t item ID */
+#define BINARY_ST_POS (BINARY_ID_POS + 4)    /* uint8_t status */
+#define BINARY_FLAGS_POS (BINARY_ST_POS + 1) /* uint8_t flags */
+#define BINARY_CODE_POS 8                    /* ITEM_CODE_LEN code */
+#define BINARY_NAME_OFF_POS 16 /* uint64_t offset of name in name heap */
+#define BINARY_NAME_LEN_POS 24 /* uint32_t length of name */
+
+#define _BINARY_FLAG_PRESENT 0x01 /* Record holds an item */
+
+/* Version 1 records, with names stored inline following the code */
+#define _BINARY_V1_RECORD_SIZE 512
+#define _BINARY_V1_NAME_LEN_POS 6 /* uint16_t length of name */
+#define _BINARY_V1_NAME_POS 15
+
+/**
+ * @brief Fields of the file header
+ */
+struct binary_header {
+    uint32_t version;      /* Version of the record format */
+    uint32_t record_size;  /* Bytes in each record */
+    uint32_t record_count; /* Records following the header, one for each ID */
+};
+
+/**
+ * @brief Open files making up binary item storage
+ */
+struct binary_files {
+    int fd;       /* Records */
+    int names_fd; /* Name heap */
+};
+
+/**
+ * @brief Write the header of an empty file of records
+ * @param fd File descriptor of empty file opened for writing
+ * @return 0 on success
+ * @return -1 on error
+ */
+extern int binary_init(const int fd);
+
+/**
+ * @brief Parse and validate the header at the start of a file of records
+ * @param data First bytes of the file, at least BINARY_RECORD_SIZE
+ * @param hdr Header to fill
+ * @return 0 on success
+ * @return -1 if the data is not a header of any version that can be read
+ * @note Headers of version 1 records are valid, check hdr->version before
+ * reading records
+ */
+extern int binary_parse_header(const char *data, struct binary_header *hdr);
+
+/**
+ * @brief Read and validate the header of a file of records
+ * @param fd File descriptor of records opened for reading
+ * @param hdr Header to fill
+ * @return 0 on success
+ * @return -1 on error or if the file does not start with a valid header
+ * @see binary_parse_header
+ */
+extern int binary_read_header(const int fd, struct binary_header *hdr);
+
+/**
+ * @brief Get the status of the item held by a record
+ * @param record Record of BINARY_RECORD_SIZE bytes
+ * @return Status of the item in the record
+ * @return -1 if the record holds no item
+ */
+extern int binary_record_status(const char *record);
+
+/**
+ * @brief Get the ID of the item held by a record
+ * @param record Record holding an item
+ * @return ID of item
+ */
+extern sitem_id binary_record_id(const char *record);
+
+/**
+ * @brief Get the offset in the name heap of the name of the item held by a
+ * record
+ * @param record Record holding an item
+ * @return Offset of name
+ */
+extern uint64_t binary_record_name_off(const char *record);
+
+/**
+ * @brief Get the length of the name of the item held by a record
+ * @param record Record holding an item
+ * @return Length of name
+ */
+extern uint32_t binary_record_name_len(const char *record);
+
+/**
+ * @brief Read a record into a freshly allocated item, including its status
+ * @param record Record holding an item
+ * @param names Name heap, loaded in full
+ * @param names_len Bytes in names
+ * @return Pointer to new item
+ * @return NULL in case of error or if the name lies outside the name heap
+ */
+extern item *binary_record_to_item(const char *record, const char *names,
+                                   const size_t names_len);
+
+/**
+ * @brief Get the status of the item with a given ID
+ * @param fd File descriptor of records opened for reading
+ * @param id ID of item
+ * @return Status of item
+ * @return -1 if no record holds an item with the ID
+ */
+extern int binary_read_status(const int fd, const sitem_id id);
+
+/**
+ * @brief Read the item with a given ID
+ * @param bf Binary item storage opened for reading
+ * @param id ID of item
+ * @return Heap-allocated item
+ * @return NULL if no record holds an item with the ID
+ */
+extern item *binary_read_item(const struct binary_files *bf, const sitem_id id);
+
+/**
+ * @brief Write the record of an item, replacing any record with its ID and
+ * preallocating space for further records when the file grows
+ * @param bf Binary item storage opened for reading and writing
+ * @param itp Pointer to item to write
+ * @return 0 on success
+ * @return -1 on error
+ * @note The name is appended to the name heap before the record is written
+ */
+extern int binary_write_item(const struct binary_files *bf, const item *itp);
+
+/**
+ * @brief Overwrite the status of the record of an item
+ * @param fd File descriptor of records opened for writing
+ * @param id ID of item, which must be held by a record
+ * @param st New status
+ * @return 0 on success
+ * @return -1 on error
+ */
+extern int binary_write_status(const int fd, const sitem_id id,
+                               const enum status st);
+
+/**
+ * @brief Clear the flags of the record of an item, so that it holds no item
+ * @param fd File descriptor of records opened for writing
+ * @param id ID of item
+ * @return 0 on success
+ * @return -1 on error
+ * @note The name of the item is left unreferenced in the name heap until it
+ * is compacted
+ */
+extern int binary_clear_record(const int fd, const sitem_id id);
+
+/**
+ * @brief Count the items held by the records of a file
+ * @param fd File descriptor of records opened for reading
+ * @return Number of items
+ * @return -1 on error
+ */
+extern int binary_total_items(const int fd);
+
+/**
+ * @brief Read all items of a single status, in order of ID
+ * @param bf Binary item storage opened for reading
+ * @param st Status of items to read
+ * @return NULL-terminated array of item pointers allocated on the heap
+ * @return NULL on error
+ */
+extern item **binary_read_items_status(const struct binary_files *bf,
+                                       const enum status st);
+
+/**
+ * @brief Read every item of a file of version 1 records, in order of ID
+ * @param fd File descriptor of version 1 records opened for reading
+ * @return NULL-terminated array of item pointers allocated on the heap
+ * @return NULL on error or if the records are not of version 1
+ */
+extern item **binary_read_v1_items(const int fd);
+
+/**
+ * @brief Store of items in binary records and a name heap in the items
+ * directory, upgrading records of an earlier version when first opened
+ */
+extern const struct store_ops binary_store;
+
+#ifdef TJUNITTEST
+extern int make_binary_record(const item *const itp, const uint64_t name_off,
+                              char buf[BINARY_RECORD_SIZE]);
+extern int binary_reserve_records(const int fd, const uint32_t num_records);
+extern int binary_load_records(const int fd, struct entry_buf *buf);
+extern void binary_store_setup(const struct store_env *env);
+extern void binary_close(struct binary_files *bf);
+extern int binary_write_files(item **items, const char *tmp_path,
+                              const char *tmp_names_path);
+extern int binary_upgrade(void);
+extern int binary_finish_compact(void);
+extern int binary_compact_names(item **items);
+extern int binary_open(int flags, struct binary_files *bf);
+extern int binary_store_create(void);
+extern void binary_store_remove(void);
+extern int binary_store_total_items(void);
+extern int binary_store_item_status(const sitem_id id);
+extern item *binary_store_read_item(const sitem_id id);
+extern item **binary_store_read_items_status(const enum status st);
+extern int binary_store_view_open(struct dir_item_view *view);
+extern int binary_record_is_visible(const struct dir_item_view *view,
+                                    const char *record);
+extern const struct dir_item_ref *
+binary_store_view_next(struct dir_item_view *view);
+extern int binary_store_append_item(const item *itp);
+extern int binary_store_change_status(const sitem_id id,
+                                      const enum status st);
+extern int binary_store_remove_item(const sitem_id id);
+extern int binary_store_compact(void);
+extern int binary_store_write_items(item **items);
+#endif
+
+#endif
@@ -0,0 +1,980 @@
+#include "btree.h"
+#include "dev-utils/test-helpers.h"
+#ifdef DEBUG
+#include "dev-utils/debug-out.h"
+#endif
+
+/* Bytes of the header page holding fields */
+#define _BTREE_HDR_LEN (BTREE_HDR_ITEMS_POS + 4)
+
+/**
+ * @brief Get the offset of a page in the file
+ */
+static inline off_t btree_page_off(const uint32_t page_num) {
+    return (off_t)page_num * BTREE_PAGE_SIZE;
+}
+
+/**
+ * @brief Get the offset of the record at index i in a leaf
+ */
+static inline size_t btree_value_off(const int i) {
+    return BTREE_LEAF_VALUES_POS + (size_t)i * TABLE_ENTRY_LEN;
+}
+
+static inline int btree_node_type(const char *page) {
+    return (unsigned char)page[BTREE_NODE_TYPE_POS];
+}
+
+static inline int btree_node_count(const char *page) {
+    return (int)load_le(page + BTREE_NODE_COUNT_POS, 2);
+}
+
+static inline uint32_t btree_node_next(const char *page) {
+    return (uint32_t)load_le(page + BTREE_NODE_NEXT_POS, 4);
+}
+
+static inline void btree_set_next(char *page, const uint32_t next) {
+    store_le(page + BTREE_NODE_NEXT_POS, next, 4);
+}
+
+static inline uint32_t btree_key(const char *page, const int i) {
+    return (uint32_t)load_le(page + BTREE_NODE_KEYS_POS + 4 * i, 4);
+}
+
+static inline uint32_t btree_child(const char *page, const int i) {
+    return (uint32_t)load_le(page + BTREE_INTERNAL_CHILDREN_POS + 4 * i, 4);
+}
+
+/**
+ * @brief Find the position of the first key of a leaf that is not below id
+ */
+static inline int btree_leaf_pos(const char *page, const sitem_id id) {
+    int lo = 0;
+    int hi = btree_node_count(page);
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if (btree_key(page, mid) < (uint32_t)id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief Replace the keys and records of a leaf, keeping its type and next
+ * leaf
+ */
+static void btree_fill_leaf(char *page, const uint32_t *keys,
+                            const char *values, const int count) {
+    memset(page + BTREE_NODE_KEYS_POS, 0,
+           BTREE_PAGE_SIZE - BTREE_NODE_KEYS_POS);
+    store_le(page + BTREE_NODE_COUNT_POS, count, 2);
+    for (int i = 0; i < count; i++)
+        store_le(page + BTREE_NODE_KEYS_POS + 4 * i, keys[i], 4);
+    memcpy(page + BTREE_LEAF_VALUES_POS, values,
+           (size_t)count * TABLE_ENTRY_LEN);
+}
+
+/**
+ * @brief Replace the keys and count + 1 children of an internal node
+ */
+static void btree_fill_internal(char *page, const uint32_t *keys,
+                                const uint32_t *children, const int count) {
+    memset(page + BTREE_NODE_KEYS_POS, 0,
+           BTREE_PAGE_SIZE - BTREE_NODE_KEYS_POS);
+    store_le(page + BTREE_NODE_COUNT_POS, count, 2);
+    for (int i = 0; i < count; i++)
+        store_le(page + BTREE_NODE_KEYS_POS + 4 * i, keys[i], 4);
+    for (int i = 0; i <= count; i++)
+        store_le(page + BTREE_INTERNAL_CHILDREN_POS + 4 * i, children[i], 4);
+}
+
+/**
+ * @brief Read a whole page
+ * @return 0 on success
+ * @return -1 on error or if the page lies past the end of the file
+ */
+static_fn int btree_read_page(const int fd, const uint32_t page_num,
+                              char page[BTREE_PAGE_SIZE]) {
+    if (pread(fd, page, BTREE_PAGE_SIZE, btree_page_off(page_num)) !=
+        BTREE_PAGE_SIZE)
+        return -1;
+    return 0;
+}
+
+/**
+ * @brief Write a whole page, growing the file if the page is new
+ * @return 0 on success
+ * @return -1 on error
+ */
+static_fn int btree_write_page(const int fd, const uint32_t page_num,
+                               const char page[BTREE_PAGE_SIZE]) {
+    return pwrite_all(fd, page, BTREE_PAGE_SIZE, btree_page_off(page_num));
+}
+
+/**
+ * @brief Write the fields of the header page
+ * @return 0 on success
+ * @return -1 on error
+ */
+static_fn int btree_write_header(const int fd, const struct btree_header *hdr) {
+    char data[_BTREE_HDR_LEN] = {'\0'};
+    memcpy(data, _BTREE_MAGIC, _BTREE_MAGIC_LEN);
+    store_le(data + BTREE_HDR_VERSION_POS, hdr->version, 4);
+    store_le(data + BTREE_HDR_PAGE_SIZE_POS, hdr->page_size, 4);
+    store_le(data + BTREE_HDR_ROOT_POS, hdr->root, 4);
+    store_le(data + BTREE_HDR_PAGES_POS, hdr->num_pages, 4);
+    store_le(data + BTREE_HDR_ITEMS_POS, hdr->num_items, 4);
+
+    return pwrite_all(fd, data, _BTREE_HDR_LEN, 0);
+}
+
+/**
+ * @brief Reserve a page past the last page of a tree, recording it in the
+ * header before any node refers to it
+ * @param fd File descriptor of tree opened for writing
+ * @param hdr Header of tree, updated with the new page
+ * @return Page reserved
+ * @return 0 on error
+ * @note A split that is interrupted may leave the page unused, but never
+ * leaves a page holding records that a later split writes over
+ */
+static_fn uint32_t btree_reserve_page(const int fd,
+                                      struct btree_header *hdr) {
+    const uint32_t page_num = hdr->num_pages++;
+    if (btree_write_header(fd, hdr) < 0)
+        return 0;
+    return page_num;
+}
+
+int btree_init(const int fd) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+
+    /* The whole header page is written so that nodes start on a page */
+    char page[BTREE_PAGE_SIZE] = {'\0'};
+    if (btree_write_page(fd, 0, page) < 0)
+        return -1;
+
+    page[BTREE_NODE_TYPE_POS] = _BTREE_LEAF;
+    if (btree_write_page(fd, 1, page) < 0)
+        return -1;
+
+    const struct btree_header hdr = {.version = BTREE_VERSION,
+                                     .page_size = BTREE_PAGE_SIZE,
+                                     .root = 1,
+                                     .num_pages = 2,
+                                     .num_items = 0};
+    return btree_write_header(fd, &hdr);
+}
+
+int btree_read_header(const int fd, struct btree_header *hdr) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+    assert(hdr);
+
+    char data[_BTREE_HDR_LEN];
+    if (pread(fd, data, _BTREE_HDR_LEN, 0) != _BTREE_HDR_LEN ||
+        memcmp(data, _BTREE_MAGIC, _BTREE_MAGIC_LEN) != 0)
+        return -1;
+
+    hdr->version = load_le(data + BTREE_HDR_VERSION_POS, 4);
+    hdr->page_size = load_le(data + BTREE_HDR_PAGE_SIZE_POS, 4);
+    hdr->root = load_le(data + BTREE_HDR_ROOT_POS, 4);
+    hdr->num_pages = load_le(data + BTREE_HDR_PAGES_POS, 4);
+    hdr->num_items = load_le(data + BTREE_HDR_ITEMS_POS, 4);
+
+    if (hdr->version != BTREE_VERSION || hdr->page_size != BTREE_PAGE_SIZE ||
+        hdr->root == 0 || hdr->root >= hdr->num_pages) {
+#ifdef DEBUG
+        log_err("Unsupported version or damaged header of B+tree");
+#endif
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Move along the chain of leaves from a leaf to the leaf holding an ID,
+ * past leaves split by an interrupted insert that are not yet referred to by
+ * the nodes above them
+ * @param fd File descriptor of tree opened for reading
+ * @param hdr Header of tree
+ * @param id ID to search for
+ * @param page_num Page of the leaf, set to the page of the leaf moved to
+ * @param page Leaf, overwritten by the leaf moved to
+ * @return 0 on success
+ * @return -1 on error or if a damaged leaf is read
+ * @note Leaves after one holding an ID no lower than id are never read
+ */
+static_fn int btree_move_right(const int fd, const struct btree_header *hdr,
+                               const sitem_id id, uint32_t *page_num,
+                               char page[BTREE_PAGE_SIZE]) {
+    char next_page[BTREE_PAGE_SIZE];
+    int count = btree_node_count(page);
+    uint32_t next = btree_node_next(page);
+
+    for (uint32_t leaves = 0; next != 0; leaves++) {
+        if (count > 0 && btree_key(page, count - 1) >= (uint32_t)id)
+            return 0;
+
+        /* A chain longer than the file has pages is a cycle */
+        if (leaves >= hdr->num_pages || next >= hdr->num_pages ||
+            btree_read_page(fd, next, next_page) < 0)
+            return -1;
+        const int next_count = btree_node_count(next_page);
+        if (btree_node_type(next_page) != _BTREE_LEAF ||
+            next_count > BTREE_LEAF_MAX)
+            return -1;
+
+        /* Empty leaves are passed over, as they hold no IDs to compare */
+        if (next_count > 0) {
+            if (btree_key(next_page, 0) > (uint32_t)id)
+                return 0;
+            memcpy(page, next_page, BTREE_PAGE_SIZE);
+            *page_num = next;
+            count = next_count;
+        }
+        next = btree_node_next(next_page);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Read the nodes from the root down to the leaf that holds, or would
+ * hold, an ID
+ * @param fd File descriptor of tree opened for reading
+ * @param hdr Header of tree
+ * @param id ID to search for
+ * @param path Page of the node read at each depth
+ * @param child_idxs Index of the child followed from the internal node at
+ * each depth
+ * @param page Buffer left holding the leaf
+ * @return Depth of the leaf, the root being at depth 0
+ * @return -1 on error or if a damaged node is read
+ */
+static_fn int btree_descend(const int fd, const struct btree_header *hdr,
+                            const sitem_id id,
+                            uint32_t path[_BTREE_MAX_DEPTH],
+                            int child_idxs[_BTREE_MAX_DEPTH],
+                            char page[BTREE_PAGE_SIZE]) {
+    uint32_t page_num = hdr->root;
+
+    for (int depth = 0; depth < _BTREE_MAX_DEPTH; depth++) {
+        if (page_num == 0 || page_num >= hdr->num_pages ||
+            btree_read_page(fd, page_num, page) < 0)
+            return -1;
+        path[depth] = page_num;
+
+        const int count = btree_node_count(page);
+        if (btree_node_type(page) == _BTREE_LEAF) {
+            if (count > BTREE_LEAF_MAX ||
+                btree_move_right(fd, hdr, id, &path[depth], page) < 0)
+                return -1;
+            return depth;
+        }
+        if (btree_node_type(page) != _BTREE_INTERNAL ||
+            count > BTREE_INTERNAL_MAX)
+            return -1;
+
+        /* The first key above the ID bounds the child holding it */
+        int lo = 0;
+        int hi = count;
+        while (lo < hi) {
+            const int mid = lo + (hi - lo) / 2;
+            if (btree_key(page, mid) <= (uint32_t)id)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        child_idxs[depth] = lo;
+        page_num = btree_child(page, lo);
+    }
+
+#ifdef DEBUG
+    log_err("B+tree is deeper than any tree written");
+#endif
+    return -1;
+}
+
+/**
+ * @brief Find the record of an item in its leaf
+ * @param fd File descriptor of tree opened for reading
+ * @param id ID of item
+ * @param page Buffer left holding the leaf
+ * @param page_num Set to the page of the leaf
+ * @return Index of the record in the leaf
+ * @return -1 on error or if the tree holds no item with the ID
+ */
+static_fn int btree_find_in_leaf(const int fd, const sitem_id id,
+                                 char page[BTREE_PAGE_SIZE],
+                                 uint32_t *page_num) {
+    if (id < 0)
+        return -1;
+
+    struct btree_header hdr;
+    if (btree_read_header(fd, &hdr) < 0)
+        return -1;
+
+    uint32_t path[_BTREE_MAX_DEPTH];
+    int child_idxs[_BTREE_MAX_DEPTH];
+    const int depth = btree_descend(fd, &hdr, id, path, child_idxs, page);
+    if (depth < 0)
+        return -1;
+
+    const int pos = btree_leaf_pos(page, id);
+    if (pos >= btree_node_count(page) || btree_key(page, pos) != (uint32_t)id)
+        return -1;
+
+    *page_num = path[depth];
+    return pos;
+}
+
+int btree_read_status(const int fd, const sitem_id id) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+
+    char page[BTREE_PAGE_SIZE];
+    uint32_t page_num;
+    const int pos = btree_find_in_leaf(fd, id, page, &page_num);
+    if (pos < 0)
+        return -1;
+
+    return table_entry_status(page + btree_value_off(pos));
+}
+
+item *btree_read_item(const int fd, const sitem_id id) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+
+    char page[BTREE_PAGE_SIZE];
+    uint32_t page_num;
+    const int pos = btree_find_in_leaf(fd, id, page, &page_num);
+    if (pos < 0)
+        return NULL;
+
+    return table_entry_to_item(page + btree_value_off(pos));
+}
+
+/**
+ * @brief Split a full leaf in two to insert a record, linking the new leaf
+ * after it in the chain of leaves
+ * @param fd File descriptor of tree opened for writing
+ * @param page Full leaf, overwritten by its new contents
+ * @param page_num Page of the full leaf
+ * @param pos Index in the full leaf at which the record is inserted
+ * @param entry Record to insert, holding the item with the ID to insert
+ * @param new_page Page of the new leaf, reserved past the end of the file
+ * @param sep Set to the first ID held by the new leaf
+ * @return 0 on success
+ * @return -1 on error
+ * @note Records moved to the new leaf are found along the chain of leaves
+ * once the full leaf is written, even before its parent refers to the new
+ * leaf
+ */
+static_fn int btree_split_leaf(const int fd, char page[BTREE_PAGE_SIZE],
+                               const uint32_t page_num, const int pos,
+                               const char entry[TABLE_ENTRY_LEN],
+                               const uint32_t new_page, uint32_t *sep) {
+    const int total = BTREE_LEAF_MAX + 1;
+    uint32_t keys[BTREE_LEAF_MAX + 1];
+    char values[(BTREE_LEAF_MAX + 1) * TABLE_ENTRY_LEN];
+
+    const uint32_t id = (uint32_t)hex_field_to_id(entry);
+    for (int i = 0, j = 0; i < total; i++) {
+        const char *value = entry;
+        keys[i] = id;
+        if (i != pos) {
+            value = page + btree_value_off(j);
+            keys[i] = btree_key(page, j++);
+        }
+        memcpy(values + (size_t)i * TABLE_ENTRY_LEN, value, TABLE_ENTRY_LEN);
+    }
+
+    /* IDs only grow, so appending past the last leaf leaves it full */
+    int left_count = total / 2;
+    if (pos == BTREE_LEAF_MAX && btree_node_next(page) == 0)
+        left_count = BTREE_LEAF_MAX;
+
+    char right[BTREE_PAGE_SIZE] = {'\0'};
+    right[BTREE_NODE_TYPE_POS] = _BTREE_LEAF;
+    btree_fill_leaf(right, keys + left_count,
+                    values + (size_t)left_count * TABLE_ENTRY_LEN,
+                    total - left_count);
+    btree_set_next(right, btree_node_next(page));
+
+    btree_fill_leaf(page, keys, values, left_count);
+    btree_set_next(page, new_page);
+
+    *sep = keys[left_count];
+
+    /* The new leaf is unreachable until the full leaf links to it */
+    if (btree_write_page(fd, new_page, right) < 0 ||
+        btree_write_page(fd, page_num, page) < 0)
+        return -1;
+    return 0;
+}
+
+/**
+ * @brief Get the keys and children of an internal node with a separating key
+ * and the child to its right inserted
+ * @param page Internal node
+ * @param pos Index of the child split in two
+ * @param sep First ID held by the new child
+ * @param child Page of the new child
+ * @param keys Set to count + 1 keys
+ * @param children Set to count + 2 children
+ * @return Number of keys in the node before the insertion, count
+ */
+static int btree_internal_insert(const char *page, const int pos,
+                                 const uint32_t sep, const uint32_t child,
+                                 uint32_t *keys, uint32_t *children) {
+    const int count = btree_node_count(page);
+    for (int i = 0, j = 0; i <= count; i++)
+        keys[i] = i == pos ? sep : btree_key(page, j++);
+    for (int i = 0, j = 0; i <= count + 1; i++)
+        children[i] = i == pos + 1 ? child : btree_child(page, j++);
+    return count;
+}
+
+/**
+ * @brief Insert a separating key and the child to its right into the
+ * internal nodes above a split node, splitting them in turn while they are
+ * full and growing a new root if the root is split
+ * @param fd File descriptor of tree opened for reading and writing
+ * @param hdr Header of tree, updated with any new pages and root
+ * @param path Page of the node read at each depth, see btree_descend
+ * @param child_idxs Index of the child followed at each depth
+ * @param depth Depth of the split node
+ * @param sep First ID held by the new node
+ * @param child Page of the new node
+ * @return 0 on success
+ * @return -1 on error
+ * @note The right half of a split node is referred to by the node above
+ * before its left half is written, so that an interrupted split leaves every
+ * child reachable from the root
+ */
+static_fn int btree_insert_internal(const int fd, struct btree_header *hdr,
+                                    const uint32_t path[_BTREE_MAX_DEPTH],
+                                    const int child_idxs[_BTREE_MAX_DEPTH],
+                                    const int depth, uint32_t sep,
+                                    uint32_t child) {
+    char page[BTREE_PAGE_SIZE];
+    uint32_t keys[BTREE_INTERNAL_MAX + 1];
+    uint32_t children[BTREE_INTERNAL_MAX + 2];
+    uint32_t seps[_BTREE_MAX_DEPTH];
+    uint32_t new_children[_BTREE_MAX_DEPTH];
+
+    int d = depth;
+    while (--d >= 0) {
+        if (btree_read_page(fd, path[d], page) < 0)
+            return -1;
+
+        seps[d] = sep;
+        new_children[d] = child;
+        const int count = btree_internal_insert(page, child_idxs[d], sep,
+                                                child, keys, children);
+        if (count < BTREE_INTERNAL_MAX) {
+            btree_fill_internal(page, keys, children, count + 1);
+            if (btree_write_page(fd, path[d], page) < 0)
+                return -1;
+            break;
+        }
+
+        /* The middle key moves up to separate the two halves */
+        const int mid = (count + 1) / 2;
+        char right[BTREE_PAGE_SIZE] = {'\0'};
+        right[BTREE_NODE_TYPE_POS] = _BTREE_INTERNAL;
+        btree_fill_internal(right, keys + mid + 1, children + mid + 1,
+                            count - mid);
+
+        sep = keys[mid];
+        child = btree_reserve_page(fd, hdr);
+        if (child == 0 || btree_write_page(fd, child, right) < 0)
+            return -1;
+    }
+
+    if (d < 0) {
+        /* The root was split, so a new root refers to both halves */
+        char root[BTREE_PAGE_SIZE] = {'\0'};
+        root[BTREE_NODE_TYPE_POS] = _BTREE_INTERNAL;
+        keys[0] = sep;
+        children[0] = hdr->root;
+        children[1] = child;
+        btree_fill_internal(root, keys, children, 1);
+
+        const uint32_t root_num = btree_reserve_page(fd, hdr);
+        if (root_num == 0 || btree_write_page(fd, root_num, root) < 0)
+            return -1;
+
+        hdr->root = root_num;
+        if (btree_write_header(fd, hdr) < 0)
+            return -1;
+    }
+
+    /* Split nodes are cut to their left halves from the top down */
+    for (int e = d + 1; e < depth; e++) {
+        if (btree_read_page(fd, path[e], page) < 0)
+            return -1;
+
+        const int count = btree_internal_insert(
+            page, child_idxs[e], seps[e], new_children[e], keys, children);
+        btree_fill_internal(page, keys, children, (count + 1) / 2);
+        if (btree_write_page(fd, path[e], page) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Insert a table record, see btree_insert_item
+ * @param fd File descriptor of tree opened for reading and writing
+ * @param entry Record holding the item with the ID to insert
+ * @return 0 on success
+ * @return -1 on error or if the tree already holds an item with the ID
+ */
+static_fn int btree_insert_entry(const int fd,
+                                 const char entry[TABLE_ENTRY_LEN]) {
+    const sitem_id id = hex_field_to_id(entry);
+    if (id < 0)
+        return -1;
+
+    struct btree_header hdr;
+    if (btree_read_header(fd, &hdr) < 0)
+        return -1;
+
+    uint32_t path[_BTREE_MAX_DEPTH];
+    int child_idxs[_BTREE_MAX_DEPTH];
+    char page[BTREE_PAGE_SIZE];
+    const int depth = btree_descend(fd, &hdr, id, path, child_idxs, page);
+    if (depth < 0)
+        return -1;
+
+    /* The tree holds at most one record for any ID */
+    const int count = btree_node_count(page);
+    const int pos = btree_leaf_pos(page, id);
+    if (pos < count && btree_key(page, pos) == (uint32_t)id)
+        return -1;
+
+    if (count < BTREE_LEAF_MAX) {
+        /* Keys and records after the new one are shifted along in place */
+        const size_t key_off = BTREE_NODE_KEYS_POS + 4 * (size_t)pos;
+        memmove(page + key_off + 4, page + key_off, 4 * (size_t)(count - pos));
+        memmove(page + btree_value_off(pos + 1), page + btree_value_off(pos),
+                (size_t)(count - pos) * TABLE_ENTRY_LEN);
+        store_le(page + key_off, (uint32_t)id, 4);
+        memcpy(page + btree_value_off(pos), entry, TABLE_ENTRY_LEN);
+        store_le(page + BTREE_NODE_COUNT_POS, count + 1, 2);
+
+        if (btree_write_page(fd, path[depth], page) < 0)
+            return -1;
+    } else {
+        uint32_t sep;
+        const uint32_t new_page = btree_reserve_page(fd, &hdr);
+        if (new_page == 0 ||
+            btree_split_leaf(fd, page, path[depth], pos, entry, new_page,
+                             &sep) < 0 ||
+            btree_insert_internal(fd, &hdr, path, child_idxs, depth, sep,
+                                  new_page) < 0)
+            return -1;
+    }
+
+    hdr.num_items++;
+    return btree_write_header(fd, &hdr);
+}
+
+int btree_insert_item(const int fd, const item *itp) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+    assert(itp);
+
+    char entry[TABLE_ENTRY_LEN + 1];
+    if (itp->item_id < 0 || table_make_entry(itp, entry) < 0)
+        return -1;
+    return btree_insert_entry(fd, entry);
+}
+
+int btree_write_status(const int fd, const sitem_id id, const enum status st) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+    assert(st < ITEM_STATUS_COUNT);
+
+    char page[BTREE_PAGE_SIZE];
+    uint32_t page_num;
+    const int pos = btree_find_in_leaf(fd, id, page, &page_num);
+    if (pos < 0)
+        return -1;
+
+    /* Only the status column of the record is rewritten */
+    char *entry = page + btree_value_off(pos);
+    table_entry_set_status(entry, st);
+    return pwrite_all(fd, entry + TABLE_ST_POS, 1,
+                      btree_page_off(page_num) + btree_value_off(pos) +
+                          TABLE_ST_POS);
+}
+
+int btree_remove_item(const int fd, const sitem_id id) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+
+    struct btree_header hdr;
+    if (btree_read_header(fd, &hdr) < 0)
+        return -1;
+
+    char page[BTREE_PAGE_SIZE];
+    uint32_t page_num;
+    const int pos = btree_find_in_leaf(fd, id, page, &page_num);
+    if (pos < 0)
+        return -1;
+
+    /* Keys and records after the removed one are shifted back in place */
+    const int count = btree_node_count(page);
+    const size_t key_off = BTREE_NODE_KEYS_POS + 4 * (size_t)pos;
+    memmove(page + key_off, page + key_off + 4, 4 * (size_t)(count - pos - 1));
+    memmove(page + btree_value_off(pos), page + btree_value_off(pos + 1),
+            (size_t)(count - pos - 1) * TABLE_ENTRY_LEN);
+    store_le(page + BTREE_NODE_COUNT_POS, count - 1, 2);
+
+    if (btree_write_page(fd, page_num, page) < 0)
+        return -1;
+
+    hdr.num_items--;
+    return btree_write_header(fd, &hdr);
+}
+
+int btree_total_items(const int fd) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+
+    struct btree_header hdr;
+    if (btree_read_header(fd, &hdr) < 0)
+        return -1;
+    return (int)hdr.num_items;
+}
+
+/**
+ * @brief Read the leftmost leaf of a tree, holding its lowest IDs
+ * @param fd File descriptor of tree opened for reading
+ * @param hdr Header of tree
+ * @param page Buffer left holding the leaf
+ * @return 0 on success
+ * @return -1 on error or if a damaged node is read
+ */
+static_fn int btree_first_leaf(const int fd, const struct btree_header *hdr,
+                               char page[BTREE_PAGE_SIZE]) {
+    uint32_t page_num = hdr->root;
+
+    for (int depth = 0; depth < _BTREE_MAX_DEPTH; depth++) {
+        if (page_num == 0 || page_num >= hdr->num_pages ||
+            btree_read_page(fd, page_num, page) < 0)
+            return -1;
+        if (btree_node_type(page) == _BTREE_LEAF)
+            return 0;
+        if (btree_node_type(page) != _BTREE_INTERNAL)
+            return -1;
+        page_num = btree_child(page, 0);
+    }
+
+    return -1;
+}
+
+int btree_load(const int fd, struct entry_buf *buf) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+    assert(buf);
+
+    memset(buf, 0, sizeof(*buf));
+
+    struct btree_header hdr;
+    char page[BTREE_PAGE_SIZE];
+    if (btree_read_header(fd, &hdr) < 0 || btree_first_leaf(fd, &hdr, page) < 0)
+        return -1;
+
+    size_t capacity = hdr.num_items;
+    buf->data = malloc(capacity * TABLE_ENTRY_LEN + 1);
+    if (!buf->data)
+        return -1;
+
+    /* Records of a leaf are contiguous and leaves are chained in ID order */
+    size_t num_entries = 0;
+    for (uint32_t leaves = 1;; leaves++) {
+        const size_t count = (size_t)btree_node_count(page);
+        if (btree_node_type(page) != _BTREE_LEAF || count > BTREE_LEAF_MAX)
+            break;
+
+        /* An insert interrupted before the header is written leaves more
+         * records than the header counts */
+        if (num_entries + count > capacity) {
+            capacity = num_entries + BTREE_LEAF_MAX;
+            char *data = realloc(buf->data, capacity * TABLE_ENTRY_LEN + 1);
+            if (!data)
+                break;
+            buf->data = data;
+        }
+
+        memcpy(buf->data + num_entries * TABLE_ENTRY_LEN,
+               page + BTREE_LEAF_VALUES_POS, count * TABLE_ENTRY_LEN);
+        num_entries += count;
+
+        const uint32_t next = btree_node_next(page);
+        if (next == 0) {
+            buf->len = num_entries * TABLE_ENTRY_LEN;
+            return (int)num_entries;
+        }
+
+        /* A chain longer than the file has pages is a cycle */
+        if (leaves >= hdr.num_pages || next >= hdr.num_pages ||
+            btree_read_page(fd, next, page) < 0)
+            break;
+    }
+
+#ifdef DEBUG
+    log_err("Damaged chain of leaves in B+tree");
+#endif
+    free_entry_buf(buf);
+    return -1;
+}
+
+item **btree_read_items_status(const int fd, const enum status st) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+    assert(st < ITEM_STATUS_COUNT);
+
+    struct entry_buf buf;
+    const int num_entries = btree_load(fd, &buf);
+    if (num_entries < 0)
+        return NULL;
+
+    item **items = (item **)malloc(sizeof(item *) * (num_entries + 1));
+    if (!items) {
+        free_entry_buf(&buf);
+        return NULL;
+    }
+
+    int num_items = 0;
+    for (int i = 0; i < num_entries; i++) {
+        const char *entry = buf.data + (size_t)i * TABLE_ENTRY_LEN;
+        if (table_entry_status(entry) != (int)st)
+            continue;
+        items[num_items] = table_entry_to_item(entry);
+        if (items[num_items])
+            num_items++;
+    }
+    items[num_items] = NULL;
+
+    free_entry_buf(&buf);
+    return items;
+}
+
+int btree_rebuild(const char *path, int (*sync)(const int fd)) {
+    assert(path);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    /* Leaves are left sparse by removals, as nodes are never merged */
+    struct btree_header hdr;
+    if (btree_read_header(fd, &hdr) < 0) {
+        close(fd);
+        return -1;
+    }
+    if (hdr.num_pages <= 2 ||
+        (size_t)hdr.num_items * _BTREE_REBUILD_FILL >=
+            (size_t)(hdr.num_pages - 1) * BTREE_LEAF_MAX) {
+        close(fd);
+        return 0;
+    }
+
+    struct entry_buf buf;
+    const int num_entries = btree_load(fd, &buf);
+    close(fd);
+    if (num_entries < 0)
+        return -1;
+
+    char tmp_path[MAX_PATH];
+    snprintf(tmp_path, sizeof(tmp_path), "%.*s.tmp", MAX_PATH - 5, path);
+    fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, CONF_DIR_PERMS & 0666);
+    int ret = fd < 0 ? -1 : btree_init(fd);
+
+    /* Records are inserted in order of ID, so each leaf is left full */
+    for (int i = 0; ret == 0 && i < num_entries; i++)
+        ret = btree_insert_entry(fd, buf.data + (size_t)i * TABLE_ENTRY_LEN);
+    if (ret == 0 && sync)
+        ret = sync(fd);
+    if (fd >= 0)
+        close(fd);
+    if (ret == 0)
+        ret = rename(tmp_path, path);
+
+    if (ret != 0)
+        unlink(tmp_path);
+    free_entry_buf(&buf);
+    return ret;
+}
+
+/* Store */
+
+static const struct store_env *btree_env = NULL;
+static char btree_path[MAX_PATH] = {'\0'};
+
+static_fn void btree_store_setup(const struct store_env *env) {
+    assert(env);
+
+    btree_env = env;
+    if (!*btree_path)
+        store_path(env->items_dir, _BTREE_F, btree_path);
+}
+
+/**
+ * @brief Open the B+tree of items
+ * @param flags Flags to open the file with
+ * @return open file descriptor
+ * @return -1 on error
+ */
+static_fn int btree_store_open(int flags) {
+    return open(btree_path, flags);
+}
+
+static_fn int btree_store_create() {
+    int fd = open(btree_path, O_WRONLY | O_CREAT | O_TRUNC,
+                  CONF_DIR_PERMS & 0666);
+    if (fd < 0)
+        return -1;
+
+    /* An empty tree is a header and an empty root leaf */
+    const int ret = btree_init(fd);
+    close(fd);
+    return ret;
+}
+
+static_fn void btree_store_remove() {
+    unlink(btree_path);
+}
+
+static_fn int btree_store_total_items() {
+    int fd = btree_store_open(O_RDONLY);
+    if (fd < 0)
+        return -1;
+    const int num_items = btree_total_items(fd);
+    close(fd);
+    return num_items;
+}
+
+static_fn int btree_store_item_status(const sitem_id id) {
+    int fd = btree_store_open(O_RDONLY);
+    if (fd < 0)
+        return -1;
+    const int st = btree_read_status(fd, id);
+    close(fd);
+    return st;
+}
+
+static_fn item *btree_store_read_item(const sitem_id id) {
+    int fd = btree_store_open(O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    item *itp = btree_read_item(fd, id);
+    close(fd);
+    return itp;
+}
+
+static_fn item **btree_store_read_items_status(const enum status st) {
+    int fd = btree_store_open(O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    item **items = btree_read_items_status(fd, st);
+    close(fd);
+    return items;
+}
+
+/**
+ * @brief Leaves are read along their chain, in order of ID
+ */
+static_fn int btree_store_view_open(struct dir_item_view *view) {
+    int fd = btree_store_open(O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    const int num_entries = btree_load(fd, &view->bufs[0]);
+    close(fd);
+    return num_entries;
+}
+
+static_fn int btree_store_append_item(const item *itp) {
+    int fd = btree_store_open(O_RDWR);
+    if (fd < 0)
+        return -1;
+
+    /* Only the pages on the path to the leaf, and any split, are written */
+    int ret = btree_insert_item(fd, itp);
+    if (ret == 0)
+        ret = btree_env->sync_written(fd, btree_path);
+    close(fd);
+    return ret;
+}
+
+static_fn int btree_store_change_status(const sitem_id id,
+                                        const enum status st) {
+    int fd = btree_store_open(O_RDWR);
+    if (fd < 0)
+        return -1;
+
+    /* Only the status column of the record in its leaf is rewritten */
+    const int old_st = btree_read_status(fd, id);
+    int ret = -1;
+    if (old_st >= 0 && (enum status)old_st != st)
+        ret = btree_write_status(fd, id, st);
+
+    if (ret == 0)
+        ret = btree_env->sync_written(fd, btree_path);
+    close(fd);
+    return ret;
+}
+
+static_fn int btree_store_remove_item(const sitem_id id) {
+    int fd = btree_store_open(O_RDWR);
+    if (fd < 0)
+        return -1;
+
+    int ret = btree_remove_item(fd, id);
+    if (ret == 0)
+        ret = btree_env->sync_written(fd, btree_path);
+    close(fd);
+    return ret;
+}
+
+/**
+ * @brief Status changes and removals are made in place, leaving no dead
+ * records behind, but leaves emptied by removals are reclaimed
+ */
+static_fn int btree_store_compact() {
+    return btree_rebuild(btree_path, btree_env->sync_replacement);
+}
+
+static_fn int btree_store_write_items(item **items) {
+    int fd = btree_store_open(O_RDWR);
+    if (fd < 0)
+        return -1;
+
+    int ret = 0;
+    for (size_t i = 0; items[i] && ret == 0; i++)
+        ret = btree_insert_item(fd, items[i]);
+
+    if (ret == 0)
+        ret = btree_env->sync_replacement(fd);
+    close(fd);
+    return ret;
+}
+
+const struct store_ops btree_store = {
+    .setup = btree_store_setup,
+    .create = btree_store_create,
+    .remove = btree_store_remove,
+    .total_items = btree_store_total_items,
+    .item_status = btree_store_item_status,
+    .read_item = btree_store_read_item,
+    .read_items_status = btree_store_read_items_status,
+    .view_open = btree_store_view_open,
+    .view_next = table_view_next,
+    .name_max = ITEM_NAME_MAX,
+    .append_item = btree_store_append_item,
+    .change_status = btree_store_change_status,
+    .remove_item = btree_store_remove_item,
+    .compact = btree_store_compact,
+    .write_items = btree_store_write_items,
+};
@@ -0,0 +1,235 @@
+/**
+ * @brief B+tree layout: every item of a project is stored in the leaves of an
+ * on-disk B+tree of fixed-size pages keyed by item ID.
+ *
+ * The first page is a header naming the root page; every other page is a
+ * node. Leaves hold item table records (see table.h) sorted by ID and are
+ * chained in order of ID, so a scan of every item reads each leaf once.
+ * Internal nodes hold separating IDs and the pages of their children: the
+ * child at index i holds IDs below key i and at least key i - 1.
+ *
+ * Lookups, inserts and status changes read one page for each level of the
+ * tree, and write only the pages they change. Integers are stored
+ * little-endian.
+ *
+ * Pages are reserved in the header before any node refers to them, and a
+ * split leaf is written before the nodes above it, so an interrupted split
+ * leaves new leaves that are found by following the chain from the leaf the
+ * internal nodes lead to.
+ *
+ * Functions are prefixed with btree_
+ * @note This should be considered only internally and not part of the dir
+ * interface
+ */
+#ifndef BTREE_H
+#define BTREE_H
+
+#include "store/store.h"
+#include "store/table.h"
+
+#define _BTREE_F "btree" /* B+tree in items directory */
+
+#define _BTREE_MAGIC "TOJOTREE" /* First bytes of the file */
+#define _BTREE_MAGIC_LEN (sizeof(_BTREE_MAGIC) - 1)
+#define BTREE_VERSION 1 /* Version of the page format written */
+
+#define BTREE_PAGE_SIZE 4096  /* Bytes in each page */
+#define _BTREE_MAX_DEPTH 16   /* Levels of any tree that can be read */
+#define _BTREE_REBUILD_FILL 2 /* Rebuilt once leaves are under 1/N full */
+
+/* Header page field positions, all uint32_t */
+#define BTREE_HDR_VERSION_POS _BTREE_MAGIC_LEN
+#define BTREE_HDR_PAGE_SIZE_POS (BTREE_HDR_VERSION_POS + 4)
+#define BTREE_HDR_ROOT_POS (BTREE_HDR_PAGE_SIZE_POS + 4)
+#define BTREE_HDR_PAGES_POS (BTREE_HDR_ROOT_POS + 4)
+#define BTREE_HDR_ITEMS_POS (BTREE_HDR_PAGES_POS + 4)
+
+/* Node field positions */
+#define BTREE_NODE_TYPE_POS 0  /* uint8_t _BTREE_LEAF or _BTREE_INTERNAL */
+#define BTREE_NODE_COUNT_POS 2 /* uint16_t number of keys */
+#define BTREE_NODE_NEXT_POS 4  /* uint32_t next leaf, 0 for the last leaf */
+#define BTREE_NODE_KEYS_POS 8  /* uint32_t keys, sorted */
+
+#define _BTREE_LEAF 1
+#define _BTREE_INTERNAL 2
+
+/* Leaves hold a key and a table record for each item */
+#define BTREE_LEAF_MAX                                                         \
+    ((int)((BTREE_PAGE_SIZE - BTREE_NODE_KEYS_POS) / (4 + TABLE_ENTRY_LEN)))
+#define BTREE_LEAF_VALUES_POS (BTREE_NODE_KEYS_POS + 4 * BTREE_LEAF_MAX)
+
+/* Internal nodes hold one more uint32_t child page than keys */
+#define BTREE_INTERNAL_MAX ((BTREE_PAGE_SIZE - BTREE_NODE_KEYS_POS - 4) / 8)
+#define BTREE_INTERNAL_CHILDREN_POS                                            \
+    (BTREE_NODE_KEYS_POS + 4 * BTREE_INTERNAL_MAX)
+
+/**
+ * @brief Fields of the header page
+ */
+struct btree_header {
+    uint32_t version;   /* Version of the page format */
+    uint32_t page_size; /* Bytes in each page */
+    uint32_t root;      /* Page of the root node */
+    uint32_t num_pages; /* Pages in the file, including the header */
+    uint32_t num_items; /* Items held by the leaves */
+};
+
+/**
+ * @brief Write the header and empty root leaf of a new tree
+ * @param fd File descriptor of empty file opened for writing
+ * @return 0 on success
+ * @return -1 on error
+ */
+extern int btree_init(const int fd);
+
+/**
+ * @brief Read and validate the header page of a tree
+ * @param fd File descriptor of tree opened for reading
+ * @param hdr Header to fill
+ * @return 0 on success
+ * @return -1 on error or if the file does not start with a valid header
+ */
+extern int btree_read_header(const int fd, struct btree_header *hdr);
+
+/**
+ * @brief Get the status of the item with a given ID
+ * @param fd File descriptor of tree opened for reading
+ * @param id ID of item
+ * @return Status of item
+ * @return -1 if the tree holds no item with the ID
+ */
+extern int btree_read_status(const int fd, const sitem_id id);
+
+/**
+ * @brief Read the item with a given ID
+ * @param fd File descriptor of tree opened for reading
+ * @param id ID of item
+ * @return Heap-allocated item
+ * @return NULL if the tree holds no item with the ID
+ */
+extern item *btree_read_item(const int fd, const sitem_id id);
+
+/**
+ * @brief Insert the record of an item, splitting full nodes on the way back
+ * up to the root
+ * @param fd File descriptor of tree opened for reading and writing
+ * @param itp Pointer to item to write
+ * @return 0 on success
+ * @return -1 on error or if the tree already holds an item with the ID
+ * @note New pages are reserved and written before the pages referring to
+ * them, and the count of items in the header is written last
+ */
+extern int btree_insert_item(const int fd, const item *itp);
+
+/**
+ * @brief Overwrite the status of the record of an item in its leaf
+ * @param fd File descriptor of tree opened for reading and writing
+ * @param id ID of item
+ * @param st New status
+ * @return 0 on success
+ * @return -1 on error or if the tree holds no item with the ID
+ */
+extern int btree_write_status(const int fd, const sitem_id id,
+                              const enum status st);
+
+/**
+ * @brief Remove the record of an item from its leaf
+ * @param fd File descriptor of tree opened for reading and writing
+ * @param id ID of item
+ * @return 0 on success
+ * @return -1 on error or if the tree holds no item with the ID
+ * @note Nodes are never merged, so a leaf may be left empty in the chain
+ * until the tree is rebuilt, see btree_rebuild
+ */
+extern int btree_remove_item(const int fd, const sitem_id id);
+
+/**
+ * @brief Count the items held by the tree
+ * @param fd File descriptor of tree opened for reading
+ * @return Number of items
+ * @return -1 on error
+ */
+extern int btree_total_items(const int fd);
+
+/**
+ * @brief Load the record of every item, following the chain of leaves
+ * @param fd File descriptor of tree opened for reading
+ * @param buf Entry buffer to load records into in order of ID, release with
+ * free_entry_buf
+ * @return Number of records loaded into buf
+ * @return -1 on error, buf is left empty
+ */
+extern int btree_load(const int fd, struct entry_buf *buf);
+
+/**
+ * @brief Read all items of a single status, in order of ID
+ * @param fd File descriptor of tree opened for reading
+ * @param st Status of items to read
+ * @return NULL-terminated array of item pointers allocated on the heap
+ * @return NULL on error
+ */
+extern item **btree_read_items_status(const int fd, const enum status st);
+
+/**
+ * @brief Rebuild a tree from its records if its leaves are less than
+ * 1/_BTREE_REBUILD_FILL full on average, replacing the file atomically
+ * @param path Path of tree
+ * @param sync Function to sync the new tree before it replaces the old one,
+ * or NULL
+ * @return 0 on success, whether or not the tree is rebuilt
+ * @return -1 on error, the tree is unchanged
+ */
+extern int btree_rebuild(const char *path, int (*sync)(const int fd));
+
+/**
+ * @brief Store of items in a B+tree in the items directory
+ */
+extern const struct store_ops btree_store;
+
+#ifdef TJUNITTEST
+extern int btree_read_page(const int fd, const uint32_t page_num,
+                           char page[BTREE_PAGE_SIZE]);
+extern int btree_write_page(const int fd, const uint32_t page_num,
+                            const char page[BTREE_PAGE_SIZE]);
+extern int btree_write_header(const int fd, const struct btree_header *hdr);
+extern uint32_t btree_reserve_page(const int fd, struct btree_header *hdr);
+extern int btree_move_right(const int fd, const struct btree_header *hdr,
+                            const sitem_id id, uint32_t *page_num,
+                            char page[BTREE_PAGE_SIZE]);
+extern int btree_descend(const int fd, const struct btree_header *hdr,
+                         const sitem_id id,
+                         uint32_t path[_BTREE_MAX_DEPTH],
+                         int child_idxs[_BTREE_MAX_DEPTH],
+                         char page[BTREE_PAGE_SIZE]);
+extern int btree_insert_entry(const int fd,
+                              const char entry[TABLE_ENTRY_LEN]);
+extern int btree_find_in_leaf(const int fd, const sitem_id id,
+                              char page[BTREE_PAGE_SIZE], uint32_t *page_num);
+extern int btree_split_leaf(const int fd, char page[BTREE_PAGE_SIZE],
+                            const uint32_t page_num, const int pos,
+                            const char entry[TABLE_ENTRY_LEN],
+                            const uint32_t new_page, uint32_t *sep);
+extern int btree_insert_internal(const int fd, struct btree_header *hdr,
+                                 const uint32_t path[_BTREE_MAX_DEPTH],
+                                 const int child_idxs[_BTREE_MAX_DEPTH],
+                                 const int depth, uint32_t sep,
+                                 uint32_t child);
+extern int btree_first_leaf(const int fd, const struct btree_header *hdr,
+                            char page[BTREE_PAGE_SIZE]);
+extern void btree_store_setup(const struct store_env *env);
+extern int btree_store_open(int flags);
+extern int btree_store_create(void);
+extern void btree_store_remove(void);
+extern int btree_store_total_items(void);
+extern int btree_store_item_status(const sitem_id id);
+extern item *btree_store_read_item(const sitem_id id);
+extern item **btree_store_read_items_status(const enum status st);
+extern int btree_store_view_open(struct dir_item_view *view);
+extern int btree_store_append_item(const item *itp);
+extern int btree_store_change_status(const sitem_id id, const enum status st);
+extern int btree_store_remove_item(const sitem_id id);
+extern int btree_store_compact(void);
+extern int btree_store_write_items(item **items);
+#endif
+
+#endif
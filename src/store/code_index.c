@@ -0,0 +1,414 @@
+#include "code_index.h"
+#include "dev-utils/test-helpers.h"
+#ifdef DEBUG
+#include "dev-utils/debug-out.h"
+#endif
+
+/**
+ * @brief Write an entry of the index, or its header
+ * @param entry Buffer of at least _CODE_INDEX_ENTRY_LEN + 1 bytes
+ * @param code ITEM_CODE_LEN code, or _CODE_INDEX_HDR
+ * @param id ID of item, or number of sorted entries
+ */
+static_fn void code_index_make_entry(char *entry, const char *code,
+                                     const sitem_id id) {
+    snprintf(entry, _CODE_INDEX_ENTRY_LEN + 1, "%.*s:%0*X\n", ITEM_CODE_LEN,
+             code, (int)HEX_LEN(sitem_id), id);
+}
+
+/**
+ * @brief Order entries, or a code and an entry, by code
+ */
+static_fn int code_index_compare(const void *a, const void *b) {
+    return memcmp(a, b, ITEM_CODE_LEN);
+}
+
+/**
+ * @brief Load the header and every entry of the index
+ * @param path Path of index
+ * @param buf Set to the loaded index, empty if the index is missing
+ * @return Number of entries loaded, including the header
+ * @return -1 on error
+ */
+static_fn int code_index_load(const char *path, struct entry_buf *buf) {
+    buf->data = NULL;
+    buf->len = 0;
+    buf->is_mapped = 0;
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return errno == ENOENT ? 0 : -1;
+
+    const int num_entries = fd_load_entries(fd, _CODE_INDEX_ENTRY_LEN, buf);
+    close(fd);
+    return num_entries;
+}
+
+/**
+ * @brief Get the number of sorted entries of a loaded index
+ * @param buf Index loaded with code_index_load
+ * @return Number of entries following the header in order of code, 0 if the
+ * index has no header
+ */
+static_fn int code_index_sorted(const struct entry_buf *buf) {
+    const int num_entries = (int)(buf->len / _CODE_INDEX_ENTRY_LEN) - 1;
+    if (num_entries < 0 || memcmp(buf->data, _CODE_INDEX_HDR, ITEM_CODE_LEN))
+        return 0;
+
+    const sitem_id num_sorted = hex_field_to_id(buf->data + _CODE_INDEX_ID_POS);
+    return num_sorted < 0 || num_sorted > num_entries ? 0 : num_sorted;
+}
+
+/**
+ * @brief Search sorted entries for a code
+ * @param entries Entries in order of code
+ * @param num_entries Number of entries
+ * @param code Full ITEM_CODE_LEN code
+ * @return Entry of code
+ * @return NULL if no entry holds code
+ */
+static_fn const char *code_index_search(const char *entries,
+                                        const int num_entries,
+                                        const char *code) {
+    return bsearch(code, entries, (size_t)num_entries, _CODE_INDEX_ENTRY_LEN,
+                   code_index_compare);
+}
+
+/**
+ * @brief Replace the index with sorted entries
+ * @param path Path of index
+ * @param data Buffer of a header followed by entries in order of code, the
+ * header is filled in
+ * @param num_entries Number of entries following the header
+ * @param sync Function syncing the index before it is replaced, NULL to not
+ * sync
+ * @return 0 on success
+ * @return -1 on error, the index is unchanged
+ */
+static_fn int code_index_replace(const char *path, char *data,
+                                 const int num_entries,
+                                 int (*sync)(const int fd)) {
+    char hdr[_CODE_INDEX_ENTRY_LEN + 1];
+    code_index_make_entry(hdr, _CODE_INDEX_HDR, num_entries);
+    memcpy(data, hdr, _CODE_INDEX_ENTRY_LEN);
+
+    return replace_file(
+        path, data, (size_t)(num_entries + 1) * _CODE_INDEX_ENTRY_LEN, sync);
+}
+
+/**
+ * @brief Sort the tail of a loaded index, merge it into the sorted entries,
+ * and replace the index with the result
+ * @param path Path of index
+ * @param buf Index loaded with code_index_load
+ * @param sync Function syncing the index before it is replaced, NULL to not
+ * sync
+ * @return 0 on success
+ * @return -1 on error, the index is unchanged
+ * @note Entries of a code already sorted are replaced by those in the tail
+ */
+static_fn int code_index_merge(const char *path, const struct entry_buf *buf,
+                               int (*sync)(const int fd)) {
+    const size_t len = _CODE_INDEX_ENTRY_LEN;
+    const int has_hdr =
+        buf->len >= len && !memcmp(buf->data, _CODE_INDEX_HDR, ITEM_CODE_LEN);
+    const char *sorted = buf->data + (has_hdr ? len : 0);
+    const int num_sorted = code_index_sorted(buf);
+    const int num_tail = (int)(buf->len / len) - has_hdr - num_sorted;
+
+    char *tail = malloc((size_t)num_tail * len + 1);
+    char *data = malloc((size_t)(num_sorted + num_tail + 1) * len + 1);
+    if (!tail || !data) {
+        free(tail);
+        free(data);
+        return -1;
+    }
+
+    memcpy(tail, sorted + (size_t)num_sorted * len, (size_t)num_tail * len);
+    qsort(tail, (size_t)num_tail, len, code_index_compare);
+
+    /* Entries are merged after the header, in order of code */
+    char *entries = data + len;
+    int num_entries = 0, s = 0, t = 0;
+    while (s < num_sorted || t < num_tail) {
+        const char *sorted_entry = sorted + (size_t)s * len;
+        const char *tail_entry = tail + (size_t)t * len;
+        const int cmp = s == num_sorted  ? 1
+                        : t == num_tail ? -1
+                                        : code_index_compare(sorted_entry,
+                                                             tail_entry);
+        if (cmp == 0)
+            s++; /* Replaced by the newer entry in the tail */
+
+        const char *next = cmp < 0 ? sorted_entry : tail_entry;
+        if (cmp < 0)
+            s++;
+        else
+            t++;
+
+        /* Codes belong to one item each, so repeated entries are dropped */
+        if (num_entries == 0 ||
+            code_index_compare(entries + (size_t)(num_entries - 1) * len,
+                               next) != 0)
+            memcpy(entries + (size_t)num_entries++ * len, next, len);
+    }
+
+    const int ret = code_index_replace(path, data, num_entries, sync);
+    free(tail);
+    free(data);
+    return ret;
+}
+
+/**
+ * @brief Load the index split into its sorted entries and its tail
+ * @param path Path of index
+ * @param idx Set to the loaded index, release with free_entry_buf(&idx->buf)
+ * @return 0 on success
+ * @return -1 if the index is missing, empty or could not be loaded, in which
+ * case idx need not be released
+ */
+static_fn int code_index_open(const char *path,
+                              struct code_index_entries *idx) {
+    if (code_index_load(path, &idx->buf) <= 0) {
+        free_entry_buf(&idx->buf);
+        return -1;
+    }
+
+    const int has_hdr = !memcmp(idx->buf.data, _CODE_INDEX_HDR, ITEM_CODE_LEN);
+    idx->sorted = idx->buf.data + (has_hdr ? _CODE_INDEX_ENTRY_LEN : 0);
+    idx->num_sorted = code_index_sorted(&idx->buf);
+    idx->tail = idx->sorted + (size_t)idx->num_sorted * _CODE_INDEX_ENTRY_LEN;
+    idx->num_tail = (int)(idx->buf.len / _CODE_INDEX_ENTRY_LEN) - has_hdr -
+                    idx->num_sorted;
+    return 0;
+}
+
+/**
+ * @brief Find the newest entry of a code in a loaded index
+ * @param idx Index loaded with code_index_open
+ * @param code Full ITEM_CODE_LEN code
+ * @return Entry of code
+ * @return NULL if no entry holds code
+ */
+static_fn const char *code_index_lookup(const struct code_index_entries *idx,
+                                        const char *code) {
+    /* Entries of the tail are newer, so are searched first, newest first */
+    for (int i = idx->num_tail - 1; i >= 0; i--) {
+        const char *entry = idx->tail + (size_t)i * _CODE_INDEX_ENTRY_LEN;
+        if (code_index_compare(code, entry) == 0)
+            return entry;
+    }
+    return code_index_search(idx->sorted, idx->num_sorted, code);
+}
+
+/**
+ * @brief Find the first of sorted entries not ordered before a prefix
+ * @param entries Entries in order of code
+ * @param num_entries Number of entries
+ * @param prefix Prefix of code
+ * @param prefix_len Characters in prefix
+ * @return Index of first entry whose code is not ordered before prefix,
+ * num_entries if there is none
+ */
+static_fn int code_index_lower_bound(const char *entries,
+                                     const int num_entries, const char *prefix,
+                                     const size_t prefix_len) {
+    int lo = 0, hi = num_entries;
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if (memcmp(entries + (size_t)mid * _CODE_INDEX_ENTRY_LEN, prefix,
+                   prefix_len) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief Get the number of leading characters two codes share
+ */
+static_fn int code_index_common_len(const char *a, const char *b) {
+    int len = 0;
+    while (len < ITEM_CODE_LEN && a[len] == b[len])
+        len++;
+    return len;
+}
+
+sitem_id code_index_find(const char *path, const char *code) {
+    assert(path);
+    assert(code);
+
+    struct code_index_entries idx;
+    if (code_index_open(path, &idx) < 0)
+        return -1;
+
+    const char *entry = code_index_lookup(&idx, code);
+    const sitem_id id =
+        entry ? hex_field_to_id(entry + _CODE_INDEX_ID_POS) : -1;
+    free_entry_buf(&idx.buf);
+    return id;
+}
+
+sitem_id code_index_find_prefix(const char *path, const char *prefix,
+                                const size_t prefix_len) {
+    assert(path);
+    assert(prefix);
+    assert(prefix_len <= ITEM_CODE_LEN);
+
+    struct code_index_entries idx;
+    if (code_index_open(path, &idx) < 0)
+        return -1;
+
+    /* Codes of sorted entries starting with the prefix follow each other */
+    const char *match = NULL;
+    int num_matches = 0;
+    for (int i = code_index_lower_bound(idx.sorted, idx.num_sorted, prefix,
+                                        prefix_len);
+         i < idx.num_sorted && num_matches < 2; i++) {
+        const char *entry = idx.sorted + (size_t)i * _CODE_INDEX_ENTRY_LEN;
+        if (memcmp(entry, prefix, prefix_len) != 0)
+            break;
+        match = entry;
+        num_matches++;
+    }
+
+    /* Codes of the tail are only counted once, and not if already sorted */
+    for (int i = 0; i < idx.num_tail && num_matches < 2; i++) {
+        const char *entry = idx.tail + (size_t)i * _CODE_INDEX_ENTRY_LEN;
+        if (memcmp(entry, prefix, prefix_len) != 0 ||
+            code_index_search(idx.sorted, idx.num_sorted, entry))
+            continue;
+
+        int is_newest = 1;
+        for (int j = i + 1; is_newest && j < idx.num_tail; j++)
+            is_newest = code_index_compare(
+                            entry, idx.tail + (size_t)j * _CODE_INDEX_ENTRY_LEN);
+        if (is_newest) {
+            match = entry;
+            num_matches++;
+        }
+    }
+
+    sitem_id id = num_matches == 0 ? -1 : CODE_INDEX_AMBIGUOUS;
+    if (num_matches == 1)
+        id = hex_field_to_id(code_index_lookup(&idx, match) +
+                             _CODE_INDEX_ID_POS);
+    free_entry_buf(&idx.buf);
+    return id;
+}
+
+int code_index_prefix_len(const char *path, const char *code) {
+    assert(path);
+    assert(code);
+
+    struct code_index_entries idx;
+    if (code_index_open(path, &idx) < 0)
+        return -1;
+
+    /* Of sorted codes, the neighbours of a code share the most with it */
+    int common_len = 0;
+    const int pos = code_index_lower_bound(idx.sorted, idx.num_sorted, code,
+                                           ITEM_CODE_LEN);
+    int after = pos;
+    if (after < idx.num_sorted &&
+        !code_index_compare(code,
+                            idx.sorted + (size_t)after * _CODE_INDEX_ENTRY_LEN))
+        after++; /* The code itself */
+    if (pos > 0)
+        common_len = code_index_common_len(
+            code, idx.sorted + (size_t)(pos - 1) * _CODE_INDEX_ENTRY_LEN);
+    if (after < idx.num_sorted) {
+        const int len = code_index_common_len(
+            code, idx.sorted + (size_t)after * _CODE_INDEX_ENTRY_LEN);
+        if (len > common_len)
+            common_len = len;
+    }
+
+    for (int i = 0; i < idx.num_tail; i++) {
+        const int len = code_index_common_len(
+            code, idx.tail + (size_t)i * _CODE_INDEX_ENTRY_LEN);
+        if (len < ITEM_CODE_LEN && len > common_len)
+            common_len = len;
+    }
+
+    free_entry_buf(&idx.buf);
+    return common_len < ITEM_CODE_LEN ? common_len + 1 : ITEM_CODE_LEN;
+}
+
+int code_index_add(const char *path, const item *itp,
+                   int (*sync)(const int fd)) {
+    assert(path);
+    assert(itp);
+
+    const int fd = open(path, O_RDWR | O_CREAT | O_APPEND,
+                        CONF_DIR_PERMS & 0666);
+    struct stat sb;
+    if (fd < 0 || fstat(fd, &sb) < 0) {
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    /* A new index is created with its header, in the same write */
+    char entries[2 * _CODE_INDEX_ENTRY_LEN + 1];
+    size_t len = 0;
+    if (sb.st_size < (off_t)_CODE_INDEX_ENTRY_LEN) {
+        code_index_make_entry(entries, _CODE_INDEX_HDR, 0);
+        len += _CODE_INDEX_ENTRY_LEN;
+    }
+    code_index_make_entry(entries + len, itp->item_code, itp->item_id);
+    len += _CODE_INDEX_ENTRY_LEN;
+
+    char hdr[_CODE_INDEX_ENTRY_LEN];
+    int ret = write(fd, entries, len) == (ssize_t)len ? 0 : -1;
+    if (ret == 0 && pread(fd, hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr))
+        ret = -1;
+    close(fd);
+    if (ret != 0)
+        return -1;
+
+    /* Only the header is read until the tail is sorted */
+    const sitem_id num_sorted =
+        memcmp(hdr, _CODE_INDEX_HDR, ITEM_CODE_LEN)
+            ? 0
+            : hex_field_to_id(hdr + _CODE_INDEX_ID_POS);
+    const off_t num_tail =
+        (sb.st_size + (off_t)len) / _CODE_INDEX_ENTRY_LEN - 1 - num_sorted;
+    if (num_tail <= _CODE_INDEX_MAX_TAIL)
+        return 0;
+
+    struct entry_buf buf;
+    ret = code_index_load(path, &buf) < 0 ? -1 : 0;
+    if (ret == 0)
+        ret = code_index_merge(path, &buf, sync);
+    free_entry_buf(&buf);
+
+#ifdef DEBUG
+    if (ret != 0)
+        log_err("Code index could not be sorted");
+#endif
+    return ret;
+}
+
+int code_index_write(const char *path, item **items,
+                     int (*sync)(const int fd)) {
+    assert(path);
+    assert(items);
+
+    const int num_items = (int)item_count_items(items);
+    char *data = malloc((size_t)(num_items + 1) * _CODE_INDEX_ENTRY_LEN + 1);
+    if (!data)
+        return -1;
+
+    char *entries = data + _CODE_INDEX_ENTRY_LEN;
+    for (int i = 0; i < num_items; i++)
+        code_index_make_entry(entries + (size_t)i * _CODE_INDEX_ENTRY_LEN,
+                              items[i]->item_code, items[i]->item_id);
+    qsort(entries, (size_t)num_items, _CODE_INDEX_ENTRY_LEN,
+          code_index_compare);
+
+    const int ret = code_index_replace(path, data, num_items, sync);
+    free(data);
+    return ret;
+}
@@ -0,0 +1,132 @@
+/**
+ * @brief Code index: the code and ID of every item added to a project,
+ * sorted by code, so that a full code is resolved with a binary search of
+ * one file rather than by reading every item.
+ *
+ * The index is a header entry of the number of sorted entries, those entries
+ * in order of code, and a tail of entries appended as items are added, in
+ * the order they were added. Once the tail holds more than
+ * _CODE_INDEX_MAX_TAIL entries it is sorted and merged into the sorted
+ * entries, replacing the index.
+ *
+ * Entries are CODE:ID, the code followed by the hex ID, and the header is
+ * _CODE_INDEX_HDR followed by the hex number of sorted entries. The index is
+ * only ever a hint: the item found with an ID must still have the code.
+ *
+ * As codes starting with a prefix follow each other once sorted, the index
+ * also resolves a prefix of any code, and gives the shortest prefix of a code
+ * that no other code starts with from the codes sorted next to it, with a
+ * binary search and a pass over the tail.
+ *
+ * Functions are prefixed with code_index_, and take the path of the index
+ * @note This should be considered only internally and not part of the dir
+ * interface
+ */
+#ifndef CODE_INDEX_H
+#define CODE_INDEX_H
+
+#include "store/store.h"
+
+#define _CODE_INDEX_HDR "#SORTED" /* Never a code, which is only letters */
+
+/* Each entry and the header are ITEM_CODE_LEN characters and a hex ID */
+#define _CODE_INDEX_ID_POS (ITEM_CODE_LEN + 1)
+#define _CODE_INDEX_ENTRY_LEN (ITEM_CODE_LEN + HEX_LEN(sitem_id) + 2)
+
+#define _CODE_INDEX_MAX_TAIL 64 /* Entries appended before they are sorted */
+
+/* Returned for a prefix of more than one indexed code */
+#define CODE_INDEX_AMBIGUOUS -2
+
+/**
+ * @brief Loaded index, split into its sorted entries and its tail
+ */
+struct code_index_entries {
+    struct entry_buf buf; /* Header and every entry */
+    const char *sorted;   /* Entries in order of code, following the header */
+    int num_sorted;
+    const char *tail; /* Entries in order of being added */
+    int num_tail;
+};
+
+/**
+ * @brief Find the ID of the item with a code
+ * @param path Path of index
+ * @param code Full ITEM_CODE_LEN code (need not be null-terminated)
+ * @return ID the index holds for code
+ * @return -1 if the index holds no entry of code, or is missing
+ */
+extern sitem_id code_index_find(const char *path, const char *code);
+
+/**
+ * @brief Find the ID of the one item whose code starts with a prefix
+ * @param path Path of index
+ * @param prefix Prefix of code (need not be null-terminated)
+ * @param prefix_len Characters in prefix, at most ITEM_CODE_LEN
+ * @return ID the index holds for the only code starting with prefix
+ * @return CODE_INDEX_AMBIGUOUS if more than one code starts with prefix
+ * @return -1 if no code starts with prefix, or the index is missing
+ */
+extern sitem_id code_index_find_prefix(const char *path, const char *prefix,
+                                       const size_t prefix_len);
+
+/**
+ * @brief Get the length of the shortest prefix of a code that no other
+ * indexed code starts with
+ * @param path Path of index
+ * @param code Full ITEM_CODE_LEN code, which need not be indexed
+ * @return Length of prefix, ITEM_CODE_LEN if every shorter prefix is shared
+ * @return -1 if the index is missing
+ */
+extern int code_index_prefix_len(const char *path, const char *code);
+
+/**
+ * @brief Add the code of a new item to the index, creating the index if
+ * needed, and sort the entries appended since it was last sorted once there
+ * are too many
+ * @param path Path of index
+ * @param itp Item added
+ * @param sync Function syncing the index before it is replaced, NULL to not
+ * sync
+ * @return 0 on success
+ * @return -1 on error
+ * @note Entries are appended with a single write, but the index must not be
+ * sorted while another run adds to it
+ */
+extern int code_index_add(const char *path, const item *itp,
+                          int (*sync)(const int fd));
+
+/**
+ * @brief Replace the index with the codes of a set of items
+ * @param path Path of index
+ * @param items NULL-terminated array of item pointers
+ * @param sync Function syncing the index before it is replaced, NULL to not
+ * sync
+ * @return 0 on success
+ * @return -1 on error, the index is unchanged
+ */
+extern int code_index_write(const char *path, item **items,
+                            int (*sync)(const int fd));
+
+#ifdef TJUNITTEST
+extern void code_index_make_entry(char *entry, const char *code,
+                                  const sitem_id id);
+extern int code_index_compare(const void *a, const void *b);
+extern int code_index_load(const char *path, struct entry_buf *buf);
+extern int code_index_sorted(const struct entry_buf *buf);
+extern int code_index_open(const char *path, struct code_index_entries *idx);
+extern const char *code_index_lookup(const struct code_index_entries *idx,
+                                     const char *code);
+extern int code_index_lower_bound(const char *entries, const int num_entries,
+                                  const char *prefix, const size_t prefix_len);
+extern int code_index_common_len(const char *a, const char *b);
+extern const char *code_index_search(const char *entries,
+                                     const int num_entries, const char *code);
+extern int code_index_replace(const char *path, char *entries,
+                              const int num_entries,
+                              int (*sync)(const int fd));
+extern int code_index_merge(const char *path, const struct entry_buf *buf,
+                            int (*sync)(const int fd));
+#endif
+
+#endif
@@ -0,0 +1,1698 @@
+#include "files.h"
+#include "dev-utils/test-helpers.h"
+#ifdef DEBUG
+#include "dev-utils/debug-out.h"
+#endif
+
+static const struct store_env *files_env = NULL;
+
+/* Item files, each split into segment files in the segments layout */
+static char backlog_path[MAX_PATH] = {'\0'};
+static char todo_path[MAX_PATH] = {'\0'};
+static char ip_path[MAX_PATH] = {'\0'};
+static char done_path[MAX_PATH] = {'\0'};
+
+static char tombstones_path[MAX_PATH] = {'\0'}; /* Dead entry counts */
+static char id_dir_path[MAX_PATH] = {'\0'};     /* Item locations by ID */
+
+/* Files of the segments layout, in the items directory */
+static char seg_tombstones_path[MAX_PATH] = {'\0'};
+static char seg_id_dir_path[MAX_PATH] = {'\0'};
+
+static const struct files_set whole_files = {0, tombstones_path, id_dir_path};
+static const struct files_set segment_files = {
+    _FILES_SEGMENT_IDS, seg_tombstones_path, seg_id_dir_path};
+
+/* Location of an item seen in a view of the item files, see locate_item */
+static const struct files_set *hinted_fs = NULL;
+static sitem_id hinted_id = -1;
+static enum status hinted_st;
+static off_t hinted_off;
+
+/* Paths of segment files written during this run, kept for syncing at exit */
+static char written_segments[_FILES_WRITTEN_SEGMENTS_MAX][MAX_PATH];
+static int num_written_segments = 0;
+
+static_fn void files_store_setup(const struct store_env *env) {
+    assert(env);
+
+    files_env = env;
+    if (!*backlog_path)
+        store_path(env->items_dir, _FILES_BACKLOG_F, backlog_path);
+    if (!*todo_path)
+        store_path(env->items_dir, _FILES_TODO_F, todo_path);
+    if (!*ip_path)
+        store_path(env->items_dir, _FILES_INPROG_F, ip_path);
+    if (!*done_path)
+        store_path(env->items_dir, _FILES_DONE_F, done_path);
+    if (!*tombstones_path)
+        store_path(env->proj_dir, _FILES_TOMBSTONES_F, tombstones_path);
+    if (!*id_dir_path)
+        store_path(env->proj_dir, _FILES_ID_DIR_F, id_dir_path);
+}
+
+static_fn void segments_store_setup(const struct store_env *env) {
+    files_store_setup(env);
+
+    if (!*seg_tombstones_path)
+        store_path(env->items_dir, _FILES_SEGMENT_TOMBSTONES_F,
+                   seg_tombstones_path);
+    if (!*seg_id_dir_path)
+        store_path(env->items_dir, _FILES_SEGMENT_ID_DIR_F, seg_id_dir_path);
+}
+
+/**
+ * @brief Get the path of the items file of a status
+ * @param st Status of items
+ * @return Path of items file in static storage
+ * @return NULL if st is not a status
+ * @note Segment files are named by this path followed by their segment
+ */
+static_fn const char *items_status_path(const enum status st) {
+    switch (st) {
+    case BACKLOG:
+        return backlog_path;
+    case TODO:
+        return todo_path;
+    case IN_PROG:
+        return ip_path;
+    case DONE:
+        return done_path;
+    default:
+        return NULL;
+    }
+}
+
+/**
+ * @brief Get the segment holding the entry of an item
+ * @param fs Set of item files
+ * @param id ID of item
+ * @return Segment of ID, always 0 if statuses are not split into segments
+ */
+static inline int segment_of(const struct files_set *fs, const sitem_id id) {
+    return fs->segment_ids ? id / fs->segment_ids : 0;
+}
+
+/**
+ * @brief Write the path of the items file of a status and segment to buf
+ * @param fs Set of item files
+ * @param st Status of items
+ * @param seg Segment of items file, 0 if statuses are not split into segments
+ * @param buf Buffer of MAX_PATH bytes to write the path to
+ * @return 0 on success
+ * @return -1 if st is not a status
+ */
+static_fn int items_file_path(const struct files_set *fs, const enum status st,
+                              const int seg, char buf[MAX_PATH]) {
+    const char *path = items_status_path(st);
+    if (!path)
+        return -1;
+
+    assert(fs->segment_ids || seg == 0);
+    if (fs->segment_ids)
+        snprintf(buf, MAX_PATH, "%.*s.%0*d", MAX_PATH - 16, path,
+                 _FILES_SEGMENT_DIGITS, seg);
+    else
+        snprintf(buf, MAX_PATH, "%s", path);
+    return 0;
+}
+
+/**
+ * @brief Open the items file of a status and segment
+ * @param fs Set of item files
+ * @param st Status of items to open file descriptor for
+ * @param seg Segment of items file
+ * @param flags Open flags
+ * @return open file descriptor
+ * @return -1 on error
+ * @see open
+ */
+static_fn int open_items_file(const struct files_set *fs, const enum status st,
+                              const int seg, const int flags) {
+    char path[MAX_PATH];
+    if (items_file_path(fs, st, seg, path) < 0) {
+#ifdef DEBUG
+        log_err("Unknown item state being requested for read");
+#endif
+        return -1;
+    }
+    return open(path, flags, CONF_DIR_PERMS & 0666);
+}
+
+/**
+ * @brief Make data written to the items file of a status and segment durable
+ * @param fs Set of item files
+ * @param fd File descriptor the data was written through
+ * @param st Status of items file
+ * @param seg Segment of items file
+ * @return 0 on success
+ * @return -1 on error
+ * @note Paths of segment files are kept in static storage, as they may only be
+ * synced at exit; once there is no room to keep a path, the file is synced
+ * immediately
+ */
+static_fn int sync_items_file(const struct files_set *fs, const int fd,
+                              const enum status st, const int seg) {
+    if (!fs->segment_ids)
+        return files_env->sync_written(fd, items_status_path(st));
+
+    char path[MAX_PATH];
+    items_file_path(fs, st, seg, path);
+
+    for (int i = 0; i < num_written_segments; i++) {
+        if (strcmp(written_segments[i], path) == 0)
+            return files_env->sync_written(fd, written_segments[i]);
+    }
+
+    if (num_written_segments == _FILES_WRITTEN_SEGMENTS_MAX)
+        return files_env->sync_replacement(fd);
+
+    strcpy(written_segments[num_written_segments], path);
+    return files_env->sync_written(fd,
+                                   written_segments[num_written_segments++]);
+}
+
+/**
+ * @brief Count the segments of each status
+ * @param fs Set of item files
+ * @return Number of segments, 1 if statuses are not split into segments
+ * @note Segments are created for every status at once and in order, so the
+ * first segment missing a backlog file is the end of every status
+ */
+static_fn int count_segments(const struct files_set *fs) {
+    if (!fs->segment_ids)
+        return 1;
+
+    char path[MAX_PATH];
+    int num_segs = 0;
+    while (items_file_path(fs, BACKLOG, num_segs, path) == 0 &&
+           access(path, F_OK) == 0)
+        num_segs++;
+
+    return num_segs;
+}
+
+/**
+ * @brief Create the empty items files of every status for each segment up to
+ * and including a given segment, leaving existing files unchanged
+ * @param fs Set of item files
+ * @param last_seg Last segment to create
+ * @return 0 on success
+ * @return -1 on error
+ */
+static_fn int create_segments(const struct files_set *fs, const int last_seg) {
+    for (int seg = 0; seg <= last_seg; seg++) {
+        for (int i = 0; i < ITEM_STATUS_COUNT; i++) {
+            int fd = open_items_file(fs, (enum status)i, seg,
+                                     O_WRONLY | O_CREAT);
+            if (fd < 0)
+                return -1;
+            close(fd);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Check that an item entry has not been removed
+ * @param entry Item entry
+ * @return Non-zero if the entry is live, 0 if it is a tombstone
+ */
+static inline int entry_is_live(const char *entry) {
+    return entry[_FILES_DEAD_POS] != *_FILES_DEAD_DELIM;
+}
+
+/**
+ * @brief Read an item entry and return all readable data in a freshly
+ * allocated item.
+ * @param entry Single entry representing item
+ * @return Pointer to new item
+ * @return NULL in case of error
+ * @note Any data that cannot be ascertained from the entry will correspond
+ * @see free
+ */
+static_fn item *entry_to_item(const char entry[FILES_ENTRY_LEN + 1]) {
+    item *item = item_init();
+    size_t pos_in_entry = 0;
+    /* Each step *may* be abstracted in the future for clarity */
+
+    /*
+     * Parse item ID:
+     * Delimiter is guaranteed not to be a valid hex digit
+     */
+    const char *id = &entry[pos_in_entry];
+    item->item_id = (sitem_id)strtoll(id, NULL, 16);
+    pos_in_entry += HEX_LEN(sitem_id) + _FILES_FIELD_DELIM_LEN;
+
+    /*
+     * Parse item code
+     */
+    const char *code = &entry[pos_in_entry];
+    memcpy(item->item_code, code, ITEM_CODE_LEN);
+    pos_in_entry += ITEM_CODE_LEN + _FILES_FIELD_DELIM_LEN;
+
+    /*
+     * Parse item name
+     */
+    const char *name = &entry[pos_in_entry];
+    /* pos_in_entry does not change; name is guaranteed to be the last field */
+
+    /* See item_set_name_deep for null termination expectations */
+    item_set_name_deep(item, name, entry_name_len(name));
+
+    return item;
+}
+
+/**
+ * @brief Read item at an offset from fd as a new item struct
+ * @param entry_off Offset of entry
+ * @param fd File descriptor of file of item entries in regular format
+ * @return item with data in entries file, heap allocated
+ * @note entry_off must be the offset of the *first* byte of the item entry
+ */
+static_fn item *fd_read_item_at(int fd, off_t entry_off) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+    assert(entry_off >= 0);
+
+    char entry[FILES_ENTRY_LEN + 1];
+    entry[FILES_ENTRY_LEN] = '\0';
+
+    if (pread(fd, entry, FILES_ENTRY_LEN, entry_off) < 0) {
+        return NULL;
+    }
+
+    item *it = entry_to_item(entry);
+
+    return it;
+}
+
+/**
+ * @brief Read only the ID field (and the following delimiter) of the item
+ * entry at an offset of fd
+ * @param fd File descriptor of file of item entries
+ * @param entry_off Offset of the *first* byte of the entry
+ * @param is_live Set to non-zero if the entry is live and 0 if it is a
+ * tombstone, may be NULL
+ * @return ID of entry
+ * @return -1 on error
+ */
+static_fn sitem_id fd_read_id_at(const int fd, const off_t entry_off,
+                                 int *is_live) {
+    char id_field[HEX_LEN(sitem_id) + _FILES_FIELD_DELIM_LEN];
+
+    if (pread(fd, id_field, sizeof(id_field), entry_off) !=
+        (ssize_t)sizeof(id_field))
+        return -1;
+
+    if (is_live)
+        *is_live = entry_is_live(id_field);
+
+    return hex_field_to_id(id_field);
+}
+
+/**
+ * @brief Get the position of the tombstone count of an items file in the
+ * tombstones file
+ */
+static inline off_t tombstone_entry_off(const enum status st, const int seg) {
+    return ((off_t)seg * ITEM_STATUS_COUNT + st) * _FILES_TOMBSTONE_ENTRY_LEN;
+}
+
+/**
+ * @brief Get the number of tombstones in the items file of a given status and
+ * segment
+ * @param fs Set of item files
+ * @param st Status of items file
+ * @param seg Segment of items file
+ * @return Number of tombstones, 0 if this has not been recorded
+ */
+static_fn int tombstone_count(const struct files_set *fs, const enum status st,
+                              const int seg) {
+    assert(st < ITEM_STATUS_COUNT);
+
+    int fd = open(fs->tombstones_path, O_RDONLY);
+    if (fd < 0)
+        return 0;
+
+    char count_field[HEX_LEN(sitem_id)];
+    ssize_t b = pread(fd, count_field, sizeof(count_field),
+                      tombstone_entry_off(st, seg));
+    close(fd);
+
+    if (b != (ssize_t)sizeof(count_field))
+        return 0;
+
+    const sitem_id count = hex_field_to_id(count_field);
+    return count < 0 ? 0 : count;
+}
+
+/**
+ * @brief Get the number of tombstones in every items file, with one read of
+ * the tombstones file
+ * @param fs Set of item files
+ * @return Total number of tombstones
+ */
+static_fn int tombstone_total(const struct files_set *fs) {
+    int fd = open(fs->tombstones_path, O_RDONLY);
+    if (fd < 0)
+        return 0;
+
+    struct entry_buf buf;
+    const int num_counts = fd_load_entries(fd, _FILES_TOMBSTONE_ENTRY_LEN,
+                                           &buf);
+    close(fd);
+
+    int total = 0;
+    for (int i = 0; i < num_counts; i++) {
+        /* Holes left by segments without tombstones are not counts */
+        const sitem_id count =
+            hex_field_to_id(buf.data + (size_t)i * _FILES_TOMBSTONE_ENTRY_LEN);
+        if (count > 0)
+            total += count;
+    }
+
+    free_entry_buf(&buf);
+    return total;
+}
+
+/**
+ * @brief Record the number of tombstones in the items file of a given status
+ * and segment
+ * @param fs Set of item files
+ * @param st Status of items file
+ * @param seg Segment of items file
+ * @param count Number of tombstones, negative values are recorded as 0
+ */
+static_fn void set_tombstone_count(const struct files_set *fs,
+                                   const enum status st, const int seg,
+                                   const int count) {
+    assert(st < ITEM_STATUS_COUNT);
+
+    /* Projects initialised before tombstones existed do not have the file */
+    int fd = open(fs->tombstones_path, O_WRONLY | O_CREAT,
+                  CONF_DIR_PERMS & 0666);
+    if (fd < 0)
+        return;
+
+    char count_entry[_FILES_TOMBSTONE_ENTRY_LEN + 1];
+    snprintf(count_entry, sizeof(count_entry), "%0*X%s",
+             (int)HEX_LEN(sitem_id), count < 0 ? 0 : count, _FILES_ENTRY_DELIM);
+
+    if (pwrite_all(fd, count_entry, _FILES_TOMBSTONE_ENTRY_LEN,
+                   tombstone_entry_off(st, seg)) < 0) {
+#ifdef DEBUG
+        log_err("Could not record number of tombstones");
+#endif
+    }
+    close(fd);
+}
+
+/**
+ * @brief Write an item entry to buf
+ * @param itp Pointer to item to parse data of
+ * @param buf Buffer to place data
+ * @return 0 on success
+ * @return -1 if the item cannot be represented by an entry
+ * @note Resulting data in buf is null-terminated and guaranteed to at the last
+ * position
+ */
+static_fn int make_item_entry(const item *const itp,
+                              char buf[FILES_ENTRY_LEN + 1]) {
+    /* Field delimiter */
+    const char delim[_FILES_FIELD_DELIM_LEN + 1] = _FILES_FIELD_DELIM;
+    /* Item terminator */
+    const char term[_FILES_ENTRY_DELIM_LEN + 1] = _FILES_ENTRY_DELIM;
+
+    /* Bytes printed to buf */
+    int b = 0;
+
+    /* Parse item data */
+    b = snprintf(buf, FILES_ENTRY_LEN + 1, "%0*X%s%.*s%s%-*s%s",
+                 /* Width and value of ID */
+                 (int)HEX_LEN(sitem_id), itp->item_id, delim, ITEM_CODE_LEN,
+                 itp->item_code, delim, ITEM_NAME_MAX,
+                 itp->item_name, /* Name */
+                 term);
+
+    /* Handle errors, longer names would be truncated along with the entry */
+    if ((size_t)b != FILES_ENTRY_LEN) {
+#ifdef DEBUG
+        log_err("make_item_entry could not parse item data correctly");
+#endif
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Convert the index of an entry to the 'would-be' offset returned by
+ * fd_search_for_entry_id for an item that is not found
+ */
+static inline off_t would_be_entry_off(const off_t index) {
+    return index == 0 ? OFF_T_MIN : -(index * (off_t)FILES_ENTRY_LEN);
+}
+
+/**
+ * @brief Search for an entry in a file, regardless of whether it exists or not
+ * @param fd Open file descriptor
+ * @param target_id Target item ID to find
+ * @return >= 0: offset of location of item with target_id in fd;
+ * @return < 0: offset of location that an item with target_id *would be*,
+ * since "-0" is obviously indistinguishable from 0, OFF_T_MIN represents a
+ * 'would-be' insertion offset of 0; this is always returned for an empty file.
+ * @return -1 on error (guaranteed not to align with a valid 'negative offset'
+ * @param is_live Set when an entry is found, to non-zero if it is live and 0
+ * if it is a tombstone, may be NULL
+ * @note Tombstones keep their place in the order of entries, and an item file
+ * holds at most one entry (live or dead) for any ID
+ * @note IDs are sorted and close to dense, so probes are interpolated from the
+ * IDs bounding the search, falling back to bisection whenever an interpolated
+ * probe fails to halve the range. Only ID fields are read.
+ */
+static_fn off_t fd_search_for_entry_id(const int fd, const sitem_id target_id,
+                                       int *is_live) {
+    assert(fcntl(fd, F_GETFD) != -1);
+    int flags = fcntl(fd, F_GETFL) & O_ACCMODE;
+
+    if (flags != O_RDWR && flags != O_RDONLY) {
+#ifdef DEBUG
+        log_err("Incorrect fd flag provided");
+#endif
+        return -1;
+    }
+    if (target_id < 0)
+        return -1;
+
+    const off_t total_entries = fd_total_items(fd, FILES_ENTRY_LEN);
+    if (total_entries < 0)
+        return -1;
+
+    /* Empty file */
+    if (total_entries == 0)
+        return OFF_T_MIN;
+
+    /* Entry indices bounding the search, and their IDs */
+    off_t lo = 0;
+    off_t hi = total_entries - 1;
+    int lo_live = 0;
+    int hi_live = 0;
+    sitem_id lo_id = fd_read_id_at(fd, 0, &lo_live);
+    sitem_id hi_id = fd_read_id_at(fd, hi * FILES_ENTRY_LEN, &hi_live);
+
+    if (lo_id < 0 || hi_id < 0)
+        return -1;
+
+    int bisect = 0;
+
+    for (;;) {
+        /* Found-at-bound cases */
+        if (target_id == lo_id || target_id == hi_id) {
+            if (is_live)
+                *is_live = target_id == lo_id ? lo_live : hi_live;
+            return (target_id == lo_id ? lo : hi) * (off_t)FILES_ENTRY_LEN;
+        }
+
+        /* 'Out of bounds' cases */
+        if (target_id < lo_id)
+            return would_be_entry_off(lo);
+        if (target_id > hi_id)
+            return would_be_entry_off(hi + 1);
+        if (hi - lo <= 1) {
+            /* Item should be between two others */
+            return would_be_entry_off(hi);
+        }
+
+        /* Probe strictly between bounds */
+        off_t probe;
+        if (bisect)
+            probe = lo + (hi - lo) / 2;
+        else
+            probe = lo + (off_t)((int64_t)(target_id - lo_id) * (hi - lo) /
+                                 ((int64_t)hi_id - lo_id));
+
+        if (probe <= lo)
+            probe = lo + 1;
+        else if (probe >= hi)
+            probe = hi - 1;
+
+        const off_t prev_width = hi - lo;
+        int probe_live = 0;
+        const sitem_id probe_id =
+            fd_read_id_at(fd, probe * (off_t)FILES_ENTRY_LEN, &probe_live);
+
+        if (probe_id < 0)
+            return -1;
+
+        if (probe_id <= target_id) {
+            lo = probe;
+            lo_id = probe_id;
+            lo_live = probe_live;
+        } else {
+            hi = probe;
+            hi_id = probe_id;
+            hi_live = probe_live;
+        }
+
+        /* Poor interpolation (sparse IDs), bisect on the next probe */
+        bisect = !bisect && (hi - lo) * 2 > prev_width;
+    }
+}
+
+/**
+ * @brief Read the location of an item from the ID directory
+ * @param fs Set of item files
+ * @param id ID of item
+ * @param st Set to the status of the item
+ * @param entry_off Set to the offset of the item entry in the items file of
+ * status st (and the segment of the ID)
+ * @return 0 on success
+ * @return -1 if the directory holds no location for the item
+ * @note Locations are only hints, since entries move within an items file
+ * when entries are inserted before them
+ */
+static_fn int read_id_dir_entry(const struct files_set *fs, const sitem_id id,
+                                enum status *st, off_t *entry_off) {
+    assert(st);
+    assert(entry_off);
+
+    if (id < 0)
+        return -1;
+
+    int fd = open(fs->id_dir_path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    char entry[_FILES_ID_DIR_ENTRY_LEN + 1];
+    const ssize_t b = pread(fd, entry, _FILES_ID_DIR_ENTRY_LEN,
+                            (off_t)id * _FILES_ID_DIR_ENTRY_LEN);
+    close(fd);
+
+    if (b != _FILES_ID_DIR_ENTRY_LEN || entry[0] == '\0')
+        return -1;
+    entry[_FILES_ID_DIR_ENTRY_LEN] = '\0';
+
+    const char *st_char = strchr(_FILES_ST_CHARS, entry[0]);
+    if (!st_char)
+        return -1;
+
+    char *off_end = NULL;
+    const long long off = strtoll(entry + _FILES_ID_DIR_OFF_POS, &off_end, 16);
+    if (off_end != entry + _FILES_ID_DIR_OFF_POS + HEX_LEN(off_t) || off < 0)
+        return -1;
+
+    *st = (enum status)(st_char - _FILES_ST_CHARS);
+    *entry_off = (off_t)off;
+    return 0;
+}
+
+/**
+ * @brief Write an ID directory entry to buf
+ * @param st Status of the item
+ * @param entry_off Offset of the item entry in the items file of status st
+ * @param buf Buffer to place data, null-terminated at the last position
+ */
+static_fn void make_id_dir_entry(const enum status st, const off_t entry_off,
+                                 char buf[_FILES_ID_DIR_ENTRY_LEN + 1]) {
+    assert(st < ITEM_STATUS_COUNT);
+
+    snprintf(buf, _FILES_ID_DIR_ENTRY_LEN + 1, "%c%s%0*llX%s",
+             _FILES_ST_CHARS[st], _FILES_FIELD_DELIM, (int)HEX_LEN(off_t),
+             (unsigned long long)entry_off, _FILES_ENTRY_DELIM);
+}
+
+/**
+ * @brief Record the location of an item in the ID directory
+ * @param fs Set of item files
+ * @param id ID of item
+ * @param st Status of the item
+ * @param entry_off Offset of the item entry in the items file of status st
+ * @note Errors are not reported, a missing or stale location only costs a
+ * search of the item files when the item is next located
+ */
+static_fn void write_id_dir_entry(const struct files_set *fs, const sitem_id id,
+                                  const enum status st, const off_t entry_off) {
+    assert(st < ITEM_STATUS_COUNT);
+
+    if (id < 0 || entry_off < 0)
+        return;
+
+    int fd = open(fs->id_dir_path, O_WRONLY | O_CREAT, CONF_DIR_PERMS & 0666);
+    if (fd < 0)
+        return;
+
+    char entry[_FILES_ID_DIR_ENTRY_LEN + 1];
+    make_id_dir_entry(st, entry_off, entry);
+
+    if (pwrite_all(fd, entry, _FILES_ID_DIR_ENTRY_LEN,
+                   (off_t)id * _FILES_ID_DIR_ENTRY_LEN) < 0) {
+#ifdef DEBUG
+        log_err("Could not record item location in ID directory");
+#endif
+    }
+    close(fd);
+}
+
+/**
+ * @brief Record the location of every live entry of an items file in the ID
+ * directory, opening the directory once
+ * @param fs Set of item files
+ * @param st Status of items file
+ * @param entries Every entry of the items file, in order
+ * @param len Length of entries in bytes
+ * @note Errors are not reported, as for write_id_dir_entry
+ */
+static_fn void write_id_dir_entries(const struct files_set *fs,
+                                    const enum status st, const char *entries,
+                                    const size_t len) {
+    int fd = open(fs->id_dir_path, O_WRONLY | O_CREAT, CONF_DIR_PERMS & 0666);
+    if (fd < 0)
+        return;
+
+    for (size_t off = 0; off < len; off += FILES_ENTRY_LEN) {
+        const sitem_id id = hex_field_to_id(entries + off);
+        if (id < 0 || !entry_is_live(entries + off))
+            continue;
+
+        char entry[_FILES_ID_DIR_ENTRY_LEN + 1];
+        make_id_dir_entry(st, off, entry);
+        if (pwrite_all(fd, entry, _FILES_ID_DIR_ENTRY_LEN,
+                       (off_t)id * _FILES_ID_DIR_ENTRY_LEN) < 0)
+            break;
+    }
+    close(fd);
+}
+
+/**
+ * @brief Rebuild the ID directory from the item files, replacing the
+ * directory atomically
+ * @param fs Set of item files
+ * @return 0 on success
+ * @return -1 on error, the directory is unchanged
+ */
+static_fn int rebuild_id_directory(const struct files_set *fs) {
+    const int num_segs = count_segments(fs);
+
+    /* Entries are sorted, so the last entry of each file has its largest ID */
+    sitem_id max_id = -1;
+    int ret = 0;
+
+    for (int seg = 0; seg < num_segs && ret == 0; seg++) {
+        for (int i = 0; i < ITEM_STATUS_COUNT && ret == 0; i++) {
+            int fd = open_items_file(fs, (enum status)i, seg, O_RDONLY);
+            const int num_entries =
+                fd < 0 ? -1 : fd_total_items(fd, FILES_ENTRY_LEN);
+
+            if (num_entries < 0) {
+                ret = -1;
+            } else if (num_entries > 0) {
+                const sitem_id last_id = fd_read_id_at(
+                    fd, (off_t)(num_entries - 1) * FILES_ENTRY_LEN, NULL);
+                if (last_id > max_id)
+                    max_id = last_id;
+            }
+            if (fd >= 0)
+                close(fd);
+        }
+    }
+
+    /* Holes are zeroed */
+    const size_t dir_len = (size_t)(max_id + 1) * _FILES_ID_DIR_ENTRY_LEN;
+    char *entries = ret == 0 ? calloc(dir_len + 1, 1) : NULL;
+    if (!entries)
+        ret = -1;
+
+    for (int seg = 0; seg < num_segs && ret == 0; seg++) {
+        for (int i = 0; i < ITEM_STATUS_COUNT && ret == 0; i++) {
+            struct entry_buf buf;
+            int fd = open_items_file(fs, (enum status)i, seg, O_RDONLY);
+            if (fd < 0 || fd_load_entries(fd, FILES_ENTRY_LEN, &buf) < 0)
+                ret = -1;
+            if (fd >= 0)
+                close(fd);
+            if (ret != 0)
+                break;
+
+            for (size_t off = 0; off < buf.len; off += FILES_ENTRY_LEN) {
+                const char *item_entry = buf.data + off;
+                const sitem_id id = hex_field_to_id(item_entry);
+                if (id < 0 || id > max_id || !entry_is_live(item_entry))
+                    continue;
+                char dir_entry[_FILES_ID_DIR_ENTRY_LEN + 1];
+                make_id_dir_entry((enum status)i, off, dir_entry);
+                memcpy(entries + (size_t)id * _FILES_ID_DIR_ENTRY_LEN,
+                       dir_entry, _FILES_ID_DIR_ENTRY_LEN);
+            }
+            free_entry_buf(&buf);
+        }
+    }
+
+    if (ret != 0) {
+        free(entries);
+        return -1;
+    }
+
+    char tmp_path[MAX_PATH];
+    snprintf(tmp_path, sizeof(tmp_path), "%.*s.tmp", MAX_PATH - 5,
+             fs->id_dir_path);
+
+    int fd_tmp = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC,
+                      CONF_DIR_PERMS & 0666);
+    if (fd_tmp < 0) {
+        free(entries);
+        return -1;
+    }
+
+    ret = pwrite_all(fd_tmp, entries, dir_len, 0);
+    free(entries);
+    close(fd_tmp);
+    if (ret == 0)
+        ret = rename(tmp_path, fs->id_dir_path);
+
+    if (ret != 0) {
+#ifdef DEBUG
+        log_err("ID directory could not be rebuilt");
+#endif
+        unlink(tmp_path);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Check whether the live entry of an item is at a location
+ * @param fs Set of item files
+ * @param id ID of item
+ * @param st Status of items file
+ * @param entry_off Offset of entry in the items file of status st (and the
+ * segment of the ID)
+ * @return Non-zero if the entry at entry_off is the live entry of the item
+ */
+static_fn int item_entry_is_at(const struct files_set *fs, const sitem_id id,
+                               const enum status st, const off_t entry_off) {
+    if (st >= ITEM_STATUS_COUNT || entry_off < 0)
+        return 0;
+
+    int fd = open_items_file(fs, st, segment_of(fs, id), O_RDONLY);
+    if (fd < 0)
+        return 0;
+
+    int is_live = 0;
+    const sitem_id found_id = fd_read_id_at(fd, entry_off, &is_live);
+    close(fd);
+    return found_id == id && is_live;
+}
+
+/**
+ * @brief Find the status and entry offset of a live item, using the ID
+ * directory
+ * @param fs Set of item files
+ * @param id ID of item
+ * @param st Set to the status of the item
+ * @param entry_off Set to the offset of the item entry in the items file of
+ * status st (and the segment of the ID)
+ * @return 0 on success
+ * @return -1 if the project contains no item with the ID
+ * @note A location hinted by a view, or else from the directory, is verified
+ * by reading the ID of the entry it points to. Missing or stale locations fall
+ * back to searching the item files of the segment of the ID and are repaired,
+ * and a missing directory is rebuilt.
+ */
+static_fn int locate_item(const struct files_set *fs, const sitem_id id,
+                          enum status *st, off_t *entry_off) {
+    assert(st);
+    assert(entry_off);
+
+    if (id < 0)
+        return -1;
+
+    const int seg = segment_of(fs, id);
+
+    /* Items are usually changed right after being listed */
+    if (hinted_fs == fs && hinted_id == id &&
+        item_entry_is_at(fs, id, hinted_st, hinted_off)) {
+        *st = hinted_st;
+        *entry_off = hinted_off;
+        return 0;
+    }
+
+    /* Projects created before the ID directory existed */
+    if (access(fs->id_dir_path, F_OK) != 0)
+        rebuild_id_directory(fs);
+
+    enum status hint_st;
+    off_t hint_off;
+    if (read_id_dir_entry(fs, id, &hint_st, &hint_off) == 0 &&
+        item_entry_is_at(fs, id, hint_st, hint_off)) {
+        *st = hint_st;
+        *entry_off = hint_off;
+        return 0;
+    }
+
+    for (int i = 0; i < ITEM_STATUS_COUNT; i++) {
+        int fd = open_items_file(fs, (enum status)i, seg, O_RDONLY);
+        if (fd < 0)
+            continue;
+
+        int is_live = 0;
+        const off_t item_off = fd_search_for_entry_id(fd, id, &is_live);
+        close(fd);
+
+        if (item_off >= 0 && is_live) {
+            write_id_dir_entry(fs, id, (enum status)i, item_off);
+            *st = (enum status)i;
+            *entry_off = item_off;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Insert an entry at a given offset, moving every following entry back
+ * by one entry
+ * @param fd File descriptor of file of entries opened for reading and writing
+ * @param entry_off Offset to insert entry at, at most the file size
+ * @param entry Entry data to insert
+ * @param entry_len Length of a single entry in the file opened
+ * @return 0 on success
+ * @return -1 on error
+ * @note Inserting at the end of the file is a single append; otherwise the
+ * tail of the file is moved in _FILES_SHIFT_CHUNK_SZ chunks, starting from the
+ * end so that no data is overwritten before it is moved
+ */
+static_fn int fd_insert_entry_at(const int fd, const off_t entry_off,
+                                 const char *entry, const size_t entry_len) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+    assert(entry);
+    assert(entry_off >= 0);
+
+    if ((fcntl(fd, F_GETFL) & O_ACCMODE) != O_RDWR) {
+#ifdef DEBUG
+        log_err("Incorrect fd flag provided");
+#endif
+        return -1;
+    }
+
+    struct stat sb;
+    if (fstat(fd, &sb) < 0 || entry_off > sb.st_size)
+        return -1;
+
+    /* Pure append */
+    if (entry_off == sb.st_size)
+        return pwrite_all(fd, entry, entry_len, entry_off);
+
+    char *chunk = malloc(_FILES_SHIFT_CHUNK_SZ);
+    if (!chunk)
+        return -1;
+
+    off_t chunk_end = sb.st_size;
+    while (chunk_end > entry_off) {
+        off_t chunk_start = chunk_end - _FILES_SHIFT_CHUNK_SZ;
+        if (chunk_start < entry_off)
+            chunk_start = entry_off;
+        const size_t chunk_len = chunk_end - chunk_start;
+
+        if (pread(fd, chunk, chunk_len, chunk_start) != (ssize_t)chunk_len ||
+            pwrite_all(fd, chunk, chunk_len, chunk_start + entry_len) < 0) {
+            free(chunk);
+            return -1;
+        }
+        chunk_end = chunk_start;
+    }
+    free(chunk);
+
+    return pwrite_all(fd, entry, entry_len, entry_off);
+}
+
+/**
+ * @brief Append write the item entry of the item pointed to by itp to the
+ * appropriate items file, creating the segment of the item if it is the first
+ * in its segment
+ * @param fs Set of item files
+ * @param itp Pointer to item to write data of
+ * @param entry Formatted entry of item to write with terminating NULL
+ * character
+ * @return 0 on success
+ * @return -1 on error or if the items file already contains the item
+ * @note No 'correctness' checks occur to validate that the entry indeed
+ * represents the item pointed to by itp, this is assumed to be the case
+ */
+static_fn int append_item_entry(const struct files_set *fs, const item *itp,
+                                const char entry[FILES_ENTRY_LEN + 1]) {
+    const int seg = segment_of(fs, itp->item_id);
+    int fd = open_items_file(fs, itp->item_st, seg, O_RDWR);
+    if (fd == -1 && errno == ENOENT && fs->segment_ids &&
+        create_segments(fs, seg) == 0)
+        fd = open_items_file(fs, itp->item_st, seg, O_RDWR);
+    if (fd == -1)
+        return -1;
+
+    const int total_entries = fd_total_items(fd, FILES_ENTRY_LEN);
+    const off_t eof_pos = (off_t)total_entries * FILES_ENTRY_LEN;
+
+    /*
+     * New IDs are handed out in increasing order, so most items belong at the
+     * end of the file; this is checked before searching
+     */
+    off_t new_item_pos = eof_pos;
+    if (total_entries > 0 &&
+        fd_read_id_at(fd, eof_pos - FILES_ENTRY_LEN, NULL) >=
+            itp->item_id) {
+        /* Ensure that the new item is placed in order */
+        int is_live = 0;
+        new_item_pos = fd_search_for_entry_id(fd, itp->item_id, &is_live);
+        if ((new_item_pos >= 0 && is_live) || new_item_pos == -1) {
+#ifdef DEBUG
+            log_err("Item is already in file or file could not be searched");
+#endif
+            close(fd);
+            return -1;
+        }
+    }
+
+    int ret = 0;
+    if (new_item_pos >= 0 && new_item_pos < eof_pos) {
+        /* Revive the item's own tombstone in place */
+        ret = pwrite_all(fd, entry, FILES_ENTRY_LEN, new_item_pos);
+        if (ret == 0)
+            set_tombstone_count(fs, itp->item_st, seg,
+                                tombstone_count(fs, itp->item_st, seg) - 1);
+    } else {
+        /* Make non-negative */
+        if (new_item_pos < 0)
+            new_item_pos = (new_item_pos == OFF_T_MIN) ? 0 : -new_item_pos;
+        ret = fd_insert_entry_at(fd, new_item_pos, entry, FILES_ENTRY_LEN);
+    }
+
+    if (ret == 0)
+        write_id_dir_entry(fs, itp->item_id, itp->item_st, new_item_pos);
+
+    if (ret == 0)
+        ret = sync_items_file(fs, fd, itp->item_st, seg);
+    close(fd);
+    return ret;
+}
+
+/**
+ * @brief Remove the item entry at the given offset by marking it as a
+ * tombstone, leaving all other entries in place
+ * @param fd File descriptor of file of item entries opened for writing
+ * @param entry_off Offset of the *first* byte of the entry
+ * @return 0 on success
+ * @return -1 on error
+ * @see compact_items_file for permanently removing tombstones
+ */
+static_fn int fd_kill_entry_at(const int fd, const off_t entry_off) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+    assert(entry_off >= 0);
+    assert(_FILES_DEAD_DELIM_LEN == _FILES_FIELD_DELIM_LEN);
+
+    return pwrite_all(fd, _FILES_DEAD_DELIM, _FILES_DEAD_DELIM_LEN,
+                      entry_off + _FILES_DEAD_POS);
+}
+
+/**
+ * @brief Permanently remove all tombstones from the items file of a given
+ * status and segment, rewriting the live entries to a new file in one
+ * sequential write
+ * @param fs Set of item files
+ * @param st Status of items file to compact
+ * @param seg Segment of items file to compact
+ * @return Number of tombstones removed
+ * @return -1 on error, in which case the items file is unchanged
+ * @note The ID directory locations of the moved entries are rewritten
+ */
+static_fn int compact_items_file(const struct files_set *fs,
+                                 const enum status st, const int seg) {
+    char file_path[MAX_PATH];
+    char tmp_path[MAX_PATH];
+
+    int fd = open_items_file(fs, st, seg, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    struct entry_buf buf;
+    const int total_entries = fd_load_entries(fd, FILES_ENTRY_LEN, &buf);
+    close(fd);
+    if (total_entries < 0)
+        return -1;
+
+    /* Live entries keep their order */
+    char *live_entries = malloc(buf.len + 1);
+    if (!live_entries) {
+        free_entry_buf(&buf);
+        return -1;
+    }
+
+    size_t live_len = 0;
+    for (int i = 0; i < total_entries; i++) {
+        const char *entry = buf.data + (size_t)i * FILES_ENTRY_LEN;
+        if (entry_is_live(entry)) {
+            memcpy(live_entries + live_len, entry, FILES_ENTRY_LEN);
+            live_len += FILES_ENTRY_LEN;
+        }
+    }
+    free_entry_buf(&buf);
+
+    const int removed = total_entries - (int)(live_len / FILES_ENTRY_LEN);
+    if (removed == 0) {
+        free(live_entries);
+        set_tombstone_count(fs, st, seg, 0);
+        return 0;
+    }
+
+    items_file_path(fs, st, seg, file_path);
+    snprintf(tmp_path, sizeof(tmp_path), "%.*s.tmp", MAX_PATH - 5, file_path);
+
+    int fd_tmp = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC,
+                      CONF_DIR_PERMS & 0666);
+    if (fd_tmp < 0) {
+        free(live_entries);
+        return -1;
+    }
+
+    int ret = pwrite_all(fd_tmp, live_entries, live_len, 0);
+
+    /* Replace the items file only once the compacted file is complete */
+    if (ret == 0)
+        ret = files_env->sync_replacement(fd_tmp);
+    close(fd_tmp);
+    if (ret == 0)
+        ret = rename(tmp_path, file_path);
+
+    if (ret != 0) {
+#ifdef DEBUG
+        log_err("Items file could not be compacted");
+#endif
+        free(live_entries);
+        unlink(tmp_path);
+        return -1;
+    }
+
+    /* Entries after the first tombstone have moved */
+    write_id_dir_entries(fs, st, live_entries, live_len);
+    free(live_entries);
+
+    set_tombstone_count(fs, st, seg, 0);
+    return removed;
+}
+
+/**
+ * @brief Load the entries of every segment of a status into buf, in order of
+ * ID
+ * @param fs Set of item files
+ * @param st Status of items
+ * @param num_segs Number of segments, see count_segments
+ * @param buf Entry buffer to load entries into, release with free_entry_buf
+ * @return Number of entries loaded into buf
+ * @return -1 on error, buf is left empty
+ * @note A status of a single segment is mapped, otherwise segments are copied
+ * into one heap-allocated buffer
+ */
+static_fn int load_status_entries(const struct files_set *fs,
+                                  const enum status st, const int num_segs,
+                                  struct entry_buf *buf) {
+    if (num_segs == 1) {
+        int fd = open_items_file(fs, st, 0, O_RDONLY);
+        if (fd < 0) {
+            memset(buf, 0, sizeof(*buf));
+            return -1;
+        }
+        const int num_entries = fd_load_entries(fd, FILES_ENTRY_LEN, buf);
+        close(fd);
+        return num_entries;
+    }
+
+    memset(buf, 0, sizeof(*buf));
+    size_t capacity = 0;
+
+    for (int seg = 0; seg < num_segs; seg++) {
+        struct entry_buf seg_buf;
+        int fd = open_items_file(fs, st, seg, O_RDONLY);
+        const int num_entries =
+            fd < 0 ? -1 : fd_load_entries(fd, FILES_ENTRY_LEN, &seg_buf);
+        if (fd >= 0)
+            close(fd);
+        if (num_entries < 0) {
+            free_entry_buf(buf);
+            return -1;
+        }
+
+        if (buf->len + seg_buf.len > capacity) {
+            const size_t new_capacity = 2 * (buf->len + seg_buf.len);
+            char *data = realloc(buf->data, new_capacity);
+            if (!data) {
+                free_entry_buf(&seg_buf);
+                free_entry_buf(buf);
+                return -1;
+            }
+            buf->data = data;
+            capacity = new_capacity;
+        }
+
+        if (seg_buf.len > 0)
+            memcpy(buf->data + buf->len, seg_buf.data, seg_buf.len);
+        buf->len += seg_buf.len;
+        free_entry_buf(&seg_buf);
+    }
+
+    return (int)(buf->len / FILES_ENTRY_LEN);
+}
+
+/**
+ * @brief Write the entries of items of one status and segment to their empty
+ * items file with one sequential write
+ * @return 0 on success
+ * @return -1 on error
+ */
+static_fn int write_items_file(const struct files_set *fs, const enum status st,
+                               const int seg, const char *entries,
+                               const size_t len) {
+    int fd = open_items_file(fs, st, seg, O_WRONLY);
+    if (fd < 0)
+        return -1;
+
+    int ret = pwrite_all(fd, entries, len, 0);
+    if (ret == 0)
+        ret = files_env->sync_replacement(fd);
+    close(fd);
+    return ret;
+}
+
+/* Operations shared by both layouts of the store */
+
+static_fn int files_create(const struct files_set *fs) {
+    const char *const paths[] = {fs->tombstones_path, fs->id_dir_path};
+
+    /* Segments beyond the first would hold items of the discarded store */
+    int num_segs = count_segments(fs);
+    for (int seg = 1; seg < num_segs; seg++) {
+        for (int i = 0; i < ITEM_STATUS_COUNT; i++) {
+            char path[MAX_PATH];
+            items_file_path(fs, (enum status)i, seg, path);
+            unlink(path);
+        }
+    }
+
+    for (int i = 0; i < ITEM_STATUS_COUNT; i++) {
+        int fd = open_items_file(fs, (enum status)i, 0,
+                                 O_WRONLY | O_CREAT | O_TRUNC);
+        if (fd < 0)
+            return -1;
+        close(fd);
+    }
+
+    for (size_t i = 0; i < sizeof(paths) / sizeof(*paths); i++) {
+        int fd = open(paths[i], O_WRONLY | O_CREAT | O_TRUNC,
+                      CONF_DIR_PERMS & 0666);
+        if (fd < 0)
+            return -1;
+        close(fd);
+    }
+
+    return 0;
+}
+
+static_fn void files_remove(const struct files_set *fs) {
+    const int num_segs = count_segments(fs);
+    for (int seg = 0; seg < num_segs; seg++) {
+        for (int i = 0; i < ITEM_STATUS_COUNT; i++) {
+            char path[MAX_PATH];
+            items_file_path(fs, (enum status)i, seg, path);
+            unlink(path);
+        }
+    }
+
+    unlink(fs->tombstones_path);
+    unlink(fs->id_dir_path);
+}
+
+static_fn int files_total_items(const struct files_set *fs) {
+    const int num_segs = count_segments(fs);
+    int num_items = 0;
+
+    /* Read entries by examining file sizes of all item files */
+    for (int seg = 0; seg < num_segs; seg++) {
+        for (int i = 0; i < ITEM_STATUS_COUNT; i++) {
+            int fd = open_items_file(fs, (enum status)i, seg, O_RDONLY);
+            const int num_entries =
+                fd < 0 ? -1 : fd_total_items(fd, FILES_ENTRY_LEN);
+            if (fd >= 0)
+                close(fd);
+
+            if (num_entries < 0) {
+#ifdef DEBUG
+                log_err("Could not open item file for reading");
+#endif
+                return -1;
+            }
+            num_items += num_entries;
+        }
+    }
+
+    return num_items - tombstone_total(fs);
+}
+
+static_fn int files_item_status(const struct files_set *fs,
+                                const sitem_id id) {
+    enum status st;
+    off_t entry_off;
+    if (locate_item(fs, id, &st, &entry_off) < 0)
+        return -1;
+
+    return st;
+}
+
+static_fn item *files_read_item(const struct files_set *fs,
+                                const sitem_id id) {
+    enum status st;
+    off_t entry_off;
+    if (locate_item(fs, id, &st, &entry_off) < 0)
+        return NULL;
+
+    int fd = open_items_file(fs, st, segment_of(fs, id), O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    item *itp = fd_read_item_at(fd, entry_off);
+    close(fd);
+
+    if (itp)
+        itp->item_st = st;
+    return itp;
+}
+
+static_fn item **files_read_items_status(const struct files_set *fs,
+                                         const enum status st) {
+    /* Entries are parsed in place */
+    struct entry_buf buf;
+    const int total_items =
+        load_status_entries(fs, st, count_segments(fs), &buf);
+
+    if (total_items < 0) {
+#ifdef DEBUG
+        log_err("Could not load items file");
+#endif
+        return NULL;
+    }
+
+    item **items = (item **)malloc(sizeof(item *) * (total_items + 1));
+    if (!items) {
+        free_entry_buf(&buf);
+        return NULL;
+    }
+
+    int live_items = 0;
+    for (int i = 0; i < total_items; i++) {
+        const char *entry = buf.data + (size_t)i * FILES_ENTRY_LEN;
+        if (!entry_is_live(entry))
+            continue;
+        /* Parse entry data */
+        items[live_items] = entry_to_item(entry);
+        items[live_items]->item_st = st; /* Set status */
+        live_items++;
+    }
+
+    /* NULL terminate */
+    items[live_items] = NULL;
+
+    free_entry_buf(&buf);
+
+    return items;
+}
+
+/**
+ * @brief The items files of each viewed status are loaded into its own buffer
+ */
+static_fn int files_view_open(const struct files_set *fs,
+                              struct dir_item_view *view) {
+    const int num_segs = count_segments(fs);
+    int total_items = 0;
+
+    for (int i = 0; i < view->num_sts; i++) {
+        const int num_items =
+            load_status_entries(fs, view->sts[i], num_segs, &view->bufs[i]);
+        if (num_items < 0)
+            return -1;
+        total_items += num_items;
+    }
+
+    return total_items;
+}
+
+/**
+ * @brief Check whether an entry in the buffer of the status being iterated by
+ * a view is live
+ */
+static_fn int files_entry_is_visible(const struct dir_item_view *view,
+                                     const char *entry) {
+    (void)view;
+    return entry_is_live(entry);
+}
+
+static_fn const struct dir_item_ref *
+files_store_view_next(struct dir_item_view *view) {
+    const char *entry =
+        view_next_entry(view, FILES_ENTRY_LEN, 0, 1, files_entry_is_visible);
+    if (!entry)
+        return NULL;
+
+    /* Fields are referenced in place, see entry_to_item for positions */
+    const size_t code_pos = HEX_LEN(sitem_id) + _FILES_FIELD_DELIM_LEN;
+    const size_t name_pos = code_pos + ITEM_CODE_LEN + _FILES_FIELD_DELIM_LEN;
+
+    view->ref.id = hex_field_to_id(entry);
+    view->ref.st = view->sts[view->curr_st];
+    view->ref.code = entry + code_pos;
+    view->ref.name = entry + name_pos;
+    view->ref.name_len = entry_name_len(entry + name_pos);
+    view->ref.loc = entry - view->bufs[view->curr_st].data;
+
+    return &view->ref;
+}
+
+static_fn int files_append_item(const struct files_set *fs, const item *itp) {
+    /* Additional + 1 allocated for NULL byte */
+    char item_entry[FILES_ENTRY_LEN + 1] = {'\0'};
+
+    if (make_item_entry(itp, item_entry) < 0)
+        return -1;
+
+    /* Write item data to items file */
+    return append_item_entry(fs, itp, item_entry);
+}
+
+/**
+ * @brief Kill the entry of an item, counting it as a tombstone of its items
+ * file and compacting the file once it is mostly tombstones
+ * @param fs Set of item files
+ * @param id ID of item
+ * @param st Status of the item
+ * @param item_off Offset of the item entry in the items file of status st
+ * @return Heap-allocated item held by the entry
+ * @return NULL on error, in which case the entry is left live
+ */
+static_fn item *kill_item_entry(const struct files_set *fs, const sitem_id id,
+                                const enum status st, const off_t item_off) {
+    /* Only the files of the segment of the item are changed */
+    const int seg = segment_of(fs, id);
+    int fd = open_items_file(fs, st, seg, O_RDWR);
+    if (fd < 0) {
+#ifdef DEBUG
+        log_err("Could not open item file for reading and writing");
+#endif
+        return NULL;
+    }
+
+    /* Remove item from current location */
+    item *itp = fd_read_item_at(fd, item_off);
+
+    if (!itp || fd_kill_entry_at(fd, item_off) < 0) {
+        /* Could not read or remove item */
+        item_free(itp);
+        close(fd);
+        return NULL;
+    }
+
+    const int file_entries = fd_total_items(fd, FILES_ENTRY_LEN);
+    sync_items_file(fs, fd, st, seg);
+    close(fd);
+
+    const int file_dead = tombstone_count(fs, st, seg) + 1;
+    set_tombstone_count(fs, st, seg, file_dead);
+
+    /* Rewrite the file once it is mostly tombstones */
+    if (file_dead >= _FILES_GC_MIN_DEAD &&
+        file_dead * 100 >= file_entries * _FILES_GC_DEAD_PERCENT)
+        compact_items_file(fs, st, seg);
+
+    return itp;
+}
+
+static_fn int files_change_status(const struct files_set *fs,
+                                  const sitem_id id,
+                                  const enum status new_status) {
+    /* Find item in project */
+    enum status old_status;
+    off_t item_off;
+    if (locate_item(fs, id, &old_status, &item_off) < 0)
+        return -1;
+
+    /* Status is already correct */
+    if (old_status == new_status)
+        return -1;
+
+    item *itp = kill_item_entry(fs, id, old_status, item_off);
+    if (!itp)
+        return -1;
+
+    /* Update status */
+    itp->item_st = new_status;
+
+    /*
+     * Add to new location, an item failing to be added is only held by the
+     * log, which is kept to be redone
+     */
+    const int ret = files_append_item(fs, itp);
+
+    item_free(itp);
+    return ret;
+}
+
+static_fn int files_remove_item(const struct files_set *fs,
+                                const sitem_id id) {
+    enum status st;
+    off_t item_off;
+    if (locate_item(fs, id, &st, &item_off) < 0)
+        return -1;
+
+    /* The ID directory location is left stale, as after a status change */
+    item *itp = kill_item_entry(fs, id, st, item_off);
+    if (!itp)
+        return -1;
+
+    item_free(itp);
+    return 0;
+}
+
+static_fn int files_compact(const struct files_set *fs) {
+    const int had_id_dir = access(fs->id_dir_path, F_OK) == 0;
+    const int num_segs = count_segments(fs);
+    int removed = 0;
+
+    for (int seg = 0; seg < num_segs; seg++) {
+        for (int i = 0; i < ITEM_STATUS_COUNT; i++) {
+            int removed_file = compact_items_file(fs, (enum status)i, seg);
+            if (removed_file < 0)
+                return -1;
+            removed += removed_file;
+        }
+    }
+
+    /* Compaction only records the locations of entries it moves */
+    if (!had_id_dir)
+        rebuild_id_directory(fs);
+
+    return removed;
+}
+
+/**
+ * @brief Each items file is written with one sequential write
+ */
+static_fn int files_write_items(const struct files_set *fs, item **items) {
+    const size_t num_items = item_count_items(items);
+    char *entries = malloc(num_items * FILES_ENTRY_LEN + 1);
+    if (!entries)
+        return -1;
+
+    sitem_id max_id = 0;
+    for (size_t i = 0; i < num_items; i++) {
+        if (items[i]->item_id > max_id)
+            max_id = items[i]->item_id;
+    }
+
+    int ret = create_segments(fs, segment_of(fs, max_id));
+
+    /* Items of a status are sorted by ID, so each segment is one run */
+    for (int st = 0; st < ITEM_STATUS_COUNT && ret == 0; st++) {
+        size_t i = 0;
+        for (;;) {
+            while (i < num_items && items[i]->item_st != (enum status)st)
+                i++;
+            if (i == num_items)
+                break;
+
+            const int seg = segment_of(fs, items[i]->item_id);
+            size_t entries_len = 0;
+            for (; i < num_items; i++) {
+                if (items[i]->item_st != (enum status)st)
+                    continue;
+                if (segment_of(fs, items[i]->item_id) != seg)
+                    break;
+                if (make_item_entry(items[i], entries + entries_len) < 0) {
+                    ret = -1;
+                    break;
+                }
+                entries_len += FILES_ENTRY_LEN;
+            }
+
+            if (ret == 0)
+                ret = write_items_file(fs, (enum status)st, seg, entries,
+                                       entries_len);
+            if (ret != 0)
+                break;
+        }
+    }
+
+    free(entries);
+
+    if (ret == 0)
+        ret = rebuild_id_directory(fs);
+    return ret;
+}
+
+/* Store of one file for each status */
+
+static_fn int files_store_create() { return files_create(&whole_files); }
+
+static_fn void files_store_remove() { files_remove(&whole_files); }
+
+static_fn int files_store_total_items() {
+    return files_total_items(&whole_files);
+}
+
+static_fn int files_store_item_status(const sitem_id id) {
+    return files_item_status(&whole_files, id);
+}
+
+static_fn item *files_store_read_item(const sitem_id id) {
+    return files_read_item(&whole_files, id);
+}
+
+/**
+ * @brief Entries of a view are loaded from the start of the one file of their
+ * status, so locations in views are offsets in that file
+ */
+static_fn void files_store_hint_location(const sitem_id id,
+                                         const enum status st,
+                                         const off_t loc) {
+    hinted_fs = &whole_files;
+    hinted_id = id;
+    hinted_st = st;
+    hinted_off = loc;
+}
+
+static_fn item **files_store_read_items_status(const enum status st) {
+    return files_read_items_status(&whole_files, st);
+}
+
+static_fn int files_store_view_open(struct dir_item_view *view) {
+    return files_view_open(&whole_files, view);
+}
+
+static_fn int files_store_append_item(const item *itp) {
+    return files_append_item(&whole_files, itp);
+}
+
+static_fn int files_store_change_status(const sitem_id id,
+                                        const enum status st) {
+    return files_change_status(&whole_files, id, st);
+}
+
+static_fn int files_store_remove_item(const sitem_id id) {
+    return files_remove_item(&whole_files, id);
+}
+
+static_fn int files_store_compact() { return files_compact(&whole_files); }
+
+static_fn int files_store_write_items(item **items) {
+    return files_write_items(&whole_files, items);
+}
+
+const struct store_ops files_store = {
+    .setup = files_store_setup,
+    .create = files_store_create,
+    .remove = files_store_remove,
+    .total_items = files_store_total_items,
+    .item_status = files_store_item_status,
+    .read_item = files_store_read_item,
+    .hint_location = files_store_hint_location,
+    .read_items_status = files_store_read_items_status,
+    .view_open = files_store_view_open,
+    .view_next = files_store_view_next,
+    .name_max = ITEM_NAME_MAX,
+    .append_item = files_store_append_item,
+    .change_status = files_store_change_status,
+    .remove_item = files_store_remove_item,
+    .compact = files_store_compact,
+    .write_items = files_store_write_items,
+};
+
+/* Store of the files of each status split into segments */
+
+static_fn int segments_store_create() { return files_create(&segment_files); }
+
+static_fn void segments_store_remove() { files_remove(&segment_files); }
+
+static_fn int segments_store_total_items() {
+    return files_total_items(&segment_files);
+}
+
+static_fn int segments_store_item_status(const sitem_id id) {
+    return files_item_status(&segment_files, id);
+}
+
+static_fn item *segments_store_read_item(const sitem_id id) {
+    return files_read_item(&segment_files, id);
+}
+
+static_fn item **segments_store_read_items_status(const enum status st) {
+    return files_read_items_status(&segment_files, st);
+}
+
+static_fn int segments_store_view_open(struct dir_item_view *view) {
+    return files_view_open(&segment_files, view);
+}
+
+static_fn int segments_store_append_item(const item *itp) {
+    return files_append_item(&segment_files, itp);
+}
+
+static_fn int segments_store_change_status(const sitem_id id,
+                                           const enum status st) {
+    return files_change_status(&segment_files, id, st);
+}
+
+static_fn int segments_store_remove_item(const sitem_id id) {
+    return files_remove_item(&segment_files, id);
+}
+
+static_fn int segments_store_compact() {
+    return files_compact(&segment_files);
+}
+
+static_fn int segments_store_write_items(item **items) {
+    return files_write_items(&segment_files, items);
+}
+
+const struct store_ops segments_store = {
+    .setup = segments_store_setup,
+    .create = segments_store_create,
+    .remove = segments_store_remove,
+    .total_items = segments_store_total_items,
+    .item_status = segments_store_item_status,
+    .read_item = segments_store_read_item,
+    .read_items_status = segments_store_read_items_status,
+    .view_open = segments_store_view_open,
+    .view_next = files_store_view_next,
+    .name_max = ITEM_NAME_MAX,
+    .append_item = segments_store_append_item,
+    .change_status = segments_store_change_status,
+    .remove_item = segments_store_remove_item,
+    .compact = segments_store_compact,
+    .write_items = segments_store_write_items,
+};
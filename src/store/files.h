@@ -0,0 +1,223 @@
+/**
+ * @brief Item files layout: the items of each status are stored in their own
+ * plain-text file of fixed-width entries, sorted by item ID.
+ *
+ * An item changing status is appended to the file of its new status and its
+ * old entry is left in place as a tombstone, counted in the tombstones file.
+ * An item removed from the store leaves only its tombstone. Files are compacted
+ * once they are mostly tombstones. The ID directory holds
+ * the last known location of each item, so that an item is found without
+ * searching every file, and the location of an item last seen in a view may
+ * be hinted so that it is found without reading the directory.
+ *
+ * In the segments layout, the file of each status is split into segment files
+ * of _FILES_SEGMENT_IDS consecutive IDs (e.g. items/done.0003 holds the done
+ * items with IDs from 3 * _FILES_SEGMENT_IDS), so that changes to an item only
+ * read and rewrite the files of its segment. Entries and ID directory
+ * locations are the same in both layouts, offsets being within the segment
+ * file of the ID, and tombstones are counted for each file.
+ *
+ * Operations of the store are prefixed with files_store_ or segments_store_
+ * @note This should be considered only internally and not part of the dir
+ * interface
+ */
+#ifndef FILES_H
+#define FILES_H
+
+#include "store/store.h"
+
+#define _FILES_BACKLOG_F "backlog" /* Backlog or *future* items */
+#define _FILES_TODO_F "todo"       /* Items staged for completion */
+#define _FILES_INPROG_F "ip"       /* Items currently mared as in progress */
+#define _FILES_DONE_F "done"       /* Complete items */
+
+#define _FILES_NUM_FILES 4 /* Number of item files categorised */
+
+/* In project directory, as they predate the items directory holding stores */
+#define _FILES_TOMBSTONES_F "TOMBSTONES" /* Dead entries in each item file */
+#define _FILES_ID_DIR_F "ID_DIRECTORY"   /* Location of each item by ID */
+
+/* Files of the segments layout, in the items directory */
+#define _FILES_SEGMENT_TOMBSTONES_F "tombstones"
+#define _FILES_SEGMENT_ID_DIR_F "ids"
+
+#define _FILES_SEGMENT_IDS 1024 /* IDs in each segment file */
+#define _FILES_SEGMENT_DIGITS 4 /* Minimum digits of segment in file names */
+
+/* Distinct segment files tracked for syncing at exit in a single run */
+#define _FILES_WRITTEN_SEGMENTS_MAX 8
+
+#define _FILES_ENTRY_DELIM "\n" /* Item delimiter - note char * type */
+#define _FILES_ENTRY_DELIM_LEN (sizeof(_FILES_ENTRY_DELIM) - 1)
+
+#define _FILES_FIELD_DELIM ":" /* Item field delimiter */
+#define _FILES_FIELD_DELIM_LEN (sizeof(_FILES_FIELD_DELIM) - 1)
+
+/*
+ * Removed (dead) item entries are left in place as tombstones, marked by
+ * replacing the delimiter following the item ID
+ */
+#define _FILES_DEAD_DELIM "!"
+#define _FILES_DEAD_DELIM_LEN (sizeof(_FILES_DEAD_DELIM) - 1)
+#define _FILES_DEAD_POS HEX_LEN(sitem_id) /* Position of mark in entry */
+
+/* Item entry format */
+#define FILES_ENTRY_LEN                                                        \
+    (                                             /* Item ID */                \
+     HEX_LEN(sitem_id) + _FILES_FIELD_DELIM_LEN + /* Item character code */    \
+     ITEM_CODE_LEN + _FILES_FIELD_DELIM_LEN +     /* Item name */              \
+     ITEM_NAME_MAX + _FILES_ENTRY_DELIM_LEN)
+
+/*
+ * ID directory entry format, the entry of an item is found at
+ * ID * _FILES_ID_DIR_ENTRY_LEN and holds the status of the item followed by
+ * the offset of its entry in the items file of that status.
+ * Entries of IDs that have no location yet are holes (zero bytes)
+ */
+#define _FILES_ST_CHARS "btid" /* Status characters, indexed by enum status */
+#define _FILES_ID_DIR_OFF_POS (1 + _FILES_FIELD_DELIM_LEN)
+#define _FILES_ID_DIR_ENTRY_LEN                                                \
+    (_FILES_ID_DIR_OFF_POS + HEX_LEN(off_t) + _FILES_ENTRY_DELIM_LEN)
+
+/*
+ * Count of tombstones in a single item file, the count of the file of status
+ * st in segment seg is entry seg * ITEM_STATUS_COUNT + st
+ */
+#define _FILES_TOMBSTONE_ENTRY_LEN (HEX_LEN(sitem_id) + _FILES_ENTRY_DELIM_LEN)
+
+/*
+ * Item files are compacted once they hold at least _FILES_GC_MIN_DEAD
+ * tombstones which make up at least _FILES_GC_DEAD_PERCENT of entries
+ */
+#define _FILES_GC_MIN_DEAD 64
+#define _FILES_GC_DEAD_PERCENT 50
+
+/* Bytes moved by each read and write when shifting entries within a file */
+#define _FILES_SHIFT_CHUNK_SZ (64 * 1024)
+
+#define OFF_T_MIN ((off_t)(((off_t)1) << (sizeof(off_t) * 8 - 1)))
+
+/**
+ * @brief Item files of one layout of the store
+ */
+struct files_set {
+    int segment_ids;             /* IDs in each segment, 0 if not segmented */
+    const char *tombstones_path; /* Dead entry counts of each file */
+    const char *id_dir_path;     /* Item locations by ID */
+};
+
+/**
+ * @brief Store of items in one file for each status in the items directory
+ */
+extern const struct store_ops files_store;
+
+/**
+ * @brief Store of items in segment files of consecutive IDs for each status
+ * in the items directory
+ */
+extern const struct store_ops segments_store;
+
+#ifdef TJUNITTEST
+extern void files_store_setup(const struct store_env *env);
+extern void segments_store_setup(const struct store_env *env);
+extern const char *items_status_path(const enum status st);
+extern int items_file_path(const struct files_set *fs, const enum status st,
+                           const int seg, char buf[MAX_PATH]);
+extern int open_items_file(const struct files_set *fs, const enum status st,
+                           const int seg, const int flags);
+extern int sync_items_file(const struct files_set *fs, const int fd,
+                           const enum status st, const int seg);
+extern int count_segments(const struct files_set *fs);
+extern int create_segments(const struct files_set *fs, const int last_seg);
+extern item *entry_to_item(const char entry[FILES_ENTRY_LEN + 1]);
+extern item *fd_read_item_at(int fd, off_t entry_off);
+extern sitem_id fd_read_id_at(const int fd, const off_t entry_off,
+                              int *is_live);
+extern int tombstone_count(const struct files_set *fs, const enum status st,
+                           const int seg);
+extern int tombstone_total(const struct files_set *fs);
+extern void set_tombstone_count(const struct files_set *fs,
+                                const enum status st, const int seg,
+                                const int count);
+extern int make_item_entry(const item *const itp,
+                           char buf[FILES_ENTRY_LEN + 1]);
+extern off_t fd_search_for_entry_id(const int fd, const sitem_id target_id,
+                                    int *is_live);
+extern int read_id_dir_entry(const struct files_set *fs, const sitem_id id,
+                             enum status *st, off_t *entry_off);
+extern void make_id_dir_entry(const enum status st, const off_t entry_off,
+                              char buf[_FILES_ID_DIR_ENTRY_LEN + 1]);
+extern void write_id_dir_entry(const struct files_set *fs, const sitem_id id,
+                               const enum status st, const off_t entry_off);
+extern void write_id_dir_entries(const struct files_set *fs,
+                                 const enum status st, const char *entries,
+                                 const size_t len);
+extern int rebuild_id_directory(const struct files_set *fs);
+extern int item_entry_is_at(const struct files_set *fs, const sitem_id id,
+                            const enum status st, const off_t entry_off);
+extern int locate_item(const struct files_set *fs, const sitem_id id,
+                       enum status *st, off_t *entry_off);
+extern int fd_insert_entry_at(const int fd, const off_t entry_off,
+                              const char *entry, const size_t entry_len);
+extern int append_item_entry(const struct files_set *fs, const item *itp,
+                             const char entry[FILES_ENTRY_LEN + 1]);
+extern int fd_kill_entry_at(const int fd, const off_t entry_off);
+extern int compact_items_file(const struct files_set *fs,
+                              const enum status st, const int seg);
+extern int load_status_entries(const struct files_set *fs,
+                               const enum status st, const int num_segs,
+                               struct entry_buf *buf);
+extern int write_items_file(const struct files_set *fs, const enum status st,
+                            const int seg, const char *entries,
+                            const size_t len);
+extern int files_create(const struct files_set *fs);
+extern void files_remove(const struct files_set *fs);
+extern int files_total_items(const struct files_set *fs);
+extern int files_item_status(const struct files_set *fs, const sitem_id id);
+extern item *files_read_item(const struct files_set *fs, const sitem_id id);
+extern item **files_read_items_status(const struct files_set *fs,
+                                      const enum status st);
+extern int files_view_open(const struct files_set *fs,
+                           struct dir_item_view *view);
+extern int files_entry_is_visible(const struct dir_item_view *view,
+                                  const char *entry);
+extern const struct dir_item_ref *
+files_store_view_next(struct dir_item_view *view);
+extern int files_append_item(const struct files_set *fs, const item *itp);
+extern item *kill_item_entry(const struct files_set *fs, const sitem_id id,
+                             const enum status st, const off_t item_off);
+extern int files_change_status(const struct files_set *fs, const sitem_id id,
+                               const enum status new_status);
+extern int files_remove_item(const struct files_set *fs, const sitem_id id);
+extern int files_compact(const struct files_set *fs);
+extern int files_write_items(const struct files_set *fs, item **items);
+extern int files_store_create(void);
+extern void files_store_remove(void);
+extern int files_store_total_items(void);
+extern int files_store_item_status(const sitem_id id);
+extern item *files_store_read_item(const sitem_id id);
+extern void files_store_hint_location(const sitem_id id, const enum status st,
+                                      const off_t loc);
+extern item **files_store_read_items_status(const enum status st);
+extern int files_store_view_open(struct dir_item_view *view);
+extern int files_store_append_item(const item *itp);
+extern int files_store_change_status(const sitem_id id, const enum status st);
+extern int files_store_remove_item(const sitem_id id);
+extern int files_store_compact(void);
+extern int files_store_write_items(item **items);
+extern int segments_store_create(void);
+extern void segments_store_remove(void);
+extern int segments_store_total_items(void);
+extern int segments_store_item_status(const sitem_id id);
+extern item *segments_store_read_item(const sitem_id id);
+extern item **segments_store_read_items_status(const enum status st);
+extern int segments_store_view_open(struct dir_item_view *view);
+extern int segments_store_append_item(const item *itp);
+extern int segments_store_change_status(const sitem_id id,
+                                        const enum status st);
+extern int segments_store_remove_item(const sitem_id id);
+extern int segments_store_compact(void);
+extern int segments_store_write_items(item **items);
+#endif
+
+#endif
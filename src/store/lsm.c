@@ -0,0 +1,716 @@
+#include "lsm.h"
+#include "dev-utils/test-helpers.h"
+#ifdef DEBUG
+#include "dev-utils/debug-out.h"
+#endif
+
+/**
+ * @brief Construct the path of the run with a given sequence number
+ */
+static inline void lsm_run_path(const char *dir, const sitem_id seq,
+                                char path[MAX_PATH]) {
+    snprintf(path, MAX_PATH, "%.*s/%s%0*X", MAX_PATH - 64, dir,
+             _LSM_RUN_PREFIX, (int)HEX_LEN(sitem_id), seq);
+}
+
+/**
+ * @brief Open a file of the store
+ */
+static inline int lsm_open(const char *dir, const char *base, int flags) {
+    char path[MAX_PATH];
+    store_path(dir, base, path);
+    return open(path, flags, CONF_DIR_PERMS & 0666);
+}
+
+int lsm_create(const char *dir) {
+    assert(dir);
+
+    const char *const bases[] = {_LSM_LOG_F, _LSM_RUNS_F};
+    for (size_t i = 0; i < sizeof(bases) / sizeof(*bases); i++) {
+        int fd = lsm_open(dir, bases[i], O_WRONLY | O_CREAT | O_TRUNC);
+        if (fd < 0)
+            return -1;
+        close(fd);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Read the sequence numbers of the runs listed in the manifest
+ * @param dir Directory holding the store
+ * @param seqs Set to a heap-allocated array of sequence numbers, oldest first
+ * @return Number of runs
+ * @return -1 on error, seqs is left unset
+ */
+static_fn int lsm_read_runs(const char *dir, sitem_id **seqs) {
+    assert(seqs);
+
+    int fd = lsm_open(dir, _LSM_RUNS_F, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    struct entry_buf buf;
+    const int num_runs = fd_load_entries(fd, _LSM_RUNS_ENTRY_LEN, &buf);
+    close(fd);
+    if (num_runs < 0)
+        return -1;
+
+    *seqs = malloc(sizeof(**seqs) * (num_runs + 1));
+    if (!*seqs) {
+        free_entry_buf(&buf);
+        return -1;
+    }
+
+    for (int i = 0; i < num_runs; i++)
+        (*seqs)[i] = hex_field_to_id(buf.data + i * _LSM_RUNS_ENTRY_LEN);
+
+    free_entry_buf(&buf);
+    return num_runs;
+}
+
+/**
+ * @brief Replace the manifest with a list of runs
+ * @param dir Directory holding the store
+ * @param seqs Sequence numbers of runs, oldest first
+ * @param num_runs Number of runs
+ * @param sync Function syncing the manifest before it is replaced, NULL to
+ * not sync
+ * @return 0 on success
+ * @return -1 on error, the manifest is unchanged
+ */
+static_fn int lsm_write_runs(const char *dir, const sitem_id *seqs,
+                             const int num_runs, int (*sync)(const int fd)) {
+    char *entries = malloc((size_t)num_runs * _LSM_RUNS_ENTRY_LEN + 1);
+    if (!entries)
+        return -1;
+
+    for (int i = 0; i < num_runs; i++) {
+        snprintf(entries + i * _LSM_RUNS_ENTRY_LEN, _LSM_RUNS_ENTRY_LEN + 1,
+                 "%0*X\n", (int)HEX_LEN(sitem_id), seqs[i]);
+    }
+
+    char path[MAX_PATH];
+    store_path(dir, _LSM_RUNS_F, path);
+    const int ret = replace_file(path, entries,
+                                     (size_t)num_runs * _LSM_RUNS_ENTRY_LEN,
+                                     sync);
+    free(entries);
+    return ret;
+}
+
+void lsm_remove(const char *dir) {
+    assert(dir);
+
+    char path[MAX_PATH];
+    sitem_id *seqs = NULL;
+    const int num_runs = lsm_read_runs(dir, &seqs);
+    for (int i = 0; i < num_runs; i++) {
+        lsm_run_path(dir, seqs[i], path);
+        unlink(path);
+    }
+    free(seqs);
+
+    store_path(dir, _LSM_RUNS_F, path);
+    unlink(path);
+    store_path(dir, _LSM_LOG_F, path);
+    unlink(path);
+}
+
+int lsm_log_append(const int fd, const item *itp) {
+    assert(fcntl(fd, F_GETFL) & O_APPEND); /* Entries are only appended */
+    assert(itp);
+
+    char entry[LSM_ENTRY_LEN + 1];
+    if (table_make_entry(itp, entry) < 0)
+        return -1;
+
+    return write(fd, entry, LSM_ENTRY_LEN) == LSM_ENTRY_LEN ? 0 : -1;
+}
+
+/**
+ * @brief Search a run for the entry with a given ID, reading O(log n) IDs
+ * @param fd File descriptor of run opened for reading
+ * @param id ID of item
+ * @param entry Buffer to copy the entry to
+ * @return 0 on success
+ * @return -1 if the run holds no entry with the ID
+ */
+static inline int lsm_search_run(const int fd, const sitem_id id,
+                                 char entry[LSM_ENTRY_LEN]) {
+    int lo = 0;
+    int hi = fd_total_items(fd, LSM_ENTRY_LEN) - 1;
+
+    while (lo <= hi) {
+        const int mid = lo + (hi - lo) / 2;
+        const off_t off = (off_t)mid * LSM_ENTRY_LEN;
+
+        char id_field[HEX_LEN(sitem_id)];
+        if (pread(fd, id_field, sizeof(id_field), off) != sizeof(id_field))
+            return -1;
+
+        const sitem_id mid_id = hex_field_to_id(id_field);
+        if (mid_id < id) {
+            lo = mid + 1;
+        } else if (mid_id > id) {
+            hi = mid - 1;
+        } else {
+            return pread(fd, entry, LSM_ENTRY_LEN, off) == LSM_ENTRY_LEN ? 0
+                                                                         : -1;
+        }
+    }
+
+    return -1;
+}
+
+int lsm_find_entry(const char *dir, const sitem_id id,
+                   char entry[LSM_ENTRY_LEN]) {
+    assert(dir);
+
+    if (id < 0)
+        return -1;
+
+    /* The log is bounded by LSM_LOG_MAX, the latest entry is last */
+    int fd = lsm_open(dir, _LSM_LOG_F, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    struct entry_buf log;
+    const int log_entries = fd_load_entries(fd, LSM_ENTRY_LEN, &log);
+    close(fd);
+
+    for (int i = log_entries - 1; i >= 0; i--) {
+        const char *log_entry = log.data + (size_t)i * LSM_ENTRY_LEN;
+        if (hex_field_to_id(log_entry) == id) {
+            memcpy(entry, log_entry, LSM_ENTRY_LEN);
+            free_entry_buf(&log);
+            return 0;
+        }
+    }
+    free_entry_buf(&log);
+
+    /* Runs are searched newest first */
+    sitem_id *seqs = NULL;
+    const int num_runs = lsm_read_runs(dir, &seqs);
+    int ret = -1;
+
+    for (int i = num_runs - 1; i >= 0 && ret < 0; i--) {
+        char path[MAX_PATH];
+        lsm_run_path(dir, seqs[i], path);
+
+        fd = open(path, O_RDONLY);
+        if (fd < 0)
+            continue;
+        ret = lsm_search_run(fd, id, entry);
+        close(fd);
+    }
+
+    free(seqs);
+    return ret;
+}
+
+int lsm_read_status(const char *dir, const sitem_id id) {
+    char entry[LSM_ENTRY_LEN];
+    if (lsm_find_entry(dir, id, entry) < 0)
+        return -1;
+
+    return table_entry_status(entry);
+}
+
+item *lsm_read_item(const char *dir, const sitem_id id) {
+    char entry[LSM_ENTRY_LEN];
+    if (lsm_find_entry(dir, id, entry) < 0)
+        return NULL;
+
+    return table_entry_to_item(entry);
+}
+
+/**
+ * @brief Compare log entries by ID, then by position in the log
+ */
+static int lsm_cmp_log_entries(const void *a, const void *b) {
+    const char *entry_a = *(const char *const *)a;
+    const char *entry_b = *(const char *const *)b;
+
+    const sitem_id id_a = hex_field_to_id(entry_a);
+    const sitem_id id_b = hex_field_to_id(entry_b);
+    if (id_a != id_b)
+        return id_a < id_b ? -1 : 1;
+
+    return (entry_a > entry_b) - (entry_a < entry_b);
+}
+
+/**
+ * @brief Sort the entries of the log by ID, keeping only the latest entry of
+ * each item
+ * @param log Log entries, in the order they were written
+ * @param out Entry buffer to write sorted entries to, on the heap
+ * @return Number of entries in out
+ * @return -1 on error, out is left empty
+ */
+static_fn int lsm_sort_log(const struct entry_buf *log, struct entry_buf *out) {
+    const size_t num_entries = log->len / LSM_ENTRY_LEN;
+
+    out->data = NULL;
+    out->len = 0;
+    out->is_mapped = 0;
+    if (num_entries == 0)
+        return 0;
+
+    const char **order = malloc(sizeof(*order) * num_entries);
+    out->data = malloc(log->len);
+    if (!order || !out->data) {
+        free(order);
+        free(out->data);
+        out->data = NULL;
+        return -1;
+    }
+
+    for (size_t i = 0; i < num_entries; i++)
+        order[i] = log->data + i * LSM_ENTRY_LEN;
+    qsort(order, num_entries, sizeof(*order), lsm_cmp_log_entries);
+
+    /* The last of each run of equal IDs is the latest entry */
+    for (size_t i = 0; i < num_entries; i++) {
+        if (i + 1 < num_entries &&
+            hex_field_to_id(order[i]) == hex_field_to_id(order[i + 1]))
+            continue;
+        memcpy(out->data + out->len, order[i], LSM_ENTRY_LEN);
+        out->len += LSM_ENTRY_LEN;
+    }
+
+    free(order);
+    return (int)(out->len / LSM_ENTRY_LEN);
+}
+
+/**
+ * @brief Merge sorted sources of entries, keeping the newest entry of each
+ * item unless it is a deletion entry
+ * @param srcs Entry buffers sorted by ID, with at most one entry for any ID,
+ * newest first
+ * @param num_srcs Number of sources
+ * @param out Entry buffer to write merged entries to, on the heap
+ * @return Number of entries in out
+ * @return -1 on error, out is left empty
+ */
+static_fn int lsm_merge(struct entry_buf *srcs, const int num_srcs,
+                        struct entry_buf *out) {
+    size_t total_len = 0;
+    for (int i = 0; i < num_srcs; i++)
+        total_len += srcs[i].len;
+
+    out->data = NULL;
+    out->len = 0;
+    out->is_mapped = 0;
+    if (total_len == 0)
+        return 0;
+
+    size_t *offs = calloc(num_srcs, sizeof(*offs));
+    out->data = malloc(total_len);
+    if (!offs || !out->data) {
+        free(offs);
+        free(out->data);
+        out->data = NULL;
+        return -1;
+    }
+
+    for (;;) {
+        /* The newest source holding the smallest ID provides its entry */
+        int min_src = -1;
+        sitem_id min_id = -1;
+        for (int i = 0; i < num_srcs; i++) {
+            if (offs[i] >= srcs[i].len)
+                continue;
+            const sitem_id id = hex_field_to_id(srcs[i].data + offs[i]);
+            if (min_src < 0 || id < min_id) {
+                min_src = i;
+                min_id = id;
+            }
+        }
+        if (min_src < 0)
+            break;
+
+        /* Removed items are held by no source once merged */
+        const char *entry = srcs[min_src].data + offs[min_src];
+        if (table_entry_status(entry) >= 0) {
+            memcpy(out->data + out->len, entry, LSM_ENTRY_LEN);
+            out->len += LSM_ENTRY_LEN;
+        }
+
+        /* Older entries of the item are shadowed */
+        for (int i = 0; i < num_srcs; i++) {
+            if (offs[i] < srcs[i].len &&
+                hex_field_to_id(srcs[i].data + offs[i]) == min_id)
+                offs[i] += LSM_ENTRY_LEN;
+        }
+    }
+
+    free(offs);
+    return (int)(out->len / LSM_ENTRY_LEN);
+}
+
+/**
+ * @brief Load the sorted log followed by every run, newest first
+ * @param dir Directory holding the store
+ * @param srcs Set to a heap-allocated array of num_runs + 1 entry buffers
+ * @param seqs Set to the sequence numbers of runs, oldest first
+ * @param num_runs Set to the number of runs
+ * @return Total entries in the log and runs
+ * @return -1 on error, nothing is left allocated
+ */
+static inline int lsm_load_sources(const char *dir, struct entry_buf **srcs,
+                                   sitem_id **seqs, int *num_runs) {
+    *num_runs = lsm_read_runs(dir, seqs);
+    if (*num_runs < 0)
+        return -1;
+
+    *srcs = calloc(*num_runs + 1, sizeof(**srcs));
+    int fd = *srcs ? lsm_open(dir, _LSM_LOG_F, O_RDONLY) : -1;
+    if (fd < 0) {
+        free(*srcs);
+        free(*seqs);
+        return -1;
+    }
+
+    struct entry_buf log;
+    int total_entries = fd_load_entries(fd, LSM_ENTRY_LEN, &log);
+    close(fd);
+    if (total_entries >= 0 && lsm_sort_log(&log, &(*srcs)[0]) < 0)
+        total_entries = -1;
+    free_entry_buf(&log);
+
+    for (int i = 0; i < *num_runs && total_entries >= 0; i++) {
+        char path[MAX_PATH];
+        lsm_run_path(dir, (*seqs)[i], path);
+
+        fd = open(path, O_RDONLY);
+        struct entry_buf *run = &(*srcs)[*num_runs - i];
+        const int run_entries =
+            fd < 0 ? -1 : fd_load_entries(fd, LSM_ENTRY_LEN, run);
+        if (fd >= 0)
+            close(fd);
+        total_entries = run_entries < 0 ? -1 : total_entries + run_entries;
+    }
+
+    if (total_entries < 0) {
+        for (int i = 0; i <= *num_runs; i++)
+            free_entry_buf(&(*srcs)[i]);
+        free(*srcs);
+        free(*seqs);
+        return -1;
+    }
+
+    return total_entries;
+}
+
+int lsm_load(const char *dir, struct entry_buf *buf) {
+    assert(dir);
+    assert(buf);
+
+    struct entry_buf *srcs;
+    sitem_id *seqs;
+    int num_runs;
+    if (lsm_load_sources(dir, &srcs, &seqs, &num_runs) < 0)
+        return -1;
+
+    const int num_entries = lsm_merge(srcs, num_runs + 1, buf);
+
+    for (int i = 0; i <= num_runs; i++)
+        free_entry_buf(&srcs[i]);
+    free(srcs);
+    free(seqs);
+    return num_entries;
+}
+
+int lsm_total_items(const char *dir) {
+    struct entry_buf buf;
+    const int num_entries = lsm_load(dir, &buf);
+
+    /* Every merged entry holds an item */
+    free_entry_buf(&buf);
+    return num_entries;
+}
+
+item **lsm_read_items_status(const char *dir, const enum status st) {
+    assert(st < ITEM_STATUS_COUNT);
+
+    struct entry_buf buf;
+    const int num_entries = lsm_load(dir, &buf);
+    if (num_entries < 0)
+        return NULL;
+
+    item **items = (item **)malloc(sizeof(item *) * (num_entries + 1));
+    if (!items) {
+        free_entry_buf(&buf);
+        return NULL;
+    }
+
+    int num_items = 0;
+    for (int i = 0; i < num_entries; i++) {
+        const char *entry = buf.data + (size_t)i * LSM_ENTRY_LEN;
+        if (table_entry_status(entry) != (int)st)
+            continue;
+        items[num_items] = table_entry_to_item(entry);
+        if (items[num_items])
+            num_items++;
+    }
+    items[num_items] = NULL;
+
+    free_entry_buf(&buf);
+    return items;
+}
+
+/**
+ * @brief Write a new run, replacing any file with its name atomically
+ * @param dir Directory holding the store
+ * @param seq Sequence number of run
+ * @param run Entries of run, sorted by ID
+ * @param sync Function syncing the run before it is named, NULL to not sync
+ * @return 0 on success
+ * @return -1 on error
+ */
+static_fn int lsm_write_run(const char *dir, const sitem_id seq,
+                            const struct entry_buf *run,
+                            int (*sync)(const int fd)) {
+    char path[MAX_PATH];
+    lsm_run_path(dir, seq, path);
+    return replace_file(path, run->data, run->len, sync);
+}
+
+int lsm_compact(const char *dir, const int merge_all,
+                int (*sync)(const int fd)) {
+    assert(dir);
+
+    struct entry_buf *srcs;
+    sitem_id *seqs;
+    int num_runs;
+    const int total_entries = lsm_load_sources(dir, &srcs, &seqs, &num_runs);
+    if (total_entries < 0)
+        return -1;
+
+    /* Sequence numbers only grow, so runs are never overwritten */
+    const sitem_id new_seq = num_runs > 0 ? seqs[num_runs - 1] + 1 : 0;
+    const int flush = srcs[0].len > 0;
+    const int merge = (merge_all && num_runs + flush > 1) ||
+                      num_runs + flush > _LSM_MAX_RUNS;
+
+    /* The log is flushed alone, or merged along with every run */
+    struct entry_buf merged = {NULL, 0, 0};
+    const struct entry_buf *new_run = &srcs[0];
+    int ret = 0;
+    if (merge) {
+        ret = lsm_merge(srcs, num_runs + 1, &merged) < 0 ? -1 : 0;
+        new_run = &merged;
+    }
+
+    /* Shadowed log entries are dropped when the log is sorted */
+    size_t kept_len = merged.len;
+    for (int i = 0; !merge && i <= num_runs; i++)
+        kept_len += srcs[i].len;
+
+    if (ret == 0 && (flush || merge)) {
+        ret = lsm_write_run(dir, new_seq, new_run, sync);
+        if (ret == 0 && merge) {
+            ret = lsm_write_runs(dir, &new_seq, 1, sync);
+        } else if (ret == 0) {
+            seqs[num_runs] = new_seq;
+            ret = lsm_write_runs(dir, seqs, num_runs + 1, sync);
+        }
+
+        if (ret != 0) {
+            char path[MAX_PATH];
+            lsm_run_path(dir, new_seq, path);
+            unlink(path);
+        }
+    }
+
+    /* Entries in the log and merged runs are now held by the new run */
+    if (ret == 0 && flush) {
+        int fd = lsm_open(dir, _LSM_LOG_F, O_WRONLY);
+        if (fd < 0 || ftruncate(fd, 0) < 0) {
+#ifdef DEBUG
+            log_err("Flushed log could not be emptied");
+#endif
+        }
+        if (fd >= 0)
+            close(fd);
+    }
+    for (int i = 0; ret == 0 && merge && i < num_runs; i++) {
+        char path[MAX_PATH];
+        lsm_run_path(dir, seqs[i], path);
+        unlink(path);
+    }
+
+    free_entry_buf(&merged);
+    for (int i = 0; i <= num_runs; i++)
+        free_entry_buf(&srcs[i]);
+    free(srcs);
+    free(seqs);
+
+    if (ret != 0) {
+#ifdef DEBUG
+        log_err("Log-structured store could not be compacted");
+#endif
+        return -1;
+    }
+
+    return total_entries - (int)(kept_len / LSM_ENTRY_LEN);
+}
+
+/* Store */
+
+static const struct store_env *lsm_env = NULL;
+static char lsm_log_path[MAX_PATH] = {'\0'};
+
+static_fn void lsm_store_setup(const struct store_env *env) {
+    assert(env);
+
+    lsm_env = env;
+    if (!*lsm_log_path)
+        store_path(env->items_dir, _LSM_LOG_F, lsm_log_path);
+}
+
+static_fn int lsm_store_create() {
+    return lsm_create(lsm_env->items_dir);
+}
+
+static_fn void lsm_store_remove() {
+    lsm_remove(lsm_env->items_dir);
+}
+
+static_fn int lsm_store_total_items() {
+    return lsm_total_items(lsm_env->items_dir);
+}
+
+static_fn int lsm_store_item_status(const sitem_id id) {
+    return lsm_read_status(lsm_env->items_dir, id);
+}
+
+static_fn item *lsm_store_read_item(const sitem_id id) {
+    return lsm_read_item(lsm_env->items_dir, id);
+}
+
+static_fn item **lsm_store_read_items_status(const enum status st) {
+    return lsm_read_items_status(lsm_env->items_dir, st);
+}
+
+/**
+ * @brief The log and runs are merged into table records, in order of ID
+ */
+static_fn int lsm_store_view_open(struct dir_item_view *view) {
+    return lsm_load(lsm_env->items_dir, &view->bufs[0]);
+}
+
+/**
+ * @brief Append an entry to the log, flushing the log to a sorted run once it
+ * is full
+ * @param entry Entry to append
+ * @return 0 on success
+ * @return -1 on error
+ */
+static_fn int lsm_store_log_entry(const char entry[LSM_ENTRY_LEN]) {
+    int fd = open(lsm_log_path, O_WRONLY | O_APPEND);
+    if (fd < 0)
+        return -1;
+
+    int ret = write(fd, entry, LSM_ENTRY_LEN) == LSM_ENTRY_LEN ? 0 : -1;
+    if (ret == 0)
+        ret = lsm_env->sync_written(fd, lsm_log_path);
+    const int log_entries = fd_total_items(fd, LSM_ENTRY_LEN);
+    close(fd);
+
+    /* The entry is already durable in the log, so a failed flush is retried
+     * by the next append */
+    if (ret == 0 && log_entries >= LSM_LOG_MAX)
+        lsm_compact(lsm_env->items_dir, 0, lsm_env->sync_replacement);
+    return ret;
+}
+
+/**
+ * @brief Append the whole state of an item to the log
+ * @param itp Pointer to item to write
+ * @return 0 on success
+ * @return -1 on error
+ */
+static_fn int lsm_store_log_item(const item *itp) {
+    char entry[LSM_ENTRY_LEN + 1];
+    if (table_make_entry(itp, entry) < 0)
+        return -1;
+    return lsm_store_log_entry(entry);
+}
+
+static_fn int lsm_store_append_item(const item *itp) {
+    /* Entries are appended, so an existing ID must be looked up first */
+    if (lsm_read_status(lsm_env->items_dir, itp->item_id) >= 0)
+        return -1;
+    return lsm_store_log_item(itp);
+}
+
+static_fn int lsm_store_change_status(const sitem_id id,
+                                      const enum status st) {
+    /* A new entry of the whole item shadows the old one */
+    item *itp = lsm_read_item(lsm_env->items_dir, id);
+    int ret = -1;
+    if (itp && itp->item_st != st) {
+        itp->item_st = st;
+        ret = lsm_store_log_item(itp);
+    }
+    item_free(itp);
+    return ret;
+}
+
+static_fn int lsm_store_remove_item(const sitem_id id) {
+    /* A deletion entry shadows the entry of the item */
+    char entry[LSM_ENTRY_LEN];
+    if (lsm_find_entry(lsm_env->items_dir, id, entry) < 0 ||
+        table_entry_status(entry) < 0)
+        return -1;
+
+    entry[TABLE_ST_POS] = _LSM_DELETED_ST;
+    return lsm_store_log_entry(entry);
+}
+
+/**
+ * @brief Shadowed and deletion entries are only left behind in the log and
+ * runs
+ */
+static_fn int lsm_store_compact() {
+    return lsm_compact(lsm_env->items_dir, 1, lsm_env->sync_replacement);
+}
+
+/**
+ * @brief Items are logged, then merged into a single run
+ */
+static_fn int lsm_store_write_items(item **items) {
+    int fd = open(lsm_log_path, O_WRONLY | O_APPEND);
+    if (fd < 0)
+        return -1;
+
+    int ret = 0;
+    for (size_t i = 0; items[i] && ret == 0; i++)
+        ret = lsm_log_append(fd, items[i]);
+    close(fd);
+
+    if (ret == 0 &&
+        lsm_compact(lsm_env->items_dir, 1, lsm_env->sync_replacement) < 0)
+        ret = -1;
+    return ret;
+}
+
+const struct store_ops lsm_store = {
+    .setup = lsm_store_setup,
+    .create = lsm_store_create,
+    .remove = lsm_store_remove,
+    .total_items = lsm_store_total_items,
+    .item_status = lsm_store_item_status,
+    .read_item = lsm_store_read_item,
+    .read_items_status = lsm_store_read_items_status,
+    .view_open = lsm_store_view_open,
+    .view_next = table_view_next,
+    .name_max = ITEM_NAME_MAX,
+    .append_item = lsm_store_append_item,
+    .change_status = lsm_store_change_status,
+    .remove_item = lsm_store_remove_item,
+    .compact = lsm_store_compact,
+    .write_items = lsm_store_write_items,
+};
@@ -0,0 +1,168 @@
+/**
+ * @brief Log-structured layout: every write appends the whole state of an item
+ * to a log, while reads merge the log with immutable sorted runs of entries.
+ *
+ * Log and run entries are item table records (see table.h). The log holds
+ * entries in the order they were written; once it holds LSM_LOG_MAX entries it
+ * is flushed, sorted by ID, to a new run and emptied. Runs are listed oldest
+ * first in a manifest and hold at most one entry for any ID. Once more than
+ * _LSM_MAX_RUNS runs exist, all runs are merged into one.
+ *
+ * The newest entry of an item wins: entries in the log (latest last) shadow
+ * entries in runs, and newer runs shadow older runs.
+ *
+ * An item is removed by logging a deletion entry, a record of the item whose
+ * status column holds _LSM_DELETED_ST. Deletion entries shadow older entries
+ * like any other, and are dropped whenever entries are merged.
+ *
+ * Functions are prefixed with lsm_, and take the path of the directory holding
+ * the log and runs; lsm_store keeps them in the items directory
+ * @note This should be considered only internally and not part of the dir
+ * interface
+ */
+#ifndef LSM_H
+#define LSM_H
+
+#include "store/store.h"
+#include "store/table.h"
+
+#define _LSM_LOG_F "log"       /* Log of item entries in items directory */
+#define _LSM_RUNS_F "runs"     /* Manifest of sorted runs, oldest first */
+#define _LSM_RUN_PREFIX "run." /* Run file names, followed by hex sequence */
+
+#define LSM_ENTRY_LEN TABLE_ENTRY_LEN /* Log and run entries */
+
+#define _LSM_DELETED_ST '-' /* Status column of deletion entries */
+
+/* Each manifest entry is the hex sequence number of a run */
+#define _LSM_RUNS_ENTRY_LEN (HEX_LEN(sitem_id) + 1)
+
+#define LSM_LOG_MAX 256 /* Log entries that cause a flush to a new run */
+#define _LSM_MAX_RUNS 4 /* Runs kept before all are merged into one */
+
+/**
+ * @brief Create the empty log and run manifest of a log-structured store
+ * @param dir Directory to hold the store
+ * @return 0 on success
+ * @return -1 on error
+ */
+extern int lsm_create(const char *dir);
+
+/**
+ * @brief Remove every file of a log-structured store
+ * @param dir Directory holding the store
+ * @note Errors with unlink are not handled
+ */
+extern void lsm_remove(const char *dir);
+
+/**
+ * @brief Append the entry of an item to the log
+ * @param fd File descriptor of log opened for appending
+ * @param itp Pointer to item to write
+ * @return 0 on success
+ * @return -1 on error
+ */
+extern int lsm_log_append(const int fd, const item *itp);
+
+/**
+ * @brief Find the newest entry of an item with a given ID
+ * @param dir Directory holding the store
+ * @param id ID of item
+ * @param entry Buffer to copy the entry to
+ * @return 0 on success
+ * @return -1 if the store holds no item with the ID
+ */
+extern int lsm_find_entry(const char *dir, const sitem_id id,
+                          char entry[LSM_ENTRY_LEN]);
+
+/**
+ * @brief Get the status of the item with a given ID
+ * @param dir Directory holding the store
+ * @param id ID of item
+ * @return Status of item
+ * @return -1 if the store holds no item with the ID
+ */
+extern int lsm_read_status(const char *dir, const sitem_id id);
+
+/**
+ * @brief Read the item with a given ID
+ * @param dir Directory holding the store
+ * @param id ID of item
+ * @return Heap-allocated item
+ * @return NULL if the store holds no item with the ID
+ */
+extern item *lsm_read_item(const char *dir, const sitem_id id);
+
+/**
+ * @brief Merge the log and every run into the newest entry of each item
+ * @param dir Directory holding the store
+ * @param buf Entry buffer to load entries into in order of ID, release with
+ * free_entry_buf
+ * @return Number of entries loaded into buf
+ * @return -1 on error, buf is left empty
+ */
+extern int lsm_load(const char *dir, struct entry_buf *buf);
+
+/**
+ * @brief Count the items held by the store
+ * @param dir Directory holding the store
+ * @return Number of items
+ * @return -1 on error
+ */
+extern int lsm_total_items(const char *dir);
+
+/**
+ * @brief Read all items of a single status, in order of ID
+ * @param dir Directory holding the store
+ * @param st Status of items to read
+ * @return NULL-terminated array of item pointers allocated on the heap
+ * @return NULL on error
+ */
+extern item **lsm_read_items_status(const char *dir, const enum status st);
+
+/**
+ * @brief Flush the log to a new run, merging every run into one if there are
+ * too many or if requested
+ * @param dir Directory holding the store
+ * @param merge_all Non-zero to merge every run into one regardless of count
+ * @param sync Function syncing runs and the manifest before they replace the
+ * entries they hold, NULL to not sync
+ * @return Number of shadowed and deletion entries discarded
+ * @return -1 on error, the store is unchanged
+ */
+extern int lsm_compact(const char *dir, const int merge_all,
+                       int (*sync)(const int fd));
+
+/**
+ * @brief Store of items in a log and sorted runs in the items directory
+ */
+extern const struct store_ops lsm_store;
+
+#ifdef TJUNITTEST
+extern int lsm_read_runs(const char *dir, sitem_id **seqs);
+extern int lsm_write_runs(const char *dir, const sitem_id *seqs,
+                          const int num_runs, int (*sync)(const int fd));
+extern int lsm_sort_log(const struct entry_buf *log, struct entry_buf *out);
+extern int lsm_merge(struct entry_buf *srcs, const int num_srcs,
+                     struct entry_buf *out);
+extern int lsm_write_run(const char *dir, const sitem_id seq,
+                         const struct entry_buf *run,
+                         int (*sync)(const int fd));
+extern void lsm_store_setup(const struct store_env *env);
+extern int lsm_store_create(void);
+extern void lsm_store_remove(void);
+extern int lsm_store_total_items(void);
+extern int lsm_store_item_status(const sitem_id id);
+extern item *lsm_store_read_item(const sitem_id id);
+extern item **lsm_store_read_items_status(const enum status st);
+extern int lsm_store_view_open(struct dir_item_view *view);
+extern int lsm_store_log_entry(const char entry[LSM_ENTRY_LEN]);
+extern int lsm_store_log_item(const item *itp);
+extern int lsm_store_append_item(const item *itp);
+extern int lsm_store_change_status(const sitem_id id, const enum status st);
+extern int lsm_store_remove_item(const sitem_id id);
+extern int lsm_store_compact(void);
+extern int lsm_store_write_items(item **items);
+#endif
+
+#endif
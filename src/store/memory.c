@@ -0,0 +1,287 @@
+#include "memory.h"
+#include "dev-utils/test-helpers.h"
+#ifdef DEBUG
+#include "dev-utils/debug-out.h"
+#endif
+
+static item **memory_items = NULL; /* Items indexed by ID, NULL if no item */
+static size_t memory_capacity = 0; /* Elements in memory_items */
+static int memory_count = 0;       /* Items held */
+
+static struct dependency_list *memory_deps = NULL;
+
+/**
+ * @brief Copy an item into a freshly allocated item
+ * @param itp Pointer to item to copy
+ * @return Pointer to new item
+ * @return NULL in case of error
+ */
+static_fn item *memory_copy_item(const item *itp) {
+    assert(itp);
+
+    item *copy = item_init();
+    if (!copy)
+        return NULL;
+
+    copy->item_id = itp->item_id;
+    copy->item_st = itp->item_st;
+    memcpy(copy->item_code, itp->item_code, ITEM_CODE_LEN);
+    item_set_name_deep(copy, itp->item_name, strlen(itp->item_name));
+
+    return copy;
+}
+
+/**
+ * @brief Grow the array of items so that it has an element for an ID
+ * @param id ID of item
+ * @return 0 on success
+ * @return -1 on error, the array is unchanged
+ */
+static_fn int memory_reserve(const sitem_id id) {
+    assert(id >= 0);
+
+    if ((size_t)id < memory_capacity)
+        return 0;
+
+    size_t capacity = memory_capacity ? memory_capacity : _MEMORY_INIT_CAPACITY;
+    while (capacity <= (size_t)id)
+        capacity *= 2;
+
+    item **items = realloc(memory_items, capacity * sizeof(*items));
+    if (!items)
+        return -1;
+
+    memset(items + memory_capacity, 0,
+           (capacity - memory_capacity) * sizeof(*items));
+    memory_items = items;
+    memory_capacity = capacity;
+    return 0;
+}
+
+/**
+ * @brief Nothing is stored in the project
+ */
+static_fn void memory_store_setup(const struct store_env *env) {
+    (void)env;
+}
+
+static_fn void memory_store_remove() {
+    for (size_t i = 0; i < memory_capacity; i++)
+        item_free(memory_items[i]);
+    free(memory_items);
+    memory_items = NULL;
+    memory_capacity = 0;
+    memory_count = 0;
+
+    if (memory_deps)
+        graph_free_dependency_list(&memory_deps);
+}
+
+static_fn int memory_store_create() {
+    memory_store_remove();
+    return 0;
+}
+
+static_fn int memory_store_total_items() {
+    return memory_count;
+}
+
+static_fn int memory_store_item_status(const sitem_id id) {
+    if (id < 0 || (size_t)id >= memory_capacity || !memory_items[id])
+        return -1;
+
+    return memory_items[id]->item_st;
+}
+
+static_fn item *memory_store_read_item(const sitem_id id) {
+    if (memory_store_item_status(id) < 0)
+        return NULL;
+
+    return memory_copy_item(memory_items[id]);
+}
+
+static_fn item **memory_store_read_items_status(const enum status st) {
+    item **items = (item **)malloc(sizeof(item *) * (memory_count + 1));
+    if (!items)
+        return NULL;
+
+    int num_items = 0;
+    for (size_t i = 0; i < memory_capacity; i++) {
+        if (!memory_items[i] || memory_items[i]->item_st != st)
+            continue;
+        items[num_items] = memory_copy_item(memory_items[i]);
+        if (items[num_items])
+            num_items++;
+    }
+    items[num_items] = NULL;
+
+    return items;
+}
+
+/**
+ * @brief Items are referenced in place, so nothing is loaded
+ */
+static_fn int memory_store_view_open(struct dir_item_view *view) {
+    (void)view;
+    return memory_count;
+}
+
+/**
+ * @brief Advance a view, where curr_off is the next ID to visit
+ */
+static_fn const struct dir_item_ref *
+memory_store_view_next(struct dir_item_view *view) {
+    while (view->curr_st < view->num_sts) {
+        if (view->curr_off >= memory_capacity) {
+            view->curr_st++;
+            view->curr_off = 0;
+            continue;
+        }
+
+        const item *itp = memory_items[view->curr_off++];
+        if (!itp || itp->item_st != view->sts[view->curr_st])
+            continue;
+
+        view->ref.id = itp->item_id;
+        view->ref.st = itp->item_st;
+        view->ref.code = itp->item_code;
+        view->ref.name = itp->item_name;
+        view->ref.name_len = (int)strlen(itp->item_name);
+        view->ref.loc = -1;
+        return &view->ref;
+    }
+
+    return NULL;
+}
+
+static_fn int memory_store_append_item(const item *itp) {
+    assert(itp);
+
+    if (itp->item_id < 0 || memory_store_item_status(itp->item_id) >= 0)
+        return -1;
+
+    /* Names are limited as they are by every other store */
+    if (strlen(itp->item_name) > ITEM_NAME_MAX)
+        return -1;
+
+    if (memory_reserve(itp->item_id) < 0)
+        return -1;
+
+    item *copy = memory_copy_item(itp);
+    if (!copy)
+        return -1;
+
+    memory_items[itp->item_id] = copy;
+    memory_count++;
+    return 0;
+}
+
+static_fn int memory_store_change_status(const sitem_id id,
+                                         const enum status st) {
+    const int old_st = memory_store_item_status(id);
+    if (old_st < 0 || (enum status)old_st == st)
+        return -1;
+
+    memory_items[id]->item_st = st;
+    return 0;
+}
+
+static_fn int memory_store_remove_item(const sitem_id id) {
+    if (memory_store_item_status(id) < 0)
+        return -1;
+
+    item_free(memory_items[id]);
+    memory_items[id] = NULL;
+    memory_count--;
+    return 0;
+}
+
+/**
+ * @brief Status changes and removals are made in place, leaving nothing
+ * behind
+ */
+static_fn int memory_store_compact() {
+    return 0;
+}
+
+static_fn int memory_store_write_items(item **items) {
+    for (size_t i = 0; items[i]; i++) {
+        if (memory_store_append_item(items[i]) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+static_fn struct dependency_list *memory_store_read_dependencies() {
+    const unsigned int count = memory_deps ? memory_deps->count : 0;
+
+    struct dependency_list *list = graph_init_dependency_list(count);
+    if (!list)
+        return NULL;
+
+    for (unsigned int i = 0; i < count; i++) {
+        const struct dependency *dep = memory_deps->dependencies[i];
+        struct dependency *copy =
+            graph_new_dependency(dep->from, dep->to, dep->is_ghost);
+        graph_new_dependency_to_list(list, &copy);
+    }
+
+    return list;
+}
+
+static_fn int memory_store_add_dependency(const struct dependency *dep) {
+    assert(dep);
+
+    if (!memory_deps)
+        memory_deps = graph_init_dependency_list(0);
+    if (!memory_deps)
+        return -1;
+
+    struct dependency *copy =
+        graph_new_dependency(dep->from, dep->to, dep->is_ghost);
+    return graph_new_dependency_to_list(memory_deps, &copy);
+}
+
+static_fn int memory_store_rm_dependency(const struct dependency *dep) {
+    assert(dep);
+
+    const unsigned int count = memory_deps ? memory_deps->count : 0;
+
+    for (unsigned int i = 0; i < count; i++) {
+        struct dependency *held = memory_deps->dependencies[i];
+        if (held->from != dep->from || held->to != dep->to)
+            continue;
+
+        /* Remaining dependencies keep their order */
+        free(held);
+        memmove(&memory_deps->dependencies[i],
+                &memory_deps->dependencies[i + 1],
+                (count - i - 1) * sizeof(*memory_deps->dependencies));
+        memory_deps->count--;
+        return 0;
+    }
+
+    return -1;
+}
+
+const struct store_ops memory_store = {
+    .setup = memory_store_setup,
+    .create = memory_store_create,
+    .remove = memory_store_remove,
+    .total_items = memory_store_total_items,
+    .item_status = memory_store_item_status,
+    .read_item = memory_store_read_item,
+    .read_items_status = memory_store_read_items_status,
+    .view_open = memory_store_view_open,
+    .view_next = memory_store_view_next,
+    .name_max = ITEM_NAME_MAX,
+    .append_item = memory_store_append_item,
+    .change_status = memory_store_change_status,
+    .remove_item = memory_store_remove_item,
+    .compact = memory_store_compact,
+    .write_items = memory_store_write_items,
+    .read_dependencies = memory_store_read_dependencies,
+    .add_dependency = memory_store_add_dependency,
+    .rm_dependency = memory_store_rm_dependency,
+};
@@ -0,0 +1,52 @@
+/**
+ * @brief In-memory store: the items and dependencies of a project are held in
+ * the memory of the running process alone, and are never read from or written
+ * to project files.
+ *
+ * Items are held in an array indexed by item ID, so every operation on a
+ * single item is a lookup. The store is emptied when it is created or
+ * removed, and its contents are lost at exit; it serves tests and benchmarks
+ * that measure dir without any file system access.
+ *
+ * Operations of the store are prefixed with memory_store_
+ * @note This should be considered only internally and not part of the dir
+ * interface
+ */
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include "ds/graph.h"
+#include "store/store.h"
+
+#define _MEMORY_INIT_CAPACITY 64 /* Items held before the array first grows */
+
+/**
+ * @brief Store of items in the memory of the running process
+ */
+extern const struct store_ops memory_store;
+
+#ifdef TJUNITTEST
+extern item *memory_copy_item(const item *itp);
+extern int memory_reserve(const sitem_id id);
+extern void memory_store_setup(const struct store_env *env);
+extern int memory_store_create(void);
+extern void memory_store_remove(void);
+extern int memory_store_total_items(void);
+extern int memory_store_item_status(const sitem_id id);
+extern item *memory_store_read_item(const sitem_id id);
+extern item **memory_store_read_items_status(const enum status st);
+extern int memory_store_view_open(struct dir_item_view *view);
+extern const struct dir_item_ref *
+memory_store_view_next(struct dir_item_view *view);
+extern int memory_store_append_item(const item *itp);
+extern int memory_store_change_status(const sitem_id id,
+                                      const enum status st);
+extern int memory_store_remove_item(const sitem_id id);
+extern int memory_store_compact(void);
+extern int memory_store_write_items(item **items);
+extern struct dependency_list *memory_store_read_dependencies(void);
+extern int memory_store_add_dependency(const struct dependency *dep);
+extern int memory_store_rm_dependency(const struct dependency *dep);
+#endif
+
+#endif
@@ -0,0 +1,183 @@
+#include "store.h"
+
+/* Whether fd_load_entries maps files, see store_map_entries */
+static int entries_mapped = 1;
+
+int fd_total_items(const int fd, int entry_len) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+
+    /* Use stat */
+    struct stat sb;
+    if (fstat(fd, &sb) < 0)
+        return -1;
+
+    return sb.st_size / entry_len;
+}
+
+int fd_load_entries(const int fd, const size_t entry_len,
+                    struct entry_buf *buf) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+    assert(buf);
+    assert(entry_len > 0);
+
+    buf->data = NULL;
+    buf->len = 0;
+    buf->is_mapped = 0;
+
+    struct stat sb;
+    if (fstat(fd, &sb) < 0)
+        return -1;
+
+    const size_t len = (sb.st_size / entry_len) * entry_len;
+    if (len == 0)
+        return 0;
+
+    /* Entries are always consumed front to back */
+    posix_fadvise(fd, 0, len, POSIX_FADV_SEQUENTIAL);
+
+    void *map = entries_mapped
+                    ? mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0)
+                    : MAP_FAILED;
+    if (map != MAP_FAILED) {
+        madvise(map, len, MADV_SEQUENTIAL);
+        buf->data = map;
+        buf->len = len;
+        buf->is_mapped = 1;
+        return len / entry_len;
+    }
+
+    /* Read the whole file into the heap if it is not mapped */
+    buf->data = malloc(len);
+    if (!buf->data)
+        return -1;
+
+    size_t bytes_read = 0;
+    while (bytes_read < len) {
+        ssize_t b = pread(fd, buf->data + bytes_read, len - bytes_read,
+                          bytes_read);
+        if (b < 0 && errno == EINTR)
+            continue;
+        if (b <= 0)
+            break;
+        bytes_read += b;
+    }
+
+    buf->len = bytes_read - (bytes_read % entry_len);
+    return buf->len / entry_len;
+}
+
+void store_map_entries(const int may_map) { entries_mapped = may_map; }
+
+void free_entry_buf(struct entry_buf *buf) {
+    if (!buf || !buf->data)
+        return;
+
+    if (buf->is_mapped)
+        munmap(buf->data, buf->len);
+    else
+        free(buf->data);
+
+    buf->data = NULL;
+    buf->len = 0;
+    buf->is_mapped = 0;
+}
+
+int pwrite_all(const int fd, const char *buf, size_t len, off_t off) {
+    while (len > 0) {
+        ssize_t b = pwrite(fd, buf, len, off);
+        if (b < 0 && errno == EINTR)
+            continue;
+        if (b <= 0)
+            return -1;
+        buf += b;
+        len -= b;
+        off += b;
+    }
+    return 0;
+}
+
+int replace_file(const char *path, const char *data, const size_t len,
+                 int (*sync)(const int fd)) {
+    char tmp_path[MAX_PATH];
+    snprintf(tmp_path, sizeof(tmp_path), "%.*s.tmp", MAX_PATH - 5, path);
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC,
+                  CONF_DIR_PERMS & 0666);
+    if (fd < 0)
+        return -1;
+
+    int ret = len > 0 ? pwrite_all(fd, data, len, 0) : 0;
+    if (ret == 0 && sync)
+        ret = sync(fd);
+    close(fd);
+    if (ret == 0)
+        ret = rename(tmp_path, path);
+
+    if (ret != 0)
+        unlink(tmp_path);
+    return ret;
+}
+
+sitem_id hex_field_to_id(const char id_field[HEX_LEN(sitem_id)]) {
+    uint32_t id = 0;
+
+    for (size_t i = 0; i < HEX_LEN(sitem_id); i++) {
+        const char c = id_field[i];
+        uint32_t digit;
+
+        if (c >= '0' && c <= '9')
+            digit = c - '0';
+        else if (c >= 'A' && c <= 'F')
+            digit = c - 'A' + 10;
+        else if (c >= 'a' && c <= 'f')
+            digit = c - 'a' + 10;
+        else
+            return -1;
+
+        id = (id << 4) | digit;
+    }
+
+    return (sitem_id)id;
+}
+
+int entry_name_len(const char *name) {
+    int name_len = ITEM_NAME_MAX;
+
+    for (int i = ITEM_NAME_MAX - 1; i > 0; i--) {
+        if (name[i] != ' ') { /* Filler character is ' ' will not be modified */
+            name_len = i + 1;
+            break;
+        }
+    }
+
+    return name_len;
+}
+
+
+const char *view_next_entry(struct dir_item_view *view,
+                            const size_t entry_len, const size_t first_off,
+                            const int per_status,
+                            int (*is_visible)(const struct dir_item_view *view,
+                                              const char *entry)) {
+    assert(view);
+    assert(is_visible);
+
+    /* Skip over hidden entries and exhausted buffers */
+    while (view->curr_st < view->num_sts) {
+        const struct entry_buf *buf =
+            &view->bufs[per_status ? view->curr_st : 0];
+        if (view->curr_off >= buf->len) {
+            view->curr_st++;
+            view->curr_off = first_off;
+            continue;
+        }
+
+        const char *entry = buf->data + view->curr_off;
+        view->curr_off += entry_len;
+
+        if (is_visible(view, entry))
+            return entry;
+    }
+
+    return NULL;
+}
@@ -0,0 +1,299 @@
+/**
+ * @brief Item store interface, and helpers shared by dir and the item stores
+ * it dispatches to
+ *
+ * Each item storage layout is a store: a table of operations on the items of
+ * a project (see struct store_ops), which dir calls through for every item it
+ * reads or writes.
+ *
+ * Every project file is made of fixed-width entries; these helpers load,
+ * parse and write such entries without knowing what they represent.
+ * @note Apart from the item references and views yielded by dir, this should
+ * be considered only internally and not part of the dir interface
+ */
+#ifndef STORE_H
+#define STORE_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "ds/item.h"
+
+struct dependency;
+struct dependency_list;
+struct store_ops;
+
+/**
+ * @brief Construct the path of a file in a directory of a store
+ */
+static inline void store_path(const char *dir, const char *base,
+                              char path[MAX_PATH]) {
+    snprintf(path, MAX_PATH, "%.*s/%s", MAX_PATH - 64, dir, base);
+}
+
+/**
+ * @brief Load a little-endian integer of len bytes
+ */
+static inline uint64_t load_le(const char *src, const int len) {
+    const unsigned char *bytes = (const unsigned char *)src;
+    uint64_t val = 0;
+    for (int i = len - 1; i >= 0; i--)
+        val = (val << 8) | bytes[i];
+    return val;
+}
+
+/**
+ * @brief Store an integer as len little-endian bytes
+ */
+static inline void store_le(char *dest, uint64_t val, const int len) {
+    for (int i = 0; i < len; i++) {
+        dest[i] = (char)(val & 0xFF);
+        val >>= 8;
+    }
+}
+
+/**
+ * @brief Whole contents of a file of fixed-width entries, loaded with a single
+ * mapping (or read) so that every entry can be parsed from the one buffer
+ * @see fd_load_entries
+ */
+struct entry_buf {
+    char *data;    /* First byte of the first entry */
+    size_t len;    /* Bytes in data, always a multiple of the entry length */
+    int is_mapped; /* Non-zero if data is mapped rather than heap-allocated */
+};
+
+/**
+ * @brief Read-only reference to the fields of a single stored item entry
+ * @note code and name point directly into the entry data of a dir_item_view
+ * and are only valid until the view is closed
+ */
+struct dir_item_ref {
+    sitem_id id;      /* Item ID */
+    enum status st;   /* Status of the item (the file the entry is in) */
+    const char *code; /* ITEM_CODE_LEN characters, not null-terminated */
+    const char *name; /* name_len characters, not null-terminated */
+    int name_len;     /* Length of name without filler characters */
+    off_t loc;        /* Offset of entry in entries of its status, or -1 */
+};
+
+/**
+ * @brief Read-only view over the items of one or more statuses, where each
+ * item file (or the item table) is mapped once and entries are referenced in
+ * place
+ * @see dir_view_open
+ */
+struct dir_item_view {
+    struct entry_buf bufs[ITEM_STATUS_COUNT]; /* Entries loaded by the store */
+    enum status sts[ITEM_STATUS_COUNT];       /* Viewed statuses in order */
+    int num_sts;                              /* Number of viewed statuses */
+    const struct store_ops *store; /* Store the view was opened on */
+    int curr_st;             /* Index into sts of the status being iterated */
+    size_t curr_off;         /* Offset of next entry in current buffer */
+    struct dir_item_ref ref; /* Reference yielded by dir_view_next */
+};
+
+/**
+ * @brief Project state a store needs, filled in by dir
+ */
+struct store_env {
+    const char *proj_dir;  /* Project directory */
+    const char *items_dir; /* Items directory, holding the files of stores */
+
+    /*
+     * Make data written to a file durable in the durability mode of the
+     * project, path must remain valid until exit
+     */
+    int (*sync_written)(const int fd, const char *path);
+
+    /* Make a complete replacement file durable before it is renamed */
+    int (*sync_replacement)(const int fd);
+};
+
+/**
+ * @brief Operations on the items of a project stored by one store
+ *
+ * Operations returning int return -1 on error unless noted otherwise, and
+ * items are returned heap-allocated, as by the dir_* function of the same
+ * name.
+ */
+struct store_ops {
+    /* Set up the paths of the files of the store, before any other call */
+    void (*setup)(const struct store_env *env);
+
+    /* Create the empty store, discarding any items it already holds */
+    int (*create)(void);
+
+    /* Remove every file of the store, errors are not handled */
+    void (*remove)(void);
+
+    int (*total_items)(void);
+
+    /* Status of the item with an ID, -1 if the store holds no such item */
+    int (*item_status)(const sitem_id id);
+
+    item *(*read_item)(const sitem_id id);
+
+    /*
+     * Location of an item seen in a view, used to find the item next if it is
+     * still there, NULL if views yield no locations
+     */
+    void (*hint_location)(const sitem_id id, const enum status st,
+                          const off_t loc);
+
+    /* NULL-terminated array of the items of a status, in order of ID */
+    item **(*read_items_status)(const enum status st);
+
+    /*
+     * Load the entries of an item view, whose statuses are already set, and
+     * return the number of entries loaded
+     */
+    int (*view_open)(struct dir_item_view *view);
+
+    const struct dir_item_ref *(*view_next)(struct dir_item_view *view);
+
+    /* Longest name the store can hold, 0 if names are not limited */
+    int name_max;
+
+    /* Fails if the store already holds an item with the ID */
+    int (*append_item)(const item *itp);
+
+    /* Fails if the item does not exist or already has the status */
+    int (*change_status)(const sitem_id id, const enum status st);
+
+    /* Fails if the item does not exist, as items moved to the archive */
+    int (*remove_item)(const sitem_id id);
+
+    /* Number of entries left behind by status changes that are removed */
+    int (*compact)(void);
+
+    /*
+     * Write items, sorted by ID within each status, to the empty store and
+     * sync each written file once
+     */
+    int (*write_items)(item **items);
+
+    /*
+     * Dependencies between items, NULL to keep dependencies in the
+     * dependency file of the project
+     */
+    struct dependency_list *(*read_dependencies)(void);
+    int (*add_dependency)(const struct dependency *dep);
+    int (*rm_dependency)(const struct dependency *dep);
+};
+
+/**
+ * @brief Get the total number of entries found in the file descriptor
+ * @param fd File descriptor of entries (of any data)
+ * @param entry_len Length of each entry in the file
+ * @return Number of entries expected in fd
+ * @return -1 on error
+ * @note File contents are not read and thus, no entries can be verified
+ */
+extern int fd_total_items(const int fd, int entry_len);
+
+/**
+ * @brief Load every entry in the file opened by fd into buf with one mapping of
+ * the file, or a single read if the file cannot be mapped
+ * @param fd File descriptor of entries (of any data) opened for reading
+ * @param entry_len Length of each entry in the file
+ * @param buf Entry buffer to load entries into, release with free_entry_buf
+ * @return Number of entries loaded into buf
+ * @return -1 on error, buf is left empty
+ * @note Trailing bytes of a partially written entry are not loaded
+ * @note buf remains valid after fd is closed
+ * @see store_map_entries
+ */
+extern int fd_load_entries(const int fd, const size_t entry_len,
+                           struct entry_buf *buf);
+
+/**
+ * @brief Choose whether fd_load_entries may map files, or must always read
+ * them into the heap
+ * @param may_map Non-zero to map files, as is done by default
+ * @note Files read while another process may truncate them must not be
+ * mapped, as reading a mapped page past the end of a truncated file raises
+ * SIGBUS
+ */
+extern void store_map_entries(const int may_map);
+
+/**
+ * @brief Release the resources held by an entry buffer loaded by
+ * fd_load_entries
+ * @param buf Entry buffer, left empty after calling
+ */
+extern void free_entry_buf(struct entry_buf *buf);
+
+/**
+ * @brief Write all len bytes of buf at offset off of fd
+ * @return 0 on success
+ * @return -1 on error
+ */
+extern int pwrite_all(const int fd, const char *buf, size_t len, off_t off);
+
+/**
+ * @brief Replace a file with data atomically, by writing a temporary file
+ * that is renamed over it
+ * @param path Path of file to replace
+ * @param data Data to write, may be NULL if len is 0
+ * @param len Bytes in data
+ * @param sync Function syncing the data before it replaces the file, NULL
+ * to not sync
+ * @return 0 on success
+ * @return -1 on error, the file is unchanged
+ */
+extern int replace_file(const char *path, const char *data, const size_t len,
+                        int (*sync)(const int fd));
+
+/**
+ * @brief Parse the fixed-width hexadecimal ID field found at the start of
+ * entries
+ * @param id_field HEX_LEN(sitem_id) hex digits (need not be null-terminated)
+ * @return Parsed ID
+ * @return -1 if the field contains any non-hex characters
+ */
+extern sitem_id hex_field_to_id(const char id_field[HEX_LEN(sitem_id)]);
+
+/**
+ * @brief Find the true length of a name field padded to ITEM_NAME_MAX
+ * characters, without filling spaces
+ * @param name Start of name field in entry (ITEM_NAME_MAX characters)
+ * @return Length of name
+ */
+extern int entry_name_len(const char *name);
+
+/**
+ * @brief Advance an item view to its next visible entry, moving on to the
+ * next viewed status once the entries of a buffer are exhausted
+ * @param view View whose buffers hold fixed-width entries
+ * @param entry_len Length of each entry in the buffers
+ * @param first_off Offset of the first entry in each buffer
+ * @param per_status Non-zero if each viewed status has its own buffer, in the
+ * order of view->sts, rather than every status sharing bufs[0]
+ * @param is_visible Check whether an entry holds an item of the status being
+ * iterated (view->sts[view->curr_st])
+ * @return Next visible entry
+ * @return NULL once all entries in the view have been visited
+ */
+extern const char *view_next_entry(struct dir_item_view *view,
+                                   const size_t entry_len,
+                                   const size_t first_off,
+                                   const int per_status,
+                                   int (*is_visible)(
+                                       const struct dir_item_view *view,
+                                       const char *entry));
+
+#endif
@@ -0,0 +1,387 @@
+#include "table.h"
+#include "dev-utils/test-helpers.h"
+#ifdef DEBUG
+#include "dev-utils/debug-out.h"
+#endif
+
+/**
+ * @brief Get the offset of the record of an item with a given ID
+ */
+static inline off_t table_entry_off(const sitem_id id) {
+    return (off_t)id * TABLE_ENTRY_LEN;
+}
+
+/**
+ * @brief Convert a status column value to a status
+ * @return Status, or -1 if the value is not a status (the record is a hole)
+ */
+static inline int table_char_to_status(const char st_char) {
+    /* Holes read as '\0', which strchr would match as the terminator */
+    if (st_char == '\0')
+        return -1;
+
+    const char *st = strchr(_TABLE_ST_CHARS, st_char);
+    return st ? (int)(st - _TABLE_ST_CHARS) : -1;
+}
+
+int table_entry_status(const char *entry) {
+    assert(entry);
+    return table_char_to_status(entry[TABLE_ST_POS]);
+}
+
+void table_entry_set_status(char *entry, const enum status st) {
+    assert(entry);
+    assert(st < ITEM_STATUS_COUNT);
+    entry[TABLE_ST_POS] = _TABLE_ST_CHARS[st];
+}
+
+item *table_entry_to_item(const char *entry) {
+    assert(entry);
+
+    const int st = table_entry_status(entry);
+    if (st < 0)
+        return NULL;
+
+    item *itp = item_init();
+    if (!itp)
+        return NULL;
+
+    itp->item_id = hex_field_to_id(entry);
+    itp->item_st = (enum status)st;
+    memcpy(itp->item_code, entry + TABLE_CODE_POS, ITEM_CODE_LEN);
+
+    const char *name = entry + TABLE_NAME_POS;
+    item_set_name_deep(itp, name, entry_name_len(name));
+
+    return itp;
+}
+
+int table_make_entry(const item *const itp, char buf[TABLE_ENTRY_LEN + 1]) {
+    assert(itp);
+    assert(itp->item_st < ITEM_STATUS_COUNT);
+
+    const int b = snprintf(buf, TABLE_ENTRY_LEN + 1, "%0*X%s%c%s%.*s%s%-*s%s",
+                           (int)HEX_LEN(sitem_id), itp->item_id,
+                           _TABLE_FIELD_DELIM, _TABLE_ST_CHARS[itp->item_st],
+                           _TABLE_FIELD_DELIM, ITEM_CODE_LEN, itp->item_code,
+                           _TABLE_FIELD_DELIM, ITEM_NAME_MAX, itp->item_name,
+                           _TABLE_ENTRY_DELIM);
+
+    if (b != TABLE_ENTRY_LEN) {
+#ifdef DEBUG
+        log_err("table_make_entry could not parse item data correctly");
+#endif
+        return -1;
+    }
+
+    return 0;
+}
+
+int table_read_status(const int fd, const sitem_id id) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+
+    if (id < 0)
+        return -1;
+
+    char st_char = '\0';
+    if (pread(fd, &st_char, 1, table_entry_off(id) + TABLE_ST_POS) != 1)
+        return -1;
+
+    return table_char_to_status(st_char);
+}
+
+item *table_read_item(const int fd, const sitem_id id) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+
+    if (id < 0)
+        return NULL;
+
+    char entry[TABLE_ENTRY_LEN];
+    if (pread(fd, entry, TABLE_ENTRY_LEN, table_entry_off(id)) !=
+        TABLE_ENTRY_LEN)
+        return NULL;
+
+    return table_entry_to_item(entry);
+}
+
+int table_write_item(const int fd, const item *itp) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+    assert(itp);
+
+    if (itp->item_id < 0)
+        return -1;
+
+    char entry[TABLE_ENTRY_LEN + 1];
+    if (table_make_entry(itp, entry) < 0)
+        return -1;
+
+    return pwrite_all(fd, entry, TABLE_ENTRY_LEN,
+                      table_entry_off(itp->item_id));
+}
+
+int table_write_status(const int fd, const sitem_id id, const enum status st) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+    assert(st < ITEM_STATUS_COUNT);
+
+    if (id < 0)
+        return -1;
+
+    return pwrite_all(fd, &_TABLE_ST_CHARS[st], 1,
+                      table_entry_off(id) + TABLE_ST_POS);
+}
+
+int table_clear_item(const int fd, const sitem_id id) {
+    assert(fcntl(fd, F_GETFD) != -1); /* File descriptor is valid */
+
+    if (id < 0)
+        return -1;
+
+    const char hole[TABLE_ENTRY_LEN] = {'\0'};
+    return pwrite_all(fd, hole, TABLE_ENTRY_LEN, table_entry_off(id));
+}
+
+int table_total_items(const int fd) {
+    struct entry_buf buf;
+    const int total_entries = fd_load_entries(fd, TABLE_ENTRY_LEN, &buf);
+    if (total_entries < 0)
+        return -1;
+
+    int num_items = 0;
+    for (int i = 0; i < total_entries; i++) {
+        if (table_entry_status(buf.data + (size_t)i * TABLE_ENTRY_LEN) >= 0)
+            num_items++;
+    }
+
+    free_entry_buf(&buf);
+    return num_items;
+}
+
+item **table_read_items_status(const int fd, const enum status st) {
+    assert(st < ITEM_STATUS_COUNT);
+
+    struct entry_buf buf;
+    const int total_entries = fd_load_entries(fd, TABLE_ENTRY_LEN, &buf);
+    if (total_entries < 0)
+        return NULL;
+
+    item **items = (item **)malloc(sizeof(item *) * (total_entries + 1));
+    if (!items) {
+        free_entry_buf(&buf);
+        return NULL;
+    }
+
+    int num_items = 0;
+    for (int i = 0; i < total_entries; i++) {
+        const char *entry = buf.data + (size_t)i * TABLE_ENTRY_LEN;
+        if (table_entry_status(entry) != (int)st)
+            continue;
+        items[num_items] = table_entry_to_item(entry);
+        if (items[num_items])
+            num_items++;
+    }
+    items[num_items] = NULL;
+
+    free_entry_buf(&buf);
+    return items;
+}
+
+/**
+ * @brief Check whether a table record holds an item of the status being
+ * iterated by a view
+ */
+static_fn int table_entry_is_visible(const struct dir_item_view *view,
+                                     const char *entry) {
+    return table_entry_status(entry) == (int)view->sts[view->curr_st];
+}
+
+const struct dir_item_ref *table_view_next(struct dir_item_view *view) {
+    assert(view);
+
+    /* Each status is a filtered pass over the one buffer of records */
+    const char *entry = view_next_entry(view, TABLE_ENTRY_LEN, 0, 0,
+                                        table_entry_is_visible);
+    if (!entry)
+        return NULL;
+
+    /* Fields are referenced in place */
+    view->ref.id = hex_field_to_id(entry);
+    view->ref.st = view->sts[view->curr_st];
+    view->ref.code = entry + TABLE_CODE_POS;
+    view->ref.name = entry + TABLE_NAME_POS;
+    view->ref.name_len = entry_name_len(entry + TABLE_NAME_POS);
+    view->ref.loc = -1;
+
+    return &view->ref;
+}
+
+/* Store */
+
+static const struct store_env *table_env = NULL;
+static char table_path[MAX_PATH] = {'\0'};
+
+static_fn void table_store_setup(const struct store_env *env) {
+    assert(env);
+
+    table_env = env;
+    if (!*table_path)
+        store_path(env->items_dir, _TABLE_F, table_path);
+}
+
+/**
+ * @brief Open the item table using flags
+ * @return open file descriptor
+ * @return -1 on error
+ */
+static_fn int table_store_open(int flags) {
+    return open(table_path, flags);
+}
+
+static_fn int table_store_create() {
+    int fd = open(table_path, O_WRONLY | O_CREAT | O_TRUNC,
+                  CONF_DIR_PERMS & 0666);
+    if (fd < 0)
+        return -1;
+    close(fd);
+    return 0;
+}
+
+static_fn void table_store_remove() {
+    unlink(table_path);
+}
+
+static_fn int table_store_total_items() {
+    int fd = table_store_open(O_RDONLY);
+    if (fd < 0)
+        return -1;
+    const int num_items = table_total_items(fd);
+    close(fd);
+    return num_items;
+}
+
+static_fn int table_store_item_status(const sitem_id id) {
+    int fd = table_store_open(O_RDONLY);
+    if (fd < 0)
+        return -1;
+    const int st = table_read_status(fd, id);
+    close(fd);
+    return st;
+}
+
+static_fn item *table_store_read_item(const sitem_id id) {
+    int fd = table_store_open(O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    item *itp = table_read_item(fd, id);
+    close(fd);
+    return itp;
+}
+
+static_fn item **table_store_read_items_status(const enum status st) {
+    int fd = table_store_open(O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    item **items = table_read_items_status(fd, st);
+    close(fd);
+    return items;
+}
+
+static_fn int table_store_view_open(struct dir_item_view *view) {
+    int fd = table_store_open(O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    const int num_entries = fd_load_entries(fd, TABLE_ENTRY_LEN,
+                                            &view->bufs[0]);
+    close(fd);
+    return num_entries;
+}
+
+static_fn int table_store_append_item(const item *itp) {
+    int fd = table_store_open(O_RDWR);
+    if (fd < 0)
+        return -1;
+
+    /* The table holds at most one record for any ID */
+    int ret = -1;
+    if (table_read_status(fd, itp->item_id) < 0)
+        ret = table_write_item(fd, itp);
+
+    if (ret == 0)
+        ret = table_env->sync_written(fd, table_path);
+    close(fd);
+    return ret;
+}
+
+static_fn int table_store_change_status(const sitem_id id,
+                                        const enum status st) {
+    int fd = table_store_open(O_RDWR);
+    if (fd < 0)
+        return -1;
+
+    /* Only the status column of the record is rewritten */
+    const int old_st = table_read_status(fd, id);
+    int ret = -1;
+    if (old_st >= 0 && (enum status)old_st != st)
+        ret = table_write_status(fd, id, st);
+
+    if (ret == 0)
+        ret = table_env->sync_written(fd, table_path);
+    close(fd);
+    return ret;
+}
+
+static_fn int table_store_remove_item(const sitem_id id) {
+    int fd = table_store_open(O_RDWR);
+    if (fd < 0)
+        return -1;
+
+    int ret = -1;
+    if (table_read_status(fd, id) >= 0)
+        ret = table_clear_item(fd, id);
+
+    if (ret == 0)
+        ret = table_env->sync_written(fd, table_path);
+    close(fd);
+    return ret;
+}
+
+/**
+ * @brief Status changes and removals are made in place, leaving nothing
+ * behind in records
+ */
+static_fn int table_store_compact() {
+    return 0;
+}
+
+static_fn int table_store_write_items(item **items) {
+    int fd = table_store_open(O_WRONLY);
+    if (fd < 0)
+        return -1;
+
+    int ret = 0;
+    for (size_t i = 0; items[i] && ret == 0; i++)
+        ret = table_write_item(fd, items[i]);
+
+    if (ret == 0)
+        ret = table_env->sync_replacement(fd);
+    close(fd);
+    return ret;
+}
+
+const struct store_ops table_store = {
+    .setup = table_store_setup,
+    .create = table_store_create,
+    .remove = table_store_remove,
+    .total_items = table_store_total_items,
+    .item_status = table_store_item_status,
+    .read_item = table_store_read_item,
+    .read_items_status = table_store_read_items_status,
+    .view_open = table_store_view_open,
+    .view_next = table_view_next,
+    .name_max = ITEM_NAME_MAX,
+    .append_item = table_store_append_item,
+    .change_status = table_store_change_status,
+    .remove_item = table_store_remove_item,
+    .compact = table_store_compact,
+    .write_items = table_store_write_items,
+};
@@ -0,0 +1,173 @@
+/**
+ * @brief Item table layout: every item of a project is stored in one file of
+ * fixed-width records indexed by item ID, with the status of each item kept
+ * in a one byte column of its record.
+ *
+ * The record of an item with ID id is found at id * TABLE_ENTRY_LEN, so an
+ * item is read, written or moved to a new status with a single pread or
+ * pwrite. Records of IDs that were never written are holes (zero bytes) and
+ * hold no item.
+ *
+ * Records are also the entries of the log-structured and B+tree layouts, whose
+ * views are iterated by table_view_next.
+ *
+ * Functions are prefixed with table_
+ * @note This should be considered only internally and not part of the dir
+ * interface
+ */
+#ifndef TABLE_H
+#define TABLE_H
+
+#include "store/store.h"
+
+#define _TABLE_F "table" /* Item table in items directory */
+
+#define _TABLE_FIELD_DELIM ":"
+#define _TABLE_FIELD_DELIM_LEN (sizeof(_TABLE_FIELD_DELIM) - 1)
+#define _TABLE_ENTRY_DELIM "\n"
+#define _TABLE_ENTRY_DELIM_LEN (sizeof(_TABLE_ENTRY_DELIM) - 1)
+
+/* Status column value of each status, indexed by enum status */
+#define _TABLE_ST_CHARS "btid"
+
+/* Field positions in a record */
+#define TABLE_ST_POS (HEX_LEN(sitem_id) + _TABLE_FIELD_DELIM_LEN)
+#define TABLE_CODE_POS (TABLE_ST_POS + 1 + _TABLE_FIELD_DELIM_LEN)
+#define TABLE_NAME_POS (TABLE_CODE_POS + ITEM_CODE_LEN + _TABLE_FIELD_DELIM_LEN)
+
+/* Item record format, ID:S:CODE:NAME */
+#define TABLE_ENTRY_LEN                                                        \
+    (TABLE_NAME_POS + ITEM_NAME_MAX + _TABLE_ENTRY_DELIM_LEN)
+
+/**
+ * @brief Get the status held in the status column of a table record
+ * @param entry Table record of TABLE_ENTRY_LEN bytes
+ * @return Status of the item in the record
+ * @return -1 if the record holds no item
+ */
+extern int table_entry_status(const char *entry);
+
+/**
+ * @brief Set the status held in the status column of a table record
+ * @param entry Table record holding an item
+ * @param st New status
+ */
+extern void table_entry_set_status(char *entry, const enum status st);
+
+/**
+ * @brief Read a table record into a freshly allocated item, including its
+ * status
+ * @param entry Table record holding an item
+ * @return Pointer to new item
+ * @return NULL in case of error
+ */
+extern item *table_entry_to_item(const char *entry);
+
+/**
+ * @brief Write the table record of an item to buf
+ * @param itp Pointer to item to parse data of
+ * @param buf Buffer to place data, null-terminated at the last position
+ * @return 0 on success
+ * @return -1 if the item cannot be represented by a record
+ */
+extern int table_make_entry(const item *const itp,
+                            char buf[TABLE_ENTRY_LEN + 1]);
+
+/**
+ * @brief Get the status of the item with a given ID
+ * @param fd File descriptor of item table opened for reading
+ * @param id ID of item
+ * @return Status of item
+ * @return -1 if the table holds no item with the ID
+ */
+extern int table_read_status(const int fd, const sitem_id id);
+
+/**
+ * @brief Read the item with a given ID
+ * @param fd File descriptor of item table opened for reading
+ * @param id ID of item
+ * @return Heap-allocated item
+ * @return NULL if the table holds no item with the ID
+ */
+extern item *table_read_item(const int fd, const sitem_id id);
+
+/**
+ * @brief Write the record of an item, replacing any record with its ID
+ * @param fd File descriptor of item table opened for writing
+ * @param itp Pointer to item to write
+ * @return 0 on success
+ * @return -1 on error
+ */
+extern int table_write_item(const int fd, const item *itp);
+
+/**
+ * @brief Overwrite the status column of the record of an item
+ * @param fd File descriptor of item table opened for writing
+ * @param id ID of item, which must be held by the table
+ * @param st New status
+ * @return 0 on success
+ * @return -1 on error
+ */
+extern int table_write_status(const int fd, const sitem_id id,
+                              const enum status st);
+
+/**
+ * @brief Clear the record of an item, leaving a hole that holds no item
+ * @param fd File descriptor of item table opened for writing
+ * @param id ID of item
+ * @return 0 on success
+ * @return -1 on error
+ */
+extern int table_clear_item(const int fd, const sitem_id id);
+
+/**
+ * @brief Count the items held by the table
+ * @param fd File descriptor of item table opened for reading
+ * @return Number of items
+ * @return -1 on error
+ */
+extern int table_total_items(const int fd);
+
+/**
+ * @brief Read all items of a single status, in order of ID
+ * @param fd File descriptor of item table opened for reading
+ * @param st Status of items to read
+ * @return NULL-terminated array of item pointers allocated on the heap
+ * @return NULL on error
+ */
+extern item **table_read_items_status(const int fd, const enum status st);
+
+/**
+ * @brief Advance an item view over table records, all loaded into bufs[0] in
+ * order of ID, to its next item
+ * @param view View opened on a store of table records
+ * @return Pointer to reference of the next item, overwritten by the next call
+ * @return NULL once all items in the view have been visited
+ */
+extern const struct dir_item_ref *table_view_next(struct dir_item_view *view);
+
+/**
+ * @brief Store of items in the item table of the items directory
+ */
+extern const struct store_ops table_store;
+
+#ifdef TJUNITTEST
+extern int table_entry_is_visible(const struct dir_item_view *view,
+                                  const char *entry);
+extern void table_store_setup(const struct store_env *env);
+extern int table_store_open(int flags);
+extern int table_store_create(void);
+extern void table_store_remove(void);
+extern int table_store_total_items(void);
+extern int table_store_item_status(const sitem_id id);
+extern item *table_store_read_item(const sitem_id id);
+extern item **table_store_read_items_status(const enum status st);
+extern int table_store_view_open(struct dir_item_view *view);
+extern int table_store_append_item(const item *itp);
+extern int table_store_change_status(const sitem_id id, const enum status st);
+extern int table_store_remove_item(const sitem_id id);
+extern int table_store_compact(void);
+extern int table_store_write_items(item **items);
+#endif
+
+#endif
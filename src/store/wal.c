@@ -0,0 +1,257 @@
+#include "wal.h"
+#include "dev-utils/test-helpers.h"
+#ifdef DEBUG
+#include "dev-utils/debug-out.h"
+#endif
+
+/**
+ * @brief Grow the records of a transaction to fit len more bytes
+ * @return 0 on success
+ * @return -1 on error, txn is unchanged
+ */
+static_fn int wal_reserve(struct wal_txn *txn, const size_t len) {
+    if (txn->len + len <= txn->cap)
+        return 0;
+
+    size_t cap = txn->cap ? txn->cap : 256;
+    while (cap < txn->len + len)
+        cap *= 2;
+
+    char *data = realloc(txn->data, cap);
+    if (!data)
+        return -1;
+
+    txn->data = data;
+    txn->cap = cap;
+    return 0;
+}
+
+/**
+ * @brief Checksum of the records of a transaction, 32-bit FNV-1a
+ */
+static_fn uint32_t wal_checksum(const char *data, const size_t len) {
+    uint32_t sum = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        sum ^= (unsigned char)data[i];
+        sum *= 16777619u;
+    }
+    return sum;
+}
+
+/**
+ * @brief Parse the item record at the start of data
+ * @param data Records
+ * @param len Bytes in data
+ * @param rec Set to the fields of the record
+ * @return Length of the record
+ * @return -1 if data does not start with a complete item record
+ */
+static_fn ssize_t wal_parse_item(const char *data, const size_t len,
+                                 struct wal_record *rec) {
+    if (len < WAL_NAME_POS || data[WAL_OP_POS] != _WAL_OP_ITEM)
+        return -1;
+
+    const uint64_t name_len = load_le(data + WAL_NAME_LEN_POS, 4);
+    const uint64_t st = load_le(data + WAL_ST_POS, 1);
+    if (name_len > len - WAL_NAME_POS || st >= ITEM_STATUS_COUNT)
+        return -1;
+
+    rec->id = (sitem_id)load_le(data + WAL_ID_POS, 4);
+    rec->st = (enum status)st;
+    rec->code = data + WAL_CODE_POS;
+    rec->name = data + WAL_NAME_POS;
+    rec->name_len = (int)name_len;
+    return (ssize_t)(WAL_NAME_POS + name_len);
+}
+
+int wal_log_item(struct wal_txn *txn, const item *itp) {
+    assert(txn);
+    assert(itp);
+    assert(itp->item_st < ITEM_STATUS_COUNT);
+
+    const size_t name_len = strlen(itp->item_name);
+    if (itp->item_id < 0 || name_len > UINT32_MAX ||
+        wal_reserve(txn, WAL_NAME_POS + name_len) < 0)
+        return -1;
+
+    char *rec = txn->data + txn->len;
+    rec[WAL_OP_POS] = _WAL_OP_ITEM;
+    store_le(rec + WAL_ID_POS, (uint64_t)itp->item_id, 4);
+    store_le(rec + WAL_ST_POS, (uint64_t)itp->item_st, 1);
+    memcpy(rec + WAL_CODE_POS, itp->item_code, ITEM_CODE_LEN);
+    store_le(rec + WAL_NAME_LEN_POS, name_len, 4);
+    memcpy(rec + WAL_NAME_POS, itp->item_name, name_len);
+
+    txn->len += WAL_NAME_POS + name_len;
+    txn->num_records++;
+    return 0;
+}
+
+int wal_find_item(const struct wal_txn *txn, const sitem_id id,
+                  struct wal_record *rec) {
+    assert(txn);
+    assert(rec);
+
+    /* Transactions are those of single commands, so are scanned in full */
+    int found = -1;
+    struct wal_record curr;
+    ssize_t rec_len;
+    for (size_t off = 0;
+         (rec_len = wal_parse_item(txn->data + off, txn->len - off, &curr)) >
+         0;
+         off += (size_t)rec_len) {
+        if (curr.id == id) {
+            *rec = curr;
+            found = 0;
+        }
+    }
+    return found;
+}
+
+item *wal_record_to_item(const struct wal_record *rec) {
+    assert(rec);
+
+    item *itp = item_init();
+    if (!itp)
+        return NULL;
+
+    itp->item_id = rec->id;
+    itp->item_st = rec->st;
+    memcpy(itp->item_code, rec->code, ITEM_CODE_LEN);
+    item_set_name_deep(itp, rec->name, rec->name_len);
+    return itp;
+}
+
+int wal_commit(const char *path, struct wal_txn *txn,
+               int (*sync)(const int fd)) {
+    assert(path);
+    assert(txn);
+    assert(txn->num_records > 0);
+
+    if (wal_reserve(txn, WAL_COMMIT_LEN) < 0)
+        return -1;
+
+    char *commit = txn->data + txn->len;
+    commit[WAL_OP_POS] = _WAL_OP_COMMIT;
+    store_le(commit + WAL_COMMIT_RECORDS_POS, (uint64_t)txn->num_records, 4);
+    store_le(commit + WAL_COMMIT_SUM_POS, wal_checksum(txn->data, txn->len),
+             4);
+
+    /* Anything left by a failed commit or recovery is redone first */
+    const int fd = open(path, O_WRONLY | O_CREAT | O_APPEND,
+                        CONF_DIR_PERMS & 0666);
+    if (fd < 0)
+        return -1;
+
+    const ssize_t written = write(fd, txn->data, txn->len + WAL_COMMIT_LEN);
+    int ret = written == (ssize_t)(txn->len + WAL_COMMIT_LEN) ? 0 : -1;
+    if (ret == 0 && sync)
+        ret = sync(fd);
+    close(fd);
+
+    if (ret != 0) {
+#ifdef DEBUG
+        log_err("Transaction could not be written to the log");
+#endif
+        return -1;
+    }
+
+    txn->len += WAL_COMMIT_LEN;
+    return 0;
+}
+
+/**
+ * @brief Redo every complete transaction in a sequence of transactions,
+ * stopping at the first transaction without a valid commit record
+ * @param data Transactions
+ * @param len Bytes in data
+ * @param redo Function making the store hold a record's item
+ * @return Number of records redone
+ * @return -1 if any record could not be redone
+ */
+static_fn int wal_redo(const char *data, const size_t len,
+                       int (*redo)(const struct wal_record *rec)) {
+    int num_redone = 0, failed = 0;
+    size_t txn_off = 0;
+
+    while (txn_off < len) {
+        /* Find the commit record of the transaction */
+        struct wal_record rec;
+        size_t off = txn_off;
+        uint32_t num_records = 0;
+        for (ssize_t rec_len;
+             (rec_len = wal_parse_item(data + off, len - off, &rec)) > 0;
+             off += (size_t)rec_len)
+            num_records++;
+
+        if (len - off < WAL_COMMIT_LEN ||
+            data[off + WAL_OP_POS] != _WAL_OP_COMMIT ||
+            load_le(data + off + WAL_COMMIT_RECORDS_POS, 4) != num_records ||
+            load_le(data + off + WAL_COMMIT_SUM_POS, 4) !=
+                wal_checksum(data + txn_off, off - txn_off))
+            break; /* Torn write of a transaction that was never applied */
+
+        for (ssize_t rec_len;
+             (rec_len = wal_parse_item(data + txn_off, off - txn_off, &rec)) >
+             0;
+             txn_off += (size_t)rec_len) {
+            if (redo(&rec) == 0)
+                num_redone++;
+            else
+                failed = 1;
+        }
+        txn_off = off + WAL_COMMIT_LEN;
+    }
+
+    if (failed) {
+#ifdef DEBUG
+        log_err("Logged item changes could not all be redone");
+#endif
+        return -1;
+    }
+
+    return num_redone;
+}
+
+int wal_apply(const struct wal_txn *txn,
+              int (*redo)(const struct wal_record *rec)) {
+    assert(txn);
+    assert(redo);
+
+    return wal_redo(txn->data, txn->len, redo);
+}
+
+int wal_recover(const char *path, int (*redo)(const struct wal_record *rec)) {
+    assert(path);
+    assert(redo);
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return errno == ENOENT ? 0 : -1;
+
+    struct entry_buf buf = {NULL, 0, 0};
+    const int len = fd_load_entries(fd, 1, &buf);
+    close(fd);
+    if (len <= 0)
+        return len;
+
+    const int ret = wal_redo(buf.data, buf.len, redo);
+    free_entry_buf(&buf);
+    return ret;
+}
+
+int wal_clear(const char *path) {
+    assert(path);
+
+    if (truncate(path, 0) < 0 && errno != ENOENT)
+        return -1;
+    return 0;
+}
+
+void wal_free_txn(struct wal_txn *txn) {
+    if (!txn)
+        return;
+
+    free(txn->data);
+    memset(txn, 0, sizeof(*txn));
+}
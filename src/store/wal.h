@@ -0,0 +1,152 @@
+/**
+ * @brief Write-ahead log of item changes: every change to the items of a
+ * project is logged, as part of a transaction, before it is made to the item
+ * store, so that a change interrupted part way is redone in full rather than
+ * leaving an item half moved between files.
+ *
+ * Each record is the after-image of an item: its ID, status, code and name
+ * once changed. Redoing a record makes the store hold the item with that
+ * status however far the change got before it was interrupted, so records can
+ * be redone any number of times.
+ *
+ * A transaction is a sequence of records followed by a commit record of the
+ * number of records and a checksum of their bytes, written with one write and
+ * made durable with one sync. Transactions are redone on the next open of the
+ * project unless the log is cleared once they are applied; a transaction
+ * without a complete commit record was never applied, and is ignored along
+ * with anything after it. Integers are stored little-endian.
+ *
+ * Functions are prefixed with wal_
+ * @note This should be considered only internally and not part of the dir
+ * interface
+ */
+#ifndef WAL_H
+#define WAL_H
+
+#include "store/store.h"
+
+#define _WAL_OP_ITEM 'I'   /* Record of the after-image of an item */
+#define _WAL_OP_COMMIT 'C' /* Commit record ending a transaction */
+
+/* Item record field positions, followed by the name */
+#define WAL_OP_POS 0
+#define WAL_ID_POS (WAL_OP_POS + 1)               /* uint32_t item ID */
+#define WAL_ST_POS (WAL_ID_POS + 4)               /* uint8_t status */
+#define WAL_CODE_POS (WAL_ST_POS + 1)             /* ITEM_CODE_LEN code */
+#define WAL_NAME_LEN_POS (WAL_CODE_POS + ITEM_CODE_LEN) /* uint32_t */
+#define WAL_NAME_POS (WAL_NAME_LEN_POS + 4)
+
+/* Commit record field positions */
+#define WAL_COMMIT_RECORDS_POS (WAL_OP_POS + 1) /* uint32_t records */
+#define WAL_COMMIT_SUM_POS (WAL_COMMIT_RECORDS_POS + 4) /* uint32_t checksum */
+#define WAL_COMMIT_LEN (WAL_COMMIT_SUM_POS + 4)
+
+/**
+ * @brief Records of a transaction not yet committed, held in memory
+ */
+struct wal_txn {
+    char *data;      /* Records, on the heap */
+    size_t len;      /* Bytes in data */
+    size_t cap;      /* Bytes allocated for data */
+    int num_records; /* Records in data */
+};
+
+/**
+ * @brief Fields of an item record, referenced in place
+ */
+struct wal_record {
+    sitem_id id;
+    enum status st;
+    const char *code; /* ITEM_CODE_LEN characters, not null-terminated */
+    const char *name; /* name_len characters, not null-terminated */
+    int name_len;
+};
+
+/**
+ * @brief Log the after-image of an item in a transaction
+ * @param txn Transaction, empty or holding records logged before
+ * @param itp Item as it is once changed
+ * @return 0 on success
+ * @return -1 on error, txn is unchanged
+ */
+extern int wal_log_item(struct wal_txn *txn, const item *itp);
+
+/**
+ * @brief Find the last record of an item in a transaction
+ * @param txn Transaction
+ * @param id ID of item
+ * @param rec Set to the fields of the record, valid until txn is changed
+ * @return 0 on success
+ * @return -1 if the transaction holds no record of the item
+ */
+extern int wal_find_item(const struct wal_txn *txn, const sitem_id id,
+                         struct wal_record *rec);
+
+/**
+ * @brief Create the item of a record
+ * @param rec Item record
+ * @return Heap-allocated item
+ * @return NULL on error
+ */
+extern item *wal_record_to_item(const struct wal_record *rec);
+
+/**
+ * @brief Write a transaction to the log, ending it with a commit record
+ * @param path Path of log
+ * @param txn Transaction holding at least one record, which is ready to be
+ * applied with wal_apply on success
+ * @param sync Function syncing the log, NULL to not sync
+ * @return 0 on success
+ * @return -1 on error, the transaction is not committed
+ */
+extern int wal_commit(const char *path, struct wal_txn *txn,
+                      int (*sync)(const int fd));
+
+/**
+ * @brief Redo every record of a committed transaction, in order
+ * @param txn Transaction committed with wal_commit
+ * @param redo Function making the store hold a record's item, returning 0 on
+ * success
+ * @return Number of records redone
+ * @return -1 if any record could not be redone, the rest are still redone
+ */
+extern int wal_apply(const struct wal_txn *txn,
+                     int (*redo)(const struct wal_record *rec));
+
+/**
+ * @brief Redo every committed transaction left in the log, in order
+ * @param path Path of log
+ * @param redo Function making the store hold a record's item, returning 0 on
+ * success
+ * @return Number of records redone, 0 if the log is empty or missing
+ * @return -1 if the log could not be read or any record could not be redone
+ * @note The log is left in place, clear it with wal_clear once the store is
+ * durable
+ */
+extern int wal_recover(const char *path,
+                       int (*redo)(const struct wal_record *rec));
+
+/**
+ * @brief Empty the log once every transaction in it is applied
+ * @param path Path of log
+ * @return 0 on success
+ * @return -1 on error
+ */
+extern int wal_clear(const char *path);
+
+/**
+ * @brief Release the records of a transaction, leaving it empty
+ * @param txn Transaction
+ */
+extern void wal_free_txn(struct wal_txn *txn);
+
+#ifdef TJUNITTEST
+extern int wal_reserve(struct wal_txn *txn, const size_t len);
+extern uint32_t wal_checksum(const char *data, const size_t len);
+extern ssize_t wal_parse_item(const char *data, const size_t len,
+                              struct wal_record *rec);
+extern int wal_redo(const char *data, const size_t len,
+                    int (*redo)(const struct wal_record *rec));
+#endif
+
+#endif
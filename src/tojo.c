@@ -6,8 +6,10 @@
 #include "cmds/add.h"
 #include "cmds/backlog.h"
 #include "cmds/depend.h"
+#include "cmds/gc.h"
 #include "cmds/init.h"
 #include "cmds/list.h"
+#include "cmds/migrate.h"
 #include "cmds/resolve.h"
 #include "cmds/work.h"
 
@@ -28,15 +30,22 @@ static const struct opt_fn tj_option_fns[] = {
 
 /* Commands */
 
+/*
+ * Only list leaves items unchanged, so reads them without a lock, and init
+ * runs before there is a project. Commands adding or changing the status of
+ * single items lock only those records, so run alongside each other.
+ */
 static const struct cmd tj_cmds[] = {
-    {ADD_CMD_NAME, add_cmd},   /* Add an item */
-    {BACK_CMD_NAME, back_cmd}, /* Backlog an item */
-    {DEP_CMD_NAME, dep_cmd},   /* Add dependency between items */
-    {INIT_CMD_NAME, init_cmd}, /* Project initialisation */
-    {LIST_CMD_NAME, list_cmd}, /* List items */
-    {WORK_CMD_NAME, work_cmd}, /* Commence work on an item */
-    {RES_CMD_NAME, res_cmd},   /* Commence work on an item */
-    {NULL, NULL}};
+    {ADD_CMD_NAME, add_cmd, DIR_LOCK_RECORDS},           /* Add an item */
+    {BACK_CMD_NAME, back_cmd, DIR_LOCK_RECORDS},         /* Backlog an item */
+    {DEP_CMD_NAME, dep_cmd, DIR_LOCK_EXCLUSIVE},         /* Add dependency */
+    {GC_CMD_NAME, gc_cmd, DIR_LOCK_EXCLUSIVE},           /* Compact storage */
+    {INIT_CMD_NAME, init_cmd, DIR_LOCK_NONE},            /* Initialisation */
+    {LIST_CMD_NAME, list_cmd, DIR_LOCK_OPTIMISTIC},      /* List items */
+    {MIGRATE_CMD_NAME, migrate_cmd, DIR_LOCK_EXCLUSIVE}, /* Change layout */
+    {WORK_CMD_NAME, work_cmd, DIR_LOCK_RECORDS},         /* Work on an item */
+    {RES_CMD_NAME, res_cmd, DIR_LOCK_RECORDS},           /* Resolve an item */
+    {NULL, NULL, DIR_LOCK_NONE}};
 
 static const struct cmd *get_cmd(char *name) {
     const struct cmd *target = NULL;
@@ -66,6 +75,8 @@ void tj_help() {
     printf("\twork\tMark items as in-progress\n");
     printf("\tlist\tList items in project\n");
     printf("\tdep\tAdd some dependencies between items of given IDs\n");
+    printf("\tgc\tCompact project item storage\n");
+    printf("\tmigrate\tChange the layout of project item storage\n");
     printf("\n");
     printf("See more details of each command in individual help pages\n");
 }
@@ -110,6 +121,30 @@ int tj_main(const int argc, char *const argv[]) {
 #endif
     }
 
+    /* The project is locked once for the whole command */
+    const int in_proj = *proj_dir != '\0';
+    if (in_proj && dir_lock(subcommand->lock) < 0) {
+        puts("Could not lock project");
+        return -1;
+    }
+
+    /* Every item change made by a command is applied once it returns */
+    if (in_proj)
+        dir_begin();
+
     /* Pass control to sub-module with modified argc and argv */
-    return subcommand->cmd_fn(argc - 1, argv + 1, proj_dir);
+    int ret = subcommand->cmd_fn(argc - 1, argv + 1, proj_dir);
+
+    if (in_proj && dir_commit() < 0) {
+#ifdef DEBUG
+        log_err("Item changes could not be committed");
+#endif
+        puts("Could not save changes to items");
+        ret = -1;
+    }
+
+    if (in_proj)
+        dir_unlock();
+
+    return ret;
 }
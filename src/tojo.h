@@ -14,6 +14,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include "dir.h"
+
 /**
  * @brief Command struct representing a single valid command that traces to a
  * module
@@ -21,6 +23,7 @@
 struct cmd {
     char *cmd_name;
     int (*cmd_fn)(const int, char *const[], const char *);
+    enum dir_lock_mode lock; /* Lock of project held while command runs */
 };
 
 /**
@@ -0,0 +1,213 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "dir.h"
+#include "ds/item.h"
+
+/*
+ * Times the same workload against a fresh project in each item storage
+ * layout: adding items, changing the status of every item twice in a
+ * scattered order, reading items by ID and listing every status.
+ *
+ * usage: bench_layouts [<items> [<layout>...]]
+ *
+ * The layout "memory" holds items in memory (see dir_use_memory_store),
+ * giving the cost of dir itself without any item files. Each layout is run in
+ * its own process, as the project path of dir is set once per process. Files
+ * are not synced, so that only the work done by each layout is measured.
+ */
+
+#define BENCH_DEFAULT_ITEMS 2000
+#define BENCH_LISTS 10 /* Listings of every status */
+
+/* Stride visiting every ID once in a scattered order, prime to any count */
+#define BENCH_STRIDE 7919
+
+/* Run in place of a layout to hold items in memory */
+#define BENCH_MEMORY DIR_LAYOUT_COUNT
+#define BENCH_MEMORY_NAME "memory"
+
+static double bench_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int bench_remove_file(const char *path, const struct stat *sb,
+                             int type, struct FTW *ftw) {
+    (void)sb;
+    (void)type;
+    (void)ftw;
+    return remove(path);
+}
+
+/**
+ * @brief Get the ID visited at step i of a scattered pass over n IDs
+ */
+static sitem_id bench_scatter(const int i, const int n) {
+    const int stride = n % BENCH_STRIDE == 0 ? 1 : BENCH_STRIDE;
+    return (sitem_id)(((long long)i * stride) % n);
+}
+
+/**
+ * @brief Get the name of a layout, or of the in-memory store
+ */
+static const char *bench_name(const int layout) {
+    if (layout == BENCH_MEMORY)
+        return BENCH_MEMORY_NAME;
+    return dir_layout_name((enum dir_layout)layout);
+}
+
+/**
+ * @brief Time the workload against a new project of a layout in the current
+ * directory
+ * @param layout Layout of project, or BENCH_MEMORY
+ * @return 0 on success
+ * @return -1 if any operation fails
+ */
+static int bench_layout(const int layout, const int num_items) {
+    const enum dir_layout proj_layout =
+        layout == BENCH_MEMORY ? DIR_LAYOUT_FILES : (enum dir_layout)layout;
+    if (dir_init(CONF_PROJ_DIR, proj_layout, DIR_DURABILITY_NONE) < 0)
+        return -1;
+    if (layout == BENCH_MEMORY && dir_use_memory_store() < 0)
+        return -1;
+
+    double start = bench_now();
+    for (int i = 0; i < num_items; i++) {
+        char name[32];
+        item it = {.item_id = dir_next_id(), .item_st = TODO};
+        item_set_name_deep(&it, name,
+                           snprintf(name, sizeof(name), "item %d", i));
+        item_set_code(&it);
+
+        const int ret = dir_append_item(&it);
+        free(it.item_name);
+        if (ret < 0)
+            return -1;
+    }
+    const double add_time = bench_now() - start;
+
+    /* Every change moves an item to a different status */
+    start = bench_now();
+    for (int i = 0; i < num_items; i++) {
+        if (dir_change_item_status_id(bench_scatter(i, num_items),
+                                      IN_PROG) < 0)
+            return -1;
+    }
+    for (int i = num_items - 1; i >= 0; i--) {
+        if (dir_change_item_status_id(bench_scatter(i, num_items), DONE) < 0)
+            return -1;
+    }
+    const double change_time = bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < num_items; i++) {
+        item *itp = dir_get_item_with_id(bench_scatter(i, num_items));
+        if (!itp)
+            return -1;
+        item_free(itp);
+    }
+    const double get_time = bench_now() - start;
+
+    const enum status sts[] = {BACKLOG, TODO, IN_PROG, DONE};
+    start = bench_now();
+    for (int i = 0; i < BENCH_LISTS; i++) {
+        struct dir_item_view view;
+        if (dir_view_open(&view, sts, ITEM_STATUS_COUNT) < 0)
+            return -1;
+
+        int num_listed = 0;
+        while (dir_view_next(&view))
+            num_listed++;
+        dir_view_close(&view);
+
+        if (num_listed != num_items)
+            return -1;
+    }
+    const double list_time = bench_now() - start;
+
+    printf("%-8s %12.2f %12.2f %12.2f %12.3f\n", bench_name(layout),
+           add_time * 1e6 / num_items, change_time * 1e6 / (2 * num_items),
+           get_time * 1e6 / num_items, list_time * 1e3 / BENCH_LISTS);
+    return 0;
+}
+
+/**
+ * @brief Run the workload of a layout in a child process and a temporary
+ * directory, removed afterwards
+ * @return 0 on success
+ * @return -1 on error
+ */
+static int bench_run(const int layout, const int num_items) {
+    char tmp_dir[] = "/tmp/tojo-bench-XXXXXX";
+    if (!mkdtemp(tmp_dir))
+        return -1;
+
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid == 0) {
+        if (chdir(tmp_dir) < 0)
+            _exit(EXIT_FAILURE);
+        const int ret = bench_layout(layout, num_items);
+        fflush(stdout);
+        _exit(ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) < 0)
+        status = -1;
+
+    nftw(tmp_dir, bench_remove_file, 16, FTW_DEPTH | FTW_PHYS);
+
+    if (status != 0) {
+        fprintf(stderr, "Benchmark of the %s layout failed\n",
+                bench_name(layout));
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int num_items = BENCH_DEFAULT_ITEMS;
+    if (argc > 1)
+        num_items = atoi(argv[1]);
+    if (num_items <= 0) {
+        fprintf(stderr, "usage: %s [<items> [<layout>...]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("%d items\n", num_items);
+    printf("%-8s %12s %12s %12s %12s\n", "layout", "add (us)", "change (us)",
+           "get (us)", "list (ms)");
+
+    int ret = 0;
+    if (argc <= 2) {
+        for (int i = 0; i <= BENCH_MEMORY; i++)
+            ret |= bench_run(i, num_items);
+    }
+
+    for (int i = 2; i < argc; i++) {
+        const int layout = strcmp(argv[i], BENCH_MEMORY_NAME) == 0
+                               ? BENCH_MEMORY
+                               : dir_layout_from_name(argv[i]);
+        if (layout < 0) {
+            fprintf(stderr, "Unknown layout: %s\n", argv[i]);
+            ret = -1;
+            continue;
+        }
+        ret |= bench_run(layout, num_items);
+    }
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
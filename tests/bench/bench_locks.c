@@ -0,0 +1,275 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "dir.h"
+#include "ds/item.h"
+
+/*
+ * Measures how listings scale with the number of concurrent readers, with and
+ * without a writer changing item statuses, and how status changes scale with
+ * the number of concurrent writers, each reader and writer being its own
+ * process locking the project as commands do.
+ *
+ * usage: bench_locks [<items> [<layout> [<durability>]]]
+ *
+ * Readers list every status under a shared lock, or optimistically without a
+ * lock as the list command does, and writers change the status of one item
+ * at a time in a transaction under an exclusive lock, or locking only its
+ * record as the res and work commands do, each writer changing its own items.
+ * Files are not synced unless a durability is given, so that only the cost of
+ * contention is measured.
+ */
+
+#define BENCH_DEFAULT_ITEMS 2000
+#define BENCH_MAX_READERS 8
+#define BENCH_MAX_WRITERS 8
+#define BENCH_SECS 1.0 /* Time each set of processes runs for */
+
+/* Stride visiting every ID once in a scattered order, prime to any count */
+#define BENCH_STRIDE 7919
+
+static double bench_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int bench_remove_file(const char *path, const struct stat *sb,
+                             int type, struct FTW *ftw) {
+    (void)sb;
+    (void)type;
+    (void)ftw;
+    return remove(path);
+}
+
+/**
+ * @brief List every status as the list command does, until the deadline
+ * @param mode DIR_LOCK_SHARED or DIR_LOCK_OPTIMISTIC
+ * @return Number of listings
+ */
+static long bench_reader(const double deadline, const int num_items,
+                         const enum dir_lock_mode mode) {
+    const enum status sts[] = {BACKLOG, TODO, IN_PROG, DONE};
+    long num_reads = 0;
+
+    while (bench_now() < deadline) {
+        if (dir_lock(mode) < 0)
+            return -1;
+
+        struct dir_item_view view;
+        int num_listed = 0;
+        if (dir_view_open(&view, sts, ITEM_STATUS_COUNT) >= 0) {
+            while (dir_view_next(&view))
+                num_listed++;
+        }
+        dir_view_close(&view);
+        dir_unlock();
+
+        if (num_listed != num_items)
+            return -1;
+        num_reads++;
+    }
+    return num_reads;
+}
+
+/**
+ * @brief Move items between in-progress and done one at a time as the res
+ * and work commands do, until the deadline
+ * @param mode DIR_LOCK_EXCLUSIVE or DIR_LOCK_RECORDS
+ * @param writer Index of writer, which changes the items whose IDs are equal
+ * to it modulo the number of writers
+ * @return Number of status changes
+ */
+static long bench_writer(const double deadline, const int num_items,
+                         const enum dir_lock_mode mode, const int writer,
+                         const int num_writers) {
+    const int num_own = (num_items - writer + num_writers - 1) / num_writers;
+    const int stride = num_own % BENCH_STRIDE == 0 ? 1 : BENCH_STRIDE;
+    long num_writes = 0;
+
+    while (bench_now() < deadline) {
+        const long long own = ((long long)num_writes * stride) % num_own;
+        const sitem_id id = (sitem_id)(own * num_writers + writer);
+        if (dir_lock(mode) < 0)
+            return -1;
+
+        dir_begin();
+        const int st = dir_item_status_id(id);
+        int ret = dir_change_item_status_id(id, st == DONE ? IN_PROG : DONE);
+        if (dir_commit() < 0)
+            ret = -1;
+        dir_unlock();
+
+        if (ret < 0)
+            return -1;
+        num_writes++;
+    }
+    return num_writes;
+}
+
+/**
+ * @brief Run readers and writers, each in its own process
+ * @param read_mode Lock mode of readers
+ * @param write_mode Lock mode of writers
+ * @param counts Shared counts of each process, the writers' last
+ * @return 0 on success
+ * @return -1 if any process failed
+ */
+static int bench_contend(const int num_readers, const int num_writers,
+                         const enum dir_lock_mode read_mode,
+                         const enum dir_lock_mode write_mode,
+                         const int num_items, long *counts) {
+    const double deadline = bench_now() + BENCH_SECS;
+    const int num_procs = num_readers + num_writers;
+
+    fflush(stdout);
+    for (int i = 0; i < num_procs; i++) {
+        const pid_t pid = fork();
+        if (pid < 0)
+            return -1;
+        if (pid == 0) {
+            counts[i] = i < num_readers
+                            ? bench_reader(deadline, num_items, read_mode)
+                            : bench_writer(deadline, num_items, write_mode,
+                                           i - num_readers, num_writers);
+            _exit(counts[i] < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+        }
+    }
+
+    int ret = 0, status;
+    for (int i = 0; i < num_procs; i++) {
+        if (wait(&status) < 0 || status != 0)
+            ret = -1;
+    }
+    return ret;
+}
+
+/**
+ * @brief Create a project of items in the current directory and time
+ * listings against it with an increasing number of readers, then status
+ * changes with an increasing number of writers
+ * @return 0 on success
+ * @return -1 on error
+ */
+static int bench_locks(const enum dir_layout layout,
+                       const enum dir_durability durability,
+                       const int num_items) {
+    if (dir_init(CONF_PROJ_DIR, layout, durability) < 0)
+        return -1;
+
+    dir_begin();
+    for (int i = 0; i < num_items; i++) {
+        char name[32];
+        item it = {.item_id = dir_next_id(), .item_st = TODO};
+        item_set_name_deep(&it, name,
+                           snprintf(name, sizeof(name), "item %d", i));
+        item_set_code(&it);
+
+        const int ret = dir_append_item(&it);
+        free(it.item_name);
+        if (ret < 0)
+            return -1;
+    }
+    if (dir_commit() < 0)
+        return -1;
+
+    const size_t counts_len =
+        sizeof(long) * (BENCH_MAX_READERS + BENCH_MAX_WRITERS);
+    long *counts = mmap(NULL, counts_len,
+                        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                        -1, 0);
+    if (counts == MAP_FAILED)
+        return -1;
+
+    const enum dir_lock_mode modes[] = {DIR_LOCK_SHARED, DIR_LOCK_OPTIMISTIC};
+    const char *mode_names[] = {"shared", "lock-free"};
+
+    printf("%-8s %-10s %14s %14s %14s\n", "readers", "reads", "lists/s",
+           "with writer", "writes/s");
+
+    int ret = 0;
+    for (int readers = 1; ret == 0 && readers <= BENCH_MAX_READERS;
+         readers *= 2) {
+        for (int m = 0; ret == 0 && m < 2; m++) {
+            long reads[2] = {0, 0};
+            for (int writer = 0; ret == 0 && writer <= 1; writer++) {
+                memset(counts, 0, counts_len);
+                ret = bench_contend(readers, writer, modes[m],
+                                    DIR_LOCK_EXCLUSIVE, num_items, counts);
+                for (int i = 0; i < readers; i++)
+                    reads[writer] += counts[i];
+            }
+            if (ret == 0)
+                printf("%-8d %-10s %14.0f %14.0f %14.0f\n", readers,
+                       mode_names[m], reads[0] / BENCH_SECS,
+                       reads[1] / BENCH_SECS, counts[readers] / BENCH_SECS);
+        }
+    }
+
+    printf("\n%-8s %14s %14s\n", "writers", "exclusive/s", "records/s");
+
+    const enum dir_lock_mode write_modes[] = {DIR_LOCK_EXCLUSIVE,
+                                              DIR_LOCK_RECORDS};
+    for (int writers = 1; ret == 0 && writers <= BENCH_MAX_WRITERS;
+         writers *= 2) {
+        long writes[2] = {0, 0};
+        for (int m = 0; ret == 0 && m < 2; m++) {
+            memset(counts, 0, counts_len);
+            ret = bench_contend(0, writers, DIR_LOCK_SHARED, write_modes[m],
+                                num_items, counts);
+            for (int i = 0; i < writers; i++)
+                writes[m] += counts[i];
+        }
+        if (ret == 0)
+            printf("%-8d %14.0f %14.0f\n", writers, writes[0] / BENCH_SECS,
+                   writes[1] / BENCH_SECS);
+    }
+
+    munmap(counts, counts_len);
+    return ret;
+}
+
+int main(int argc, char **argv) {
+    int num_items = BENCH_DEFAULT_ITEMS;
+    if (argc > 1)
+        num_items = atoi(argv[1]);
+    const int layout =
+        argc > 2 ? dir_layout_from_name(argv[2]) : DIR_LAYOUT_FILES;
+    const int durability =
+        argc > 3 ? dir_durability_from_name(argv[3]) : DIR_DURABILITY_NONE;
+    if (num_items <= 0 || layout < 0 || durability < 0) {
+        fprintf(stderr, "usage: %s [<items> [<layout> [<durability>]]]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    char tmp_dir[] = "/tmp/tojo-bench-XXXXXX";
+    if (!mkdtemp(tmp_dir) || chdir(tmp_dir) < 0)
+        return EXIT_FAILURE;
+
+    printf("%d items, %s layout, %s durability\n", num_items,
+           dir_layout_name((enum dir_layout)layout),
+           dir_durability_name((enum dir_durability)durability));
+
+    const int ret = bench_locks((enum dir_layout)layout,
+                                (enum dir_durability)durability, num_items);
+
+    nftw(tmp_dir, bench_remove_file, 16, FTW_DEPTH | FTW_PHYS);
+
+    if (ret != 0) {
+        fprintf(stderr, "Benchmark of %d items failed\n", num_items);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,191 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ds/item.h"
+#include "ds/trie.h"
+
+/*
+ * Measures finding the shortest unique prefix of every item code, as list does
+ * for every listing, with shortest_unique_prefix_lengths against the trie it
+ * replaced, which allocated a node for each new character of each code.
+ *
+ * usage: bench_prefixes [<codes>...]
+ *
+ * Codes are those of the items with IDs from 0, and each engine is run
+ * repeatedly until BENCH_MIN_SECS have passed. Prefixes the trie gives that
+ * are shared with a code inserted after them are counted as ambiguous.
+ */
+
+#define BENCH_MIN_SECS 0.5 /* Least time each engine is run for */
+
+static const int bench_default_codes[] = {1000, 100000, 1000000};
+
+static double bench_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Trie engine as it was, each node having an array of children once any */
+
+struct bench_trie_node {
+    struct bench_trie_node **children;
+    char tok;
+    unsigned int num_children;
+};
+
+static struct bench_trie_node *bench_trie_node(const int num_children) {
+    struct bench_trie_node *node = malloc(sizeof(*node));
+    if (!node)
+        return NULL;
+
+    node->children =
+        num_children > 0 ? calloc(num_children, sizeof(*node->children))
+                         : NULL;
+    node->tok = '\0';
+    node->num_children = 0;
+    return node;
+}
+
+static void bench_trie_free(struct bench_trie_node *root) {
+    for (unsigned int i = 0; i < root->num_children; i++)
+        bench_trie_free(root->children[i]);
+    free(root->children);
+    free(root);
+}
+
+static void bench_trie_prefix_lengths(const char *const *strings,
+                                      const int num_strings, const int len,
+                                      const int uniq_chars,
+                                      int *prefix_lengths) {
+    struct bench_trie_node *root = bench_trie_node(uniq_chars);
+
+    for (int i = 0; i < num_strings; i++) {
+        struct bench_trie_node *curr = root;
+        prefix_lengths[i] = len;
+        for (int j = 0; j < len; j++) {
+            /* Children are found by a linear scan */
+            struct bench_trie_node *child = NULL;
+            for (unsigned int c = 0; !child && c < curr->num_children; c++) {
+                if (curr->children[c]->tok == strings[i][j])
+                    child = curr->children[c];
+            }
+            if (child) {
+                curr = child;
+                continue;
+            }
+
+            /* Sequence is new, so the prefix ends here */
+            child = bench_trie_node(0);
+            child->tok = strings[i][j];
+            if (!curr->children)
+                curr->children = calloc(uniq_chars, sizeof(*curr->children));
+            curr->children[curr->num_children++] = child;
+            prefix_lengths[i] = j + 1;
+            break;
+        }
+    }
+
+    bench_trie_free(root);
+}
+
+/**
+ * @brief Run an engine over codes until BENCH_MIN_SECS have passed
+ * @return Seconds taken by each run
+ */
+static double bench_engine(void (*engine)(const char *const *, const int,
+                                          const int, const int, int *),
+                           const char *const *codes, const int num_codes,
+                           int *prefix_lengths) {
+    const double start = bench_now();
+    double elapsed;
+    int runs = 0;
+    do {
+        engine(codes, num_codes, ITEM_CODE_LEN, ITEM_CODE_CHARS,
+               prefix_lengths);
+        runs++;
+        elapsed = bench_now() - start;
+    } while (elapsed < BENCH_MIN_SECS);
+
+    return elapsed / runs;
+}
+
+/**
+ * @brief Time both engines over the codes of num_codes items
+ * @return 0 on success
+ * @return -1 on error
+ */
+static int bench_prefixes(const int num_codes) {
+    char *code_data = malloc((size_t)num_codes * ITEM_CODE_LEN);
+    const char **codes = malloc(sizeof(*codes) * num_codes);
+    int *trie_lengths = malloc(sizeof(*trie_lengths) * num_codes);
+    int *sort_lengths = malloc(sizeof(*sort_lengths) * num_codes);
+    item *itp = item_init();
+    if (!code_data || !codes || !trie_lengths || !sort_lengths || !itp) {
+        free(code_data);
+        free(codes);
+        free(trie_lengths);
+        free(sort_lengths);
+        item_free(itp);
+        return -1;
+    }
+
+    for (int i = 0; i < num_codes; i++) {
+        itp->item_id = i;
+        item_set_code(itp);
+        codes[i] = code_data + (size_t)i * ITEM_CODE_LEN;
+        memcpy(code_data + (size_t)i * ITEM_CODE_LEN, itp->item_code,
+               ITEM_CODE_LEN);
+    }
+    item_free(itp);
+
+    const double trie_secs = bench_engine(bench_trie_prefix_lengths, codes,
+                                          num_codes, trie_lengths);
+    const double sort_secs = bench_engine(shortest_unique_prefix_lengths,
+                                          codes, num_codes, sort_lengths);
+
+    /* Prefixes are unique once no shorter than the shortest unique prefix */
+    int num_ambiguous = 0;
+    for (int i = 0; i < num_codes; i++)
+        num_ambiguous += trie_lengths[i] < sort_lengths[i];
+
+    printf("%-10d %12.3f %12.3f %8.1fx %12d\n", num_codes, trie_secs * 1e3,
+           sort_secs * 1e3, trie_secs / sort_secs, num_ambiguous);
+
+    free(code_data);
+    free(codes);
+    free(trie_lengths);
+    free(sort_lengths);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const int num_sizes =
+        argc > 1 ? argc - 1
+                 : (int)(sizeof(bench_default_codes) /
+                         sizeof(*bench_default_codes));
+
+    printf("%-10s %12s %12s %9s %12s\n", "codes", "trie ms", "sort ms",
+           "speedup", "ambiguous");
+
+    for (int i = 0; i < num_sizes; i++) {
+        const int num_codes =
+            argc > 1 ? atoi(argv[i + 1]) : bench_default_codes[i];
+        if (num_codes <= 0) {
+            fprintf(stderr, "usage: %s [<codes>...]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+        if (bench_prefixes(num_codes) < 0) {
+            fprintf(stderr, "Benchmark of %d codes failed\n", num_codes);
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,4 +1,5 @@
 #include "ds/item.h"
+#include "ds/trie.h"
 #include "minunit.h"
 
 /*
@@ -148,6 +149,22 @@ MU_TEST(test_item_set_name_deep) {
     item_free(itp);
 }
 
+MU_TEST(test_item_set_name_deep_long) {
+    item *itp = item_init();
+    char name[3 * ITEM_NAME_MAX + 1];
+    memset(name, 'n', sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+
+    /* Names are not limited to fixed-width entries */
+    item_set_name_deep(itp, name, strlen(name));
+    mu_assert_string_eq(name, itp->item_name);
+
+    /* Padding is trimmed and copying stops at len */
+    item_set_name_deep(itp, "  padded name   ", 13);
+    mu_assert_string_eq("padded name", itp->item_name);
+    item_free(itp);
+}
+
 MU_TEST(test_item_set_code) {
     /* This is also a test that the code generation produces acceptably entropic
     * codes based on 'similar' IDs */
@@ -161,6 +178,65 @@ MU_TEST(test_item_set_code) {
     item_free(itp);
 }
 
+MU_TEST(test_item_code_to_id) {
+    item *itp = item_init();
+    const sitem_id ids[] = {0, 1, 2, 25, 26, 4095, 1000000, INT32_MAX};
+    for (size_t i = 0; i < sizeof(ids) / sizeof(*ids); i++) {
+        itp->item_id = ids[i];
+        item_set_code(itp);
+        mu_assert_int_eq(ids[i], item_code_to_id(itp->item_code));
+    }
+    item_free(itp);
+
+    /* Larger than any 32-bit code index */
+    mu_assert_int_eq(-1, item_code_to_id("zzzzzzz"));
+    /* Prefixes and invalid characters */
+    mu_assert_int_eq(-1, item_code_to_id("aaa"));
+    mu_assert_int_eq(-1, item_code_to_id("aaaaaA1"));
+}
+
+MU_TEST(test_shortest_unique_prefix_lengths) {
+    /* Earlier strings are not given prefixes later strings share */
+    const char *strings[] = {"abcdefg", "abcdxyz", "bbbbbbb", "abcdefg"};
+    int lengths[4];
+    shortest_unique_prefix_lengths(strings, 4, ITEM_CODE_LEN, ITEM_CODE_CHARS,
+                                   lengths);
+    mu_assert_int_eq(ITEM_CODE_LEN, lengths[0]);
+    mu_assert_int_eq(5, lengths[1]);
+    mu_assert_int_eq(1, lengths[2]);
+    mu_assert_int_eq(ITEM_CODE_LEN, lengths[3]);
+
+    /* Prefixes of item codes are checked against every other code */
+    const int num_codes = 2000;
+    char codes[num_codes][ITEM_CODE_LEN];
+    const char *code_ptrs[num_codes];
+    int prefix_lengths[num_codes];
+    item *itp = item_init();
+    for (int i = 0; i < num_codes; i++) {
+        itp->item_id = i;
+        item_set_code(itp);
+        memcpy(codes[i], itp->item_code, ITEM_CODE_LEN);
+        code_ptrs[i] = codes[i];
+    }
+    item_free(itp);
+
+    shortest_unique_prefix_lengths(code_ptrs, num_codes, ITEM_CODE_LEN,
+                                   ITEM_CODE_CHARS, prefix_lengths);
+    int all_shortest = 1;
+    for (int i = 0; i < num_codes; i++) {
+        int common = 0;
+        for (int j = 0; j < num_codes; j++) {
+            int len = 0;
+            while (len < ITEM_CODE_LEN && codes[i][len] == codes[j][len])
+                len++;
+            if (j != i && len > common)
+                common = len;
+        }
+        all_shortest &= prefix_lengths[i] == common + 1;
+    }
+    mu_check(all_shortest);
+}
+
 MU_TEST_SUITE(item_test_suite) {
     MU_SUITE_CONFIGURE(test_setup, test_teardown);
 
@@ -176,7 +252,10 @@ MU_TEST_SUITE(item_test_suite) {
     MU_RUN_TEST(test_item_array_add);
     MU_RUN_TEST(test_item_set_name);
     MU_RUN_TEST(test_item_set_name_deep);
+    MU_RUN_TEST(test_item_set_name_deep_long);
     MU_RUN_TEST(test_item_set_code);
+    MU_RUN_TEST(test_item_code_to_id);
+    MU_RUN_TEST(test_shortest_unique_prefix_lengths);
 }
 
 MU_MAIN(MU_RUN_SUITE(item_test_suite); MU_REPORT(); return MU_EXIT_CODE;)
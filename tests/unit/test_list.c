@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cmds/list.h"
+#include "minunit.h"
+
+/*
+ * List output is written to stdout, which is redirected to a temporary file
+ * for each test and read back.
+ */
+
+static char out_path[] = "/tmp/tojo-test-list-XXXXXX";
+static int out_fd = -1;
+static int saved_stdout = -1;
+
+void test_setup() {
+    fflush(stdout);
+    out_fd = mkstemp(out_path);
+    saved_stdout = dup(STDOUT_FILENO);
+    if (out_fd >= 0)
+        dup2(out_fd, STDOUT_FILENO);
+}
+
+void test_teardown() {
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    close(out_fd);
+    unlink(out_path);
+    strcpy(out_path + strlen(out_path) - 6, "XXXXXX");
+}
+
+MU_TEST(test_list_out_put_longer_than_buffer) {
+    mu_check(out_fd >= 0);
+
+    /* Names of the binary layout are not limited to the buffer */
+    const size_t name_len = LIST_OUT_BUF_SZ + 4464;
+    char *name = malloc(name_len);
+    struct list_out *out = malloc(sizeof(*out));
+    mu_check(name && out);
+    memset(name, 'x', name_len);
+    out->len = 0;
+
+    list_out_put(out, "1\t", 2);
+    list_out_put(out, name, name_len);
+    list_out_put(out, "\n", 1);
+    list_out_flush(out);
+
+    /* Output is in the order it was put */
+    const size_t expected_len = name_len + 3;
+    char *written = malloc(expected_len + 1);
+    mu_check(written != NULL);
+    const ssize_t b = pread(out_fd, written, expected_len + 1, 0);
+    mu_assert_int_eq((int)expected_len, (int)b);
+    mu_check(!memcmp(written, "1\t", 2) &&
+             !memcmp(written + 2, name, name_len) &&
+             written[expected_len - 1] == '\n');
+
+    free(written);
+    free(out);
+    free(name);
+}
+
+MU_TEST_SUITE(list_test_suite) {
+    MU_SUITE_CONFIGURE(test_setup, test_teardown);
+
+    MU_RUN_TEST(test_list_out_put_longer_than_buffer);
+}
+
+MU_MAIN(MU_RUN_SUITE(list_test_suite); MU_REPORT(); return MU_EXIT_CODE;)
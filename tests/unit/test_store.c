@@ -0,0 +1,1050 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ds/graph.h"
+#include "ds/item.h"
+#include "minunit.h"
+#include "store/archive.h"
+#include "store/binary.h"
+#include "store/btree.h"
+#include "store/code_index.h"
+#include "store/files.h"
+#include "store/lsm.h"
+#include "store/memory.h"
+#include "store/table.h"
+#include "store/wal.h"
+
+/*
+ * Every store is run against the same workload in a temporary project
+ * directory, which is removed after each test.
+ */
+
+/* Enough to split B+tree leaves, compact and fill several segments */
+#define STORE_TEST_ITEMS 2500
+
+static char proj_dir[] = "/tmp/tojo-test-XXXXXX";
+static char items_dir[MAX_PATH];
+
+/* Files are not synced, only the contents of each store are tested */
+static int test_sync_written(const int fd, const char *path) {
+    (void)fd;
+    (void)path;
+    return 0;
+}
+
+static int test_sync_replacement(const int fd) {
+    (void)fd;
+    return 0;
+}
+
+static const struct store_env test_env = {
+    .proj_dir = proj_dir,
+    .items_dir = items_dir,
+    .sync_written = test_sync_written,
+    .sync_replacement = test_sync_replacement,
+};
+
+static int remove_file(const char *path, const struct stat *sb, int type,
+                       struct FTW *ftw) {
+    (void)sb;
+    (void)type;
+    (void)ftw;
+    return remove(path);
+}
+
+/*
+ * Stores keep the paths of their files from their first setup, so the
+ * directory is recreated at the same path for every test
+ */
+void test_setup() {
+    static int created = 0;
+    if (!created && !mkdtemp(proj_dir))
+        return;
+    if (created)
+        mkdir(proj_dir, 0755);
+    created = 1;
+
+    snprintf(items_dir, sizeof(items_dir), "%s/items", proj_dir);
+    mkdir(items_dir, 0755);
+}
+
+void test_teardown() { nftw(proj_dir, remove_file, 16, FTW_DEPTH | FTW_PHYS); }
+
+/**
+ * @brief Status an item is first added with
+ */
+static enum status initial_status(const sitem_id id) {
+    return (enum status)(id % ITEM_STATUS_COUNT);
+}
+
+/**
+ * @brief Status of an item once the workload is complete, every third item
+ * is moved to DONE or TODO if already done
+ */
+static enum status final_status(const sitem_id id) {
+    if (id % 3 != 0)
+        return initial_status(id);
+    return initial_status(id) == DONE ? TODO : DONE;
+}
+
+/**
+ * @brief Run the workload against a store
+ * @return NULL on success
+ * @return Message of the first failed check
+ */
+static const char *run_store(const struct store_ops *store) {
+    store->setup(&test_env);
+    if (store->create() < 0)
+        return "Store could not be created";
+
+    for (sitem_id id = 0; id < STORE_TEST_ITEMS; id++) {
+        char name[32];
+        item it = {.item_id = id, .item_st = initial_status(id)};
+        item_set_name_deep(&it, name,
+                           snprintf(name, sizeof(name), "item %d", id));
+        item_set_code(&it);
+
+        const int ret = store->append_item(&it);
+        free(it.item_name);
+        if (ret < 0)
+            return "Item could not be appended";
+    }
+
+    for (sitem_id id = 0; id < STORE_TEST_ITEMS; id += 3) {
+        if (store->change_status(id, final_status(id)) < 0)
+            return "Item status could not be changed";
+    }
+    if (store->change_status(1, initial_status(1)) >= 0)
+        return "Item status changed to its current status";
+    if (store->change_status(STORE_TEST_ITEMS, TODO) >= 0)
+        return "Status of missing item changed";
+
+    if (store->compact() < 0)
+        return "Store could not be compacted";
+
+    if (store->total_items() != STORE_TEST_ITEMS)
+        return "Total items differs from items appended";
+
+    for (sitem_id id = 0; id < STORE_TEST_ITEMS; id++) {
+        if (store->item_status(id) != (int)final_status(id))
+            return "Item status differs from status changed to";
+
+        char name[32];
+        snprintf(name, sizeof(name), "item %d", id);
+        item *itp = store->read_item(id);
+        if (!itp)
+            return "Item could not be read";
+        const int same = itp->item_id == id && !strcmp(itp->item_name, name) &&
+                         itp->item_st == final_status(id);
+        item_free(itp);
+        if (!same)
+            return "Item read differs from item appended";
+    }
+    if (store->item_status(STORE_TEST_ITEMS) != -1 ||
+        store->read_item(STORE_TEST_ITEMS))
+        return "Missing item was found";
+
+    for (int st = 0; st < ITEM_STATUS_COUNT; st++) {
+        item **items = store->read_items_status((enum status)st);
+        if (!items)
+            return "Items of status could not be read";
+
+        /* Items are in order of ID, skipping items of other statuses */
+        sitem_id id = 0;
+        int in_order = 1;
+        for (item **itpp = items; *itpp; itpp++, id++) {
+            while (id < STORE_TEST_ITEMS && final_status(id) != st)
+                id++;
+            in_order &= (*itpp)->item_id == id && (*itpp)->item_st == st;
+        }
+        while (id < STORE_TEST_ITEMS && final_status(id) != st)
+            id++;
+        item_array_free(&items, SIZE_MAX);
+        if (!in_order || id != STORE_TEST_ITEMS)
+            return "Items of status differ from items appended";
+    }
+
+    /* View statuses in an order other than that of enum status */
+    struct dir_item_view view;
+    memset(&view, 0, sizeof(view));
+    const enum status sts[] = {DONE, BACKLOG, IN_PROG, TODO};
+    memcpy(view.sts, sts, sizeof(sts));
+    view.num_sts = ITEM_STATUS_COUNT;
+    view.store = store;
+    if (store->view_open(&view) < 0)
+        return "View could not be opened";
+
+    /* Statuses are visited in the order given, never returning to one */
+    int num_viewed = 0, in_order = 1, sts_idx = 0, hints_found = 1;
+    off_t other_loc = -1; /* Location of another item of the status of 1 */
+    for (const struct dir_item_ref *ref; (ref = store->view_next(&view));) {
+        while (sts_idx < ITEM_STATUS_COUNT && sts[sts_idx] != ref->st)
+            sts_idx++;
+        in_order &= sts_idx < ITEM_STATUS_COUNT &&
+                    ref->st == final_status(ref->id);
+        num_viewed++;
+
+        /* Items are found at the locations they were viewed at */
+        if (store->hint_location && ref->loc >= 0) {
+            store->hint_location(ref->id, ref->st, ref->loc);
+            item *itp = store->read_item(ref->id);
+            hints_found &= itp && itp->item_id == ref->id;
+            item_free(itp);
+        }
+        if (ref->id != 1 && ref->st == final_status(1))
+            other_loc = ref->loc;
+    }
+    for (int i = 0; i < ITEM_STATUS_COUNT; i++)
+        free_entry_buf(&view.bufs[i]);
+    if (!in_order || num_viewed != STORE_TEST_ITEMS)
+        return "Items viewed differ from items appended";
+
+    /* Locations of other entries are not used */
+    if (store->hint_location && other_loc >= 0) {
+        store->hint_location(1, final_status(1), other_loc);
+        hints_found &= store->item_status(1) == (int)final_status(1);
+    }
+    if (!hints_found)
+        return "Item not found after its location was hinted";
+
+    /* Every fifth item is removed, and the first is then added back */
+    int num_removed = 0;
+    for (sitem_id id = 0; id < STORE_TEST_ITEMS; id += 5, num_removed++) {
+        if (store->remove_item(id) < 0)
+            return "Item could not be removed";
+    }
+    if (store->remove_item(0) >= 0)
+        return "Removed item removed again";
+    if (store->item_status(5) != -1 || store->read_item(5))
+        return "Removed item was found";
+
+    item *first = store->read_item(1);
+    if (!first)
+        return "Item could not be read after removals";
+    first->item_id = 0;
+    const int readded = store->append_item(first);
+    item_free(first);
+    if (readded < 0 || store->item_status(0) != (int)final_status(1))
+        return "Removed item could not be added back";
+
+    if (store->compact() < 0)
+        return "Store could not be compacted after removals";
+    if (store->total_items() != STORE_TEST_ITEMS - num_removed + 1)
+        return "Total items differs from items left after removals";
+
+    store->remove();
+    return NULL;
+}
+
+MU_TEST(test_files_store) {
+    const char *msg = run_store(&files_store);
+    mu_assert(!msg, msg);
+}
+
+MU_TEST(test_table_store) {
+    const char *msg = run_store(&table_store);
+    mu_assert(!msg, msg);
+}
+
+MU_TEST(test_binary_store) {
+    const char *msg = run_store(&binary_store);
+    mu_assert(!msg, msg);
+}
+
+MU_TEST(test_binary_compact) {
+    binary_store.setup(&test_env);
+    mu_check(binary_store.create() == 0);
+    char names_path[MAX_PATH];
+    store_path(items_dir, _BINARY_NAMES_F, names_path);
+
+    /* Names of removed items are left in the heap until it is compacted */
+    int all_changed = 1;
+    for (sitem_id id = 0; id < 64; id++) {
+        char name[32];
+        item it = {.item_id = id, .item_st = initial_status(id)};
+        item_set_name_deep(&it, name,
+                           snprintf(name, sizeof(name), "item %d", id));
+        item_set_code(&it);
+        all_changed &= binary_store.append_item(&it) == 0;
+        free(it.item_name);
+    }
+    for (sitem_id id = 0; id < 64; id++) {
+        if (id % 4 != 0)
+            all_changed &= binary_store.remove_item(id) == 0;
+    }
+    mu_check(all_changed);
+
+    struct stat sb;
+    mu_check(stat(names_path, &sb) == 0);
+    const off_t heap_size = sb.st_size;
+    mu_check(binary_store.compact() == 0);
+    mu_check(stat(names_path, &sb) == 0);
+    mu_check(sb.st_size < heap_size / 2);
+
+    /*
+     * Compaction is interrupted once its new records are complete, then again
+     * once the name heap is replaced, and is finished by the next read
+     */
+    for (int renamed = 0; renamed <= 1; renamed++) {
+        item *items[] = {binary_store.read_item(4), NULL};
+        char records_new[MAX_PATH], names_tmp[MAX_PATH];
+        store_path(items_dir, _BINARY_F ".new", records_new);
+        store_path(items_dir, _BINARY_NAMES_F ".tmp", names_tmp);
+        mu_check(items[0] &&
+                 binary_write_files(items, records_new, names_tmp) == 0);
+        item_free(items[0]);
+        if (renamed)
+            mu_check(rename(names_tmp, names_path) == 0);
+
+        item *itp = binary_store.read_item(4);
+        mu_check(itp && !strcmp(itp->item_name, "item 4"));
+        item_free(itp);
+        mu_assert_int_eq(1, binary_store.total_items());
+        mu_check(access(records_new, F_OK) < 0 && access(names_tmp, F_OK) < 0);
+    }
+
+    binary_store.remove();
+}
+
+MU_TEST(test_lsm_store) {
+    const char *msg = run_store(&lsm_store);
+    mu_assert(!msg, msg);
+}
+
+MU_TEST(test_btree_store) {
+    const char *msg = run_store(&btree_store);
+    mu_assert(!msg, msg);
+}
+
+/**
+ * @brief Insert an item into a B+tree, as the store appends it
+ */
+static int btree_test_insert(const int fd, const sitem_id id) {
+    char name[32];
+    item it = {.item_id = id, .item_st = initial_status(id)};
+    item_set_name_deep(&it, name, snprintf(name, sizeof(name), "item %d", id));
+    item_set_code(&it);
+
+    const int ret = btree_insert_item(fd, &it);
+    free(it.item_name);
+    return ret;
+}
+
+/**
+ * @brief Check that a B+tree holds exactly the items with the given IDs
+ * @param ids IDs in ascending order
+ * @return Non-zero if every item is found and loaded in order
+ */
+static int btree_test_holds(const int fd, const sitem_id *ids, const int n) {
+    int all_found = 1;
+    for (int i = 0; i < n; i++) {
+        item *itp = btree_read_item(fd, ids[i]);
+        all_found &= itp && itp->item_st == initial_status(ids[i]);
+        item_free(itp);
+    }
+
+    struct entry_buf buf;
+    if (btree_load(fd, &buf) != n) {
+        free_entry_buf(&buf);
+        return 0;
+    }
+    for (int i = 0; i < n; i++)
+        all_found &=
+            hex_field_to_id(buf.data + (size_t)i * TABLE_ENTRY_LEN) == ids[i];
+    free_entry_buf(&buf);
+    return all_found;
+}
+
+MU_TEST(test_btree_interrupted_split) {
+    btree_store.setup(&test_env);
+    mu_check(btree_store.create() == 0);
+    char tree_path[MAX_PATH];
+    store_path(items_dir, _BTREE_F, tree_path);
+    const int fd = open(tree_path, O_RDWR);
+    mu_check(fd >= 0);
+
+    /* A root leaf full of even IDs is split by an odd ID in its middle */
+    sitem_id ids[3 * BTREE_LEAF_MAX];
+    int n = 0;
+    for (sitem_id id = 0; n < BTREE_LEAF_MAX; id += 2) {
+        mu_check(btree_test_insert(fd, id) == 0);
+        ids[n++] = id;
+    }
+    const sitem_id split_id = BTREE_LEAF_MAX | 1;
+    char pre[2 * BTREE_PAGE_SIZE], post[3 * BTREE_PAGE_SIZE];
+    struct btree_header pre_hdr;
+    mu_check(btree_read_header(fd, &pre_hdr) == 0);
+    mu_check(pread(fd, pre, sizeof(pre), 0) == sizeof(pre));
+    mu_check(btree_test_insert(fd, split_id) == 0);
+    mu_check(pread(fd, post, sizeof(post), 0) == sizeof(post));
+
+    for (int i = n++; i > 0 && ids[i - 1] > split_id; i--) {
+        ids[i] = ids[i - 1];
+        ids[i - 1] = split_id;
+    }
+    const int split_n = n;
+
+    /*
+     * The file is cut short after each write of the leaf split in turn: the
+     * reservation of the new leaf, the new leaf, then the full leaf
+     */
+    for (int writes = 1; writes <= 3; writes++) {
+        mu_check(ftruncate(fd, 0) == 0);
+        mu_check(pwrite(fd, pre, sizeof(pre), 0) == sizeof(pre));
+        struct btree_header hdr = pre_hdr;
+        hdr.num_pages = 3;
+        mu_check(btree_write_header(fd, &hdr) == 0);
+        for (int page = 2; page > 3 - writes; page--) {
+            const off_t off = (off_t)page * BTREE_PAGE_SIZE;
+            mu_check(pwrite(fd, post + off, BTREE_PAGE_SIZE, off) ==
+                     BTREE_PAGE_SIZE);
+        }
+
+        /* The log is replayed, then later splits must not reuse pages */
+        n = split_n;
+        item *split_itp = btree_read_item(fd, split_id);
+        const int replayed = split_itp == NULL;
+        item_free(split_itp);
+        mu_assert_int_eq(writes < 3, replayed);
+        if (replayed)
+            mu_check(btree_test_insert(fd, split_id) == 0);
+        for (sitem_id id = 100; n < 3 * BTREE_LEAF_MAX; id++) {
+            mu_check(btree_test_insert(fd, id) == 0);
+            ids[n++] = id;
+        }
+        mu_check(btree_test_holds(fd, ids, n));
+    }
+
+    close(fd);
+    btree_store.remove();
+}
+
+/* Enough leaves that the root internal node is split */
+#define BTREE_TEST_SPLIT_IDS (2 * BTREE_INTERNAL_MAX * BTREE_LEAF_MAX)
+
+MU_TEST(test_btree_internal_split) {
+    btree_store.setup(&test_env);
+    mu_check(btree_store.create() == 0);
+    char tree_path[MAX_PATH];
+    store_path(items_dir, _BTREE_F, tree_path);
+    const int fd = open(tree_path, O_RDWR);
+    mu_check(fd >= 0);
+
+    /* Even IDs fill leaves, then odd IDs split them in the middle */
+    sitem_id *ids = malloc(sizeof(*ids) * BTREE_TEST_SPLIT_IDS);
+    mu_check(ids != NULL);
+    int all_inserted = 1;
+    for (sitem_id id = 0; id < BTREE_TEST_SPLIT_IDS; id += 2)
+        all_inserted &= btree_test_insert(fd, id) == 0;
+    for (sitem_id id = 1; id < BTREE_TEST_SPLIT_IDS; id += 2)
+        all_inserted &= btree_test_insert(fd, id) == 0;
+    mu_check(all_inserted);
+    for (sitem_id id = 0; id < BTREE_TEST_SPLIT_IDS; id++)
+        ids[id] = id;
+    mu_check(btree_test_holds(fd, ids, BTREE_TEST_SPLIT_IDS));
+    mu_assert_int_eq(BTREE_TEST_SPLIT_IDS, btree_total_items(fd));
+
+    /* Leaves lie below a new root and the halves of the old one */
+    struct btree_header hdr;
+    uint32_t path[_BTREE_MAX_DEPTH];
+    int child_idxs[_BTREE_MAX_DEPTH];
+    char page[BTREE_PAGE_SIZE];
+    mu_check(btree_read_header(fd, &hdr) == 0);
+    mu_assert_int_eq(2, btree_descend(fd, &hdr, 0, path, child_idxs, page));
+
+    free(ids);
+    close(fd);
+    btree_store.remove();
+}
+
+MU_TEST(test_btree_rebuild) {
+    btree_store.setup(&test_env);
+    mu_check(btree_store.create() == 0);
+    char tree_path[MAX_PATH];
+    store_path(items_dir, _BTREE_F, tree_path);
+    int fd = open(tree_path, O_RDWR);
+    mu_check(fd >= 0);
+
+    /* Removing all but every fourth item leaves leaves mostly empty */
+    const int num_ids = 16 * BTREE_LEAF_MAX;
+    sitem_id ids[16 * BTREE_LEAF_MAX];
+    int n = 0, all_changed = 1;
+    for (sitem_id id = 0; id < num_ids; id++)
+        all_changed &= btree_test_insert(fd, id) == 0;
+    for (sitem_id id = 0; id < num_ids; id++) {
+        if (id % 4 == 0)
+            ids[n++] = id;
+        else
+            all_changed &= btree_remove_item(fd, id) == 0;
+    }
+    mu_check(all_changed);
+    const off_t sparse_size = lseek(fd, 0, SEEK_END);
+    close(fd);
+
+    mu_check(btree_store.compact() == 0);
+    fd = open(tree_path, O_RDWR);
+    mu_check(fd >= 0);
+    mu_check(lseek(fd, 0, SEEK_END) < sparse_size / 2);
+    mu_check(btree_test_holds(fd, ids, n));
+
+    /* A tree emptied of every item is rebuilt to a single empty leaf */
+    for (int i = 0; i < n; i++)
+        all_changed &= btree_remove_item(fd, ids[i]) == 0;
+    mu_check(all_changed);
+    close(fd);
+    mu_check(btree_store.compact() == 0);
+    fd = open(tree_path, O_RDONLY);
+    mu_check(fd >= 0);
+    mu_assert_int_eq(2 * BTREE_PAGE_SIZE, (int)lseek(fd, 0, SEEK_END));
+    mu_check(btree_test_holds(fd, ids, 0));
+
+    close(fd);
+    btree_store.remove();
+}
+
+MU_TEST(test_segments_store) {
+    const char *msg = run_store(&segments_store);
+    mu_assert(!msg, msg);
+}
+
+MU_TEST(test_files_store_failed_change) {
+    files_store.setup(&test_env);
+    mu_check(files_store.create() == 0);
+
+    item it = {.item_id = 0, .item_st = TODO};
+    item_set_name_deep(&it, "item 0", 6);
+    item_set_code(&it);
+    mu_check(files_store.append_item(&it) == 0);
+    free(it.item_name);
+
+    /* An item file that cannot be opened fails the move of the item to it */
+    char ip_file[MAX_PATH];
+    store_path(items_dir, _FILES_INPROG_F, ip_file);
+    mu_check(unlink(ip_file) == 0 && mkdir(ip_file, 0755) == 0);
+    mu_assert_int_eq(-1, files_store.change_status(0, IN_PROG));
+    rmdir(ip_file);
+}
+
+/**
+ * @brief Write the entries of items with the given sorted IDs to a new file
+ * @return File descriptor of the file opened for reading and writing
+ * @return -1 on error
+ */
+static int files_test_entries(const sitem_id *ids, const int n) {
+    char path[MAX_PATH];
+    store_path(proj_dir, "entries", path);
+    const int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return -1;
+
+    for (int i = 0; i < n; i++) {
+        char entry[FILES_ENTRY_LEN + 1];
+        char name[] = "item";
+        item it = {.item_id = ids[i], .item_name = name};
+        item_set_code(&it);
+        if (make_item_entry(&it, entry) < 0 ||
+            pwrite_all(fd, entry, FILES_ENTRY_LEN,
+                       (off_t)i * FILES_ENTRY_LEN) < 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+/**
+ * @brief Check that every ID is found at its own entry, and that the IDs
+ * between and around them are placed where they would be inserted
+ */
+static int files_test_search(const int fd, const sitem_id *ids, const int n) {
+    for (int i = 0; i < n; i++) {
+        int is_live = 0;
+        if (fd_search_for_entry_id(fd, ids[i], &is_live) !=
+                (off_t)i * FILES_ENTRY_LEN ||
+            !is_live)
+            return 0;
+
+        /* Missing IDs before this entry belong in its place */
+        const sitem_id prev = i == 0 ? -1 : ids[i - 1];
+        if (ids[i] - prev > 1 &&
+            fd_search_for_entry_id(fd, ids[i] - 1, NULL) !=
+                (i == 0 ? OFF_T_MIN : -(off_t)i * (off_t)FILES_ENTRY_LEN))
+            return 0;
+    }
+    return fd_search_for_entry_id(fd, ids[n - 1] + 1, NULL) ==
+           -(off_t)n * (off_t)FILES_ENTRY_LEN;
+}
+
+MU_TEST(test_files_search_uniform) {
+    /* Even IDs only, every odd ID is missing */
+    sitem_id ids[1000];
+    for (int i = 0; i < 1000; i++)
+        ids[i] = 2 * i + 2;
+
+    const int fd = files_test_entries(ids, 1000);
+    mu_check(fd >= 0);
+    mu_check(files_test_search(fd, ids, 1000));
+    mu_check(fd_search_for_entry_id(fd, 0, NULL) == OFF_T_MIN);
+
+    /* Tombstones are found in place */
+    int is_live = 1;
+    mu_check(fd_kill_entry_at(fd, 500 * FILES_ENTRY_LEN) == 0);
+    mu_check(fd_search_for_entry_id(fd, ids[500], &is_live) ==
+             500 * FILES_ENTRY_LEN);
+    mu_check(!is_live);
+    close(fd);
+
+    /* A single entry, and no entries at all */
+    const int one_fd = files_test_entries(ids, 1);
+    mu_check(one_fd >= 0);
+    mu_check(files_test_search(one_fd, ids, 1));
+    close(one_fd);
+    const int empty_fd = files_test_entries(ids, 0);
+    mu_check(empty_fd >= 0);
+    mu_check(fd_search_for_entry_id(empty_fd, 1, NULL) == OFF_T_MIN);
+    close(empty_fd);
+}
+
+MU_TEST(test_files_search_skewed) {
+    /*
+     * A dense run of IDs followed by a few far larger IDs: interpolated probes
+     * land near the start of the file, so the search falls back to bisection
+     */
+    sitem_id ids[600];
+    for (int i = 0; i < 590; i++)
+        ids[i] = i;
+    for (int i = 590; i < 600; i++)
+        ids[i] = (sitem_id)1 << (i - 590 + 20);
+
+    const int fd = files_test_entries(ids, 600);
+    mu_check(fd >= 0);
+    mu_check(files_test_search(fd, ids, 600));
+    mu_check(fd_search_for_entry_id(fd, 590, NULL) ==
+             -590 * (off_t)FILES_ENTRY_LEN);
+    close(fd);
+
+    /* Skewed the other way, a few small IDs before a dense run */
+    for (int i = 0; i < 10; i++)
+        ids[i] = i * 1000;
+    for (int i = 10; i < 600; i++)
+        ids[i] = 1000000 + i;
+
+    const int rev_fd = files_test_entries(ids, 600);
+    mu_check(rev_fd >= 0);
+    mu_check(files_test_search(rev_fd, ids, 600));
+    close(rev_fd);
+}
+
+/**
+ * @brief Append a TODO item named after its ID to the files store
+ */
+static int files_test_append(const sitem_id id) {
+    char name[32];
+    item it = {.item_id = id, .item_st = TODO};
+    item_set_name_deep(&it, name, snprintf(name, sizeof(name), "item %d", id));
+    item_set_code(&it);
+
+    const int ret = files_store.append_item(&it);
+    free(it.item_name);
+    return ret;
+}
+
+MU_TEST(test_files_insert_shift) {
+    files_store.setup(&test_env);
+    mu_check(files_store.create() == 0);
+
+    /* Even IDs only, filling several shift chunks */
+    const int chunk_entries = _FILES_SHIFT_CHUNK_SZ / FILES_ENTRY_LEN;
+    const int n = 4 * chunk_entries;
+    for (sitem_id id = 0; id < 2 * n; id += 2)
+        mu_check(files_test_append(id) == 0);
+
+    /*
+     * Odd IDs inserted out of order: near the end, at the front, and either
+     * side of the boundary between the first two chunks of a shift
+     */
+    const int boundary = n - chunk_entries;
+    const sitem_id inserted[] = {2 * n - 3, 1, 2 * boundary - 1,
+                                 2 * boundary + 1, 2 * chunk_entries - 1};
+    const int num_inserted = sizeof(inserted) / sizeof(*inserted);
+    for (int i = 0; i < num_inserted; i++)
+        mu_check(files_test_append(inserted[i]) == 0);
+
+    /* Every entry is intact and in order of ID */
+    char todo_file[MAX_PATH];
+    store_path(items_dir, _FILES_TODO_F, todo_file);
+    const int fd = open(todo_file, O_RDONLY);
+    mu_check(fd >= 0);
+    mu_assert_int_eq(n + num_inserted, fd_total_items(fd, FILES_ENTRY_LEN));
+
+    int entry = 0;
+    for (sitem_id id = 0; id < 2 * n; id++) {
+        int is_inserted = 0;
+        for (int i = 0; i < num_inserted; i++)
+            is_inserted |= inserted[i] == id;
+        if (id % 2 != 0 && !is_inserted)
+            continue;
+
+        char name[32];
+        snprintf(name, sizeof(name), "item %d", id);
+        item *itp = fd_read_item_at(fd, (off_t)entry * FILES_ENTRY_LEN);
+        mu_check(itp != NULL);
+        mu_assert_int_eq(id, itp->item_id);
+        mu_assert_string_eq(name, itp->item_name);
+        item_free(itp);
+        entry++;
+    }
+    close(fd);
+
+    files_store.remove();
+}
+
+MU_TEST(test_memory_store) {
+    const char *msg = run_store(&memory_store);
+    mu_assert(!msg, msg);
+}
+
+MU_TEST(test_memory_store_dependencies) {
+    memory_store.setup(&test_env);
+    mu_check(memory_store.create() == 0);
+
+    struct dependency dep_a = {.from = 1, .to = 2};
+    struct dependency dep_b = {.from = 3, .to = 2};
+    mu_check(memory_store.add_dependency(&dep_a) == 0);
+    mu_check(memory_store.add_dependency(&dep_b) == 0);
+    mu_check(memory_store.rm_dependency(&dep_a) == 0);
+    mu_check(memory_store.rm_dependency(&dep_a) == -1);
+
+    struct dependency_list *list = memory_store.read_dependencies();
+    mu_check(list != NULL);
+    mu_assert_int_eq(1, list->count);
+    mu_check(graph_dependencies_equal(list->dependencies[0], &dep_b));
+    graph_free_dependency_list(&list);
+
+    memory_store.remove();
+}
+
+MU_TEST(test_load_entries) {
+    char path[MAX_PATH];
+    store_path(proj_dir, "entries", path);
+    const int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    mu_check(fd >= 0);
+    mu_check(write(fd, "aaaabbbbcc", 10) == 10);
+
+    /* Files read optimistically are copied, partial entries are left out */
+    struct entry_buf buf;
+    for (int may_map = 1; may_map >= 0; may_map--) {
+        store_map_entries(may_map);
+        mu_assert_int_eq(2, fd_load_entries(fd, 4, &buf));
+        mu_assert_int_eq(may_map, buf.is_mapped);
+        mu_check(buf.len == 8 && memcmp(buf.data, "aaaabbbb", 8) == 0);
+        free_entry_buf(&buf);
+    }
+
+    store_map_entries(1);
+    close(fd);
+}
+
+MU_TEST(test_archive_compress) {
+    /* Runs of every length around the bounds, between literals */
+    char src[4096], comp[ARCHIVE_COMPRESS_BOUND(sizeof(src))], out[4096];
+    size_t len = 0;
+    for (int run = 1; len + run + 1 < sizeof(src); run += 7) {
+        memset(src + len, ' ', run);
+        len += run;
+        src[len++] = (char)('a' + run % 26);
+    }
+
+    const size_t comp_len = archive_compress(src, len, comp);
+    mu_check(comp_len < len);
+    mu_check(archive_decompress(comp, comp_len, out, sizeof(out)) ==
+             (ssize_t)len);
+    mu_check(memcmp(src, out, len) == 0);
+
+    /* Damaged or oversized input is rejected */
+    mu_check(archive_decompress(comp, comp_len, out, len - 1) == -1);
+    mu_check(archive_decompress(comp, comp_len - 1, out, sizeof(out)) == -1);
+}
+
+/**
+ * @brief Archive a segment of the items with IDs from first, every step IDs
+ */
+static int archive_ids(const char *dir, const sitem_id first,
+                       const sitem_id last, const int step) {
+    const int num = (last - first) / step + 1;
+    struct entry_buf entries = {malloc((size_t)num * TABLE_ENTRY_LEN + 1), 0,
+                                0};
+    if (!entries.data)
+        return -1;
+
+    for (sitem_id id = first; id <= last; id += step) {
+        char name[32];
+        item it = {.item_id = id, .item_st = DONE};
+        item_set_name_deep(&it, name,
+                           snprintf(name, sizeof(name), "item %d", id));
+        item_set_code(&it);
+        table_make_entry(&it, entries.data + entries.len);
+        entries.len += TABLE_ENTRY_LEN;
+        free(it.item_name);
+    }
+
+    const int ret = archive_add_segment(dir, &entries, test_sync_replacement);
+    free(entries.data);
+    return ret;
+}
+
+MU_TEST(test_archive) {
+    char dir[MAX_PATH];
+    snprintf(dir, sizeof(dir), "%s/archive", proj_dir);
+
+    /* Nothing is archived until the first segment is written */
+    mu_assert_int_eq(0, archive_total_items(dir));
+    mu_check(archive_read_item(dir, 0) == NULL);
+    mu_check(archive_revive(dir, 0, NULL) == -1);
+
+    /* Even IDs, then every third ID, so that some IDs are in both */
+    mu_check(archive_ids(dir, 0, STORE_TEST_ITEMS - 2, 2) == 0);
+    mu_check(archive_ids(dir, 0, STORE_TEST_ITEMS - 1, 3) == 0);
+    mu_check(archive_revive(dir, 6, NULL) == 0);
+    mu_check(archive_revive(dir, 9, NULL) == 0);
+
+    int expected = 0;
+    for (sitem_id id = 0; id < STORE_TEST_ITEMS; id++)
+        expected += (id % 2 == 0 || id % 3 == 0) && id != 6 && id != 9;
+
+    /* Records shadowed by newer segments are counted until merged */
+    const int shadowed = (STORE_TEST_ITEMS + 5) / 6;
+    mu_assert_int_eq(expected + shadowed, archive_total_items(dir));
+
+    item *itp = archive_read_item(dir, 4);
+    mu_check(itp && itp->item_id == 4 && itp->item_st == DONE &&
+             !strcmp(itp->item_name, "item 4"));
+    item_free(itp);
+    mu_check(archive_read_item(dir, 1) == NULL);
+    mu_check(archive_read_item(dir, STORE_TEST_ITEMS) == NULL);
+
+    /* Views visit each item once in order of ID, skipping revived items */
+    struct archive_view view;
+    mu_check(archive_view_open(dir, &view) >= expected);
+    int num_viewed = 0, in_order = 1;
+    sitem_id last_id = -1;
+    for (const struct dir_item_ref *ref; (ref = archive_view_next(&view));) {
+        in_order &= ref->id > last_id && ref->id != 6 && ref->id != 9 &&
+                    ref->st == DONE;
+        last_id = ref->id;
+        num_viewed++;
+    }
+    archive_view_close(&view);
+    mu_check(in_order);
+    mu_assert_int_eq(expected, num_viewed);
+
+    /* Writing past the most segments kept merges every segment */
+    for (int i = 0; i < _ARCHIVE_MAX_SEGMENTS - 1; i++)
+        mu_check(archive_ids(dir, STORE_TEST_ITEMS + i,
+                             STORE_TEST_ITEMS + i, 1) == 0);
+    expected += _ARCHIVE_MAX_SEGMENTS - 1;
+    mu_assert_int_eq(expected, archive_total_items(dir));
+
+    item **items = archive_read_items(dir);
+    mu_check(items != NULL);
+    mu_assert_int_eq(expected, (int)item_count_items(items));
+    item_array_free(&items, SIZE_MAX);
+
+    sitem_id *seqs = NULL;
+    mu_assert_int_eq(1, archive_read_segments(dir, &seqs));
+    free(seqs);
+    mu_check(archive_read_item(dir, 6) == NULL);
+}
+
+/* IDs of records redone, in order */
+static sitem_id redone_ids[8];
+static int num_redone = 0;
+
+static int test_redo(const struct wal_record *rec) {
+    if (num_redone == 8 || rec->st != DONE || rec->name_len != 6)
+        return -1;
+    redone_ids[num_redone++] = rec->id;
+    return 0;
+}
+
+/**
+ * @brief Log a done item named after its ID in a transaction
+ */
+static int wal_log_id(struct wal_txn *txn, const sitem_id id) {
+    char name[32];
+    item it = {.item_id = id, .item_st = DONE};
+    item_set_name_deep(&it, name, snprintf(name, sizeof(name), "item %d", id));
+    item_set_code(&it);
+    const int ret = wal_log_item(txn, &it);
+    free(it.item_name);
+    return ret;
+}
+
+MU_TEST(test_wal) {
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "%s/WAL", proj_dir);
+    mu_assert_int_eq(0, wal_recover(path, test_redo));
+
+    /* The last record of an item is found before the transaction commits */
+    struct wal_txn txn = {NULL, 0, 0, 0};
+    mu_check(wal_log_id(&txn, 1) == 0);
+    mu_check(wal_log_id(&txn, 2) == 0);
+    mu_check(wal_log_id(&txn, 1) == 0);
+    struct wal_record rec;
+    mu_check(wal_find_item(&txn, 2, &rec) == 0 && rec.id == 2);
+    mu_check(wal_find_item(&txn, 3, &rec) == -1);
+    item *itp = wal_record_to_item(&rec);
+    mu_check(itp && itp->item_id == 2 && !strcmp(itp->item_name, "item 2"));
+    item_free(itp);
+
+    mu_check(wal_commit(path, &txn, test_sync_replacement) == 0);
+    mu_assert_int_eq(3, wal_apply(&txn, test_redo));
+    wal_free_txn(&txn);
+
+    mu_check(wal_log_id(&txn, 4) == 0);
+    mu_check(wal_commit(path, &txn, NULL) == 0);
+    wal_free_txn(&txn);
+
+    /* A transaction torn part way is never redone */
+    mu_check(wal_log_id(&txn, 5) == 0);
+    FILE *fp = fopen(path, "a");
+    mu_check(fp != NULL);
+    fwrite(txn.data, 1, txn.len, fp);
+    fputc('C', fp);
+    fclose(fp);
+    wal_free_txn(&txn);
+
+    num_redone = 0;
+    mu_assert_int_eq(4, wal_recover(path, test_redo));
+    mu_assert_int_eq(4, num_redone);
+    mu_check(redone_ids[0] == 1 && redone_ids[1] == 2 && redone_ids[2] == 1 &&
+             redone_ids[3] == 4);
+
+    mu_check(wal_clear(path) == 0);
+    mu_assert_int_eq(0, wal_recover(path, test_redo));
+}
+
+/**
+ * @brief Make a todo item named after its ID, with the code of its ID
+ */
+static item *code_index_item(const sitem_id id) {
+    char name[32];
+    item *itp = item_init();
+    itp->item_id = id;
+    itp->item_st = TODO;
+    item_set_name_deep(itp, name, snprintf(name, sizeof(name), "item %d", id));
+    item_set_code(itp);
+    return itp;
+}
+
+MU_TEST(test_code_index) {
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "%s/CODE_INDEX", proj_dir);
+
+    item *itp = code_index_item(0);
+    mu_assert_int_eq(-1, code_index_find(path, itp->item_code));
+    item_free(itp);
+
+    /* Enough items to sort the tail several times, and leave some unsorted */
+    const int num_items = 5 * _CODE_INDEX_MAX_TAIL + 3;
+    int all_added = 1;
+    for (sitem_id id = 0; id < num_items; id++) {
+        itp = code_index_item(id);
+        all_added &= code_index_add(path, itp, test_sync_replacement) == 0;
+        item_free(itp);
+    }
+    mu_check(all_added);
+
+    struct entry_buf buf;
+    mu_assert_int_eq(num_items + 1, code_index_load(path, &buf));
+    const int num_sorted = code_index_sorted(&buf);
+    mu_check(num_sorted > 0 && num_items - num_sorted <= _CODE_INDEX_MAX_TAIL);
+    int in_order = 1;
+    for (int i = 2; i <= num_sorted; i++)
+        in_order &=
+            code_index_compare(buf.data + (i - 1) * _CODE_INDEX_ENTRY_LEN,
+                               buf.data + i * _CODE_INDEX_ENTRY_LEN) < 0;
+    mu_check(in_order);
+    free_entry_buf(&buf);
+
+    int all_found = 1;
+    for (sitem_id id = 0; id < num_items; id++) {
+        itp = code_index_item(id);
+        all_found &= code_index_find(path, itp->item_code) == id;
+        item_free(itp);
+    }
+    mu_check(all_found);
+    mu_assert_int_eq(-1, code_index_find(path, "zzzzzzz"));
+
+    /* Prefixes of sorted and tail codes are checked against every code */
+    char codes[num_items][ITEM_CODE_LEN];
+    for (sitem_id id = 0; id < num_items; id++) {
+        itp = code_index_item(id);
+        memcpy(codes[id], itp->item_code, ITEM_CODE_LEN);
+        item_free(itp);
+    }
+    int all_shortest = 1, all_resolved = 1;
+    for (sitem_id id = 0; id < num_items; id++) {
+        int common_len = 0;
+        for (sitem_id other = 0; other < num_items; other++) {
+            const int len = code_index_common_len(codes[id], codes[other]);
+            if (other != id && len > common_len)
+                common_len = len;
+        }
+        const int prefix_len = code_index_prefix_len(path, codes[id]);
+        all_shortest &= prefix_len == common_len + 1;
+        all_resolved &=
+            code_index_find_prefix(path, codes[id], prefix_len) == id &&
+            code_index_find_prefix(path, codes[id], prefix_len - 1) ==
+                CODE_INDEX_AMBIGUOUS;
+    }
+    mu_check(all_shortest);
+    mu_check(all_resolved);
+    mu_assert_int_eq(-1, code_index_find_prefix(path, "zzzzzzz", 4));
+
+    /* Writing the index sorts every entry */
+    item *items[] = {code_index_item(7), code_index_item(3), NULL};
+    mu_check(code_index_write(path, items, NULL) == 0);
+    mu_assert_int_eq(3, code_index_load(path, &buf));
+    mu_assert_int_eq(2, code_index_sorted(&buf));
+    free_entry_buf(&buf);
+    mu_assert_int_eq(7, code_index_find(path, items[0]->item_code));
+    mu_assert_int_eq(3, code_index_find(path, items[1]->item_code));
+    item_free(items[0]);
+    item_free(items[1]);
+}
+
+MU_TEST_SUITE(store_test_suite) {
+    MU_SUITE_CONFIGURE(test_setup, test_teardown);
+
+    MU_RUN_TEST(test_files_store);
+    MU_RUN_TEST(test_table_store);
+    MU_RUN_TEST(test_binary_store);
+    MU_RUN_TEST(test_binary_compact);
+    MU_RUN_TEST(test_lsm_store);
+    MU_RUN_TEST(test_btree_store);
+    MU_RUN_TEST(test_btree_interrupted_split);
+    MU_RUN_TEST(test_btree_internal_split);
+    MU_RUN_TEST(test_btree_rebuild);
+    MU_RUN_TEST(test_segments_store);
+    MU_RUN_TEST(test_files_store_failed_change);
+    MU_RUN_TEST(test_files_search_uniform);
+    MU_RUN_TEST(test_files_search_skewed);
+    MU_RUN_TEST(test_files_insert_shift);
+    MU_RUN_TEST(test_memory_store);
+    MU_RUN_TEST(test_memory_store_dependencies);
+    MU_RUN_TEST(test_load_entries);
+    MU_RUN_TEST(test_archive_compress);
+    MU_RUN_TEST(test_archive);
+    MU_RUN_TEST(test_wal);
+    MU_RUN_TEST(test_code_index);
+}
+
+MU_MAIN(MU_RUN_SUITE(store_test_suite); MU_REPORT(); return MU_EXIT_CODE;)